@@ -827,6 +827,111 @@ str
     microcode
 """
 
+%feature("docstring") Program::get_profile
+""" Returns the profile of the passes of the last compilation of the program
+
+Parameters
+----------
+None
+
+Returns
+-------
+str
+    json string with for each pass the time taken by it, its allocations,
+    the peak memory use after it, and the program size before and after it;
+    empty unless option profile_passes or write_profile_files was yes
+"""
+
+%feature("docstring") FidelityEstimator
+""" FidelityEstimator class estimates the fidelity of many scheduled circuits at once,
+e.g. to compare candidate schedules or mappings in design-space exploration.
+It uses the model of the bounded fidelity metric: each gate multiplies the fidelity of its qubits
+by the gate fidelity, after decay by idling since the previous operation on the qubit,
+a two-qubit gate gives both operands the product of their fidelities, and prepz restores the fidelity of its qubit.
+The result of a circuit is the average over the qubits of their fidelity at the end of the circuit."""
+
+
+%feature("docstring") FidelityEstimator::FidelityEstimator
+""" Constructs a FidelityEstimator
+
+Parameters
+----------
+arg1 : int
+    number of qubits, at least 1
+arg2 : float
+    fidelity of a single-qubit gate, default 0.999
+arg3 : float
+    fidelity of a two-qubit gate, default 0.99
+arg4 : float
+    decoherence time in cycles, default 150
+
+Returns
+-------
+None
+"""
+
+%feature("docstring") FidelityEstimator::add_schedule
+""" Adds a scheduled circuit, given as lists with one element per gate
+
+Parameters
+----------
+arg1 : []
+    first qubit operand of each gate
+arg2 : []
+    second qubit operand of each two-qubit gate, ignored for other gates
+arg3 : []
+    start cycle of each gate, the first cycle being 1
+arg4 : []
+    duration in cycles of each gate
+arg5 : []
+    class of each gate: 0 for gates that don't affect the fidelity (e.g. measure),
+    1 for prepz, 2 for single-qubit gates and 3 for two-qubit gates
+
+Returns
+-------
+int
+    index of the circuit in the list of results of estimate
+"""
+
+%feature("docstring") FidelityEstimator::add_program
+""" Adds the scheduled circuit of each kernel of a compiled program
+
+Parameters
+----------
+arg1 : Program
+    compiled program
+
+Returns
+-------
+int
+    index of the first kernel's circuit in the list of results of estimate
+"""
+
+%feature("docstring") FidelityEstimator::estimate
+""" Estimates the fidelity of all circuits added
+
+Parameters
+----------
+None
+
+Returns
+-------
+[]
+    estimated fidelity of each circuit, in the order in which they were added
+"""
+
+%feature("docstring") FidelityEstimator::clear
+""" Removes all circuits added
+
+Parameters
+----------
+None
+
+Returns
+-------
+None
+"""
+
 %feature("docstring") cQasmReader
 """ cQasmReader class specifies an interface to add cqasm programs to a program."""
 
@@ -121,6 +121,11 @@ class build_ext(_build_ext):
             if 'OPENQL_DISABLE_UNITARY' in os.environ:
                 cmd = cmd['-DWITH_UNITARY_DECOMPOSITION=OFF']
 
+            # Debug/info logging can be compiled away using an environment
+            # variable, set to LOG_INFO or LOG_WARNING.
+            if 'OPENQL_MIN_LOG_LEVEL' in os.environ:
+                cmd = cmd['-DOPENQL_MIN_LOG_LEVEL=' + os.environ['OPENQL_MIN_LOG_LEVEL']]
+
             # Initial placement support can be enabled using an environment
             # variable.
             if 'OPENQL_ENABLE_INITIAL_PLACEMENT' in os.environ:
@@ -17,6 +17,8 @@
 #include <version.h>
 #include <options.h>
 
+#include <algorithm>
+
 /************************************************************************\
 | Generic
 \************************************************************************/
@@ -27,13 +29,17 @@ void codegen_cc::init(const ql::quantum_platform &platform)
     // as a result also a codegen_cc, so we don't need to cleanup
     this->platform = &platform;
     load_backend_settings();
+    loopCompression = (ql::options::get("backend_cc_loop_compression") == "yes");
+#if OPT_VCD_OUTPUT
+    loadVcdFilter();
+#endif
 
     // optionally preload codewordTable
     std::string map_input_file = ql::options::get("backend_cc_map_input_file");
     if(map_input_file != "") {
         DOUT("loading map_input_file='" << map_input_file << "'");
         json map = ql::load_json(map_input_file);
-        codewordTable = map["codeword_table"];      // FIXME: use json_get
+        loadCodewordTable(map["codeword_table"]);   // FIXME: use json_get
         mapPreloaded = true;
     }
 }
@@ -45,18 +51,69 @@ std::string codegen_cc::getCode()
 
 std::string codegen_cc::getMap()
 {
-    json map;
+    return mapText;
+}
 
-    map["note"] = "generated by OpenQL CC backend version " CC_BACKEND_VERSION_STRING;
-    map["codeword_table"] = codewordTable;
-//    map["inputLut_table"] = inputLutTable;
-    return SS2S(std::setw(4) << map << std::endl);
+// kernels can be generated independently, unless codewords are assigned in order of use
+bool codegen_cc::canForkKernels() const
+{
+#if OPT_SUPPORT_STATIC_CODEWORDS
+    return true;
+#else
+    return mapPreloaded;
+#endif
+}
+
+// start generating a kernel that starts at kernelStartCycle after the kernels generated by program so far.
+// NB: only reads program, so kernels can be forked concurrently
+void codegen_cc::kernel_fork(const codegen_cc &program, size_t kernelStartCycle)
+{
+    platform = program.platform;
+    verboseCode = program.verboseCode;
+    mapPreloaded = program.mapPreloaded;
+    loopCompression = program.loopCompression;
+    cccode << std::left;    // assumed by emit()
+    programCode << std::left;
+
+    jsonInstrumentDefinitions = program.jsonInstrumentDefinitions;
+    jsonControlModes = program.jsonControlModes;
+    jsonInstruments = program.jsonInstruments;
+    jsonSignals = program.jsonSignals;
+    instrumentInfo = program.instrumentInfo;
+    signalInfo = program.signalInfo;
+    instructionIds = program.instructionIds;
+    instructionInfo = program.instructionInfo;
+    codewordTable = program.codewordTable;
+
+#if OPT_VCD_OUTPUT
+    kernelStartTime = program.kernelStartTime + kernelStartCycle*platform->cycle_time;
+    vcdVarKernel = program.vcdVarKernel;
+    vcdVarQubit = program.vcdVarQubit;
+    vcdVarSignal = program.vcdVarSignal;
+    vcdVarCodeword = program.vcdVarCodeword;
+    vcdKernels = program.vcdKernels;
+    vcdFirstCycle = program.vcdFirstCycle;
+    vcdLastCycle = program.vcdLastCycle;
+    vcd.spill();                    // NB: bounds our memory like the program's file does, until kernel_join()
+#endif
+}
+
+// append the code generated by kernel, which was forked from us
+void codegen_cc::kernel_join(codegen_cc &kernel)
+{
+    cccode << kernel.cccode.rdbuf();
+#if OPT_VCD_OUTPUT
+    vcd.merge(kernel.vcd);
+    kernelStartTime = kernel.kernelStartTime;
+    vcd.flush(kernelStartTime);     // NB: the next kernel may still overwrite the end of this one
+#endif
 }
 
 void codegen_cc::program_start(const std::string &progName)
 {
     // emit program header
     cccode << std::left;    // assumed by emit()
+    programCode << std::left;   // NB: swapped with cccode by loop compression
     cccode << "# Program: '" << progName << "'" << std::endl;   // NB: put on top so it shows up in internal CC logging
     cccode << "# CC_BACKEND_VERSION " << CC_BACKEND_VERSION_STRING << std::endl;
     cccode << "# OPENQL_VERSION " << OPENQL_VERSION_STRING << std::endl;
@@ -66,8 +123,13 @@ void codegen_cc::program_start(const std::string &progName)
     latencyCompensation();  // FIXME: does not support measuring yet
 
 #if OPT_VCD_OUTPUT
-    // define header
-    vcd.start();
+    // open VCD file and define header. NB: changes are streamed to the file during code generation
+    std::string file_name(ql::options::get("output_dir") + "/" + progName + ".vcd");
+    IOUT("Writing Value Change Dump to " << file_name);
+    vcd.start(file_name);
+    if(!vcd.good()) {
+        WOUT("cannot open '" << file_name << "', Value Change Dump is discarded");
+    }
 
     // define kernel variable
     vcd.scope(vcd.ST_MODULE, "kernel");
@@ -79,34 +141,32 @@ void codegen_cc::program_start(const std::string &progName)
     vcdVarQubit.resize(platform->qubit_number);
     for(size_t q=0; q<platform->qubit_number; q++) {
         std::string name = "q"+std::to_string(q);
-        vcdVarQubit[q] = vcd.registerVar(name, Vcd::VT_STRING);
+        bool selected = vcdQubits.empty() || vcdQubits.count(std::to_string(q));
+        vcdVarQubit[q] = selected ? vcd.registerVar(name, Vcd::VT_STRING) : -1;
     }
     vcd.upscope();
 
     // define signal variables
     size_t instrsUsed = jsonInstruments->size();
     vcd.scope(vcd.ST_MODULE, "signals");
-    vcdVarSignal.assign(instrsUsed, std::vector<int>(MAX_GROUPS, {0}));
+    vcdVarSignal.assign(instrsUsed, std::vector<int>(MAX_GROUPS, -1));
     for(size_t instrIdx=0; instrIdx<instrsUsed; instrIdx++) {
-        const json &instrument = (*jsonInstruments)[instrIdx];                  // NB: always exists
-        std::string instrumentPath = SS2S("instruments["<<instrIdx<<"]");       // for JSON error reporting
-        std::string instrumentName = json_get<std::string>(instrument, "name", instrumentPath);
-        const json qubits = json_get<const json>(instrument, "qubits", instrumentPath);
-        for(size_t group=0; group<qubits.size(); group++) {
+        const std::string &instrumentName = instrumentInfo[instrIdx].name;
+        for(size_t group=0; group<instrumentInfo[instrIdx].nrQubitGroups; group++) {
             std::string name = instrumentName+"-"+std::to_string(group);
-            vcdVarSignal[instrIdx][group] = vcd.registerVar(name, Vcd::VT_STRING);
+            bool selected = vcdInstruments.empty() || vcdInstruments.count(instrumentName) || vcdInstruments.count(name);
+            vcdVarSignal[instrIdx][group] = selected ? vcd.registerVar(name, Vcd::VT_STRING) : -1;
         }
     }
     vcd.upscope();
 
     // define codeword variables
     vcd.scope(vcd.ST_MODULE, "codewords");
-    vcdVarCodeword.resize(platform->qubit_number);
+    vcdVarCodeword.resize(instrsUsed);
     for(size_t instrIdx=0; instrIdx<instrsUsed; instrIdx++) {
-        const json &instrument = (*jsonInstruments)[instrIdx];                  // NB: always exists
-        std::string instrumentPath = SS2S("instruments["<<instrIdx<<"]");       // for JSON error reporting
-        std::string instrumentName = json_get<std::string>(instrument, "name", instrumentPath);
-        vcdVarCodeword[instrIdx] = vcd.registerVar(instrumentName, Vcd::VT_STRING);
+        const std::string &instrumentName = instrumentInfo[instrIdx].name;
+        bool selected = vcdInstruments.empty() || vcdInstruments.count(instrumentName);
+        vcdVarCodeword[instrIdx] = selected ? vcd.registerVar(instrumentName, Vcd::VT_STRING) : -1;
     }
     vcd.upscope();
 #endif
@@ -123,29 +183,52 @@ void codegen_cc::program_finish(const std::string &progName)
          "# loop indefinitely");
 #endif
 
+    // serialize codewordTable for getMap
+    json map;
+    json table;
+    for(auto &instrument : codewordTable) {
+        json &groups = table[instrument.first];
+        for(size_t group=0; group<instrument.second.size(); group++) {
+            groups[group] = codewordGroupToJson(instrument.second[group]);
+        }
+    }
+    map["note"] = "generated by OpenQL CC backend version " CC_BACKEND_VERSION_STRING;
+    map["codeword_table"] = table;
+//    map["inputLut_table"] = inputLutTable;
+    mapText = SS2S(std::setw(4) << map << std::endl);
+
 #if OPT_VCD_OUTPUT
-    // generate VCD
+    // write the remaining changes and close the VCD file
     vcd.finish();
-
-    // write VCD to file
-    std::string file_name(ql::options::get("output_dir") + "/" + progName + ".vcd");
-    IOUT("Writing Value Change Dump to " << file_name);
-    ql::utils::write_file(file_name, vcd.getVcd());
 #endif
 }
 
-void codegen_cc::kernel_start()
+void codegen_cc::kernel_start(const std::string &kernelName, size_t firstBundleIdx)
 {
     ql::utils::zero(lastEndCycle);       // FIXME: actually, bundle.startCycle starts counting at 1
+    this->firstBundleIdx = firstBundleIdx;
+    bundleCode.clear();
+
+#if OPT_VCD_OUTPUT
+    vcdKernelSelected = vcdKernels.empty() || vcdKernels.count(kernelName);
+    if(vcdKernelSelected) {
+        vcd.change(vcdVarKernel, kernelStartTime, kernelName);  // start of kernel
+    }
+#endif
 }
 
 void codegen_cc::kernel_finish(const std::string &kernelName, size_t durationInCycles)
 {
+    if(loopCompression) {
+        emitBundleLoops(kernelName);
+    }
+
 #if OPT_VCD_OUTPUT
     // NB: timing starts anew for every kernel
     size_t durationInNs = durationInCycles*platform->cycle_time;
-    vcd.change(vcdVarKernel, kernelStartTime, kernelName);     // start of kernel
-    vcd.change(vcdVarKernel, kernelStartTime + durationInNs, "");               // end of kernel
+    if(vcdKernelSelected) {
+        vcd.change(vcdVarKernel, kernelStartTime + durationInNs, "");           // end of kernel
+    }
     kernelStartTime += durationInNs;
 #endif
 }
@@ -156,6 +239,14 @@ void codegen_cc::bundle_start(const std::string &cmnt)
     size_t slotsUsed = jsonInstruments->size();   // FIXME: assuming all instruments use a slot
     groupInfo.assign(slotsUsed, std::vector<tGroupInfo>(MAX_GROUPS, {"", 0, -1}));
 
+    if(loopCompression) {   // collect the code of the bundle in an empty cccode
+        programCode.swap(cccode);
+        cccode.str("");
+        inBundle = true;
+        bundleSignature.clear();
+        bundleNrInstructions = 0;
+    }
+
     comment(cmnt);
 }
 
@@ -167,11 +258,9 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
     }
 
     // iterate over instruments
-    for(size_t instrIdx=0; instrIdx<jsonInstruments->size(); instrIdx++) {
-        const json &instrument = (*jsonInstruments)[instrIdx];          // NB: always exists
-        std::string instrumentName = json_get<std::string>(instrument, "name", SS2S("instruments["<<instrIdx<<"]"));
-        JSON_ASSERT(instrument, "controller", instrumentName);          // first check intermediate node
-        int slot = json_get<int>(instrument["controller"], "slot", instrumentName+"/controller");    // FIXME: assuming controller being cc
+    for(size_t instrIdx=0; instrIdx<instrumentInfo.size(); instrIdx++) {
+        const std::string &instrumentName = instrumentInfo[instrIdx].name;
+        int slot = instrumentInfo[instrIdx].slot;
 
         // collect info for all groups within slot, i.e. one connected instrument
         // FIXME: the term 'group' is used in a diffused way: 1) index of signal vectors, 2) ...
@@ -185,9 +274,9 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                 isSlotUsed = true;
 
                 // find control mode & bits for instrument&group
-                std::string refControlMode = json_get<std::string>(instrument, "ref_control_mode", instrumentName);
-                const json controlMode = json_get<const json>(*jsonControlModes, refControlMode, "control_modes");     // the control mode definition for our instrument
-                size_t nrControlBitsGroups = controlMode["control_bits"].size();    // how many groups of control bits does the control mode specify
+                const tInstrumentInfo &controlMode = getControlModeInfo(instrIdx);  // the control mode definition for our instrument
+                const std::string &refControlMode = controlMode.refControlMode;
+                size_t nrControlBitsGroups = controlMode.controlBits.size();        // how many groups of control bits does the control mode specify
                 // determine which group to use
                 size_t controlModeGroup = -1;
                 if(nrControlBitsGroups == 0) {
@@ -204,18 +293,18 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                           << " groups in 'control_bits'");
                 }
                 // FIXME: check array size
-                const json groupControlBits = controlMode["control_bits"][controlModeGroup];
+                const std::vector<int> &groupControlBits = controlMode.controlBits[controlModeGroup];
 
 
                 // find or create codeword/mask fragment for this group
                 DOUT("instrumentName=" << instrumentName
                      << ", slot=" << slot
                      << ", control mode group=" << controlModeGroup
-                     << ", group control bits: " << groupControlBits);
+                     << ", group control bits: " << groupControlBits.size());
                 size_t nrGroupControlBits = groupControlBits.size();
                 uint32_t groupDigOut = 0;
                 if(nrGroupControlBits == 1) {      // single bit, implying this is a mask (not code word)
-                    groupDigOut |= 1<<(int)groupControlBits[0];     // NB: we assume the mask is active high, which is correct for VSM and UHF-QC
+                    groupDigOut |= 1<<groupControlBits[0];          // NB: we assume the mask is active high, which is correct for VSM and UHF-QC
                     // FIXME: check controlModeGroup vs group
                 } else {                // > 1 bit, implying code word
                     // FIXME allow single code word for vector of groups. Requires looking at all signals before assigning code word
@@ -237,7 +326,7 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                     // convert codeword to digOut
                     for(size_t idx=0; idx<nrGroupControlBits; idx++) {
                         int codeWordBit = nrGroupControlBits-1-idx;    // NB: groupControlBits defines MSB..LSB
-                        if(codeword & (1<<codeWordBit)) groupDigOut |= 1<<(int)groupControlBits[idx];
+                        if(codeword & (1<<codeWordBit)) groupDigOut |= 1<<groupControlBits[idx];
                     }
 
                     comment(SS2S("  # slot=" << slot
@@ -252,13 +341,13 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                 digOut |= groupDigOut;
 
                 // add trigger to digOut
-                size_t nrTriggerBits = controlMode["trigger_bits"].size();
+                size_t nrTriggerBits = controlMode.triggerBits.size();
                 if(nrTriggerBits == 0) {                                    // no trigger
                     // do nothing
                 } else if(nrTriggerBits == 1) {                             // single trigger for all groups
-                    digOut |= 1 << (int)controlMode["trigger_bits"][0];
+                    digOut |= 1 << controlMode.triggerBits[0];
                 } else if(nrTriggerBits == nrGroups) {                      // trigger per group
-                    digOut |= 1 << (int)controlMode["trigger_bits"][group];
+                    digOut |= 1 << controlMode.triggerBits[group];
                 } else {
                     FATAL("instrument '" << instrumentName
                           << "' uses " << nrGroups
@@ -275,11 +364,10 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                 // NB: this does not allow for readout without signal generation (by the same instrument), which might be needed in the future
                 // FIXME: move out of this loop
                 // FIXME: test for groupInfo[instrIdx][group].readoutCop >= 0
-                if(JSON_EXISTS(controlMode, "result_bits")) {                               // this instrument mode produces results
-                    const json &resultBits = controlMode["result_bits"][group];
-                    size_t nrResultBits = resultBits.size();
+                if(controlMode.hasResultBits) {                                             // this instrument mode produces results
+                    size_t nrResultBits = group < controlMode.resultBits.size() ? controlMode.resultBits[group].size() : 0;
                     if(nrResultBits == 1) {                     // single bit
-                        digIn |= 1<<(int)resultBits[0];         // NB: we assume the result is active high, which is correct for UHF-QC
+                        digIn |= 1<<controlMode.resultBits[group][0];   // NB: we assume the result is active high, which is correct for UHF-QC
 
 #if 0   // FIXME: WIP on measurement
                         // FIXME: save groupInfo[instrIdx][group].readoutCop in inputLut
@@ -292,31 +380,26 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
                         }
 #endif
                     } else {    // NB: nrResultBits==0 will not arrive at this point
-                        std::string controlModeName = controlMode;                      // convert to string
-                        FATAL("JSON key '" << controlModeName << "/result_bits' must have 1 bit per group");
+                        FATAL("JSON key 'control_modes/" << refControlMode << "/result_bits' must have 1 bit per group");
                     }
                 }
 #if OPT_VCD_OUTPUT
                 // generate signal output for group
-                size_t startTime = kernelStartTime + startCycle*platform->cycle_time;
                 size_t durationInNs = groupInfo[instrIdx][group].durationInNs;
                 std::string signalValue = groupInfo[instrIdx][group].signalValue;
                 int var = vcdVarSignal[instrIdx][group];
                 std::string val = SS2S(groupDigOut) + "=" + signalValue;
-                vcd.change(var, startTime, val);                // start of signal
-                vcd.change(var, startTime+durationInNs, "");     // end of signal
+                vcdChange(var, startCycle, durationInNs, val);
 #endif
             } // if(signal defined)
         } // for(group)
 
 #if OPT_VCD_OUTPUT
         // generate codeword output for instrument
-        size_t startTime = kernelStartTime + startCycle*platform->cycle_time;
         size_t durationInNs = slotDurationInCycles*platform->cycle_time;
         int var = vcdVarCodeword[instrIdx];
         std::string val = SS2S("0x" << std::hex << std::setfill('0') << std::setw(8) << digOut);
-        vcd.change(var, startTime, val);                // start of signal
-        vcd.change(var, startTime+durationInNs, "");     // end of signal
+        vcdChange(var, startCycle, durationInNs, val);
 #endif
 
 
@@ -361,6 +444,17 @@ void codegen_cc::bundle_finish(size_t startCycle, size_t durationInCycles, bool
     } // for(instrIdx)
 
     comment("");    // blank line to separate bundles
+
+#if OPT_VCD_OUTPUT
+    // later bundles start no earlier than this one, so the changes before it are final
+    vcd.flush(kernelStartTime + startCycle*platform->cycle_time);
+#endif
+
+    if(loopCompression) {
+        bundleCode.push_back({cccode.str(), bundleSignature, bundleNrInstructions});
+        cccode.swap(programCode);
+        inBundle = false;
+    }
 }
 
 void codegen_cc::comment(const std::string &c)
@@ -384,15 +478,11 @@ void codegen_cc::custom_gate(
         DOUT("iname=" << iname << ", angle=" << angle);
     }
 #endif
-    bool isReadout = false;
+    tInstructionInfo &ii = getInstructionInfo(iname);
+    bool isReadout = ii.isReadout;
 
-    if("readout" == platform->find_instruction_type(iname))          // handle readout
-    /* FIXME: we only use the "readout" instruction_type and don't care about the rest because the terms "mw" and "flux" don't fully
-     * cover gate functionality. It would be nice if custom gates could mimic ql::gate_type_t
-    */
+    if(isReadout)                                                   // handle readout
     {
-        isReadout = true;
-
         if(cops.size() == 0) {      // NB: existing code uses empty cops: measurement results can also be read from the readout device
             // FIXME: define meaning: no classical target, or implied target (classical register matching qubit)
             comment(SS2S(" # READOUT: " << iname << "(q" << qops[0] << ")"));
@@ -414,27 +504,18 @@ void codegen_cc::custom_gate(
         comment(cmnt.str());
     }
 
-    const json &instruction = platform->find_instruction(iname);
-
 #if OPT_VCD_OUTPUT
     // generate qubit output
-    size_t startTime = kernelStartTime + startCycle*platform->cycle_time;
     for(size_t i=0; i<qops.size(); i++) {
         // FIXME: improve name for 2q gates
         int var = vcdVarQubit[qops[i]];
-        vcd.change(var, startTime, iname);             // start of instruction
-        vcd.change(var, startTime+durationInNs, "");    // end of instruction
+        vcdChange(var, startCycle, durationInNs, iname);
     }
 #endif
 
 #if OPT_SUPPORT_STATIC_CODEWORDS
-    // look for optional codeword override
-    int staticCodewordOverride = -1;    // -1 means unused
-    if(JSON_EXISTS(instruction["cc"], "static_codeword_override")) {
-        staticCodewordOverride = instruction["cc"]["static_codeword_override"];
-        DOUT("Found static_codeword_override=" << staticCodewordOverride <<
-             " for instruction '" << iname << "'");
-    }
+    // optional codeword override
+    int staticCodewordOverride = ii.staticCodewordOverride;    // -1 means unused
  #if 1 // FIXME: require override
     if(staticCodewordOverride < 0) {
         FATAL("No static codeword defined for instruction '" << iname <<
@@ -443,16 +524,10 @@ void codegen_cc::custom_gate(
  #endif
 #endif
 
-    // find signal definition for iname
-    tJsonNodeInfo nodeInfo = findSignalDefinition(instruction, iname);
-    const json signal = nodeInfo.node;
-    std::string signalPath = nodeInfo.path;
-
     // iterate over signals defined for instruction
-    for(size_t s=0; s<signal.size(); s++) {
+    for(size_t s=0; s<ii.signals.size(); s++) {
         // get the qubit to work on
-        std::string signalSPath = SS2S(signalPath<<"["<<s<<"]");        // for JSON error reporting
-        size_t operandIdx = json_get<size_t>(signal[s], "operand_idx", signalSPath);
+        size_t operandIdx = ii.signals[s].operandIdx;
 
         if(operandIdx >= qops.size()) {
             FATAL("Error in JSON definition of instruction '" << iname <<
@@ -462,26 +537,12 @@ void codegen_cc::custom_gate(
         size_t qubit = qops[operandIdx];
 
 
-        // get the instrument and group that generates the signal
-        std::string instructionSignalType = json_get<std::string>(signal[s], "type", signalSPath);
-        JSON_ASSERT(signal[s], "value", signalSPath);                   // NB: json_get<const json&> unavailable
-        const json &instructionSignalValue = signal[s]["value"];
-
-        tSignalInfo si = findSignalInfoForQubit(instructionSignalType, qubit);
-        const json &instrument = (*jsonInstruments)[si.instrIdx];       // should exist
-        std::string instrumentName = json_get<std::string>(instrument, "name", SS2S("instruments["<<si.instrIdx<<"]"));
-        JSON_ASSERT(instrument, "controller", instrumentName);          // first check intermediate node
-        int slot = json_get<int>(instrument["controller"], "slot", instrumentName+"/controller");    // FIXME: assuming controller being cc
-
-
-        // expand macros in signalValue
-        std::string signalValueString = SS2S(instructionSignalValue);   // serialize instructionSignalValue into std::string
-        ql::utils::replace(signalValueString, std::string("\""), std::string(""));   // get rid of quotes
-        ql::utils::replace(signalValueString, std::string("{gateName}"), iname);
-        ql::utils::replace(signalValueString, std::string("{instrumentName}"), instrumentName);
-        ql::utils::replace(signalValueString, std::string("{instrumentGroup}"), std::to_string(si.group));
-        // FIXME: allow using all qubits involved (in same signalType?, or refer to signal: qubitOfSignal[n]), e.g. qubit[0], qubit[1], qubit[2]
-        ql::utils::replace(signalValueString, std::string("{qubit}"), std::to_string(qubit));
+        // get the instrument and group that generates the signal, and the signal value with its macros expanded
+        const tSignalTarget &st = getSignalTarget(ii.signals[s], qubit);
+        tSignalInfo si = st.si;
+        const std::string &instrumentName = instrumentInfo[si.instrIdx].name;
+        int slot = instrumentInfo[si.instrIdx].slot;
+        const std::string &signalValueString = st.signalValue;
 
         comment(SS2S("  # slot=" << slot
                 << ", instrument='" << instrumentName << "'"
@@ -599,6 +660,10 @@ void codegen_cc::emit(const char *labelOrComment, const char *instr)
 void codegen_cc::emit(const char *label, const char *instr, const std::string &qops, const char *comment)
 {
     cccode << std::setw(16) << label << std::setw(16) << instr << std::setw(24) << qops << comment << std::endl;
+    if(inBundle) {
+        bundleSignature.append(label).append(" ").append(instr).append(" ").append(qops).append("\n");
+        bundleNrInstructions++;
+    }
 }
 // FIXME: assure space between fields!
 // FIXME: also provide the above with std::string parameters
@@ -683,34 +748,143 @@ void codegen_cc::padToCycle(size_t lastEndCycle, size_t startCycle, int slot, co
     }
 }
 
+// emit the code of the bundles of a kernel collected in bundleCode, emitting sequences of bundles that repeat as a loop.
+// NB: the output timing of a slot only depends on the sequence of its seq_out instructions, which is unchanged by looping
+// over bundles whose instructions are identical (given that the loop instructions take no time on the output queues)
+void codegen_cc::emitBundleLoops(const std::string &kernelName)
+{
+    static const size_t MAX_LOOP_BUNDLES = 256;                 // maximum number of bundles in a loop body
+    static const size_t LOOP_OVERHEAD = 2;                      // instructions added by a loop, i.e. 'move' and 'loop'
+
+    // number the distinct signatures, so that sequences of bundles compare as integers
+    size_t nrBundles = bundleCode.size();
+    std::unordered_map<std::string, size_t> signatureIds;
+    std::vector<size_t> ids(nrBundles);
+    std::vector<size_t> instrsBefore(nrBundles+1, 0);           // number of instructions of the bundles before
+    for(size_t b=0; b<nrBundles; b++) {
+        ids[b] = signatureIds.emplace(bundleCode[b].signature, signatureIds.size()).first->second;
+        instrsBefore[b+1] = instrsBefore[b] + bundleCode[b].nrInstructions;
+    }
+
+    size_t nrLoops = 0;
+    size_t nrInstrsSaved = 0;
+    size_t b = 0;
+    while(b < nrBundles) {
+        // find the body starting at bundle b which saves most instructions by looping over its repetitions
+        size_t bestLength = 0;
+        size_t bestReps = 0;
+        size_t bestSaving = 0;
+        for(size_t length=1; length<=MAX_LOOP_BUNDLES && b+2*length<=nrBundles; length++) {
+            size_t reps = 1;
+            while(b+(reps+1)*length <= nrBundles
+                    && std::equal(ids.begin()+b, ids.begin()+b+length, ids.begin()+b+reps*length)) {
+                reps++;
+            }
+            size_t saving = (reps-1) * (instrsBefore[b+length] - instrsBefore[b]);
+            if(saving > LOOP_OVERHEAD && saving-LOOP_OVERHEAD > bestSaving) {
+                bestLength = length;
+                bestReps = reps;
+                bestSaving = saving-LOOP_OVERHEAD;
+            }
+        }
+
+        if(bestSaving > 0) {
+            std::string label = SS2S("bundleLoop" << firstBundleIdx+b);      // NB: the number of the first bundle in the loop
+            comment(SS2S("# BUNDLE_LOOP_START(" << bestReps << "): " << bestLength << " bundles"));
+            emit("", "move", SS2S(bestReps << ",R61"), "# R61 is the 'bundle loop counter'");
+            emit((label+":").c_str(), "", SS2S(""), "# ");        // just a label
+            for(size_t i=b; i<b+bestLength; i++) {
+                cccode << bundleCode[i].code;
+            }
+            comment("# BUNDLE_LOOP_END");
+            emit("", "loop", SS2S("R61,@" << label), "# R61 is the 'bundle loop counter'");
+            b += bestLength*bestReps;
+            nrLoops++;
+            nrInstrsSaved += bestSaving;
+        } else {
+            cccode << bundleCode[b].code;
+            b++;
+        }
+    }
+    IOUT("Loop compression of kernel '" << kernelName << "': " << nrBundles << " bundles with " << instrsBefore[nrBundles]
+         << " instructions emitted in " << nrLoops << " loops, saving " << nrInstrsSaved << " instructions");
+    bundleCode.clear();
+}
+
+#if OPT_VCD_OUTPUT
+// load what to record in the VCD from the options backend_cc_vcd_*, which are comma separated lists (empty for all),
+// and a cycle range 'first-last' within each kernel, of which either bound may be omitted
+void codegen_cc::loadVcdFilter()
+{
+    auto loadList = [](const std::string &option, std::set<std::string> &list) {
+        std::istringstream iss(ql::options::get(option));
+        std::string item;
+        list.clear();
+        while(std::getline(iss, item, ',')) {
+            if(item != "") list.insert(item);
+        }
+    };
+    loadList("backend_cc_vcd_instruments", vcdInstruments);
+    loadList("backend_cc_vcd_qubits", vcdQubits);
+    loadList("backend_cc_vcd_kernels", vcdKernels);
+
+    std::string cycles = ql::options::get("backend_cc_vcd_cycles");
+    vcdFirstCycle = 0;
+    vcdLastCycle = SIZE_MAX;
+    if(cycles != "") {
+        size_t dash = cycles.find('-');
+        try {
+            if(dash == std::string::npos) {
+                vcdFirstCycle = vcdLastCycle = std::stoul(cycles);
+            } else {
+                if(dash > 0) vcdFirstCycle = std::stoul(cycles.substr(0, dash));
+                if(dash+1 < cycles.size()) vcdLastCycle = std::stoul(cycles.substr(dash+1));
+            }
+        } catch(std::exception &e) {
+            FATAL("illegal value '" << cycles << "' for option backend_cc_vcd_cycles, expected 'first-last'");
+        }
+    }
+}
+
+// record value on var during a bundle starting at startCycle, if var, the kernel and the cycle are selected
+void codegen_cc::vcdChange(int var, size_t startCycle, size_t durationInNs, const std::string &value)
+{
+    if(var < 0 || !vcdKernelSelected || startCycle < vcdFirstCycle || startCycle > vcdLastCycle) {
+        return;
+    }
+    size_t startTime = kernelStartTime + startCycle*platform->cycle_time;
+    vcd.change(var, startTime, value);                  // start of signal
+    vcd.change(var, startTime+durationInNs, "");        // end of signal
+}
+#endif
+
 #if !OPT_SUPPORT_STATIC_CODEWORDS
 uint32_t codegen_cc::assignCodeword(const std::string &instrumentName, int instrIdx, int group)
 {
     uint32_t codeword;
-    std::string signalValue = groupInfo[instrIdx][group].signalValue;
+    const std::string &signalValue = groupInfo[instrIdx][group].signalValue;
 
-    if(JSON_EXISTS(codewordTable, instrumentName) &&                    // instrument exists
-                    codewordTable[instrumentName].size() > group) {     // group exists
-        bool cwFound = false;
+    auto it = codewordTable.find(instrumentName);
+    if(it != codewordTable.end() &&                                     // instrument exists
+                    it->second.size() > (size_t)group) {                // group exists
         // try to find signalValue
-        json &myCodewordArray = codewordTable[instrumentName][group];
-        for(codeword=0; codeword<myCodewordArray.size() && !cwFound; codeword++) {   // NB: JSON find() doesn't work for arrays
-            if(myCodewordArray[codeword] == signalValue) {
-                DOUT("signal value found at cw=" << codeword);
-                cwFound = true;
-            }
-        }
-        if(!cwFound) {
+        tCodewordGroup &cwGroup = it->second[group];
+        auto cw = cwGroup.codewords.find(signalValue);
+        if(cw != cwGroup.codewords.end()) {
+            codeword = cw->second;
+            DOUT("signal value found at cw=" << codeword);
+        } else {
             std::string msg = SS2S("signal value '" << signalValue
                     << "' not found in group " << group
-                    << ", which contains " << myCodewordArray);
+                    << ", which contains " << codewordGroupToJson(cwGroup));
             if(mapPreloaded) {
                 FATAL("mismatch between preloaded 'backend_cc_map_input_file' and program requirements:" << msg)
             } else {
                 DOUT(msg);
-                // NB: codeword already contains last used value + 1
                 // FIXME: check that number is available
-                myCodewordArray[codeword] = signalValue;                    // NB: structure created on demand
+                codeword = cwGroup.signalValues.size();
+                cwGroup.signalValues.push_back(signalValue);
+                cwGroup.codewords.emplace(signalValue, codeword);
             }
         }
     } else {    // new instrument or group
@@ -720,15 +894,51 @@ uint32_t codegen_cc::assignCodeword(const std::string &instrumentName, int instr
                   << group
                   << " not present in file");
         } else {
+            std::vector<tCodewordGroup> &groups = codewordTable[instrumentName];
+            groups.resize(group+1);                                     // NB: groups skipped remain unused
+            tCodewordGroup &cwGroup = groups[group];
+            cwGroup.signalValues.push_back("");                         // code word 0 is empty
+            cwGroup.codewords.emplace("", 0);
             codeword = 1;
-            codewordTable[instrumentName][group][0] = "";                   // code word 0 is empty
-            codewordTable[instrumentName][group][codeword] = signalValue;   // NB: structure created on demand
+            cwGroup.signalValues.push_back(signalValue);
+            cwGroup.codewords.emplace(signalValue, codeword);
         }
     }
     return codeword;
 }
 #endif
 
+// load codewordTable from the "codeword_table" of a map file
+void codegen_cc::loadCodewordTable(const json &table)
+{
+    codewordTable.clear();
+    for(auto it=table.begin(); it!=table.end(); ++it) {                 // instruments
+        std::vector<tCodewordGroup> &groups = codewordTable[it.key()];
+        const json &jsonGroups = it.value();
+        groups.resize(jsonGroups.size());
+        for(size_t group=0; group<jsonGroups.size(); group++) {
+            const json &jsonGroup = jsonGroups[group];
+            tCodewordGroup &cwGroup = groups[group];
+            for(size_t codeword=0; codeword<jsonGroup.size(); codeword++) {
+                cwGroup.signalValues.push_back(jsonGroup[codeword]);
+                if(jsonGroup[codeword].is_string()) {                   // NB: other values never match a signal value
+                    cwGroup.codewords.emplace(jsonGroup[codeword].get<std::string>(), codeword);
+                }
+            }
+        }
+    }
+}
+
+// the JSON array of a codeword group, as stored in the map file. NB: a group that is unused is null
+json codegen_cc::codewordGroupToJson(const tCodewordGroup &cwGroup)
+{
+    json ret;
+    for(size_t codeword=0; codeword<cwGroup.signalValues.size(); codeword++) {
+        ret[codeword] = cwGroup.signalValues[codeword];
+    }
+    return ret;
+}
+
 /************************************************************************\
 | Functions processing JSON
 \************************************************************************/
@@ -751,6 +961,42 @@ void codegen_cc::load_backend_settings()
     JSON_ASSERT(jsonBackendSettings, "signals", "eqasm_backend_cc");
     jsonSignals = &jsonBackendSettings["signals"];
 
+    // compile instruments, and which instrument/group provides each signal type for each qubit
+    instrumentInfo.clear();
+    signalInfo.clear();
+    for(size_t instrIdx=0; instrIdx<jsonInstruments->size(); instrIdx++) {
+        const json &instrument = (*jsonInstruments)[instrIdx];                  // NB: always exists
+        std::string instrumentPath = SS2S("instruments["<<instrIdx<<"]");       // for JSON error reporting
+        tInstrumentInfo info;
+        info.name = json_get<std::string>(instrument, "name", instrumentPath);
+        JSON_ASSERT(instrument, "controller", info.name);                       // first check intermediate node
+        info.slot = json_get<int>(instrument["controller"], "slot", info.name+"/controller");    // FIXME: assuming controller being cc
+        const json qubits = json_get<const json>(instrument, "qubits", instrumentPath);   // NB: json_get<const json&> unavailable
+        info.nrQubitGroups = qubits.size();
+        info.controlModeLoaded = false;
+        info.hasResultBits = false;
+        instrumentInfo.push_back(info);
+
+        // FIXME: verify group size: qubits vs. control mode
+        // FIXME: verify signal dimensions
+        std::string instrumentSignalType = json_get<std::string>(instrument, "signal_type", instrumentPath);
+        std::vector<tSignalInfo> &byQubit = signalInfo[instrumentSignalType];
+        for(size_t group=0; group<qubits.size(); group++) {
+            for(size_t idx=0; idx<qubits[group].size(); idx++) {
+                size_t qubit = qubits[group][idx];
+                if(qubit >= byQubit.size()) {
+                    byQubit.resize(qubit+1, tSignalInfo{-1, -1});
+                }
+                if(byQubit[qubit].instrIdx < 0) {                               // the first instrument found drives the qubit
+                    byQubit[qubit].instrIdx = instrIdx;
+                    byQubit[qubit].group = group;
+                }
+            }
+        }
+    }
+    instructionIds.clear();
+    instructionInfo.clear();
+
 #if 0   // FIXME: print some info, which also helps detecting errors early on
     // read instrument definitions
     // FIXME: the following requires json>v3.1.0:  for(auto& id : jsonInstrumentDefinitions->items()) {
@@ -798,51 +1044,20 @@ const json &codegen_cc::findInstrumentDefinition(const std::string &name)
 // find instrument/group providing instructionSignalType for qubit
 codegen_cc::tSignalInfo codegen_cc::findSignalInfoForQubit(const std::string &instructionSignalType, size_t qubit)
 {
-    tSignalInfo ret = {-1, -1};
-    bool signalTypeFound = false;
-    bool qubitFound = false;
-
-    // iterate over instruments
-    for(size_t instrIdx=0; instrIdx<jsonInstruments->size(); instrIdx++) {
-        const json &instrument = (*jsonInstruments)[instrIdx];                  // NB: always exists
-        std::string instrumentPath = SS2S("instruments["<<instrIdx<<"]");       // for JSON error reporting
-        std::string instrumentSignalType = json_get<std::string>(instrument, "signal_type", instrumentPath);
-        if(instrumentSignalType == instructionSignalType) {
-            signalTypeFound = true;
-            std::string instrumentName = json_get<std::string>(instrument, "name", instrumentPath);
-            const json qubits = json_get<const json>(instrument, "qubits", instrumentPath);   // NB: json_get<const json&> unavailable
-
-            // FIXME: verify group size: qubits vs. control mode
-            // FIXME: verify signal dimensions
-
-            // anyone connected to qubit?
-            for(size_t group=0; group<qubits.size() && !qubitFound; group++) {
-                for(size_t idx=0; idx<qubits[group].size() && !qubitFound; idx++) {
-                    if(qubits[group][idx] == qubit) {
-                        qubitFound = true;
-
-                        DOUT("qubit " << qubit
-                             << " signal type '" << instructionSignalType
-                             << "' driven by instrument '" << instrumentName
-                             << "' group " << group
-//                                 << " in CC slot " << ccSetupSlot["slot"]
-                             );
-
-                        ret.instrIdx = instrIdx;
-                        ret.group = group;
-                        // FIXME: stop searching?
-                    }
-                }
-            }
-        }
-    }
-    if(!signalTypeFound) {
+    auto it = signalInfo.find(instructionSignalType);
+    if(it == signalInfo.end()) {
         FATAL("No instruments found providing signal type '" << instructionSignalType << "'");     // FIXME: clarify for user
     }
-    if(!qubitFound) {
+    if(qubit >= it->second.size() || it->second[qubit].instrIdx < 0) {
         FATAL("No instruments found driving qubit " << qubit << " for signal type '" << instructionSignalType << "'");     // FIXME: clarify for user
     }
 
+    tSignalInfo ret = it->second[qubit];
+    DOUT("qubit " << qubit
+         << " signal type '" << instructionSignalType
+         << "' driven by instrument '" << instrumentInfo[ret.instrIdx].name
+         << "' group " << ret.group
+         );
     return ret;
 }
 
@@ -867,3 +1082,101 @@ codegen_cc::tJsonNodeInfo codegen_cc::findSignalDefinition(const json &instructi
     }
     return nodeInfo;
 }
+
+
+// compile instruction iname on its first use
+codegen_cc::tInstructionInfo &codegen_cc::getInstructionInfo(const std::string &iname)
+{
+    auto it = instructionIds.find(iname);
+    if(it != instructionIds.end()) {
+        return instructionInfo[it->second];
+    }
+
+    tInstructionInfo ii;
+    /* FIXME: we only use the "readout" instruction_type and don't care about the rest because the terms "mw" and "flux" don't fully
+     * cover gate functionality. It would be nice if custom gates could mimic ql::gate_type_t
+    */
+    ii.isReadout = ("readout" == platform->find_instruction_type(iname));
+    const json &instruction = platform->find_instruction(iname);
+
+#if OPT_SUPPORT_STATIC_CODEWORDS
+    // look for optional codeword override
+    ii.staticCodewordOverride = -1;     // -1 means unused
+    if(JSON_EXISTS(instruction["cc"], "static_codeword_override")) {
+        ii.staticCodewordOverride = instruction["cc"]["static_codeword_override"];
+        DOUT("Found static_codeword_override=" << ii.staticCodewordOverride <<
+             " for instruction '" << iname << "'");
+    }
+#endif
+
+    // find signal definition for iname
+    tJsonNodeInfo nodeInfo = findSignalDefinition(instruction, iname);
+    const json &signal = nodeInfo.node;
+    for(size_t s=0; s<signal.size(); s++) {
+        std::string signalSPath = SS2S(nodeInfo.path<<"["<<s<<"]");     // for JSON error reporting
+        tSignalDef sd;
+        sd.operandIdx = json_get<size_t>(signal[s], "operand_idx", signalSPath);
+        sd.signalType = json_get<std::string>(signal[s], "type", signalSPath);
+        JSON_ASSERT(signal[s], "value", signalSPath);                   // NB: json_get<const json&> unavailable
+
+        // expand the macros that don't depend on the qubit
+        sd.signalValue = SS2S(signal[s]["value"]);                      // serialize signal value into std::string
+        ql::utils::replace(sd.signalValue, std::string("\""), std::string(""));   // get rid of quotes
+        ql::utils::replace(sd.signalValue, std::string("{gateName}"), iname);
+        ii.signals.push_back(sd);
+    }
+
+    instructionIds[iname] = instructionInfo.size();
+    instructionInfo.push_back(ii);
+    return instructionInfo.back();
+}
+
+
+// instrument/group and signal value of signal sd for qubit, resolved on its first use
+const codegen_cc::tSignalTarget &codegen_cc::getSignalTarget(tSignalDef &sd, size_t qubit)
+{
+    if(qubit >= sd.targets.size()) {
+        sd.targets.resize(qubit+1, tSignalTarget{false, {-1, -1}, ""});
+    }
+    tSignalTarget &st = sd.targets[qubit];
+    if(!st.resolved) {
+        st.si = findSignalInfoForQubit(sd.signalType, qubit);
+
+        // expand the remaining macros in signalValue
+        st.signalValue = sd.signalValue;
+        ql::utils::replace(st.signalValue, std::string("{instrumentName}"), instrumentInfo[st.si.instrIdx].name);
+        ql::utils::replace(st.signalValue, std::string("{instrumentGroup}"), std::to_string(st.si.group));
+        // FIXME: allow using all qubits involved (in same signalType?, or refer to signal: qubitOfSignal[n]), e.g. qubit[0], qubit[1], qubit[2]
+        ql::utils::replace(st.signalValue, std::string("{qubit}"), std::to_string(qubit));
+        st.resolved = true;
+    }
+    return st;
+}
+
+
+// control mode of instrument instrIdx, loaded on its first use
+const codegen_cc::tInstrumentInfo &codegen_cc::getControlModeInfo(size_t instrIdx)
+{
+    tInstrumentInfo &info = instrumentInfo[instrIdx];
+    if(!info.controlModeLoaded) {
+        const json &instrument = (*jsonInstruments)[instrIdx];                  // NB: always exists
+        info.refControlMode = json_get<std::string>(instrument, "ref_control_mode", info.name);
+        const json controlMode = json_get<const json>(*jsonControlModes, info.refControlMode, "control_modes");
+        if(JSON_EXISTS(controlMode, "control_bits")) {
+            for(auto &groupControlBits : controlMode["control_bits"]) {
+                info.controlBits.push_back(groupControlBits.get<std::vector<int>>());
+            }
+        }
+        if(JSON_EXISTS(controlMode, "trigger_bits")) {
+            info.triggerBits = controlMode["trigger_bits"].get<std::vector<int>>();
+        }
+        info.hasResultBits = JSON_EXISTS(controlMode, "result_bits");
+        if(info.hasResultBits) {
+            for(auto &groupResultBits : controlMode["result_bits"]) {
+                info.resultBits.push_back(groupResultBits.get<std::vector<int>>());
+            }
+        }
+        info.controlModeLoaded = true;
+    }
+    return info;
+}
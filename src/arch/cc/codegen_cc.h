@@ -24,7 +24,13 @@
 #endif
 
 #include <string>
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 #include <cstddef>  // for size_t etc.
+#include <cstdint>  // for SIZE_MAX
 #ifdef _MSC_VER     // MS Visual C++ does not know about ssize_t
 // FIXME JvS: this #ifdef should not be necessary. libqasm shouldn't be
 // #define'ing ssize_t, but should just use its own type! (so should this,
@@ -60,6 +66,56 @@ private: // types
         std::string path;       // path of the node, for reporting purposes
     } tJsonNodeInfo;
 
+    // JSON section "instruments" and the control modes they refer to, compiled by load_backend_settings
+    typedef struct {
+        std::string name;
+        int slot;
+        size_t nrQubitGroups;                           // size of "qubits"
+        bool controlModeLoaded;                         // the fields below are loaded on first use, see getControlModeInfo
+        std::string refControlMode;
+        std::vector<std::vector<int>> controlBits;      // [control mode group]: bits, MSB..LSB
+        std::vector<int> triggerBits;
+        bool hasResultBits;
+        std::vector<std::vector<int>> resultBits;       // [group]
+    } tInstrumentInfo;
+
+    // instrument, group and expanded signal value of a signal of an instruction, for a qubit
+    typedef struct {
+        bool resolved;                                  // the fields below are resolved on first use, see getSignalTarget
+        tSignalInfo si;
+        std::string signalValue;
+    } tSignalTarget;
+
+    // signal of an instruction, from JSON "signals" or the instruction's "cc/signal"
+    typedef struct {
+        size_t operandIdx;
+        std::string signalType;
+        std::string signalValue;                        // serialized value, with {gateName} expanded
+        std::vector<tSignalTarget> targets;             // [qubit]
+    } tSignalDef;
+
+    // codewords versus signals of an instrument group, see assignCodeword
+    typedef struct {
+        std::vector<json> signalValues;                             // [codeword], as in the map file
+        std::unordered_map<std::string, uint32_t> codewords;        // signal value to its (first) codeword
+    } tCodewordGroup;
+
+    // code of a bundle, collected for loop compression, see emitBundleLoops
+    typedef struct {
+        std::string code;                                           // as emitted, including comments
+        std::string signature;                                      // the instructions without comments: bundles repeat if identical
+        size_t nrInstructions;
+    } tBundleCode;
+
+    // instruction, compiled from JSON on first use by getInstructionInfo
+    typedef struct {
+        bool isReadout;
+#if OPT_SUPPORT_STATIC_CODEWORDS
+        int staticCodewordOverride;                     // -1 means unused
+#endif
+        std::vector<tSignalDef> signals;
+    } tInstructionInfo;
+
 public:
     codegen_cc() = default;
     ~codegen_cc() = default;
@@ -69,9 +125,15 @@ public:
     std::string getCode();
     std::string getMap();
 
+    // Parallel code generation of kernels: the code of each kernel is generated by a codegen_cc forked from that of the
+    // program, which joins them in program order
+    bool canForkKernels() const;
+    void kernel_fork(const codegen_cc &program, size_t kernelStartCycle);
+    void kernel_join(codegen_cc &kernel);
+
     void program_start(const std::string &progName);
     void program_finish(const std::string &progName);
-    void kernel_start();
+    void kernel_start(const std::string &kernelName, size_t firstBundleIdx);
     void kernel_finish(const std::string &kernelName, size_t durationInCycles);
     void bundle_start(const std::string &cmnt);
     void bundle_finish(size_t startCycle, size_t durationInCycles, bool isLastBundle);
@@ -103,12 +165,22 @@ private:    // vars
 
     bool verboseCode = true;                                    // output extra comments in generated code. FIXME: not yet configurable
     bool mapPreloaded = false;
+    bool loopCompression = false;                               // option backend_cc_loop_compression
 
     std::stringstream cccode;                                   // the code generated for the CC
 
+    // loop compression state: the code of the bundles of the current kernel is collected, and emitted by kernel_finish
+    std::stringstream programCode;                              // the code before the current bundle, while cccode collects the bundle
+    std::vector<tBundleCode> bundleCode;                        // [bundle within kernel]
+    bool inBundle = false;
+    std::string bundleSignature;
+    size_t bundleNrInstructions;
+    size_t firstBundleIdx;                                      // of the current kernel within the program, to make loop labels unique
+
     // codegen state
     std::vector<std::vector<tGroupInfo>> groupInfo;             // matrix[instrIdx][group]
-    json codewordTable;                                         // codewords versus signals per instrument group
+    std::unordered_map<std::string, std::vector<tCodewordGroup>> codewordTable;   // codewords versus signals per instrument group
+    std::string mapText;                                        // codewordTable serialized by program_finish, see getMap
     json inputLutTable;                                         // input LUT usage per instrument group
     size_t lastEndCycle[MAX_SLOTS];
 
@@ -118,15 +190,29 @@ private:    // vars
     const json *jsonInstruments;
     const json *jsonSignals;
 
+    // the JSON sections above compiled into tables, so that code generation doesn't walk JSON per gate or bundle
+    std::vector<tInstrumentInfo> instrumentInfo;                // [instrIdx]
+    std::map<std::string, std::vector<tSignalInfo>> signalInfo; // [signal type][qubit]: first instrument/group providing it
+    std::map<std::string, size_t> instructionIds;               // instruction name to index in instructionInfo
+    std::vector<tInstructionInfo> instructionInfo;
+
     const ql::quantum_platform *platform;
 
 #if OPT_VCD_OUTPUT
-    size_t kernelStartTime;
+    size_t kernelStartTime = 0;
     Vcd vcd;
     int vcdVarKernel;
-    std::vector<int> vcdVarQubit;
-    std::vector<std::vector<int>> vcdVarSignal;
-    std::vector<int> vcdVarCodeword;
+    std::vector<int> vcdVarQubit;                               // -1 if not recorded
+    std::vector<std::vector<int>> vcdVarSignal;                 // idem
+    std::vector<int> vcdVarCodeword;                            // idem
+
+    // what to record in the VCD (options backend_cc_vcd_*), empty sets select all
+    std::set<std::string> vcdInstruments;                       // instrument names, and instrument groups as '<name>-<group>'
+    std::set<std::string> vcdQubits;
+    std::set<std::string> vcdKernels;
+    size_t vcdFirstCycle = 0;                                   // within the kernel
+    size_t vcdLastCycle = SIZE_MAX;
+    bool vcdKernelSelected = true;                              // of the current kernel
 #endif
 
 private:    // funcs
@@ -140,7 +226,14 @@ private:    // funcs
     // helpers
     void latencyCompensation();
     void padToCycle(size_t lastEndCycle, size_t startCycle, int slot, const std::string &instrumentName);
+    void emitBundleLoops(const std::string &kernelName);
+#if OPT_VCD_OUTPUT
+    void loadVcdFilter();
+    void vcdChange(int var, size_t startCycle, size_t durationInNs, const std::string &value);
+#endif
     uint32_t assignCodeword(const std::string &instrumentName, int instrIdx, int group);
+    void loadCodewordTable(const json &table);
+    static json codewordGroupToJson(const tCodewordGroup &cwGroup);
 
     // Functions processing JSON
     void load_backend_settings();
@@ -150,6 +243,11 @@ private:    // funcs
     tSignalInfo findSignalInfoForQubit(const std::string &instructionSignalType, size_t qubit);
 
     tJsonNodeInfo findSignalDefinition(const json &instruction, const std::string &iname) const;
+
+    // lookups in the compiled tables
+    tInstructionInfo &getInstructionInfo(const std::string &iname);
+    const tSignalTarget &getSignalTarget(tSignalDef &sd, size_t qubit);
+    const tInstrumentInfo &getControlModeInfo(size_t instrIdx);
 }; // class
 
 #endif  // ndef ARCH_CC_CODEGEN_CC_H
@@ -26,8 +26,16 @@
 #include "eqasm_backend_cc.h"
 
 #include <options.h>
+#include <trace.h>
 #include <platform.h>
 #include <ir.h>
+
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <functional>
 // Including scheduler.h causes duplicate function definitions during make/linking;
 // instead of including it with its function bodies, declare those functions here and now ...
 // FIXME HvS create schedule.cc (but this waits until scheduler and mapper have been disentangled)
@@ -80,6 +88,45 @@ namespace ql
 namespace arch
 {
 
+// call work(k) for all k<count, concurrently on a thread per core if parallel.
+// Rethrows the exception of the lowest k that failed, as running them in order would
+static void for_each_kernel(size_t count, bool parallel, const std::function<void(size_t)> &work)
+{
+    if(!parallel) {
+        for(size_t k=0; k<count; k++) {
+            work(k);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> exceptions(count);
+    auto worker = [&]()
+    {
+        for(size_t k=next++; k<count; k=next++) {
+            try {
+                work(k);
+            } catch(...) {
+                exceptions[k] = std::current_exception();
+            }
+        }
+    };
+    size_t threadCount = std::min(count, size_t(std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::thread> threads;
+    for(size_t t=1; t<threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto &thread : threads) {
+        thread.join();
+    }
+    for(auto &exception : exceptions) {
+        if(exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
 // compile for Central Controller
 // NB: a new eqasm_backend_cc is instantiated per call to compile, so we don't need to cleanup
 void eqasm_backend_cc::compile(quantum_program* programp, const ql::quantum_platform &platform)
@@ -89,7 +136,6 @@ void eqasm_backend_cc::compile(quantum_program* programp, const ql::quantum_plat
     // init
     load_hw_settings(platform);
     codegen.init(platform);
-    bundleIdx = 0;
 
     // generate program header
     codegen.program_start(programp->unique_name);
@@ -104,21 +150,41 @@ void eqasm_backend_cc::compile(quantum_program* programp, const ql::quantum_plat
   // FIXME: plain old CClight scheduler
 #endif
 
-    for(auto &kernel : programp->kernels) {
-        IOUT("Compiling kernel: " << kernel.name);
-        codegen_kernel_prologue(kernel);
-
-        if (!kernel.c.empty()) {
-            ql::ir::bundles_t bundles = ql::ir::bundler(kernel.c, platform.cycle_time);
+    // kernels are generated concurrently if requested and possible, which doesn't change the code generated
+    bool parallel = ql::options::get("backend_cc_parallel_kernels") == "yes" && codegen.canForkKernels();
+    size_t nrKernels = programp->kernels.size();
 
-            codegen.kernel_start();
-            codegen_bundles(bundles, platform);
-            codegen.kernel_finish(kernel.name, bundles.back().start_cycle+bundles.back().duration_in_cycles);
-        } else {
-            DOUT("Empty kernel: " << kernel.name);                      // NB: normal situation for kernels with classical control
+    // bundle all kernels, and number their bundles and cycles in program order
+    std::vector<ql::ir::bundles_t> kernelBundles(nrKernels);
+    for_each_kernel(nrKernels, parallel, [&](size_t k) {
+        ql::quantum_kernel &kernel = programp->kernels[k];
+        if(!kernel.c.empty()) {
+            kernelBundles[k] = ql::ir::bundler(kernel.c, platform.cycle_time);
         }
+    });
+    std::vector<size_t> firstBundleIdx(nrKernels+1, 0);
+    std::vector<size_t> kernelStartCycle(nrKernels+1, 0);
+    for(size_t k=0; k<nrKernels; k++) {
+        const ql::ir::bundles_t &bundles = kernelBundles[k];
+        firstBundleIdx[k+1] = firstBundleIdx[k] + bundles.size();
+        kernelStartCycle[k+1] = kernelStartCycle[k] + (bundles.empty() ? 0 : bundles.back().start_cycle+bundles.back().duration_in_cycles);
+    }
 
-        codegen_kernel_epilogue(kernel);
+    if(parallel) {
+        std::vector<std::unique_ptr<codegen_cc>> kernelCodegens(nrKernels);
+        for_each_kernel(nrKernels, true, [&](size_t k) {
+            kernelCodegens[k].reset(new codegen_cc());
+            kernelCodegens[k]->kernel_fork(codegen, kernelStartCycle[k]);
+            codegen_kernel(*kernelCodegens[k], programp->kernels[k], kernelBundles[k], firstBundleIdx[k]);
+        });
+        for(size_t k=0; k<nrKernels; k++) {
+            codegen.kernel_join(*kernelCodegens[k]);
+            kernelCodegens[k].reset();
+        }
+    } else {
+        for(size_t k=0; k<nrKernels; k++) {
+            codegen_kernel(codegen, programp->kernels[k], kernelBundles[k], firstBundleIdx[k]);
+        }
     }
 
     codegen.program_finish(programp->unique_name);
@@ -184,9 +250,28 @@ std::string eqasm_backend_cc::kernelLabel(ql::quantum_kernel &k)
     return tokens[0];
 }
 
+// generate the code of kernel k, whose bundles are numbered from firstBundleIdx
+void eqasm_backend_cc::codegen_kernel(codegen_cc &codegen, ql::quantum_kernel &k, ql::ir::bundles_t &bundles, size_t firstBundleIdx)
+{
+    IOUT("Compiling kernel: " << k.name);
+    QL_TRACE_SPAN("kernel", "codegen", k.name);
+    codegen_kernel_prologue(codegen, k);
+
+    if (!k.c.empty()) {
+        codegen.kernel_start(k.name, firstBundleIdx);
+        codegen_bundles(codegen, bundles, firstBundleIdx);
+        codegen.kernel_finish(k.name, bundles.back().start_cycle+bundles.back().duration_in_cycles);
+    } else {
+        DOUT("Empty kernel: " << k.name);                      // NB: normal situation for kernels with classical control
+    }
+
+    codegen_kernel_epilogue(codegen, k);
+}
+
+
 // handle kernel conditionality at beginning of kernel
 // based on cc_light_eqasm_compiler.h::get_prologue
-void eqasm_backend_cc::codegen_kernel_prologue(ql::quantum_kernel &k)
+void eqasm_backend_cc::codegen_kernel_prologue(codegen_cc &codegen, ql::quantum_kernel &k)
 {
     codegen.comment(SS2S("### Kernel: '" << k.name << "'"));
 
@@ -240,7 +325,7 @@ void eqasm_backend_cc::codegen_kernel_prologue(ql::quantum_kernel &k)
 
 // handle kernel conditionality at end of kernel
 // based on cc_light_eqasm_compiler.h::get_epilogue
-void eqasm_backend_cc::codegen_kernel_epilogue(ql::quantum_kernel &k)
+void eqasm_backend_cc::codegen_kernel_epilogue(codegen_cc &codegen, ql::quantum_kernel &k)
 {
     switch(k.type) {
         case kernel_type_t::FOR_END:
@@ -281,9 +366,10 @@ void eqasm_backend_cc::codegen_kernel_epilogue(ql::quantum_kernel &k)
 
 
 // based on cc_light_eqasm_compiler.h::bundles2qisa()
-void eqasm_backend_cc::codegen_bundles(ql::ir::bundles_t &bundles, const ql::quantum_platform &platform)
+void eqasm_backend_cc::codegen_bundles(codegen_cc &codegen, ql::ir::bundles_t &bundles, size_t bundleIdx)
 {
     IOUT("Generating .vq1asm for bundles");
+    QL_TRACE_SPAN("backend", "codegen_bundles", (int64_t)bundles.size());
 
     for(ql::ir::bundle_t &bundle : bundles) {
         // generate bundle header
@@ -36,14 +36,14 @@ public:
 private:
     std::string kernelLabel(ql::quantum_kernel &k);
     void codegen_classical_instruction(ql::gate *classical_ins);
-    void codegen_kernel_prologue(ql::quantum_kernel &k);
-    void codegen_kernel_epilogue(ql::quantum_kernel &k);
-    void codegen_bundles(ql::ir::bundles_t &bundles, const ql::quantum_platform &platform);
+    void codegen_kernel(codegen_cc &codegen, ql::quantum_kernel &k, ql::ir::bundles_t &bundles, size_t firstBundleIdx);
+    void codegen_kernel_prologue(codegen_cc &codegen, ql::quantum_kernel &k);
+    void codegen_kernel_epilogue(codegen_cc &codegen, ql::quantum_kernel &k);
+    void codegen_bundles(codegen_cc &codegen, ql::ir::bundles_t &bundles, size_t bundleIdx);
     void load_hw_settings(const ql::quantum_platform &platform);
 
 private: // vars
     codegen_cc codegen;
-    int bundleIdx;
 }; // class
 
 } // arch
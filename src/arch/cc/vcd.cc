@@ -12,19 +12,31 @@
 #include "vcd.h"
 
 #include <iostream>
+#include <utility>
 
 
-void Vcd::start()
+Vcd::~Vcd()
 {
-    vcd << "$date today $end" << std::endl;
-    vcd << "$timescale 1 ns $end" << std::endl;
+    if(spillFile) {
+        std::fclose(spillFile);     // NB: a temporary file is removed when closed
+    }
+}
+
+
+void Vcd::start(const std::string &fileName)
+{
+    buffer.resize(BUFFER_SIZE);
+    vcd.rdbuf()->pubsetbuf(buffer.data(), buffer.size());   // NB: must precede open
+    vcd.open(fileName);
+    vcd << "$date today $end\n";
+    vcd << "$timescale 1 ns $end\n";
 }
 
 
 void Vcd::scope(tScopeType type, const std::string &name)
 {
     // FIXME: handle type
-    vcd << "$scope " << "module" << " " << name << " $end" << std::endl;
+    vcd << "$scope " << "module" << " " << name << " $end\n";
 }
 
 
@@ -33,33 +45,66 @@ int Vcd::registerVar(const std::string &name, tVarType type, tScopeType scope)
     // FIXME: incomplete
     const int width = 20;
 
-    vcd << "$var string " << width << " " << lastId << " " << name << " $end" << std::endl;
+    vcd << "$var string " << width << " " << lastId << " " << name << " $end\n";
 
     return lastId++;
 }
 
 void Vcd::upscope()
 {
-    vcd << "$upscope $end" << std::endl;
+    vcd << "$upscope $end\n";
+}
+
+
+// from now on, write the changes that are flushed to a temporary file from which merge() reads them back, so a kernel
+// generated without a file doesn't keep them all in memory. If no temporary file can be created they are kept
+void Vcd::spill()
+{
+    spillFile = std::tmpfile();
+}
+
+
+void Vcd::flush(int timestamp)
+{
+    write(timestampMap.lower_bound(timestamp));
 }
 
 
 void Vcd::finish()
 {
-    vcd << "$enddefinitions $end" << std::endl;
+    write(timestampMap.end());
+    vcd.close();
+}
 
-    for(auto &t: timestampMap) {
-        vcd << "#" << t.first << std::endl;      // timestamp
-        for(auto &v: t.second) {
-            vcd << "s" << v.second.strVal << " " << v.first << std::endl;
-        }
-    }
+
+bool Vcd::good() const
+{
+    return vcd.good();
 }
 
 
-std::string Vcd::getVcd()
+// write the changes up to end, and forget them
+void Vcd::write(tTimestampMap::iterator end)
 {
-    return vcd.str();
+    if(spillFile) {
+        writeSpill(end);
+        return;
+    }
+    if(!vcd.is_open()) {
+        return;
+    }
+    if(inDefinitions) {
+        vcd << "$enddefinitions $end\n";
+        inDefinitions = false;
+    }
+
+    for(auto t=timestampMap.begin(); t!=end; ++t) {
+        vcd << "#" << t->first << "\n";      // timestamp
+        for(auto &v: t->second) {
+            vcd << "s" << v.second.strVal << " " << v.first << "\n";
+        }
+    }
+    timestampMap.erase(timestampMap.begin(), end);
 }
 
 
@@ -106,3 +151,54 @@ void Vcd::change(int var, int timestamp, int value)
 {
     // FIXME
 }
+
+// write the changes up to end to the spill file as lines 'timestamp var value', and forget them
+void Vcd::writeSpill(tTimestampMap::iterator end)
+{
+    for(auto t=timestampMap.begin(); t!=end; ++t) {
+        for(auto &v: t->second) {
+            std::fprintf(spillFile, "%d %d %s\n", t->first, v.first, v.second.strVal.c_str());
+        }
+    }
+    timestampMap.erase(timestampMap.begin(), end);
+}
+
+
+// apply the changes spilled to file as if they were made after ours, streaming ours up to each timestamp read: the
+// spilled timestamps ascend, so only those of the last one are kept
+void Vcd::mergeSpill(std::FILE *file)
+{
+    std::rewind(file);
+    int timestamp;
+    int var;
+    while(std::fscanf(file, "%d %d", &timestamp, &var) == 2) {
+        std::fgetc(file);           // the separating space
+        std::string value;
+        for(int c=std::fgetc(file); c!=EOF && c!='\n'; c=std::fgetc(file)) {
+            value += char(c);
+        }
+        flush(timestamp);
+        change(var, timestamp, value);
+    }
+}
+
+
+// move the changes of other to us, as if they were made after ours
+void Vcd::merge(Vcd &other)
+{
+    if(other.spillFile) {
+        mergeSpill(other.spillFile);
+        std::fclose(other.spillFile);
+        other.spillFile = nullptr;
+    }
+    for(auto &t: other.timestampMap) {
+        if(timestampMap.empty() || t.first > timestampMap.rbegin()->first) {   // after our last timestamp, i.e. usually
+            timestampMap.emplace_hint(timestampMap.end(), t.first, std::move(t.second));
+        } else {
+            for(auto &v: t.second) {
+                change(v.first, t.first, v.second.strVal);
+            }
+        }
+    }
+    other.timestampMap.clear();
+}
@@ -4,14 +4,19 @@
  * @author Wouter Vlothuizen (wouter.vlothuizen@tno.nl)
  * @brief  generate Value Change Dump file for GTKWave viewer
  * @remark based on https://github.com/SanDisk-Open-Source/pyvcd/tree/master/vcd
+ * @note   changes are buffered until flush() is told that no earlier changes will follow, and then streamed to the
+ *         file passed to start(). Without a file they are kept, unless spill() moved them to a temporary file for
+ *         merge() (e.g. when generating a kernel to be merged later)
  */
 
 #ifndef _VCD_H
 #define _VCD_H
 
 #include <string>
-#include <sstream>
+#include <fstream>
+#include <vector>
 #include <map>
+#include <cstdio>
 
 class Vcd {
 public:
@@ -19,14 +24,18 @@ public:
     typedef enum { ST_MODULE } tScopeType;
 
 public:
-    void start();
+    ~Vcd();
+    void start(const std::string &fileName);
+    void spill();                                       // write the flushed changes to a temporary file, for merge()
     void scope(tScopeType type, const std::string &name);
     int registerVar(const std::string &name, tVarType type, tScopeType scope=ST_MODULE);
     void upscope();
     void change(int var, int timestamp, const std::string &value);
     void change(int var, int timestamp, int value);
+    void merge(Vcd &other);
+    void flush(int timestamp);                          // write the changes before timestamp
     void finish();
-    std::string getVcd();
+    bool good() const;
 
 private:
     typedef struct {
@@ -37,9 +46,19 @@ private:
     typedef std::map<int, tVarChangeMap> tTimestampMap; // map 'timestamp' to variables
 
 private:
-    int lastId;
-    tTimestampMap timestampMap;
-    std::stringstream vcd;
+    static const size_t BUFFER_SIZE = 1<<20;            // of the file
+
+    int lastId = 0;
+    tTimestampMap timestampMap;                         // the changes not yet written
+    std::vector<char> buffer;
+    std::ofstream vcd;
+    bool inDefinitions = true;
+    std::FILE *spillFile = nullptr;                     // the changes flushed while spilling
+
+private:
+    void write(tTimestampMap::iterator end);
+    void writeSpill(tTimestampMap::iterator end);
+    void mergeSpill(std::FILE *file);
 };
 
 #endif // ndef _VCD_H
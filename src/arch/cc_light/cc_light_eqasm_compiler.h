@@ -23,6 +23,11 @@
 #include <latency_compensation.h>
 #include <buffer_insertion.h>
 #include <qsoverlay.h>
+#include <trace.h>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
 
 // eqasm code : set of cc_light_eqasm instructions
 typedef std::vector<ql::arch::cc_light_eqasm_instr_t> eqasm_t;
@@ -44,124 +49,252 @@ typedef std::vector<qubit_pair_t>  qubit_pair_set_t;
 
 const size_t MAX_S_REG =32;
 const size_t MAX_T_REG =64;
-
-extern size_t CurrSRegCount;
-extern size_t CurrTRegCount;
+const size_t NO_MASK = SIZE_MAX;        // mask id of an instruction without qubit operands
 
 class Mask
 {
 public:
-    size_t regNo;
+    size_t regNo;                           // register holding the mask; of a mask that isn't pinned, the one it was loaded in last
     std::string regName;
-    qubit_set_t squbits;
-    qubit_pair_set_t dqubits;
+    qubit_set_t squbits;                    // the qubits of a smis mask
+    qubit_pair_set_t dqubits;               // the qubit pairs of a smit mask
+    size_t useCount = 0;                    // number of bundles using the mask
+    bool pinned = false;                    // loaded by the program's prologue and never evicted
 
     Mask() {}
 
-    Mask(qubit_set_t & qs) : squbits(qs)
+    Mask(qubit_set_t & qs) : squbits(qs) {}
+
+    Mask(qubit_pair_set_t & qps) : dqubits(qps) {}
+
+    bool isPairMask() const
     {
+        return !dqubits.empty();
+    }
 
-        if(CurrSRegCount < MAX_S_REG)
+    // the smis or smit instruction loading the mask in register regName
+    std::string instruction() const
+    {
+        std::stringstream ss;
+        if(isPairMask())
         {
-            regNo = CurrSRegCount++;
-            regName = "s" + std::to_string(regNo);
+            ss << "smit " << regName << ", {";
+            for(auto it = dqubits.begin(); it != dqubits.end(); ++it)
+            {
+                ss << "(" << it->first << ", " << it->second << ")";
+                if( std::next(it) != dqubits.end() )
+                    ss << ", ";
+            }
         }
         else
         {
-            COUT(" !!!! Handle cases requiring more registers");
+            ss << "smis " << regName << ", {";
+            for(auto it = squbits.begin(); it != squbits.end(); ++it)
+            {
+                ss << *it;
+                if( std::next(it) != squbits.end() )
+                    ss << ", ";
+            }
         }
+        ss << "}";
+        return ss.str();
     }
+};
 
-    Mask(std::string rn, qubit_set_t & qs ) : regName(rn), squbits(qs)
+// allocates the mask registers of the program to the masks used by its bundles, in two passes:
+// - first, addKernel and useMasks collect the masks used by each bundle of each kernel, after which allocate
+//   assigns registers: when all masks fit in the registers, all are loaded by the prologue (getMaskInstructions);
+//   otherwise the most used masks are, and the remaining registers are scratch registers
+// - then, per kernel, startKernel and loadMasks (for each bundle, in the same order) load the other masks in scratch
+//   registers before the bundle that uses them, reusing the register of a mask that isn't used any more in the
+//   kernel, or else the least recently used one. Scratch registers are assumed empty at the start of a kernel,
+//   because it can be entered from several kernels
+class MaskManager
+{
+private:
+    struct QubitSetHash
     {
-        if(CurrSRegCount < MAX_S_REG)
+        size_t operator()(const qubit_set_t & qs) const
         {
-            regNo = CurrSRegCount++;
+            size_t h = qs.size();
+            for(auto q : qs)
+            {
+                h = h*31 + q;
+            }
+            return h;
         }
-        else
+    };
+
+    struct QubitPairSetHash
+    {
+        size_t operator()(const qubit_pair_set_t & qps) const
         {
-            COUT(" !!!! Handle cases requiring more registers");
+            size_t h = qps.size();
+            for(auto & p : qps)
+            {
+                h = (h*31 + p.first)*31 + p.second;
+            }
+            return h;
         }
+    };
+
+    // the registers of one kind: s registers for smis masks, t registers for smit masks
+    struct RegisterFile
+    {
+        std::string prefix;
+        size_t size;
+        std::vector<size_t> masks;                  // ids of the masks of this kind, in order of creation
+        size_t maxBundleMasks = 0;                  // maximum number of different masks of this kind used by a bundle
+        std::vector<size_t> pinnedMasks;            // [register] for registers 0..pinnedMasks.size()-1
+        std::vector<size_t> content;                // [register] mask loaded in a scratch register, NO_MASK if none
+        std::vector<size_t> lastUse;                // [register] bundle of the kernel that used the scratch register last
+    };
+
+    std::vector<Mask> masks;                        // [mask id]
+    std::unordered_map<qubit_set_t,size_t,QubitSetHash> QS2Mask;
+    std::unordered_map<qubit_pair_set_t,size_t,QubitPairSetHash> QPS2Mask;
+    RegisterFile SRegs;
+    RegisterFile TRegs;
+
+    std::vector<std::unordered_map<size_t,size_t>> lastBundle;  // [kernel] mask id to the last bundle using it
+    size_t kernelIdx = 0;
+    size_t bundleIdx = 0;                           // within the kernel; bundles are counted from 1
+
+    RegisterFile & registerFile(const Mask & m)
+    {
+        return m.isPairMask() ? TRegs : SRegs;
+    }
+
+    size_t addMask(const Mask & m)
+    {
+        size_t id = masks.size();
+        masks.push_back(m);
+        registerFile(m).masks.push_back(id);
+        return id;
+    }
+
+    void pin(RegisterFile & rf, size_t id)
+    {
+        Mask & m = masks[id];
+        m.pinned = true;
+        m.regNo = rf.pinnedMasks.size();
+        m.regName = rf.prefix + std::to_string(m.regNo);
+        rf.pinnedMasks.push_back(id);
     }
 
-    Mask(qubit_pair_set_t & qps) : dqubits(qps)
+    void allocate(RegisterFile & rf)
     {
-        if(CurrTRegCount < MAX_T_REG)
+        if(rf.masks.size() <= rf.size)
         {
-            regNo = CurrTRegCount++;
-            regName = "t" + std::to_string(regNo);
+            // all masks fit, in order of creation
+            for(auto id : rf.masks)
+            {
+                pin(rf, id);
+            }
         }
         else
         {
-            COUT(" !!!! Handle cases requiring more registers");
+            if(rf.maxBundleMasks > rf.size)
+            {
+                FATAL("a bundle uses " << rf.maxBundleMasks << " different masks, but there are only " << rf.size
+                      << " " << rf.prefix << " registers");
+            }
+
+            // pin the most used masks, keeping at least maxBundleMasks (and a quarter of the) registers for the others
+            size_t nrScratch = std::max(rf.maxBundleMasks, rf.size/4);
+            std::vector<size_t> byUse;
+            for(auto id : rf.masks)
+            {
+                if(masks[id].useCount > 0)
+                {
+                    byUse.push_back(id);
+                }
+            }
+            std::stable_sort(byUse.begin(), byUse.end(),
+                [this](size_t id1, size_t id2) { return masks[id1].useCount > masks[id2].useCount; });
+            if(byUse.size() > rf.size)
+            {
+                byUse.resize(rf.size - nrScratch);
+            }
+            std::sort(byUse.begin(), byUse.end());
+            for(auto id : byUse)
+            {
+                pin(rf, id);
+            }
+            rf.content.assign(rf.size, NO_MASK);
+            rf.lastUse.assign(rf.size, 0);
+            IOUT(rf.masks.size() << " masks for " << rf.size << " " << rf.prefix << " registers: "
+                 << rf.pinnedMasks.size() << " loaded by the prologue, the others before the bundles using them");
         }
     }
 
-};
-
-class MaskManager
-{
-private:
-    std::map<size_t,Mask> SReg2Mask;
-    std::map<qubit_set_t,Mask> QS2Mask;
-
-    std::map<size_t,Mask> TReg2Mask;
-    std::map<qubit_pair_set_t,Mask> QPS2Mask;
+    // the scratch register to load a mask in for bundleIdx: an empty one, or else one holding a mask that is not used
+    // any more in the kernel, or else the least recently used one, which is not used by bundleIdx itself
+    size_t chooseRegister(RegisterFile & rf)
+    {
+        size_t best = NO_MASK;
+        for(size_t r=rf.pinnedMasks.size(); r<rf.size; r++)
+        {
+            size_t id = rf.content[r];
+            if(id == NO_MASK)
+            {
+                return r;
+            }
+            if(rf.lastUse[r] == bundleIdx)
+            {
+                continue;
+            }
+            auto it = lastBundle[kernelIdx].find(id);
+            if(it == lastBundle[kernelIdx].end() || it->second < bundleIdx)
+            {
+                return r;
+            }
+            if(best == NO_MASK || rf.lastUse[r] < rf.lastUse[best])
+            {
+                best = r;
+            }
+        }
+        CclAssert(best != NO_MASK);     // NB: allocate leaves at least maxBundleMasks scratch registers
+        return best;
+    }
 
 public:
     MaskManager()
     {
+        SRegs.prefix = "s";
+        SRegs.size = MAX_S_REG;
+        TRegs.prefix = "t";
+        TRegs.size = MAX_T_REG;
+
         // add pre-defined smis
         for(size_t i=0; i<7; ++i)
         {
             qubit_set_t qs;
             qs.push_back(i);
-            Mask m(qs);
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            getMaskId(qs);
         }
 
         // add some common single qubit masks
         {
             qubit_set_t qs;
             for(auto i=0; i<7; i++) qs.push_back(i);
-            Mask m(qs); // TODO add proper support for:  Mask m(qs, "all_qubits");
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            getMaskId(qs); // TODO add proper support for:  Mask m(qs, "all_qubits");
         }
 
         {
             qubit_set_t qs;
             qs.push_back(0); qs.push_back(1); qs.push_back(5); qs.push_back(6);
-            Mask m(qs); // TODO add proper support for:  Mask m(qs, "data_qubits");
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            getMaskId(qs); // TODO add proper support for:  Mask m(qs, "data_qubits");
         }
 
         {
             qubit_set_t qs;
             qs.push_back(2); qs.push_back(3); qs.push_back(4);
-            Mask m(qs); // TODO add proper support for:  Mask m(qs, "ancilla_qubits");
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            getMaskId(qs); // TODO add proper support for:  Mask m(qs, "ancilla_qubits");
         }
-
-
-        // qubit_pair_set_t pre_defined_edges = { {2,0}, {0,3}, {3,1}, {1,4}, {2,5}, {5,3}, {3,6}, {6,4},
-        //                                {0,2}, {3,0}, {1,3}, {4,1}, {5,2}, {3,5}, {6,3}, {4,6} };
-        // // add smit
-        // for(auto & p : pre_defined_edges)
-        // {
-        //     qubit_pair_set_t qps;
-        //     qps.push_back(p);
-        //     Mask m(qps);
-        //     QPS2Mask[qps] = m;
-        //     TReg2Mask[m.regNo] = m;
-        // }
-
     }
 
-    size_t getRegNo( qubit_set_t & qs )
+    size_t getMaskId( qubit_set_t & qs )
     {
         // sort qubit operands to avoid variation in order
         sort(qs.begin(), qs.end());
@@ -169,14 +302,12 @@ public:
         auto it = QS2Mask.find(qs);
         if( it == QS2Mask.end() )
         {
-            Mask m(qs);
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            it = QS2Mask.emplace(qs, addMask(Mask(qs))).first;
         }
-        return QS2Mask[qs].regNo;
+        return it->second;
     }
 
-    size_t getRegNo( qubit_pair_set_t & qps )
+    size_t getMaskId( qubit_pair_set_t & qps )
     {
         // sort qubit operands pair to avoid variation in order
         sort(qps.begin(), qps.end(), ql::utils::sort_pair_helper);
@@ -184,81 +315,104 @@ public:
         auto it = QPS2Mask.find(qps);
         if( it == QPS2Mask.end() )
         {
-            Mask m(qps);
-            QPS2Mask[qps] = m;
-            TReg2Mask[m.regNo] = m;
+            it = QPS2Mask.emplace(qps, addMask(Mask(qps))).first;
         }
-        return QPS2Mask[qps].regNo;
+        return it->second;
     }
 
-    std::string getRegName( qubit_set_t & qs )
+    // first pass: collect the masks used by the next kernel, and by its bundles
+    void addKernel()
     {
-        // sort qubit operands to avoid variation in order
-        sort(qs.begin(), qs.end());
+        lastBundle.emplace_back();
+        bundleIdx = 0;
+    }
 
-        auto it = QS2Mask.find(qs);
-        if( it == QS2Mask.end() )
+    void useMasks(const std::vector<size_t> & ids)
+    {
+        bundleIdx++;
+        size_t nrS = 0;
+        size_t nrT = 0;
+        for(size_t i=0; i<ids.size(); i++)
         {
-            Mask m(qs);
-            QS2Mask[qs] = m;
-            SReg2Mask[m.regNo] = m;
+            size_t id = ids[i];
+            if(id == NO_MASK || std::find(ids.begin(), ids.begin()+i, id) != ids.begin()+i)
+            {
+                continue;
+            }
+            masks[id].useCount++;
+            lastBundle.back()[id] = bundleIdx;
+            (masks[id].isPairMask() ? nrT : nrS)++;
         }
-        return QS2Mask[qs].regName;
+        SRegs.maxBundleMasks = std::max(SRegs.maxBundleMasks, nrS);
+        TRegs.maxBundleMasks = std::max(TRegs.maxBundleMasks, nrT);
     }
 
-    std::string getRegName( qubit_pair_set_t & qps )
+    void allocate()
     {
-        // sort qubit operands pair to avoid variation in order
-        sort(qps.begin(), qps.end(), ql::utils::sort_pair_helper);
+        allocate(SRegs);
+        allocate(TRegs);
+    }
 
-        auto it = QPS2Mask.find(qps);
-        if( it == QPS2Mask.end() )
-        {
-            Mask m(qps);
-            QPS2Mask[qps] = m;
-            TReg2Mask[m.regNo] = m;
-        }
-        return QPS2Mask[qps].regName;
+    // second pass: start generating kernel k; loadMasks returns the smis/smit instructions loading the masks of its
+    // next bundle that are not loaded yet
+    void startKernel(size_t k)
+    {
+        kernelIdx = k;
+        bundleIdx = 0;
+        std::fill(SRegs.content.begin(), SRegs.content.end(), NO_MASK);
+        std::fill(TRegs.content.begin(), TRegs.content.end(), NO_MASK);
     }
 
-    std::string getMaskInstructions()
+    std::string loadMasks(const std::vector<size_t> & ids)
     {
-        std::stringstream ssmasks;
-        for(size_t r=0; r<CurrSRegCount; ++r)
+        bundleIdx++;
+        std::stringstream ss;
+        for(auto id : ids)
         {
-            auto & m = SReg2Mask[r];
-            ssmasks << "smis " << m.regName << ", {";
-            for(auto it = m.squbits.begin(); it != m.squbits.end(); ++it)
+            if(id == NO_MASK || masks[id].pinned)
             {
-                ssmasks << *it;
-                if( std::next(it) != m.squbits.end() )
-                    ssmasks << ", ";
+                continue;
             }
-            ssmasks << "} \n";
-        }
-
-        for(size_t r=0; r<CurrTRegCount; ++r)
-        {
-            auto & m = TReg2Mask[r];
-            ssmasks << "smit " << m.regName << ", {";
-            for(auto it = m.dqubits.begin(); it != m.dqubits.end(); ++it)
+            Mask & m = masks[id];
+            RegisterFile & rf = registerFile(m);
+            auto it = std::find(rf.content.begin(), rf.content.end(), id);
+            size_t r;
+            if(it != rf.content.end())
             {
-                ssmasks << "(" << it->first << ", " << it->second << ")";
-                if( std::next(it) != m.dqubits.end() )
-                    ssmasks << ", ";
+                r = it - rf.content.begin();
             }
-            ssmasks << "} \n";
+            else
+            {
+                r = chooseRegister(rf);
+                rf.content[r] = id;
+                m.regNo = r;
+                m.regName = rf.prefix + std::to_string(r);
+                ss << "    " << m.instruction() << "\n";
+            }
+            rf.lastUse[r] = bundleIdx;
         }
-
-        return ssmasks.str();
+        return ss.str();
     }
 
-    ~MaskManager()
+    std::string getRegName( size_t id )
     {
-        CurrSRegCount=0;
-        CurrTRegCount=0;
+        return masks[id].regName;
     }
 
+    // the smis/smit instructions of the prologue, loading the pinned masks
+    std::string getMaskInstructions()
+    {
+        std::stringstream ssmasks;
+        for(auto id : SRegs.pinnedMasks)
+        {
+            ssmasks << masks[id].instruction() << " \n";
+        }
+        for(auto id : TRegs.pinnedMasks)
+        {
+            ssmasks << masks[id].instruction() << " \n";
+        }
+        return ssmasks.str();
+    }
 };
 
 
@@ -444,11 +598,9 @@ inline std::string get_cc_light_instruction_name(std::string & id, const ql::qua
     return cc_light_instr_name;
 }
 
-static std::string ir2qisa(quantum_kernel & kernel,
-    const ql::quantum_platform & platform, MaskManager & gMaskManager)
+// bundle the kernel, with the parallel instructions of the same type in one section, which will become a SIMD
+static ql::ir::bundles_t ir2bundles(quantum_kernel & kernel, const ql::quantum_platform & platform)
 {
-    IOUT("Generating CC-Light QISA");
-
     ql::ir::bundles_t   bundles1;
     CclAssert(kernel.cycles_valid);
     bundles1 = ql::ir::bundler(kernel.c, platform.cycle_time);
@@ -540,12 +692,74 @@ static std::string ir2qisa(quantum_kernel & kernel,
                 return iname2 < iname1;
             });
     }
+    return bundles2;
+}
+
+// the mask of the operands of the instructions in section sec, which will become a SIMD;
+// NO_MASK for a classical or nop instruction
+static size_t section2mask(ql::ir::section_t & sec, MaskManager & gMaskManager)
+{
+    qubit_set_t squbits;
+    qubit_pair_set_t dqubits;
+    auto firstInsIt = sec.begin();
+    auto itype = (*(firstInsIt))->type();
+    if(__classical_gate__ == itype || __nop_gate__ == itype)
+    {
+        return NO_MASK;
+    }
+
+    auto nOperands = ((*firstInsIt)->operands).size();
+    for(auto insIt = sec.begin(); insIt != sec.end(); ++insIt )
+    {
+        if( 1 == nOperands )
+        {
+            auto & op = (*insIt)->operands[0];
+            squbits.push_back(op);
+        }
+        else if( 2 == nOperands )
+        {
+            auto & op1 = (*insIt)->operands[0];
+            auto & op2 = (*insIt)->operands[1];
+            dqubits.push_back( qubit_pair_t(op1, op2) );
+        }
+        else
+        {
+            throw ql::exception("Error : only 1 and 2 operand instructions are supported by cc light masks !",false);
+        }
+    }
+
+    if(1 == nOperands)
+    {
+        return gMaskManager.getMaskId(squbits);
+    }
+    else
+    {
+        return gMaskManager.getMaskId(dqubits);
+    }
+}
+
+// the masks of the sections of a bundle
+static std::vector<size_t> bundle2masks(ql::ir::bundle_t & abundle, MaskManager & gMaskManager)
+{
+    std::vector<size_t> masks;
+    for(auto & sec : abundle.parallel_sections)
+    {
+        masks.push_back(section2mask(sec, gMaskManager));
+    }
+    return masks;
+}
+
+// generate the qisa of the bundles of a kernel, after gMaskManager allocated the mask registers of the program
+static std::string bundles2qisa(ql::ir::bundles_t & bundles2,
+    const ql::quantum_platform & platform, MaskManager & gMaskManager)
+{
+    IOUT("Generating CC-Light QISA");
 
     // And now generate qisa
     // each section of a bundle will become a SIMD (all operations in a section are the same, see above)
     // for the operands of the SIMD, a mask will be used
     //
-    // kernel prologue (start label) and epilogue are generated by the caller or ir2qisa
+    // kernel prologue (start label) and epilogue are generated by the caller
     std::stringstream ssqisa;   // output qisa in here
     size_t curr_cycle=0; // first instruction should be with pre-interval 1, 'bs 1' FIXME HvS start in cycle 0
     for (ql::ir::bundle_t & abundle : bundles2)
@@ -561,11 +775,12 @@ static std::string ir2qisa(quantum_kernel & kernel,
             sspre << "    qwait " << delta-1 << "\n"
                   << "    1    ";
 
+        std::vector<size_t> masks = bundle2masks(abundle, gMaskManager);
+        std::string ssload = gMaskManager.loadMasks(masks);
+        size_t secIdx = 0;
         for(auto secIt = abundle.parallel_sections.begin();
-            secIt != abundle.parallel_sections.end(); ++secIt )
+            secIt != abundle.parallel_sections.end(); ++secIt, ++secIdx )
         {
-            qubit_set_t squbits;
-            qubit_pair_set_t dqubits;
             auto firstInsIt = secIt->begin();
             iname = (*(firstInsIt))->name;
             auto itype = (*(firstInsIt))->type();
@@ -579,47 +794,13 @@ static std::string ir2qisa(quantum_kernel & kernel,
             {
                 DOUT("get cclight instr name for : " << iname);
                 std::string cc_light_instr_name = get_cc_light_instruction_name(iname, platform);
-                auto nOperands = ((*firstInsIt)->operands).size();
                 if( itype == __nop_gate__ )
                 {
                     ssinst << cc_light_instr_name;
                 }
                 else
                 {
-                    for(auto insIt = secIt->begin(); insIt != secIt->end(); ++insIt )
-                    {
-                        if( 1 == nOperands )
-                        {
-                            auto & op = (*insIt)->operands[0];
-                            squbits.push_back(op);
-                        }
-                        else if( 2 == nOperands )
-                        {
-                            auto & op1 = (*insIt)->operands[0];
-                            auto & op2 = (*insIt)->operands[1];
-                            dqubits.push_back( qubit_pair_t(op1, op2) );
-                        }
-                        else
-                        {
-                            throw ql::exception("Error : only 1 and 2 operand instructions are supported by cc light masks !",false);
-                        }
-                    }
-
-                    std::string rname;
-                    if(1 == nOperands)
-                    {
-                        rname = gMaskManager.getRegName(squbits);
-                    }
-                    else if(2 == nOperands)
-                    {
-                        rname = gMaskManager.getRegName(dqubits);
-                    }
-                    else
-                    {
-                        throw ql::exception("Error : only 1 and 2 operand instructions are supported by cc light masks !",false);
-                    }
-
-                    ssinst << cc_light_instr_name << " " << rname;
+                    ssinst << cc_light_instr_name << " " << gMaskManager.getRegName(masks[secIdx]);
                 }
             }
 
@@ -628,6 +809,7 @@ static std::string ir2qisa(quantum_kernel & kernel,
                 ssinst << " | ";
             }
         }
+        ssqisa << ssload;   // masks that are not loaded by the prologue, see MaskManager
         if(classical_bundle)
         {
             if(iname == "fmr")
@@ -936,12 +1118,14 @@ public:
         std::ofstream   ofs;
         ofs = ql::report_open(programp, "out", passname);
 
+        double  mapbudget = std::stod(ql::options::get("mapbudget"));    // for reporting the achieved lookahead depth
         size_t  total_swaps = 0;        // for reporting, data is mapper specific
         size_t  total_moves = 0;        // for reporting, data is mapper specific
         double  total_timetaken = 0.0;  // total over kernels of time taken by mapper
         for(auto &kernel : programp->kernels)
         {
             IOUT("Mapping kernel: " << kernel.name);
+            QL_TRACE_SPAN("kernel", "map", kernel.name);
 
             // compute timetaken, start interval timer here
             double    timetaken = 0.0;
@@ -969,6 +1153,14 @@ public:
             ss << "# ----- realqubit states before mapper:" << ql::utils::to_string(mapper.rs_in) << "\n";
             ss << "# ----- realqubit states after mapper:" << ql::utils::to_string(mapper.rs_out) << "\n";
             ss << "# ----- time taken: " << timetaken << "\n";
+            if (mapbudget > 0.0)
+            {
+                ss << "# ----- routing decisions: " << mapper.ndecisions << "\n";
+                ss << "# ----- alternative selections (search nodes expanded): " << mapper.nexpansions << "\n";
+                ss << "# ----- lookahead depth achieved min/avg/max: " << mapper.mindepth << "/"
+                   << (mapper.ndecisions ? mapper.sumdepth / mapper.ndecisions : 0.0) << "/" << mapper.maxdepth << "\n";
+                ss << "# ----- time taken by routing decisions (ms): " << mapper.budgetused << " of budget " << mapbudget << "\n";
+            }
             ql::report_string(ofs, ss.str());
 
             total_swaps += mapper.nswapsadded;
@@ -1151,12 +1343,15 @@ public:
             return;
         }
         ql::circuit decomp_ckt;	// collect result circuit in here and before return swap with kernel.c
+        bool modified = false;  // the kernel changes when a gate is renamed or decomposed
 
         DOUT("decomposing instructions...");
         for( auto ins : kernel.c )
         {
             auto & iname =  ins->name;
+            std::string original_iname = iname;
             str::lower_case(iname);
+            modified = modified || iname != original_iname;
             DOUT("decomposing instruction " << iname << "...");
             auto & icopers = ins->creg_operands;
             auto & iqopers = ins->operands;
@@ -1266,6 +1461,10 @@ public:
                 }
             }
         }
+        if (modified || decomp_ckt != kernel.c)
+        {
+            kernel.set_modified();
+        }
         kernel.c = decomp_ckt;;
 
         DOUT("decomposing instructions...[Done]");
@@ -1276,15 +1475,36 @@ public:
     void qisa_code_generation(quantum_program* programp, const ql::quantum_platform& platform, std::string passname)
     {
         MaskManager mask_manager;
+
+        // bundle all kernels and collect the masks they use, to allocate the mask registers before generating code
+        std::vector<ql::ir::bundles_t> kernel_bundles(programp->kernels.size());
+        for(size_t k=0; k<programp->kernels.size(); k++)
+        {
+            auto &kernel = programp->kernels[k];
+            mask_manager.addKernel();
+            if (! kernel.c.empty())
+            {
+                kernel_bundles[k] = ir2bundles(kernel, platform);
+                for (ql::ir::bundle_t & abundle : kernel_bundles[k])
+                {
+                    mask_manager.useMasks(bundle2masks(abundle, mask_manager));
+                }
+            }
+        }
+        mask_manager.allocate();
+
         std::stringstream ssqisa, sskernels_qisa;
         sskernels_qisa << "start:" << std::endl;
-        for(auto &kernel : programp->kernels)
+        for(size_t k=0; k<programp->kernels.size(); k++)
         {
+            auto &kernel = programp->kernels[k];
+            QL_TRACE_SPAN("backend", "qisa_code_generation", kernel.name);
             sskernels_qisa << "\n" << kernel.name << ":" << std::endl;
             sskernels_qisa << get_qisa_prologue(kernel);
             if (! kernel.c.empty())
             {
-                sskernels_qisa << ir2qisa(kernel, platform, mask_manager);
+                mask_manager.startKernel(k);
+                sskernels_qisa << bundles2qisa(kernel_bundles[k], platform, mask_manager);
             }
             sskernels_qisa << get_qisa_epilogue(kernel);
         }
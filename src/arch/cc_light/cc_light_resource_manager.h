@@ -47,6 +47,18 @@ inline std::string ccl_get_operation_type(ql::gate *ins, const ql::quantum_platf
     return operation_type;
 }
 
+// the first start cycle from op_start_cycle in direction dir at which an operation doesn't conflict with a resource that,
+// when forward scheduling, is busy till cycle bound, and, when backward scheduling, is busy from cycle bound;
+// when backward, 0 is returned when there is no such cycle
+inline size_t ccl_first_start_cycle(scheduling_direction_t dir, size_t op_start_cycle, size_t operation_duration, size_t bound)
+{
+    if (forward_scheduling == dir)
+    {
+        return std::max(op_start_cycle, bound);
+    }
+    return std::min(op_start_cycle, bound >= operation_duration ? bound - operation_duration : 0);
+}
+
 // operation name is used to know which operations are the same when one qwg steers several qubits using the vsm
 inline std::string ccl_get_operation_name(ql::gate *ins, const ql::quantum_platform &platform)
 {
@@ -116,6 +128,17 @@ public:
         return true;
     }
 
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        size_t      operation_duration = ccl_get_operation_duration(ins, platform);
+
+        for( auto q : ins->operands )
+        {
+            op_start_cycle = ccl_first_start_cycle(direction, op_start_cycle, operation_duration, state[q]);
+        }
+        return op_start_cycle;
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         std::string operation_type = ccl_get_operation_type(ins, platform);
@@ -213,6 +236,27 @@ public:
         return true;
     }
 
+    // a qwg busy with the same operation can be shared from the start of that operation (forward)
+    // or till its end (backward); otherwise, the operation must wait until the qwg is free
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        std::string operation_type = ccl_get_operation_type(ins, platform);
+        std::string operation_name = ccl_get_operation_name(ins, platform);
+        size_t      operation_duration = ccl_get_operation_duration(ins, platform);
+
+        if( operation_type == "mw" )
+        {
+            for( auto q : ins->operands )
+            {
+                size_t  qwg = qubit2qwg[q];
+                bool    same = (operations[qwg] == operation_name);
+                size_t  bound = (forward_scheduling == direction) == same ? fromcycle[qwg] : tocycle[qwg];
+                op_start_cycle = ccl_first_start_cycle(direction, op_start_cycle, operation_duration, bound);
+            }
+        }
+        return op_start_cycle;
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         std::string operation_type = ccl_get_operation_type(ins, platform);
@@ -337,6 +381,46 @@ public:
         return true;
     }
 
+    // a measurement unit is available in the cycle its last measurement started, and once it is free;
+    // since that is not monotonic in the start cycle, iterate over the operands until all agree
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        std::string operation_type = ccl_get_operation_type(ins, platform);
+        size_t      operation_duration = ccl_get_operation_duration(ins, platform);
+
+        if( operation_type == "readout" )
+        {
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                for(auto q : ins->operands)
+                {
+                    size_t  meas = qubit2meas[q];
+                    size_t  c;
+                    if (op_start_cycle == fromcycle[meas])
+                    {
+                        c = op_start_cycle;
+                    }
+                    else if (forward_scheduling == direction)
+                    {
+                        c = (op_start_cycle < fromcycle[meas] ? fromcycle[meas] : std::max(op_start_cycle, tocycle[meas]));
+                    }
+                    else
+                    {
+                        c = (op_start_cycle > fromcycle[meas] ? fromcycle[meas] : ccl_first_start_cycle(direction, op_start_cycle, operation_duration, fromcycle[meas]));
+                    }
+                    if (c != op_start_cycle)
+                    {
+                        op_start_cycle = c;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return op_start_cycle;
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         std::string operation_type = ccl_get_operation_type(ins, platform);
@@ -482,6 +566,23 @@ public:
         return true;
     }
 
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        if (available(op_start_cycle, ins, platform))   // also checks the operands
+        {
+            return op_start_cycle;
+        }
+        size_t      operation_duration = ccl_get_operation_duration(ins, platform);
+
+        auto edge_no = qubits2edge[qubits_pair_t(ins->operands[0], ins->operands[1])];
+        op_start_cycle = ccl_first_start_cycle(direction, op_start_cycle, operation_duration, state[edge_no]);
+        for(auto & e : edge2edges[edge_no])
+        {
+            op_start_cycle = ccl_first_start_cycle(direction, op_start_cycle, operation_duration, state[e]);
+        }
+        return op_start_cycle;
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         std::string operation_type = ccl_get_operation_type(ins, platform);
@@ -714,6 +815,36 @@ public:
         return true;
     }
 
+    // the qubits a two-qubit flux gate detunes, and the qubit of a rotation, are shared with operations
+    // of the same type from the start of those (forward) or till their end (backward);
+    // otherwise, the operation must wait until the qubit is free
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        if (available(op_start_cycle, ins, platform))   // also checks the operands
+        {
+            return op_start_cycle;
+        }
+        std::string operation_type = ccl_get_operation_type(ins, platform);
+        size_t      operation_duration = ccl_get_operation_duration(ins, platform);
+
+        std::vector<size_t> qubits;
+        if (operation_type == "flux")
+        {
+            qubits = edge_detunes_qubits[qubitpair2edge[qubits_pair_t(ins->operands[0], ins->operands[1])]];
+        }
+        else
+        {
+            qubits = ins->operands;
+        }
+        for( auto q : qubits )
+        {
+            bool    same = (operations[q] == operation_type);
+            size_t  bound = (forward_scheduling == direction) == same ? fromcycle[q] : tocycle[q];
+            op_start_cycle = ccl_first_start_cycle(direction, op_start_cycle, operation_duration, bound);
+        }
+        return op_start_cycle;
+    }
+
     // A two-qubit flux gate must set the qubits it would detune to detuned, busy with a flux gate.
     // A one-qubit rotation gate must set its operand qubit to busy, busy with a rotation.
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
@@ -10,6 +10,7 @@
 #include "kernel.h"
 
 #include "clifford.h"
+#include "trace.h"
 
 
 namespace ql
@@ -26,6 +27,31 @@ public:
         ct = kernel.cycle_time;
         DOUT("Clifford " << passname << " on kernel " << kernel.name << " ...");
 
+        // a change of the kernel includes invalidating its cycles
+        bool    was_cycles_valid = kernel.cycles_valid;
+
+        // without unary clifford gates the output would equal the input;
+        // then save copying the circuit
+        bool    has_cliffords = false;
+        for (auto gp: kernel.c)
+        {
+            if (gp->type() != ql::gate_type_t::__classical_gate__
+                && gp->operands.size() == 1
+                && string2cs(gp->name) != -1
+               )
+            {
+                has_cliffords = true;
+                break;
+            }
+        }
+        if (!has_cliffords)
+        {
+            DOUT("Clifford " << passname << " on kernel " << kernel.name << " found no cliffords [DONE]");
+            if (was_cycles_valid) kernel.set_modified();
+            kernel.cycles_valid = false;
+            return;
+        }
+
         // copy circuit kernel.c to take input from;
         // output will fill kernel.c again
         ql::circuit input_circuit = kernel.c;
@@ -116,6 +142,7 @@ public:
             DOUT("... gate: " << gp->qasm() << " DONE");
         }
         sync_all(kernel);
+        if (was_cycles_valid || !same_gates(input_circuit, kernel.c)) kernel.set_modified();
 	    kernel.cycles_valid = false;
 
         DOUT("Clifford " << passname << " on kernel " << kernel.name << " saved " << total_saved << " cycles [DONE]");
@@ -128,6 +155,17 @@ private:
     std::vector<size_t> cliffcycles;                   // current accumulated clifford cycles per qubit
     size_t  total_saved;                               // total number of cycles saved per kernel
 
+    // whether both circuits have the same gates (by name and operands) in the same order
+    bool same_gates(const ql::circuit& c1, const ql::circuit& c2)
+    {
+        if (c1.size() != c2.size()) return false;
+        for (size_t i = 0; i < c1.size(); i++)
+        {
+            if (c1[i]->name != c2[i]->name || c1[i]->operands != c2[i]->operands) return false;
+        }
+        return true;
+    }
+
     // create gate sequences for all accumulated cliffords, output them and reset state
     void sync_all(quantum_kernel& k)
     {
@@ -296,10 +334,20 @@ private:
         Clifford cliff;
         for(auto &kernel : programp->kernels)
         {
+            QL_TRACE_SPAN("kernel", "clifford_optimize", kernel.name);
             cliff.clifford_optimize_kernel(kernel, platform, passname);
         }
 
         ql::report_statistics(programp, platform, "out", passname, "# ");
         ql::report_qasm(programp, platform, "out", passname);
     }
+
+    void clifford_report(quantum_program* programp, const ql::quantum_platform& platform, std::string passname)
+    {
+        DOUT("Clifford optimization on program " << programp->name << " at " << passname << " avoided, reporting only");
+        ql::report_statistics(programp, platform, "in", passname, "# ");
+        ql::report_qasm(programp, platform, "in", passname);
+        ql::report_statistics(programp, platform, "out", passname, "# ");
+        ql::report_qasm(programp, platform, "out", passname);
+    }
 }
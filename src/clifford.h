@@ -18,6 +18,12 @@ namespace ql
  * clifford sequence optimizer
  */
     void clifford_optimize(quantum_program* programp, const ql::quantum_platform& platform, std::string passname);
+
+/*
+ * the in and out reports of clifford_optimize of a program that it leaves unchanged,
+ * for when the PassManager avoids running it again on its own output
+ */
+    void clifford_report(quantum_program* programp, const ql::quantum_platform& platform, std::string passname);
 }
 
 #endif // CLIFFORD_H
@@ -19,15 +19,16 @@ namespace ql
         {
             auto g = *cit;
             ql::gate_type_t gtype = g->type();
-            std::vector<size_t> goperands = g->operands;
-
-            ql::quantum_kernel toff_kernel("toff_kernel");
-            toff_kernel.instruction_map = kernel.instruction_map;
-            toff_kernel.qubit_count = kernel.qubit_count;
-            toff_kernel.cycle_time = kernel.cycle_time;
 
             if( __toffoli_gate__ == gtype )
             {
+                std::vector<size_t> goperands = g->operands;
+
+                ql::quantum_kernel toff_kernel("toff_kernel");
+                toff_kernel.instruction_map = kernel.instruction_map;
+                toff_kernel.qubit_count = kernel.qubit_count;
+                toff_kernel.cycle_time = kernel.cycle_time;
+
                 size_t cq1 = goperands[0];
                 size_t cq2 = goperands[1];
                 size_t tq = goperands[2];
@@ -44,6 +45,7 @@ namespace ql
                 cit = kernel.c.erase(cit);
                 cit = kernel.c.insert(cit, toff_ckt.begin(), toff_ckt.end());
                 kernel.cycles_valid = false;
+                kernel.set_modified();
             }
         }
         DOUT("decompose_toffoli() [Done] ");
@@ -1121,6 +1121,34 @@ public:
     }
 };
 
+// node of the dependence graph representing a list of commuting gates, see Scheduler::add_group
+class GROUP final : public gate
+{
+public:
+    cmat_t m;
+
+    GROUP() : m(nop_c)
+    {
+        name = "GROUP";
+        duration = 0;
+    }
+
+    instruction_t qasm()
+    {
+        return instruction_t("GROUP");
+    }
+
+    gate_type_t type()
+    {
+        return __dummy_gate__;
+    }
+
+    cmat_t mat()
+    {
+        return m;
+    }
+};
+
 class display : public gate
 {
 public:
@@ -0,0 +1,624 @@
+/**
+ * @file   initial_place.cc
+ * @date   10/2020
+ * @brief  solvers of the quadratic assignment problem of initial placement
+ */
+
+#include <initial_place.h>
+#include <utils.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#ifdef INITIALPLACE
+#include <lemon/lp.h>
+#if defined(LEMON_HAVE_GLPK) && LEMON_DEFAULT_MIP == _LEMON_GLPK
+#include <glpk.h>
+#define MIP_CANCELLABLE
+#endif
+#endif
+
+namespace ql
+{
+namespace initial_place
+{
+    static const size_t NO_FACILITY = size_t(-1);
+
+    size_t cost(const problem_t &problem, const std::vector<size_t> &loc)
+    {
+        size_t  c = 0;
+        for (size_t i = 0; i < problem.nfac; i++)
+        {
+            for (size_t j = 0; j < problem.nfac; j++)
+            {
+                c += problem.refcount[i][j] * problem.distance[loc[i]][loc[j]];
+            }
+        }
+        return c;
+    }
+
+// =========================================================================================
+// MIP
+// the article "An algorithm for the quadratic assignment problem using Benders' decomposition"
+// by L. Kaufman and F. Broeckx, transforms the problem by introducing w[i][k] as follows:
+//
+// forall i: forall k: w[i][k] =  x[i][k] * ( sum j: sum l: refcount[i][j] * distance(k,l) * x[j][l] )
+//
+// to the following mixed integer linear problem:
+//
+//  precompute:
+//      forall i: forall k: costmax[i][k] = sum j: sum l: refcount[i][j] * distance(k,l)
+//      (note: each of these costmax[][] is >= 0, so the "max(this,0)" around this is not needed)
+//  variables:
+//      forall i: forall k: x[i][k], x[i][k] is integral and 0 or 1, meaning facility i is in location k
+//      forall i: forall k: w[i][k], w[i][k] is real and >= 0
+//  objective:
+//      min z = sum i: sum k: w[i][k]
+//  subject to:
+//      forall k: ( sum i: x[i][k] <= 1 )       allow more locations than facilities
+//      forall i: ( sum k: x[i][k] == 1 )       but each facility must have one location
+//      forall i: forall k: costmax[i][k] * x[i][k]
+//          + ( sum j: sum l: refcount[i][j]*distance(k,l)*x[j][l] ) - w[i][k] <= costmax[i][k]
+//
+// This model is coded in lemon/mip below.
+// The latter is mapped onto glpk.
+// lemon's Mip::solve can't be interrupted, so when it is glpk's, glpk is called directly instead
+// with a callback that terminates the branch-and-bound search when cancelled;
+// glpk then keeps the best integer feasible solution found until then, the incumbent.
+
+#ifdef INITIALPLACE
+    bool mip_supported()
+    {
+        return true;
+    }
+
+#ifdef MIP_CANCELLABLE
+    bool mip_cancellable()
+    {
+        return true;
+    }
+
+    // called by glpk during the branch-and-bound search
+    static void mip_callback(glp_tree *tree, void *info)
+    {
+        const cancellation_t *cancellation = static_cast<const cancellation_t *>(info);
+        if (cancellation != nullptr && cancellation->is_cancelled())
+        {
+            glp_ios_terminate(tree);
+        }
+    }
+
+    // as lemon's GlpkMip::solve but cancellable
+    static solution_t mip_solve(lemon::GlpkMip &mip, const cancellation_t *cancellation)
+    {
+        glp_prob *lp = mip.lpx();
+
+        glp_smcp smcp;
+        glp_init_smcp(&smcp);
+        smcp.msg_lev = GLP_MSG_OFF;
+        smcp.meth = GLP_DUAL;
+        switch (glp_simplex(lp, &smcp))
+        {
+        case 0:
+            break;
+        case GLP_EBADB:
+        case GLP_ESING:
+        case GLP_ECOND:
+            glp_adv_basis(lp, 0);
+            if (glp_simplex(lp, &smcp) != 0) return solution_none;
+            break;
+        default:
+            return solution_none;
+        }
+        if (glp_get_status(lp) != GLP_OPT)
+        {
+            return solution_none;
+        }
+
+        glp_iocp iocp;
+        glp_init_iocp(&iocp);
+        iocp.msg_lev = GLP_MSG_OFF;
+        iocp.cb_func = mip_callback;
+        iocp.cb_info = const_cast<cancellation_t *>(cancellation);
+        int ret = glp_intopt(lp, &iocp);
+        int status = glp_mip_status(lp);
+        if (ret == 0 && status == GLP_OPT)
+        {
+            return solution_optimal;
+        }
+        if (status == GLP_OPT || status == GLP_FEAS)
+        {
+            DOUT("InitialPlace: MIP stopped before completion (glp_intopt returned " << ret << "), using its incumbent");
+            return solution_feasible;
+        }
+        return solution_none;
+    }
+#else // ifdef MIP_CANCELLABLE
+    bool mip_cancellable()
+    {
+        return false;
+    }
+#endif // ifdef MIP_CANCELLABLE
+
+    solution_t solve_mip(const problem_t &problem, std::vector<size_t> &loc, const cancellation_t *cancellation)
+    {
+        using lemon::Mip;
+        QL_TRACE_SPAN("mapper", "initialplace_mip");
+        size_t  nfac = problem.nfac;
+        size_t  nlocs = problem.nlocs;
+        auto   &refcount = problem.refcount;
+        auto   &distance = problem.distance;
+
+        // precompute costmax by applying formula
+        // costmax[i][k] = sum j: sum l: refcount[i][j] * distance(k,l) for facility i in location k
+        DOUT("... precompute costmax by combining refcount and distances");
+        std::vector<std::vector<size_t>>  costmax;
+        costmax.resize(nfac); for (size_t i=0; i<nfac; i++) costmax[i].resize(nlocs,0);
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            for ( size_t k=0; k<nlocs; k++ )
+            {
+                for ( size_t j=0; j<nfac; j++ )
+                {
+                    for ( size_t l=0; l<nlocs; l++ )
+                    {
+                        costmax[i][k] += refcount[i][j] * (distance[k][l] - 1);
+                    }
+                }
+            }
+        }
+
+        // the problem
+        // mixed integer programming
+        Mip  mip;
+
+        // variables (columns)
+        //  x[i][k] are integral, values 0 or 1
+        //      x[i][k] represents whether facility i is in location k
+        //  w[i][k] are real, values >= 0
+        //      w[i][k] represents x[i][k] * sum j: sum l: refcount[i][j] * distance(k,l) * x[j][l]
+        //       i.e. if facility i not in location k then 0
+        //       else for all facilities j in its location l sum refcount[i][j] * distance(k,l)
+        std::vector<std::vector<Mip::Col>> x;
+            x.resize(nfac); for (size_t i=0; i<nfac; i++) x[i].resize(nlocs);
+        std::vector<std::vector<Mip::Col>> w;
+            w.resize(nfac); for (size_t i=0; i<nfac; i++) w[i].resize(nlocs);
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            for ( size_t k=0; k<nlocs; k++ )
+            {
+                x[i][k] = mip.addCol();
+                mip.colLowerBound(x[i][k], 0);          // 0 <= x[i][k]
+                mip.colUpperBound(x[i][k], 1);          //      x[i][k] <= 1
+                mip.colType(x[i][k], Mip::INTEGER);     // int
+
+                w[i][k] = mip.addCol();
+                mip.colLowerBound(w[i][k], 0);          // 0 <= w[i][k]
+                mip.colType(w[i][k], Mip::REAL);        // real
+            }
+        }
+
+        // constraints (rows)
+        //  forall i: ( sum k: x[i][k] == 1 )
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            Mip::Expr   sum;
+            for ( size_t k=0; k<nlocs; k++ )
+            {
+                sum += x[i][k];
+            }
+            mip.addRow(sum == 1);
+        }
+
+        // constraints (rows)
+        //  forall k: ( sum i: x[i][k] <= 1 )
+        //  < 1 (i.e. == 0) may apply for a k when location k doesn't contain a qubit in this solution
+        for ( size_t k=0; k<nlocs; k++ )
+        {
+            Mip::Expr   sum;
+            for ( size_t i=0; i<nfac; i++ )
+            {
+                sum += x[i][k];
+            }
+            mip.addRow(sum <= 1);
+        }
+
+        // constraints (rows)
+        //  forall i, k: costmax[i][k] * x[i][k]
+        //          + sum j sum l refcount[i][j]*distance[k][l]*x[j][l] - w[i][k] <= costmax[i][k]
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            for ( size_t k=0; k<nlocs; k++ )
+            {
+                Mip::Expr   left = costmax[i][k] * x[i][k];
+                for ( size_t j=0; j<nfac; j++ )
+                {
+                    for ( size_t l=0; l<nlocs; l++ )
+                    {
+                        left += refcount[i][j] * distance[k][l] * x[j][l];
+                    }
+                }
+                left -= w[i][k];
+                Mip::Expr   right = costmax[i][k];
+                mip.addRow(left <= right);
+            }
+        }
+
+        // objective
+        Mip::Expr   objective;
+        mip.min();
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            for ( size_t k=0; k<nlocs; k++ )
+            {
+                objective += w[i][k];
+            }
+        }
+        mip.obj(objective);
+
+        // solve the problem
+        if (cancellation != nullptr && cancellation->is_cancelled())
+        {
+            DOUT("InitialPlace: cancelled before solving");
+            return solution_none;
+        }
+        DOUT("InitialPlace: solving the problem, this may take a while ...");
+#ifdef MIP_CANCELLABLE
+        solution_t solution = mip_solve(mip, cancellation);
+        if (solution == solution_none)
+        {
+            DOUT("... InitialPlace: no solution found");
+            return solution_none;
+        }
+#else // ifdef MIP_CANCELLABLE
+        solution_t solution = solution_optimal;
+        Mip::SolveExitStatus s = mip.solve();
+        Mip::ProblemType pt = mip.type();
+        if (s != Mip::SOLVED || pt != Mip::OPTIMAL)
+        {
+            DOUT("... InitialPlace: no (optimal) solution found; solve returned:"<< s << " type returned:" << pt);
+            return solution_none;
+        }
+#endif // ifdef MIP_CANCELLABLE
+
+        // get the results: x[i][k] == 1 iff facility i is in location k
+        loc.assign(nfac, 0);
+        for ( size_t i=0; i<nfac; i++ )
+        {
+            size_t k;
+            for (k=0; k<nlocs; k++ )
+            {
+                if (mip.sol(x[i][k]) == 1)
+                {
+                    loc[i] = k;
+                    break;
+                }
+            }
+            if (k >= nlocs)
+            {
+                FATAL("InitialPlace: facility " << i << " didn't get a location in the MIP solution");
+            }
+        }
+        return solution;
+    }
+#else // ifdef INITIALPLACE
+    bool mip_supported()
+    {
+        return false;
+    }
+
+    bool mip_cancellable()
+    {
+        return false;
+    }
+
+    solution_t solve_mip(const problem_t &problem, std::vector<size_t> &loc, const cancellation_t *cancellation)
+    {
+        return solution_none;
+    }
+#endif // ifdef INITIALPLACE
+
+// =========================================================================================
+// simulated annealing
+// The interaction graph has an edge between facilities i and j with weight refcount[i][j] + refcount[j][i].
+// The greedy embedding repeatedly takes the unplaced facility with the largest weight to the placed ones
+// (the one with the largest total weight to start a new connected component),
+// and puts it in the free location minimizing the cost with respect to the placed facilities;
+// the first facility of a component goes to the free location with the smallest sum of distances to all locations.
+// Each annealing chain starts from the greedy embedding; a step moves a random facility to a random location,
+// swapping it with the facility in that location when there is one; the cost delta is computed from the neighbors
+// in the interaction graph only. The temperature decreases geometrically from one at which about half of the
+// uphill steps are accepted to one at which hardly any are; the best solution of the chain is then improved
+// by a local search over all moves and swaps until no improvement is found.
+
+    typedef std::vector<std::vector<std::pair<size_t, size_t>>> interaction_graph_t;   // [i]: (j, weight)
+
+    class anneal_state_t
+    {
+    public:
+        anneal_state_t(const problem_t &problem, const interaction_graph_t &graph, const std::vector<size_t> &start)
+            : problem(problem), graph(graph), loc(start), occupant(problem.nlocs, NO_FACILITY)
+        {
+            for (size_t i = 0; i < problem.nfac; i++)
+            {
+                occupant[loc[i]] = i;
+            }
+            current = cost(problem, loc);
+        }
+
+        // change of the cost when facility i would move to location l, with all other facilities in place
+        int64_t move_delta(size_t i, size_t l) const
+        {
+            int64_t delta = 0;
+            const std::vector<size_t>& dl = problem.distance[l];
+            const std::vector<size_t>& dk = problem.distance[loc[i]];
+            for (auto &e : graph[i])
+            {
+                delta += int64_t(e.second) * (int64_t(dl[loc[e.first]]) - int64_t(dk[loc[e.first]]));
+            }
+            return delta;
+        }
+
+        // change of the cost when facility i would move to location l, swapping with its occupant if any
+        int64_t delta(size_t i, size_t l) const
+        {
+            size_t  j = occupant[l];
+            int64_t d = move_delta(i, l);
+            if (j != NO_FACILITY)
+            {
+                d += move_delta(j, loc[i]);
+                // both move_deltas assumed the other one to stay in place
+                d += 2 * int64_t(weight(i, j)) * int64_t(problem.distance[loc[i]][l]);
+            }
+            return d;
+        }
+
+        void apply(size_t i, size_t l, int64_t d)
+        {
+            size_t  k = loc[i];
+            size_t  j = occupant[l];
+            loc[i] = l;
+            occupant[l] = i;
+            occupant[k] = j;
+            if (j != NO_FACILITY)
+            {
+                loc[j] = k;
+            }
+            current = size_t(int64_t(current) + d);
+        }
+
+        size_t weight(size_t i, size_t j) const
+        {
+            return problem.refcount[i][j] + problem.refcount[j][i];
+        }
+
+        const problem_t            &problem;
+        const interaction_graph_t  &graph;
+        std::vector<size_t>         loc;
+        std::vector<size_t>         occupant;   // [k]: facility in location k or NO_FACILITY
+        size_t                      current;    // cost of loc
+    };
+
+    static std::vector<size_t> greedy_embedding(const problem_t &problem, const interaction_graph_t &graph)
+    {
+        size_t  nfac = problem.nfac;
+        size_t  nlocs = problem.nlocs;
+        std::vector<size_t> total(nfac, 0);         // total weight of the facility
+        std::vector<size_t> attached(nfac, 0);      // weight to the placed facilities
+        for (size_t i = 0; i < nfac; i++)
+        {
+            for (auto &e : graph[i]) total[i] += e.second;
+        }
+        std::vector<size_t> centrality(nlocs, 0);   // sum of the distances to all locations, lower is more central
+        for (size_t k = 0; k < nlocs; k++)
+        {
+            for (size_t l = 0; l < nlocs; l++) centrality[k] += problem.distance[k][l];
+        }
+
+        std::vector<size_t> loc(nfac, 0);
+        std::vector<bool>   placed(nfac, false);
+        std::vector<bool>   used(nlocs, false);
+        for (size_t n = 0; n < nfac; n++)
+        {
+            size_t  i = NO_FACILITY;
+            for (size_t f = 0; f < nfac; f++)
+            {
+                if (placed[f]) continue;
+                if (i == NO_FACILITY || attached[f] > attached[i] || (attached[f] == attached[i] && total[f] > total[i]))
+                {
+                    i = f;
+                }
+            }
+
+            size_t  best_k = NO_FACILITY;
+            size_t  best_cost = 0;
+            for (size_t k = 0; k < nlocs; k++)
+            {
+                if (used[k]) continue;
+                size_t  c = 0;
+                for (auto &e : graph[i])
+                {
+                    if (placed[e.first]) c += e.second * problem.distance[k][loc[e.first]];
+                }
+                if (best_k == NO_FACILITY || c < best_cost || (c == best_cost && centrality[k] < centrality[best_k]))
+                {
+                    best_k = k;
+                    best_cost = c;
+                }
+            }
+
+            loc[i] = best_k;
+            placed[i] = true;
+            used[best_k] = true;
+            for (auto &e : graph[i]) attached[e.first] += e.second;
+        }
+        return loc;
+    }
+
+    // run annealing chain from start; returns false when the deadline passed or it was cancelled before it completed,
+    // in which case loc is the best solution found until then, not improved by the local search
+    static bool anneal_chain(const problem_t &problem, const interaction_graph_t &graph, const std::vector<size_t> &start,
+            size_t seed, const anneal_parameters_t &parameters, std::vector<size_t> &loc, size_t &loc_cost)
+    {
+        anneal_state_t  state(problem, graph, start);
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        size_t  nfac = problem.nfac;
+        size_t  nlocs = problem.nlocs;
+        loc = state.loc;
+        loc_cost = state.current;
+
+        // initial temperature: at which half of an average uphill step is accepted
+        double  uphill = 0.0;
+        size_t  uphill_count = 0;
+        for (size_t n = 0; n < 100; n++)
+        {
+            int64_t d = state.delta(rng() % nfac, rng() % nlocs);
+            if (d > 0)
+            {
+                uphill += d;
+                uphill_count++;
+            }
+        }
+        double  t_start = (uphill_count == 0 ? 1.0 : uphill / uphill_count / std::log(2.0));
+        double  t_end = 0.01;
+        size_t  steps = 2000 * nlocs;
+        double  cooling = std::pow(t_end / t_start, 1.0 / steps);
+
+        bool    completed = true;
+        double  temperature = t_start;
+        for (size_t step = 0; step < steps; step++, temperature *= cooling)
+        {
+            if ((step % 1024) == 0
+                && ((parameters.has_deadline && std::chrono::steady_clock::now() > parameters.deadline)
+                    || (parameters.cancellation != nullptr && parameters.cancellation->is_cancelled())))
+            {
+                completed = false;
+                break;
+            }
+            size_t  i = rng() % nfac;
+            size_t  l = rng() % nlocs;
+            if (l == state.loc[i]) continue;
+            int64_t d = state.delta(i, l);
+            if (d <= 0 || uniform(rng) < std::exp(-d / temperature))
+            {
+                state.apply(i, l, d);
+                if (state.current < loc_cost)
+                {
+                    loc = state.loc;
+                    loc_cost = state.current;
+                }
+            }
+        }
+        if (!completed)
+        {
+            return false;
+        }
+
+        // local search from the best solution of the chain
+        anneal_state_t  best(problem, graph, loc);
+        bool    improved = true;
+        while (improved)
+        {
+            improved = false;
+            for (size_t i = 0; i < nfac; i++)
+            {
+                for (size_t l = 0; l < nlocs; l++)
+                {
+                    if (l == best.loc[i]) continue;
+                    int64_t d = best.delta(i, l);
+                    if (d < 0)
+                    {
+                        best.apply(i, l, d);
+                        improved = true;
+                    }
+                }
+            }
+        }
+        loc = best.loc;
+        loc_cost = best.current;
+        return true;
+    }
+
+    void solve_anneal(const problem_t &problem, const anneal_parameters_t &parameters, std::vector<size_t> &loc)
+    {
+        QL_TRACE_SPAN("mapper", "initialplace_anneal");
+        size_t  nfac = problem.nfac;
+        interaction_graph_t graph(nfac);
+        for (size_t i = 0; i < nfac; i++)
+        {
+            for (size_t j = 0; j < nfac; j++)
+            {
+                size_t  w = problem.refcount[i][j] + problem.refcount[j][i];
+                if (i != j && w != 0)
+                {
+                    graph[i].emplace_back(j, w);
+                }
+            }
+        }
+
+        std::vector<size_t> start = greedy_embedding(problem, graph);
+        DOUT("InitialPlace: greedy embedding has cost " << cost(problem, start));
+        if (nfac < 2 || parameters.chains == 0)
+        {
+            loc = start;
+            return;
+        }
+
+        size_t  chains = parameters.chains;
+        std::vector<std::vector<size_t>>    chain_loc(chains);
+        std::vector<size_t>                 chain_cost(chains, 0);
+        std::atomic<size_t>                 next_chain(0);
+        std::exception_ptr                  worker_exception;
+        std::mutex                          worker_exception_mutex;
+        auto worker = [&]()
+        {
+            for (size_t c = next_chain++; c < chains; c = next_chain++)
+            {
+                try
+                {
+                    QL_TRACE_SPAN("mapper", "initialplace_anneal_chain", int64_t(c));
+                    anneal_chain(problem, graph, start, parameters.seed * 1000003 + c, parameters, chain_loc[c], chain_cost[c]);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(worker_exception_mutex);
+                    worker_exception = std::current_exception();
+                }
+            }
+        };
+        size_t  thread_count = std::min(chains, size_t(std::max(1u, std::thread::hardware_concurrency())));
+        std::vector<std::thread>    threads;
+        for (size_t t = 1; t < thread_count; t++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        if (worker_exception)
+        {
+            std::rethrow_exception(worker_exception);
+        }
+
+        // the best chain, the lowest one of those with the same cost
+        size_t  best = 0;
+        for (size_t c = 1; c < chains; c++)
+        {
+            if (chain_cost[c] < chain_cost[best]) best = c;
+        }
+        DOUT("InitialPlace: annealing chain " << best << " of " << chains << " found the lowest cost " << chain_cost[best]);
+        loc = chain_loc[best];
+    }
+
+} // initial_place namespace
+} // ql namespace
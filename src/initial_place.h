@@ -0,0 +1,101 @@
+/**
+ * @file   initial_place.h
+ * @date   10/2020
+ * @brief  solvers of the quadratic assignment problem of initial placement
+ */
+
+#ifndef QL_INITIAL_PLACE_H
+#define QL_INITIAL_PLACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/*
+    Summary
+
+    Initial placement (class InitialPlace in mapper.cc) assigns the virtual qubits used by a circuit (facilities,
+    indexed by i and j) to distinct real qubits (locations, indexed by k and l), minimizing the sum over all
+    two-qubit gates of the distance between the locations of their operands:
+        min sum i: sum j: refcount[i][j] * distance(loc[i], loc[j])
+    This is a quadratic assignment problem, which is NP-hard.
+
+    Two solvers are provided:
+    - solve_mip models it as a mixed integer linear program that is solved by lemon/glpk;
+        the solution is optimal but the solving time grows very fast with the number of qubits,
+        beyond 20 qubits it rarely completes;
+        it is only available when OpenQL was built with initial placement support (cmake WITH_INITIAL_PLACEMENT)
+    - solve_anneal embeds the interaction graph greedily in the grid and improves the result by a number of
+        simulated annealing chains that are run concurrently on a pool of threads, each followed by a local search;
+        the best solution found is returned; it doesn't need glpk
+
+    Both solvers can be cancelled cooperatively through a cancellation_t that they poll while solving;
+    when cancelled, they stop and return the best solution they found until then, if any.
+    The annealing chains poll it every 1024 steps; the MIP polls it between branch-and-bound nodes
+    when lemon uses glpk (mip_cancellable()), other MIP solvers are only polled before they start.
+*/
+
+namespace ql
+{
+namespace initial_place
+{
+    struct problem_t
+    {
+        size_t                              nfac;       // number of facilities
+        size_t                              nlocs;      // number of locations, at least nfac
+        std::vector<std::vector<size_t>>    refcount;   // [nfac][nfac]: number of two-qubit gates between i and j
+        std::vector<std::vector<size_t>>    distance;   // [nlocs][nlocs]: distance between locations k and l
+    };
+
+    // objective value of assigning each facility i to location loc[i]
+    size_t cost(const problem_t &problem, const std::vector<size_t> &loc);
+
+    // shared between a solver and the thread that may cancel it
+    class cancellation_t
+    {
+    public:
+        cancellation_t() : cancelled(false) {}
+        void cancel() { cancelled = true; }
+        bool is_cancelled() const { return cancelled; }
+    private:
+        std::atomic<bool>   cancelled;
+    };
+
+    typedef enum
+    {
+        solution_none,      // no assignment was found
+        solution_feasible,  // an assignment was found, it may not be optimal
+        solution_optimal    // the assignment was proven optimal
+    } solution_t;
+
+    // whether solve_mip is available in this build
+    bool mip_supported();
+
+    // whether solve_mip stops soon after being cancelled, instead of only when it is complete
+    bool mip_cancellable();
+
+    // assignment into loc[i] by the MIP, optimal unless it was cancelled before completion;
+    // cancellation may be nullptr, when it is cancelled, the best incumbent is returned as solution_feasible;
+    // returns solution_none when the MIP is not supported or no solution was found
+    solution_t solve_mip(const problem_t &problem, std::vector<size_t> &loc, const cancellation_t *cancellation);
+
+    struct anneal_parameters_t
+    {
+        size_t  chains;         // number of annealing chains, each with its own random stream
+        size_t  seed;           // the random stream of chain c is seeded by seed and c
+        bool    has_deadline;   // when the deadline passes, the chains stop and the best solution found is returned
+        std::chrono::steady_clock::time_point deadline;
+        const cancellation_t *cancellation;     // when not nullptr and cancelled, the chains stop as at the deadline
+
+        anneal_parameters_t() : chains(8), seed(0), has_deadline(false), cancellation(nullptr) {}
+    };
+
+    // heuristic assignment into loc[i], always found; without deadline and cancellation, the result only depends on the problem,
+    // the number of chains and the seed, not on the number of threads
+    void solve_anneal(const problem_t &problem, const anneal_parameters_t &parameters, std::vector<size_t> &loc);
+
+} // initial_place namespace
+} // ql namespace
+
+#endif // QL_INITIAL_PLACE_H
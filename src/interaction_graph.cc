@@ -0,0 +1,151 @@
+/**
+ * @file   interaction_graph.cc
+ * @date   10/2020
+ * @brief  sparse weighted graph of the interactions between qubits by two-qubit gates
+ */
+
+#include <interaction_graph.h>
+#include <utils.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace ql
+{
+    bool interaction_graph::is_twoqubit_gate(gate *gp)
+    {
+        if (gp->operands.size() != 2)
+        {
+            return false;
+        }
+        gate_type_t t = gp->type();
+        return t != __wait_gate__ && t != __classical_gate__ && t != __dummy_gate__;
+    }
+
+    interaction_graph::interaction_graph(const circuit &circ, size_t nqubits, size_t horizon)
+        : nqubits(nqubits), ntwoqubit(0), ntwoqubit_total(0), usecount(nqubits, 0), adjacency(nqubits)
+    {
+        // the pass over the circuit collects the operand pairs, each qubit's pairs are then merged per other qubit
+        std::vector<std::pair<size_t,size_t>>  pairs;
+        for (auto gp : circ)
+        {
+            bool within = (horizon == 0 || ntwoqubit_total < horizon);
+            if (within)
+            {
+                for (auto q : gp->operands)
+                {
+                    usecount[q] += 1;
+                }
+            }
+            if (is_twoqubit_gate(gp))
+            {
+                if (within)
+                {
+                    pairs.push_back(std::make_pair(gp->operands[0], gp->operands[1]));
+                    ntwoqubit++;
+                }
+                ntwoqubit_total++;
+            }
+        }
+
+        std::vector<size_t> slot(nqubits, MAX_CYCLE);   // [other qubit]: index of its edge in the current list
+        std::vector<std::vector<std::pair<size_t,bool>>> incident(nqubits);     // [qubit]: (other qubit, is first operand)
+        for (auto &p : pairs)
+        {
+            incident[p.first].push_back(std::make_pair(p.second, true));
+            incident[p.second].push_back(std::make_pair(p.first, false));
+        }
+        for (size_t q = 0; q < nqubits; q++)
+        {
+            std::vector<edge_t> &edges = adjacency[q];
+            for (auto &inc : incident[q])
+            {
+                if (slot[inc.first] == MAX_CYCLE)
+                {
+                    slot[inc.first] = edges.size();
+                    edges.push_back(edge_t{inc.first, 0, 0});
+                }
+                edge_t &e = edges[slot[inc.first]];
+                e.count += 1;
+                e.forward += (inc.second ? 1 : 0);
+            }
+            for (auto &e : edges)
+            {
+                slot[e.qubit] = MAX_CYCLE;
+            }
+            std::sort(edges.begin(), edges.end(), [](const edge_t &e1, const edge_t &e2) { return e1.qubit < e2.qubit; });
+        }
+    }
+
+    size_t interaction_graph::edge_count() const
+    {
+        size_t  n = 0;
+        for (auto &edges : adjacency)
+        {
+            n += edges.size();
+        }
+        return n / 2;
+    }
+
+    const interaction_graph::edge_t *interaction_graph::find(size_t q0, size_t q1) const
+    {
+        const std::vector<edge_t> &edges = adjacency[q0];
+        auto it = std::lower_bound(edges.begin(), edges.end(), q1, [](const edge_t &e, size_t q) { return e.qubit < q; });
+        return (it != edges.end() && it->qubit == q1) ? &*it : nullptr;
+    }
+
+    size_t interaction_graph::weight(size_t q0, size_t q1) const
+    {
+        const edge_t *e = find(q0, q1);
+        return e ? e->count : 0;
+    }
+
+    size_t interaction_graph::directed_weight(size_t q0, size_t q1) const
+    {
+        const edge_t *e = find(q0, q1);
+        return e ? e->forward : 0;
+    }
+
+    std::string interaction_graph::matrix_string() const
+    {
+        std::stringstream ss;
+
+        // Use the following for properly aligned matrix print for visual inspection
+        // This can be problematic of width not set properly to be processed by gnuplot script
+        #define ALIGNMENT (std::setw(4))
+
+        // Use the following to print tabs which will not be visually appealing but it will
+        // generate the columns properly for further processing by other tools
+        // #define ALIGNMENT ("    ")
+
+        ss << ALIGNMENT << " ";
+        for (size_t c = 0; c < nqubits; c++)
+        {
+            ss << ALIGNMENT << "q" + std::to_string(c);
+        }
+        ss << std::endl;
+
+        for (size_t p = 0; p < nqubits; p++)
+        {
+            ss << ALIGNMENT << "q" + std::to_string(p);
+            auto e = adjacency[p].begin();
+            for (size_t c = 0; c < nqubits; c++)
+            {
+                size_t w = 0;
+                if (e != adjacency[p].end() && e->qubit == c)
+                {
+                    w = e->count;
+                    ++e;
+                }
+                ss << ALIGNMENT << w;
+            }
+            ss << std::endl;
+        }
+        #undef ALIGNMENT
+
+        return ss.str();
+    }
+
+} // ql namespace
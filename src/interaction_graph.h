@@ -0,0 +1,86 @@
+/**
+ * @file   interaction_graph.h
+ * @date   10/2020
+ * @brief  sparse weighted graph of the interactions between qubits by two-qubit gates
+ */
+
+#ifndef QL_INTERACTION_GRAPH_H
+#define QL_INTERACTION_GRAPH_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "circuit.h"
+
+/*
+    Summary
+
+    The interaction graph of a circuit has the qubits as nodes and an edge between each pair of qubits
+    that are the operands of a two-qubit gate, weighted by the number of such gates.
+    It is built in one pass over the circuit, recognizing two-qubit gates by their type and number of qubit operands
+    (any quantum gate with two qubit operands, so cnot, cz and custom gates alike; not waits nor classical gates),
+    and is stored as adjacency lists sorted by qubit, so its size is linear in the number of distinct interactions
+    instead of quadratic in the number of qubits.
+
+    The graph can be limited to a prefix of the circuit, the horizon: only its first horizon two-qubit gates,
+    and only the uses of qubits by the gates before the first two-qubit gate beyond the horizon, are counted.
+
+    It is used for initial placement (InitialPlace in mapper.cc) and for
+    Program.print_interaction_matrix/write_interaction_matrix.
+*/
+
+namespace ql
+{
+    class interaction_graph
+    {
+    public:
+        struct edge_t
+        {
+            size_t  qubit;      // the other qubit
+            size_t  count;      // number of two-qubit gates between both qubits, in any operand order
+            size_t  forward;    // number of those with this qubit as first operand
+        };
+
+        interaction_graph() : nqubits(0), ntwoqubit(0), ntwoqubit_total(0) {}
+
+        // graph of the circuit on nqubits qubits, of its first horizon two-qubit gates, of all when horizon is 0
+        interaction_graph(const circuit &circ, size_t nqubits, size_t horizon = 0);
+
+        // whether the gate counts as an interaction of its operands
+        static bool is_twoqubit_gate(gate *gp);
+
+        size_t qubit_count() const { return nqubits; }
+
+        // number of two-qubit gates within the horizon, in the whole circuit
+        size_t twoqubit_count() const { return ntwoqubit; }
+        size_t total_twoqubit_count() const { return ntwoqubit_total; }
+
+        // number of gates within the horizon that have the qubit as operand
+        size_t use_count(size_t q) const { return usecount[q]; }
+
+        // edges of the qubit, sorted on the other qubit
+        const std::vector<edge_t> &neighbors(size_t q) const { return adjacency[q]; }
+        size_t degree(size_t q) const { return adjacency[q].size(); }
+        size_t edge_count() const;
+
+        // number of two-qubit gates between q0 and q1 in any operand order; with q0 as first operand
+        size_t weight(size_t q0, size_t q1) const;
+        size_t directed_weight(size_t q0, size_t q1) const;
+
+        // the weights as a matrix of nqubits rows and columns, aligned for visual inspection
+        std::string matrix_string() const;
+
+    private:
+        const edge_t *find(size_t q0, size_t q1) const;
+
+        size_t                              nqubits;
+        size_t                              ntwoqubit;
+        size_t                              ntwoqubit_total;
+        std::vector<size_t>                 usecount;   // [qubit]
+        std::vector<std::vector<edge_t>>    adjacency;  // [qubit]: its edges, sorted on the other qubit
+    };
+
+} // ql namespace
+
+#endif // QL_INTERACTION_GRAPH_H
@@ -54,15 +54,16 @@ public: // FIXME: should be private
     operation     br_condition;
     size_t        cycle_time;   // FIXME HvS just a copy of platform.cycle_time
     instruction_map_t instruction_map;
+    size_t        generation;   // bumped by passes that modify the kernel; see PassManager::compile
 
 public:
     quantum_kernel(std::string name) :
-        name(name), iterations(1), type(kernel_type_t::STATIC) {}
+        name(name), iterations(1), type(kernel_type_t::STATIC), generation(0) {}
 
     quantum_kernel(std::string name, const ql::quantum_platform& platform,
                    size_t qcount, size_t ccount=0) :
         name(name), iterations(1), qubit_count(qcount),
-        creg_count(ccount), type(kernel_type_t::STATIC)
+        creg_count(ccount), type(kernel_type_t::STATIC), generation(0)
     {
         instruction_map = platform.instruction_map;
         cycle_time = platform.cycle_time;
@@ -133,6 +134,15 @@ public:
         return c;
     }
 
+    /**
+     * to be called by a pass after it has changed the kernel;
+     * a pass that doesn't call it on any kernel didn't change the program
+     */
+    void set_modified()
+    {
+        generation++;
+    }
+
     /************************************************************************\
     | Gate shortcuts
     \************************************************************************/
@@ -1,14 +1,15 @@
 #include "mapper.h"
+#include "initial_place.h"
+#include "interaction_graph.h"
 
-#ifdef INITIALPLACE
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <lemon/lp.h>
+#include <memory>
+#include <exception>
 
-using namespace lemon;
 // =========================================================================================
-// InitialPlace: initial placement solved as an MIP, mixed integer linear program
+// InitialPlace: initial placement solved as a Quadratic Assignment Problem
 // the initial placement is modelled as a Quadratic Assignment Problem
 // by Lingling Lao in her mapping paper:
 //  
@@ -19,40 +20,26 @@ using namespace lemon;
 // subject to:
 //     forall k: ( sum i: x[i][k] <= 1 )        allow more locations than qubits
 //     forall i: ( sum k: x[i][k] == 1 )        but each qubit must have one locations
-//  
-// the article "An algorithm for the quadratic assignment problem using Benders' decomposition"
-// by L. Kaufman and F. Broeckx, transforms this problem by introducing w[i][k] as follows:
-//  
-// forall i: forall k: w[i][k] =  x[i][k] * ( sum j: sum l: refcount[i][j] * distance(k,l) * x[j][l] )
-//  
-// to the following mixed integer linear problem:
-//  
-//  precompute:
-//      forall i: forall k: costmax[i][k] = sum j: sum l: refcount[i][j] * distance(k,l)
-//      (note: each of these costmax[][] is >= 0, so the "max(this,0)" around this is not needed)
-//  variables:
-//      forall i: forall k: x[i][k], x[i][k] is integral and 0 or 1
-//      forall i: forall k: w[i][k], w[i][k] is real and >= 0
-//  objective:
-//      min z = sum i: sum k: w[i][k]
-//  subject to:
-//      forall k: ( sum i: x[i][k] <= 1 )
-//      forall i: ( sum k: x[i][k] == 1 )
-//      forall i: forall k: costmax[i][k] * x[i][k]
-//          + ( sum j: sum l: refcount[i][j]*distance(k,l)*x[j][l] ) - w[i][k] <= costmax[i][k]
 //
-// This model is coded in lemon/mip below.
-// The latter is mapped onto glpk.
+// The solvers are in initial_place.cc; option initialplace_algorithm selects one of:
+//  mip     the problem is transformed to a mixed integer linear program that is solved by lemon/glpk;
+//          the solution is optimal but solving takes very long for larger numbers of qubits
+//  anneal  greedy embedding followed by simulated annealing; heuristic but fast and scaling to large devices
 //
 // Since solving takes a while, two ways are offered to deal with this; these can be combined:
 // 1. option initialplace2qhorizon: one of: 0,10,20,30,40,50,60,70,80,90,100
 // The initialplace algorithm considers only this number of initial two-qubit gates to determine a mapping.
 // When 0 is specified as option value, there is no limit.
 // 2. option initialplace: an option steerable timeout mechanism around it is implemented, using threads:
-// The solver runs in a subthread which can succeed or be timed out by the main thread waiting for it.
-// When timed out, it can stop the compiler by raising an exception or continue mapping as if it were not called.
-// When INITIALPLACE is not defined, the compiler doesn't contain initial placement support and ignores calls to it;
-// then all this: lemon/mip, glpk, thread support is avoided making OpenQL much easier build and run.
+// The mip solver runs in a subthread which can succeed or be timed out by the main thread waiting for it.
+// When timed out, the main thread cancels the solver, which then stops and returns its best solution until then;
+// when it has one, mapping continues from it, otherwise it can stop the compiler by raising an exception
+// or continue mapping as if it were not called.
+// A MIP solver that can't be cancelled (lemon not using glpk) would keep running after the timeout,
+// so with a time limit the anneal solver is used instead of it.
+// The anneal solver takes the timeout as its deadline and then returns the best mapping it found until then.
+// When INITIALPLACE is not defined, the compiler doesn't contain the mip solver and ignores calls to it;
+// then lemon/mip and glpk are avoided making OpenQL much easier build and run.
 // Otherwise, depending on the initialplace option value, initial placement is attempted before the heuristic.
 // Options values of initialplace:
 //  no      don't run initial placement ('ip')
@@ -78,6 +65,22 @@ enum InitialPlaceResults
     ipr_timedout        // initial placement solution timed out and thus failed
 } ipr_t;
 
+// state shared between InitialPlace and the thread running the MIP when there is a time limit;
+// the thread only accesses this and its own copy of the problem
+struct MipJob
+{
+    ql::initial_place::problem_t        problem;
+    std::vector<size_t>                 loc;
+    ql::initial_place::solution_t       solution;
+    ql::initial_place::cancellation_t   cancellation;
+    std::exception_ptr                  exception;
+    std::mutex                          m;
+    std::condition_variable             cv;
+    bool                                done;       // guarded by m; solution, loc and exception are valid
+
+    MipJob() : solution(ql::initial_place::solution_none), done(false) {}
+};
+
 class InitialPlace
 {
 private:
@@ -121,7 +124,8 @@ void Init(Grid* g, const ql::quantum_platform *p)
 // find an initial placement of the virtual qubits for the given circuit
 // the resulting placement is put in the provided virt2real map
 // result indicates one of the result indicators (ipr_t, see above)
-void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptimetaken)
+// initialplaceopt specifies the time limit, if any, see above
+void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptimetaken, const std::string& initialplaceopt)
 {
     DOUT("InitialPlace.PlaceBody ...");
 
@@ -140,36 +144,20 @@ void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptime
     std::string initialplace2qhorizonopt = ql::options::get("initialplace2qhorizon");
     int  prefix = stoi(initialplace2qhorizonopt);
 
-    // compute ipusecount[] to know which virtual qubits are actually used
-    // use it to compute v2i, mapping (non-contiguous) virtual qubit indices to contiguous facility indices
+    // the interaction graph of the circuit within that horizon gives both the use counts of the virtual qubits
+    // and the number of two-qubit gates between each pair of them, in one pass over the circuit
+    DOUT("... compute interaction graph by scanning circuit");
+    ql::interaction_graph graph(circ, nvq, prefix);
+
+    // use the use counts to compute v2i, mapping (non-contiguous) virtual qubit indices to contiguous facility indices
     // (the MIP model is shorter when the indices are contiguous)
-    // finally, nfac is set to the number of these facilities;
-    // only consider virtual qubit uses until the specified max number of two qubit gates has been seen
-    DOUT("... compute ipusecount by scanning circuit");
-    std::vector<size_t>  ipusecount;// ipusecount[v] = count of use of virtual qubit v in current circuit
-    ipusecount.resize(nvq,0);       // initially all 0
+    // finally, nfac is set to the number of these facilities
     std::vector<size_t> v2i;        // v2i[virtual qubit index v] -> index of facility i
     v2i.resize(nvq,UNDEFINED_QUBIT);// virtual qubit v not used by circuit as gate operand
-
-    int  twoqubitcount = 0;
-    for ( auto& gp : circ )
-    {
-        if (prefix == 0 || twoqubitcount < prefix)
-        {
-            for ( auto v : gp->operands)
-            {
-                ipusecount[v] += 1;
-            }
-        }
-        if (gp->operands.size() == 2)
-        {
-            twoqubitcount++;
-        }
-    }
     nfac = 0;
     for (size_t v=0; v < nvq; v++)
     {
-        if (ipusecount[v] != 0)
+        if (graph.use_count(v) != 0)
         {
             v2i[v] = nfac;
             nfac += 1;
@@ -177,42 +165,33 @@ void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptime
     }
     DOUT("... number of facilities: " << nfac << " while number of used virtual qubits is: " << nvq);
 
-    // precompute refcount (used by the model as constants) by scanning circuit;
-    // refcount[i][j] = count of two-qubit gates between facilities i and j in current circuit
+    // refcount (used by the model as constants) from the edges of the graph;
+    // refcount[i][j] = count of two-qubit gates between facilities i and j with i as first operand in current circuit
     // at the same time, set anymap and currmap
     // anymap = there are no two-qubit gates so any map will do
     // currmap = in the current map, all two-qubit gates are NN so current map will do
-    DOUT("... compute refcount by scanning circuit");
+    DOUT("... compute refcount from interaction graph");
     std::vector<std::vector<size_t>>  refcount;
     refcount.resize(nfac); for (size_t i=0; i<nfac; i++) refcount[i].resize(nfac,0);
-    bool anymap = true;    // true when all refcounts are 0
+    bool anymap = (graph.twoqubit_count() == 0);    // true when all refcounts are 0
     bool currmap = true;   // true when in current map all two-qubit gates are NN
-    
-    twoqubitcount = 0;
-    for ( auto& gp : circ )
+    for (size_t v=0; v < nvq; v++)
     {
-        auto&   q = gp->operands;
-        if (q.size() == 2)
+        for (auto& e : graph.neighbors(v))
         {
-            if (prefix == 0 || twoqubitcount < prefix)
+            refcount[v2i[v]][v2i[e.qubit]] = e.forward;
+            if (v2r[v] == UNDEFINED_QUBIT
+                || v2r[e.qubit] == UNDEFINED_QUBIT
+                || gridp->Distance(v2r[v], v2r[e.qubit]) > 1
+                )
             {
-                anymap = false;
-                refcount[v2i[q[0]]][v2i[q[1]]] += 1;
-                
-                if (v2r[q[0]] == UNDEFINED_QUBIT
-                    || v2r[q[1]] == UNDEFINED_QUBIT
-                    || gridp->Distance(v2r[q[0]], v2r[q[1]]) > 1
-                    )
-                {
-                    currmap = false;
-                }
+                currmap = false;
             }
-            twoqubitcount++;
         }
     }
-    if (prefix != 0 && twoqubitcount >= prefix)
+    if (prefix != 0 && graph.total_twoqubit_count() >= size_t(prefix))
     {
-        DOUT("InitialPlace: only considered " << prefix << " of " << twoqubitcount << " two-qubit gates, so resulting mapping is not exact");
+        DOUT("InitialPlace: only considered " << prefix << " of " << graph.total_twoqubit_count() << " two-qubit gates, so resulting mapping is not exact");
     }
     if (anymap)
     {
@@ -235,250 +214,100 @@ void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptime
     using namespace std::chrono;
     high_resolution_clock::time_point t1 = high_resolution_clock::now();
 
-    // precompute costmax by applying formula
-    // costmax[i][k] = sum j: sum l: refcount[i][j] * distance(k,l) for facility i in location k
-    DOUT("... precompute costmax by combining refcount and distances");
-    std::vector<std::vector<size_t>>  costmax;   
-    costmax.resize(nfac); for (size_t i=0; i<nfac; i++) costmax[i].resize(nlocs,0);
-    for ( size_t i=0; i<nfac; i++ )
-    {
-        for ( size_t k=0; k<nlocs; k++ )
-        {
-            for ( size_t j=0; j<nfac; j++ )
-            {
-                for ( size_t l=0; l<nlocs; l++ )
-                {
-                    costmax[i][k] += refcount[i][j] * (gridp->Distance(k,l) - 1);
-                }
-            }
-        }
-    }
-    
-    // the problem
-    // mixed integer programming
-    Mip  mip;
-    
-    // variables (columns)
-    //  x[i][k] are integral, values 0 or 1
-    //      x[i][k] represents whether facility i is in location k
-    //  w[i][k] are real, values >= 0
-    //      w[i][k] represents x[i][k] * sum j: sum l: refcount[i][j] * distance(k,l) * x[j][l]
-    //       i.e. if facility i not in location k then 0
-    //       else for all facilities j in its location l sum refcount[i][j] * distance(k,l)
-    // DOUT("... allocate x column variable");
-    std::vector<std::vector<Mip::Col>> x;
-        x.resize(nfac); for (size_t i=0; i<nfac; i++) x[i].resize(nlocs);
-    // DOUT("... allocate w column variable");
-    std::vector<std::vector<Mip::Col>> w;
-        w.resize(nfac); for (size_t i=0; i<nfac; i++) w[i].resize(nlocs);
-    // DOUT("... add/initialize x and w column variables with trivial constraints and type");
-    for ( size_t i=0; i<nfac; i++ )
-    {
-        for ( size_t k=0; k<nlocs; k++ )
-        {
-            x[i][k] = mip.addCol();
-            mip.colLowerBound(x[i][k], 0);          // 0 <= x[i][k]
-            mip.colUpperBound(x[i][k], 1);          //      x[i][k] <= 1
-            mip.colType(x[i][k], Mip::INTEGER);     // int
-            // DOUT("x[" << i << "][" << k << "] INTEGER >= 0 and <= 1");
-    
-            w[i][k] = mip.addCol();
-            mip.colLowerBound(w[i][k], 0);          // 0 <= w[i][k]
-            mip.colType(w[i][k], Mip::REAL);        // real
-            // DOUT("w[" << i << "][" << k << "] REAL >= 0");
-        }
-    }
-    
-    // constraints (rows)
-    //  forall i: ( sum k: x[i][k] == 1 )
-    // DOUT("... add/initialize sum to 1 constraint rows");
-    for ( size_t i=0; i<nfac; i++ )
-    {
-        Mip::Expr   sum;
-        std::string s = "";
-        bool started = false;
-        for ( size_t k=0; k<nlocs; k++ )
-        {
-            sum += x[i][k];
-            if (started) s += "+ "; else started = true;
-            s += "x[";
-            s += std::to_string(i);
-            s += "][";
-            s += std::to_string(k);
-            s += "]";
-        }
-        mip.addRow(sum == 1);
-        s += " == 1";
-        // DOUT(s);
-    }
-    
-    // constraints (rows)
-    //  forall k: ( sum i: x[i][k] <= 1 )
-    //  < 1 (i.e. == 0) may apply for a k when location k doesn't contain a qubit in this solution
+    ql::initial_place::problem_t problem;
+    problem.nfac = nfac;
+    problem.nlocs = nlocs;
+    problem.refcount = refcount;
+    problem.distance.resize(nlocs); for (size_t k=0; k<nlocs; k++) problem.distance[k].resize(nlocs,0);
     for ( size_t k=0; k<nlocs; k++ )
     {
-        Mip::Expr   sum;
-        std::string s = "";
-        bool started = false;
-        for ( size_t i=0; i<nfac; i++ )
+        for ( size_t l=0; l<nlocs; l++ )
         {
-            sum += x[i][k];
-            if (started) s += "+ "; else started = true;
-            s += "x[";
-            s += std::to_string(i);
-            s += "]["; 
-            s += std::to_string(k); 
-            s += "]";
+            problem.distance[k][l] = gridp->Distance(k,l);
         }
-        mip.addRow(sum <= 1);
-        s += " <= 1";
-        // DOUT(s);
     }
-    
-    // constraints (rows)
-    //  forall i, k: costmax[i][k] * x[i][k]
-    //          + sum j sum l refcount[i][j]*distance[k][l]*x[j][l] - w[i][k] <= costmax[i][k]
-    // DOUT("... add/initialize nfac x nlocs constraint rows based on nfac x nlocs column combinations");
-    for ( size_t i=0; i<nfac; i++ )
+
+    std::vector<size_t> loc;    // loc[i]: location k (i.e. real qubit index k) of facility i
+    ql::initial_place::solution_t solution;
+    bool timedout = false;
+    std::string initialplacealgorithmopt = ql::options::get("initialplace_algorithm");
+    if ("mip" == initialplacealgorithmopt && "yes" != initialplaceopt
+        && ql::initial_place::mip_supported() && !ql::initial_place::mip_cancellable())
     {
-        for ( size_t k=0; k<nlocs; k++ )
-        {
-            Mip::Expr   left = costmax[i][k] * x[i][k];
-            std::string lefts = "";
-            bool started = false;
-            for ( size_t j=0; j<nfac; j++ )
-            {
-                for ( size_t l=0; l<nlocs; l++ )
-                {
-                    left += refcount[i][j] * gridp->Distance(k,l) * x[j][l];
-                    if (refcount[i][j] * gridp->Distance(k,l) != 0)
-                    {
-                        if (started) lefts += " + "; else started = true;
-                        lefts += std::to_string(refcount[i][j] * gridp->Distance(k,l));
-                        lefts += " * x[";
-                        lefts += std::to_string(j);
-                        lefts += "][";
-                        lefts += std::to_string(l);
-                        lefts += "]";
-                    }
-                }
-            }
-            left -= w[i][k];
-            lefts += "- w[";
-            lefts += std::to_string(i);
-            lefts += "][";
-            lefts += std::to_string(k);
-            lefts += "]";
-            Mip::Expr   right = costmax[i][k];
-            mip.addRow(left <= right);
-            // DOUT(lefts << " <= " << costmax[i][k]);
-        }
+        WOUT("... the MIP solver of this build can't be stopped at the time limit of initialplace=" << initialplaceopt << ", using anneal instead");
+        initialplacealgorithmopt = "anneal";
     }
-    
-    // objective
-    Mip::Expr   objective;
-    // DOUT("... add/initialize objective");
-    std::string objs = "";
-    bool started = false;
-    mip.min();
-    for ( size_t i=0; i<nfac; i++ )
+    if ("anneal" == initialplacealgorithmopt)
     {
-        for ( size_t k=0; k<nlocs; k++ )
+        // annealing stops at the time limit with the best mapping found until then, so it doesn't time out
+        DOUT("InitialPlace: solving the problem by greedy embedding and simulated annealing ...");
+        ql::initial_place::anneal_parameters_t  parameters;
+        if ("yes" != initialplaceopt)
         {
-            objective += w[i][k];
-            if (started) objs += "+ "; else started = true;
-            objs += "w[";
-            objs += std::to_string(i);
-            objs += "][";
-            objs += std::to_string(k);
-            objs += "]";
+            bool andthrowexception;
+            parameters.has_deadline = true;
+            parameters.deadline = steady_clock::now() + seconds(WaitSeconds(initialplaceopt, andthrowexception));
         }
+        ql::initial_place::solve_anneal(problem, parameters, loc);
+        solution = ql::initial_place::solution_feasible;
     }
-    mip.obj(objective);
-    // DOUT("MINIMIZE " << objs);
-
-    DOUT("... v2r before solving, nvq=" << nvq);
-    for (size_t v=0; v<nvq; v++)
+    else if ("yes" == initialplaceopt)
     {
-        DOUT("... about to print v2r[" << v << "]= ...");
-        DOUT("....." << v2r[v]);
+        WOUT("... computing initial placement using MIP, this may take a while ...");
+        solution = ql::initial_place::solve_mip(problem, loc, nullptr);
     }
-    DOUT("..1 nvq=" << nvq);
-    
-    // solve the problem
-    WOUT("... computing initial placement using MIP, this may take a while ...");
-    DOUT("InitialPlace: solving the problem, this may take a while ...");
-    DOUT("..2 nvq=" << nvq);
-    Mip::SolveExitStatus s;
-    DOUT("Just before solve: platformp=" << platformp << " nlocs=" << nlocs << " nvq=" << nvq << " gridp=" << gridp);
-    DOUT("Just before solve: objs=" << objs << " x.size()=" << x.size() << " w.size()=" << w.size() << " refcount.size()=" << refcount.size() << " v2i.size()=" << v2i.size() << " ipusecount.size()=" << ipusecount.size());
-    DOUT("..2b nvq=" << nvq);
+    else
     {
-        s = mip.solve();
+        WOUT("... computing initial placement using MIP, this may take a while ...");
+        timedout = PlaceWrapper(problem, loc, solution, initialplaceopt);
     }
-    DOUT("..3 nvq=" << nvq);
-    DOUT("Just after solve: platformp=" << platformp << " nlocs=" << nlocs << " nvq=" << nvq << " gridp=" << gridp);
-    DOUT("Just after solve: objs=" << objs << " x.size()=" << x.size() << " w.size()=" << w.size() << " refcount.size()=" << refcount.size() << " v2i.size()=" << v2i.size() << " ipusecount.size()=" << ipusecount.size());
     MapperAssert(nvq == nlocs);         // consistency check, mainly to let it crash
 
     // computing iptimetaken, stop interval timer
-    DOUT("..4 nvq=" << nvq);
     high_resolution_clock::time_point t2 = high_resolution_clock::now();
     duration<double> time_span = t2 - t1;
     iptimetaken = time_span.count();
-    DOUT("..5 nvq=" << nvq);
 
-    // DOUT("... determine result of solving");
-    Mip::ProblemType pt = mip.type();
-    DOUT("..6 nvq=" << nvq);
-    if (s != Mip::SOLVED || pt != Mip::OPTIMAL)
+    if (solution == ql::initial_place::solution_none)
     {
-        DOUT("... InitialPlace: no (optimal) solution found; solve returned:"<< s << " type returned:" << pt);
-        result = ipr_failed;
-        DOUT("InitialPlace.PlaceBody [FAILED, DID NOT FIND MAPPING]");
+        if (timedout)
+        {
+            result = ipr_timedout;
+            DOUT("InitialPlace.PlaceBody [TIMED OUT, DID NOT FIND MAPPING]");
+        }
+        else
+        {
+            result = ipr_failed;
+            DOUT("InitialPlace.PlaceBody [FAILED, DID NOT FIND MAPPING]");
+        }
         return;
     }
-    DOUT("..7 nvq=" << nvq);
+    if (timedout)
+    {
+        DOUT("InitialPlace: timed out, continuing from the best mapping found until then");
+    }
+    DOUT("InitialPlace: " << initialplacealgorithmopt << " found mapping with cost " << ql::initial_place::cost(problem, loc) << " in " << iptimetaken << " seconds");
 
     // return new mapping as result in v2r
 
-    // get the results: x[i][k] == 1 iff facility i is in location k (i.e. real qubit index k)
+    // loc[i] is the location of facility i (i.e. real qubit index k)
     // use v2i to translate facilities back to original virtual qubit indices
     // and fill v2r with the found locations for the used virtual qubits;
     // the unused mapped virtual qubits are mapped to an arbitrary permutation of the remaining locations;
     // the latter must be updated to generate swaps when mapping multiple kernels
-    DOUT("..8 nvq=" << nvq);
     DOUT("... interpret result and copy to Virt2Real, nvq=" << nvq);
     for (size_t v=0; v<nvq; v++)
     {
-        DOUT("... about to set v2r to undefined for v " << v);
         v2r[v] = UNDEFINED_QUBIT;      // i.e. undefined, i.e. v is not an index of a used virtual qubit
     }
-    for ( size_t i=0; i<nfac; i++ )
+    for (size_t v=0; v<nvq; v++)
     {
-        size_t v;   // found virtual qubit index v represented by facility i
-        // use v2i backward to find virtual qubit v represented by facility i
-        DOUT("... about to inspect v2i to get solution and set it in v2r for facility " << i);
-        for (v=0; v<nvq; v++)
+        if (v2i[v] != UNDEFINED_QUBIT)
         {
-            if (v2i[v] == i)
-            {
-                break;
-            }
-        }
-        MapperAssert(v < nvq);  // for each facility there must be a virtual qubit
-        size_t k;   // location to which facility i being virtual qubit index v was allocated
-        for (k=0; k<nlocs; k++ )
-        {
-            if (mip.sol(x[i][k]) == 1)
-            {
-                v2r[v] = k;
-                // v2r.rs[] is not updated because no gates were really mapped yet
-                break;
-            }
+            MapperAssert(loc[v2i[v]] < nlocs);  // each facility represents a used qubit so must have got a location
+            v2r[v] = loc[v2i[v]];
+            // v2r.rs[] is not updated because no gates were really mapped yet
         }
-        MapperAssert(k < nlocs);  // each facility i by definition represents a used qubit so must have got a location
-        DOUT("... end loop body over nfac");
     }
 
     auto mapinitone2oneopt = ql::options::get("mapinitone2one");
@@ -523,23 +352,12 @@ void PlaceBody( ql::circuit& circ, Virt2Real& v2r, ipr_t &result, double& iptime
     DOUT("InitialPlace.PlaceBody [SUCCESS, FOUND MAPPING]");
 }
 
-// the above PlaceBody is a regular function using circ, and updating v2r and result before it returns;
-// it implements Initial Placement as if the call to Place in the mapper called PlaceBody directly;
-// because it may take a while to return, a new Place and a PlaceWrapper are put in between;
-// the idea is to run PlaceBody in a detached thread, that, when ready, signals the main thread;
-// the main thread waits for this signal with a timeout value;
-// all this is done in a try block where the catch is called on this timeout;
-// why exceptions are used, is not clear, so it was replaced by PlaceWrapper returning "timedout" or not
-// and this works as well ...
-bool PlaceWrapper( ql::circuit& circ, Virt2Real& v2r, ipr_t& result, double& iptimetaken, std::string& initialplaceopt)
+// the time limit in seconds specified by a value of the initialplace option other than no and yes,
+// and whether compilation should stop when it expires
+int WaitSeconds(const std::string& initialplaceopt, bool& andthrowexception)
 {
-    DOUT("InitialPlace.PlaceWrapper called");
-    std::mutex  m;
-    std::condition_variable cv;
-
-    // prepare timeout
     int      waitseconds;
-    bool     andthrowexception = false;
+    andthrowexception = false;
     if ("1s" == initialplaceopt)        { waitseconds = 1; }
     else if ("1sx" == initialplaceopt)  { waitseconds = 1; andthrowexception = true; }
     else if ("10s" == initialplaceopt)  { waitseconds = 10; }
@@ -554,83 +372,87 @@ bool PlaceWrapper( ql::circuit& circ, Virt2Real& v2r, ipr_t& result, double& ipt
     {
         FATAL("Unknown value of option 'initialplace'='" << initialplaceopt << "'.");
     }
-    iptimetaken = waitseconds;    // pessimistic, in case of timeout, otherwise it is corrected
+    return waitseconds;
+}
 
-    // v2r and result are allocated on stack of main thread by some ancestor so be careful with threading
-    std::thread t([&cv, this, &circ, &v2r, &result, &iptimetaken]()
+// with a time limit, the MIP of PlaceBody is run by PlaceWrapper in a new thread
+// while the calling thread waits for it to complete, with the time limit as timeout;
+// when the timeout expires first, the MIP is cancelled and the thread is joined, which is soon after that
+// since PlaceBody only gets here with a cancellable MIP (or none), and the best solution found until then is returned,
+// if any; the calling thread then continues and PlaceWrapper returns "timedout"
+bool PlaceWrapper( const ql::initial_place::problem_t& problem, std::vector<size_t>& loc, ql::initial_place::solution_t& solution, const std::string& initialplaceopt)
+{
+    DOUT("InitialPlace.PlaceWrapper called");
+
+    // prepare timeout
+    bool     andthrowexception;
+    int      waitseconds = WaitSeconds(initialplaceopt, andthrowexception);
+
+    std::shared_ptr<MipJob> job = std::make_shared<MipJob>();
+    job->problem = problem;
+    std::thread t([job]()
         {
-            DOUT("InitialPlace.PlaceWrapper subthread about to call PlaceBody");
-            PlaceBody(circ, v2r, result, iptimetaken);
-            DOUT("InitialPlace.PlaceBody returned in subthread; about to signal the main thread");
-            cv.notify_one();        // by this, the main thread awakes from cv.wait_for without timeout
-            DOUT("InitialPlace.PlaceWrapper subthread after signaling the main thread, and is about to die");
+            ql::initial_place::solution_t   solution = ql::initial_place::solution_none;
+            std::vector<size_t>             loc;
+            std::exception_ptr              exception;
+            try
+            {
+                solution = ql::initial_place::solve_mip(job->problem, loc, &job->cancellation);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+            std::lock_guard<std::mutex> l(job->m);
+            job->solution = solution;
+            job->loc = loc;
+            job->exception = exception;
+            job->done = true;
+            job->cv.notify_one();   // by this, the main thread awakes from cv.wait_for without timeout
         }
     );
-    DOUT("InitialPlace.PlaceWrapper main code created thread; about to call detach on it");
-    t.detach();
-    DOUT("InitialPlace.PlaceWrapper main code detached thread");
+
+    bool timedout;
     {
-        std::chrono::seconds maxwaittime(waitseconds);
-        std::unique_lock<std::mutex> l(m);
+        std::unique_lock<std::mutex> l(job->m);
         DOUT("InitialPlace.PlaceWrapper main code starts waiting with timeout of " << waitseconds << " seconds");
-        if (cv.wait_for(l, maxwaittime) == std::cv_status::timeout)
-        {
-            DOUT("InitialPlace.PlaceWrapper main code awoke from waiting with timeout");
-            if (andthrowexception)
-            {
-                DOUT("InitialPlace: timed out and stops compilation [TIMED OUT, STOP COMPILATION]");
-                FATAL("Initial placement timed out and stops compilation [TIMED OUT, STOP COMPILATION]");
-            }
-            DOUT("InitialPlace.PlaceWrapper about to return timedout==true");
-            return true;
-        }
-        DOUT("InitialPlace.PlaceWrapper main code awoke from waiting without timeout, from signal sent by InitialPlace.PlaceWrapper subthread just before its death");
+        timedout = !job->cv.wait_for(l, std::chrono::seconds(waitseconds), [&job]() { return job->done; });
     }
-
-    DOUT("InitialPlace.PlaceWrapper about to return timedout==false");
-    return false;
+    if (timedout)
+    {
+        DOUT("InitialPlace.PlaceWrapper main code awoke from waiting with timeout; cancelling the MIP");
+        job->cancellation.cancel();
+    }
+    t.join();
+    if (job->exception)
+    {
+        std::rethrow_exception(job->exception);
+    }
+    solution = job->solution;
+    loc = job->loc;
+    if (timedout && andthrowexception)
+    {
+        DOUT("InitialPlace: timed out and stops compilation [TIMED OUT, STOP COMPILATION]");
+        FATAL("Initial placement timed out and stops compilation [TIMED OUT, STOP COMPILATION]");
+    }
+    DOUT("InitialPlace.PlaceWrapper about to return timedout==" << timedout);
+    return timedout;
 }
 
-// find an initial placement of the virtual qubits for the given circuit as in Place
+// find an initial placement of the virtual qubits for the given circuit as in PlaceBody
 // put a timelimit on its execution specified by the initialplace option
-// when it expires, result is set to ipr_timedout;
+// when it expires without a mapping, result is set to ipr_timedout;
 // details of how this is accomplished, can be found above;
-// v2r is updated by PlaceBody/PlaceWrapper when it has found a mapping
+// v2r is updated by PlaceBody when it has found a mapping
 void Place( ql::circuit& circ, Virt2Real& v2r, ipr_t& result, double& iptimetaken, std::string& initialplaceopt)
 {
-    Virt2Real   v2r_orig = v2r;
-
     DOUT("InitialPlace.Place ...");
-    if ("yes" == initialplaceopt)
-    {
-        // do initial placement without time limit
-        DOUT("InitialPlace.Place calling PlaceBody without time limit");
-        PlaceBody(circ, v2r, result, iptimetaken);
-        // v2r reflects new mapping, if any found, otherwise unchanged
-        DOUT("InitialPlace.Place [done, no time limit], result=" << result << " iptimetaken=" << iptimetaken << " seconds");
-    }
-    else
-    {
-        bool timedout;
-        timedout = PlaceWrapper(circ, v2r, result, iptimetaken, initialplaceopt);
-    
-        if (timedout)
-        {
-            result = ipr_timedout;
-            DOUT("InitialPlace.Place [done, TIMED OUT, NO MAPPING FOUND], result=" << result << " iptimetaken=" << iptimetaken << " seconds");
-
-            v2r = v2r_orig; // v2r may have got corrupted when timed out during v2r updating
-        }
-        else
-        {
-            // v2r reflects new mapping, if any found, otherwise unchanged
-            DOUT("InitialPlace.Place [done, not timed out], result=" << result << " iptimetaken=" << iptimetaken << " seconds");
-        }
-    }
+    PlaceBody(circ, v2r, result, iptimetaken, initialplaceopt);
+    // v2r reflects new mapping, if any found, otherwise unchanged
+    DOUT("InitialPlace.Place [done], result=" << result << " iptimetaken=" << iptimetaken << " seconds");
 }
     
 };  // end class InitialPlace
-#endif // INITIALPLACE
 
 // map kernel's circuit, main mapper entry once per kernel
 void Mapper::Map(ql::quantum_kernel& kernel)
@@ -653,20 +475,24 @@ void Mapper::Map(ql::quantum_kernel& kernel)
     std::string initialplaceopt = ql::options::get("initialplace");
     if("no" != initialplaceopt)
     {
-#ifdef INITIALPLACE
-        std::string initialplace2qhorizonopt = ql::options::get("initialplace2qhorizon");
-        DOUT("InitialPlace: kernel=" << kernel.name << " initialplace=" << initialplaceopt << " initialplace2qhorizon=" << initialplace2qhorizonopt << " [START]");
-        InitialPlace    ip;             // initial placer facility
-        ipr_t           ipok;           // one of several ip result possibilities
-        double          iptimetaken;      // time solving the initial placement took, in seconds
-        
-        ip.Init(&grid, platformp);
-        ip.Place(kernel.c, v2r, ipok, iptimetaken, initialplaceopt); // compute mapping (in v2r) using ip model, may fail
-        DOUT("InitialPlace: kernel=" << kernel.name << " initialplace=" << initialplaceopt << " initialplace2qhorizon=" << initialplace2qhorizonopt << " result=" << ip.ipr2string(ipok) << " iptimetaken=" << iptimetaken << " seconds [DONE]");
-#else // ifdef INITIALPLACE
-        DOUT("InitialPlace support disabled during OpenQL build [DONE]");
-        WOUT("InitialPlace support disabled during OpenQL build [DONE]");
-#endif // ifdef INITIALPLACE
+        std::string initialplacealgorithmopt = ql::options::get("initialplace_algorithm");
+        if ("mip" == initialplacealgorithmopt && !ql::initial_place::mip_supported())
+        {
+            DOUT("InitialPlace support disabled during OpenQL build [DONE]");
+            WOUT("InitialPlace support disabled during OpenQL build [DONE]");
+        }
+        else
+        {
+            std::string initialplace2qhorizonopt = ql::options::get("initialplace2qhorizon");
+            DOUT("InitialPlace: kernel=" << kernel.name << " initialplace=" << initialplaceopt << " initialplace2qhorizon=" << initialplace2qhorizonopt << " [START]");
+            InitialPlace    ip;             // initial placer facility
+            ipr_t           ipok;           // one of several ip result possibilities
+            double          iptimetaken;      // time solving the initial placement took, in seconds
+
+            ip.Init(&grid, platformp);
+            ip.Place(kernel.c, v2r, ipok, iptimetaken, initialplaceopt); // compute mapping (in v2r) using ip model, may fail
+            DOUT("InitialPlace: kernel=" << kernel.name << " initialplace=" << initialplaceopt << " initialplace2qhorizon=" << initialplace2qhorizonopt << " result=" << ip.ipr2string(ipok) << " iptimetaken=" << iptimetaken << " seconds [DONE]");
+        }
     }
     v2r.DPRINT("After InitialPlace");
 
@@ -19,6 +19,7 @@
 #include "gate.h"
 #include "scheduler.h"
 #include "metrics.h"
+#include "trace.h"
 
 // Note on the use of constructors and Init functions for classes of the mapper
 // -----------------------------------------------------------------------------
@@ -577,20 +578,8 @@ size_t StartCycle(ql::gate *g)
     {
         size_t      baseStartCycle = startCycle;
 
-        while (startCycle < MAX_CYCLE)
-        {
-            // DOUT("Startcycle for " << g->qasm() << ": available? at startCycle=" << startCycle);
-            if (rm.available(startCycle, g, *platformp))
-            {
-                // DOUT(" ... [" << startCycle << "] resources available for " << g->qasm());
-                break;
-            }   
-            else
-            {
-                // DOUT(" ... [" << startCycle << "] Busy resource for " << g->qasm());
-                startCycle++;
-            }
-        }
+        // the resources know the earliest cycle at which they are available, so no probing of each cycle
+        startCycle = rm.earliest_available(startCycle, g, *platformp);
         if (baseStartCycle != startCycle)
         {
             // DOUT(" ... from [" << baseStartCycle << "] to [" << startCycle-1 << "] busy resource(s) for " << g->qasm());
@@ -697,6 +686,8 @@ private:
                                         //        although updated by set_cycle called from MakeAvailable/TakeAvailable
     size_t                  nswapsadded;// number of swaps (including moves) added to this past
     size_t                  nmovesadded;// number of moves added to this past
+    bool                    trackfidelity;  // maintain fidstate, for mapper=maxfidelity
+    ql::FidelityState       fidstate;   // state: fidelity estimate of the gates in lg, updated as gates are scheduled
 
 public:
 
@@ -726,6 +717,8 @@ void Init(const ql::quantum_platform *p, ql::quantum_kernel *k)
     nswapsadded = 0;            // no swaps or moves added yet to this past; AddSwap adds one here
     nmovesadded = 0;            // no moves added yet to this past; AddSwap may add one here
     cycle.clear();              // no gates have cycles assigned in this past; scheduling gate updates this
+    trackfidelity = ("maxfidelity" == ql::options::get("mapper"));
+    fidstate.Init(nq);          // no gates in lg yet of which to estimate the fidelity
 }
 
 // import Past's v2r from v2r_value
@@ -808,6 +801,10 @@ void Schedule()
         fc.Add(gp, startCycle);
         cycle[gp] = startCycle; // cycle[gp] is private to this past but gp->cycle is private to gp
         gp->cycle = startCycle; // so gp->cycle gets assigned for each alter' Past and finally definitively for mainPast
+        if (trackfidelity)
+        {
+            fidstate.Add(gp);   // the gates on each qubit are scheduled in cycle order, as fidstate requires
+        }
         // DOUT("... set " << gp->qasm() << " at cycle " << startCycle);
     
         // insert gate gp in lg, the list of gates, in cycle[gp] order, and inside this order, as late as possible
@@ -907,6 +904,13 @@ bool new_gate(ql::circuit& circ, std::string gname, std::vector<size_t> qubits,
     return added;
 }
 
+// fidelity estimate of the gates scheduled so far, negated so that lower is better: read from fidstate, which Add()
+// updated incrementally as each gate was scheduled, and equal to ql::quick_fidelity of those gates in cycle order
+double Fidelity()
+{
+    return fidstate.Score();
+}
+
 // return number of swaps added to this past
 size_t NumberOfSwapsAdded()
 {
@@ -1241,17 +1245,27 @@ size_t MaxFreeCycle()
 // - nonq gates first cause lg to be flushed/cleared to output before the nonq gate is output
 // all gates in outlg are out of view for scheduling/mapping optimization and can be taken out to elsewhere
 void FlushAll()
+{
+    FlushWindow();
+    if (trackfidelity)
+    {
+        fidstate.Init(nq);  // the fidelity estimate starts afresh after a non-quantum gate, as lg did before
+    }
+}
+
+// move lg to outlg, so that the cost of cloning this past doesn't grow with the number of gates mapped;
+// the cycle values of the gates are kept in the gates, and the free cycles and fidelity estimate are unaffected,
+// so that the gates in outlg between non-quantum gates need to be stable sorted on cycle to get lg's order
+void FlushWindow()
 {
     for( auto & gp : lg )
     {
         outlg.push_back(gp);
     }
     lg.clear();         // so effectively, lg's content was moved to outlg
+    cycle.clear();      // cycle is only looked up for gates in lg
 
     // fc.Init(platformp); // needed?
-    // cycle.clear();      // needed?
-                        // cycle is initialized to empty map
-                        // is ok without windowing, but with window, just delete the ones outside the window
 }
 
 // gp as nonq gate immediately goes to outlg
@@ -1550,7 +1564,7 @@ void Extend(Past currPast, Past basePast)
     auto mapperopt = ql::options::get("mapper");
     if ("maxfidelity" == mapperopt)
     {
-        score = ql::quick_fidelity(past.lg);
+        score = past.Fidelity();
     }
     else
     {
@@ -1635,7 +1649,7 @@ void Split(std::list<Alter> & resla)
 // Grid public members (apart from nq):
 //  form:               how presence of neighbors relates to x/y coordinates of qubits
 //  Distance(qi,qj):    distance in physical connection hops from real qubit qi to real qubit qj;
-//                      - computing it relies on nbs (and Floyd-Warshall)
+//                      - computing it relies on nbs (and breadth-first search from qi, on its first use)
 //                      - in a fully assigned regular topology it could be defined by a formula (not supported)
 //  nbs[qi]:            list of neighbor real qubits of real qubit qi
 //                      - nbs can be derived from topology.edges or
@@ -1678,6 +1692,7 @@ public:
     std::map<size_t,int> x;             // x[i] is x coordinate of qubit i
     std::map<size_t,int> y;             // y[i] is y coordinate of qubit i
     std::vector<std::vector<size_t>>  dist; // dist[i][j] is computed distance between qubits i and j;
+                                        // row dist[i] is empty until the first distance from i is asked for
 
 // Grid initializer
 // initialize mapper internal grid maps from configuration
@@ -1718,7 +1733,8 @@ void Init(const ql::quantum_platform* p)
     InitXY();
     InitNbs();
     AngleSortNbs();
-    ComputeDist();
+    dist.clear();
+    dist.resize(nq);            // rows are computed by Distance on first use
     DPRINTGrid();
 }
 
@@ -1726,9 +1742,15 @@ void Init(const ql::quantum_platform* p)
 // formulae for convex (hole free) topologies with underlying grid and with bidirectional edges:
 //      gf_cross:   std::max( std::abs( x[to_realqi] - x[from_realqi] ), std::abs( y[to_realqi] - y[from_realqi] ))
 //      gf_plus:    std::abs( x[to_realqi] - x[from_realqi] ) + std::abs( y[to_realqi] - y[from_realqi] )
-// when the neighbor relation is defined (topology.edges in config file), Floyd-Warshall is used, which currently is always
+// when the neighbor relation is defined (topology.edges in config file), breadth-first search is used,
+// which currently is always; it computes the distances from from_realqi to all qubits the first time one is asked for;
+// so only the rows of the qubits involved in routing are computed
 size_t Distance(size_t from_realqi, size_t to_realqi)
 {
+    if (dist[from_realqi].empty())
+    {
+        ComputeDist(from_realqi);
+    }
     return dist[from_realqi][to_realqi];
 }
 
@@ -1800,51 +1822,27 @@ void Normalize( size_t src, neighbors_t& nbl )
     // for (auto dn : nbl) { std::cout << dn << " "; } std::cout << std::endl;
 }
 
-// Floyd-Warshall dist[i][j] = shortest distances between all nq qubits i and j
-void ComputeDist()
+// breadth-first search dist[src][j] = shortest distance from qubit src to each of all nq qubits j
+void ComputeDist(size_t src)
 {
-    // initialize all distances to maximum value, to neighbors to 1, to itself to 0
-    dist.resize(nq); for (size_t i=0; i<nq; i++) dist[i].resize(nq, MAX_CYCLE);
-    for (size_t i=0; i<nq; i++)
+    std::vector<size_t>& d = dist[src];
+    d.assign(nq, MAX_CYCLE);    // unreachable qubits keep the maximum value
+    d[src] = 0;
+    std::vector<size_t> queue;
+    queue.reserve(nq);
+    queue.push_back(src);
+    for (size_t h=0; h<queue.size(); h++)
     {
-        dist[i][i] = 0;
+        size_t i = queue[h];
         for (size_t j: nbs[i])
         {
-            dist[i][j] = 1;
-        }
-    }
-
-    // find shorter distances by gradually including more qubits (k) in path
-    for (size_t k=0; k<nq; k++)
-    {
-        for (size_t i=0; i<nq; i++)
-        {
-            for (size_t j=0; j<nq; j++)
+            if (d[j] == MAX_CYCLE)
             {
-               if (dist[i][j] > dist[i][k] + dist[k][j])
-               {
-                   dist[i][j] = dist[i][k] + dist[k][j];
-               }
+                d[j] = d[i] + 1;
+                queue.push_back(j);
             }
         }
     }
-#ifdef debug
-    for (size_t i=0; i<nq; i++)
-    {
-        for (size_t j=0; j<nq; j++)
-        {
-            if (form == gf_cross)
-            {
-                MapperAssert (dist[i][j] == (std::max( std::abs( x[i] - x[j] ), std::abs( y[i] - y[j] ))) );
-            }
-            else if (form == gf_plus)
-            {
-                MapperAssert (dist[i][j] == (std::abs( x[i] - x[j] ) + std::abs( y[i] - y[j] )) );
-            }
-
-        }
-    }
-#endif
 }
 
 void DPRINTGrid()
@@ -2000,6 +1998,17 @@ void AngleSortNbs()
 //
 // With option maplookaheadopt=="no", the future window's dependence graph (scheduled and avlist) are not used.
 // Instead a copy of the input circuit (input_gatepv) is created and iterated over (input_gatepp).
+//
+// Otherwise the avlist is represented by buckets of nodes with equal remaining value (criticality),
+// highest first, each bucket ordered by deep-criticality as the scheduler's avlist would be;
+// since deep-criticality first compares remaining values, the concatenation of the buckets
+// is identical to the scheduler's avlist but a node is inserted by only scanning its own bucket.
+// Whether a node was scheduled and whether it is available are flat vectors indexed by node id,
+// and the number of unscheduled predecessors of each node is counted,
+// so that taking a gate makes its successors available without inspecting their other predecessors.
+// The number of available gates of each kind (non-quantum, not needing routing, two-qubit) is maintained
+// so that the mapper only scans the avlist when there is something of the kind it looks for;
+// option maplookaheadwindow caps the number of two-qubit gates that GetGates returns to the mapper.
 
 class Future
 {
@@ -2008,8 +2017,21 @@ public:
     Scheduler                       *schedp;        // a pointer, since dependence graph doesn't change
     ql::circuit                     input_gatepv;   // input circuit when not using scheduler based avlist
 
-    std::map<ql::gate*,bool>        scheduled;      // state: has gate been scheduled, here: done from future?
-    std::list<ListDigraph::Node>    avlist;         // state: which nodes/gates are available for mapping now?
+    typedef enum
+    {
+        avnonquantum,   // classical and dummy gates
+        avnorouting,    // quantum gates that never need routing: wait and single-qubit gates
+        avtwoqubit      // two-qubit gates, they might need routing
+    } avkind_t;
+
+    std::vector<bool>               scheduled;      // state: [graph.id(n)]: has node been scheduled, here: done from future?
+    std::vector<bool>               available;      // state: [graph.id(n)]: is node in avlist?
+    std::vector<size_t>             npending;       // state: [graph.id(n)]: number of in-arcs from unscheduled nodes
+    std::map<size_t, std::list<ListDigraph::Node>, std::greater<size_t>>
+                                    avlist;         // state: which nodes/gates are available for mapping now?
+                                                    // by remaining value, highest first; per value by deep-criticality
+    size_t                          navailable[3];  // state: [avkind_t]: number of nodes of that kind in avlist
+    size_t                          lookaheadwindow;// max number of two-qubit gates returned by GetGates, 0 for all
     ql::circuit::iterator           input_gatepp;   // state: alternative iterator in input_gatepv
 
 // just program wide initialization
@@ -2037,15 +2059,20 @@ void SetCircuit(ql::quantum_kernel& kernel, Scheduler& sched, size_t nq, size_t
     {
         schedp->init(kernel.c, *platformp, nq, nc);             // fills schedp->graph (dependence graph) from all of circuit
                                                                 // and so also the original circuit can be output to after this
-        for( auto & gp : kernel.c )
+        size_t  nodecount = schedp->graph.maxNodeId() + 1;
+        scheduled.assign(nodecount, false);                     // none were scheduled, including SOURCE/SINK
+        available.assign(nodecount, false);
+        npending.assign(nodecount, 0);
+        for (ListDigraph::ArcIt a(schedp->graph); a != INVALID; ++a)
         {
-            scheduled[gp] = false;   // none were scheduled
+            npending[schedp->graph.id(schedp->graph.target(a))]++;
         }
-        scheduled[schedp->instruction[schedp->s]] = false;      // also the dummy nodes not
-        scheduled[schedp->instruction[schedp->t]] = false;
         avlist.clear();
-        avlist.push_back(schedp->s);
+        navailable[avnonquantum] = navailable[avnorouting] = navailable[avtwoqubit] = 0;
+        std::string windowopt = ql::options::get("maplookaheadwindow");
+        lookaheadwindow = ("all" == windowopt ? 0 : std::stoi(windowopt));
         schedp->set_remaining(ql::forward_scheduling);          // to know criticality
+        MakeAvailable(schedp->s);
 
         if (ql::options::get("print_dot_graphs") == "yes")
         {
@@ -2062,6 +2089,77 @@ void SetCircuit(ql::quantum_kernel& kernel, Scheduler& sched, size_t nq, size_t
     DOUT("Future::SetCircuit [DONE]");
 }
 
+// kind of gate of node n in avlist
+avkind_t AvKind(ListDigraph::Node n)
+{
+    ql::gate*  gp = schedp->instruction[n];
+    if (gp->type() == ql::__classical_gate__
+        || gp->type() == ql::__dummy_gate__
+        )
+    {
+        return avnonquantum;
+    }
+    if ( gp->type() == ql::gate_type_t::__wait_gate__
+        || gp->operands.size() == 1
+        )
+    {
+        return avnorouting;
+    }
+    return avtwoqubit;
+}
+
+// add node n to avlist, just after the last node that is not less deep-critical;
+// this is where Scheduler::MakeAvailable would insert it in its avlist
+void MakeAvailable(ListDigraph::Node n)
+{
+    size_t  id = schedp->graph.id(n);
+    if (available[id])
+    {
+        return;
+    }
+    available[id] = true;
+    navailable[AvKind(n)]++;
+    schedp->set_cycle_gate(schedp->instruction[n], ql::forward_scheduling);
+
+    auto&   bucket = avlist[schedp->remaining[n]];
+    auto    inp = bucket.begin();
+    while (inp != bucket.end() && !schedp->criticality_lessthan(*inp, n, ql::forward_scheduling))
+    {
+        inp++;
+    }
+    bucket.insert(inp, n);
+}
+
+// take node n out of avlist and make those successors available of which all predecessors have been scheduled now;
+// they are made available in the order of n's out-arcs, as Scheduler::TakeAvailable does
+void TakeAvailable(ListDigraph::Node n)
+{
+    size_t  id = schedp->graph.id(n);
+    scheduled[id] = true;
+    available[id] = false;
+    navailable[AvKind(n)]--;
+
+    auto    bucketp = avlist.find(schedp->remaining[n]);
+    bucketp->second.remove(n);
+    if (bucketp->second.empty())
+    {
+        avlist.erase(bucketp);
+    }
+
+    for (ListDigraph::OutArcIt succArc(schedp->graph,n); succArc != INVALID; ++succArc)
+    {
+        npending[schedp->graph.id(schedp->graph.target(succArc))]--;
+    }
+    for (ListDigraph::OutArcIt succArc(schedp->graph,n); succArc != INVALID; ++succArc)
+    {
+        ListDigraph::Node succNode = schedp->graph.target(succArc);
+        if (npending[schedp->graph.id(succNode)] == 0)
+        {
+            MakeAvailable(succNode);
+        }
+    }
+}
+
 // Get from avlist all gates that are non-quantum into nonqlg
 // Non-quantum gates include: classical, and dummy (SOURCE/SINK)
 // Return whether some non-quantum gate was found
@@ -2082,23 +2180,25 @@ bool GetNonQuantumGates(std::list<ql::gate*>& nonqlg)
             }
         }
     }
-    else
+    else if (navailable[avnonquantum] != 0)
     {
-        for ( auto n : avlist)
+        for ( auto& bucket : avlist)
         {
-            ql::gate*  gp = schedp->instruction[n];
-            if (gp->type() == ql::__classical_gate__
-                || gp->type() == ql::__dummy_gate__
-                )
+            for ( auto n : bucket.second)
             {
-                nonqlg.push_back(gp);
+                if (AvKind(n) == avnonquantum)
+                {
+                    nonqlg.push_back(schedp->instruction[n]);
+                }
             }
         }
     }
     return nonqlg.size() != 0;
 }
 
-// Get all gates from avlist into qlg
+// Get gates from avlist into qlg:
+// when there are gates not needing routing, only the most critical of these;
+// otherwise the two-qubit gates, most critical first, at most lookaheadwindow of them when it is not 0
 // Return whether some gate was found
 bool GetGates(std::list<ql::gate*>& qlg)
 {
@@ -2118,14 +2218,27 @@ bool GetGates(std::list<ql::gate*>& qlg)
     }
     else
     {
-        for ( auto n : avlist)
+        avkind_t    kind = (navailable[avnorouting] != 0 ? avnorouting : avtwoqubit);
+        size_t      maxcount = (kind == avnorouting ? 1 : lookaheadwindow);
+        for ( auto& bucket : avlist)
         {
-            ql::gate*  gp = schedp->instruction[n];
-            if (gp->operands.size() > 2)
+            for ( auto n : bucket.second)
             {
-                FATAL(" gate: " << gp->qasm() << " has more than 2 operand qubits; please decompose such gates first before mapping.");
+                if (AvKind(n) != kind)
+                {
+                    continue;
+                }
+                ql::gate*  gp = schedp->instruction[n];
+                if (gp->operands.size() > 2)
+                {
+                    FATAL(" gate: " << gp->qasm() << " has more than 2 operand qubits; please decompose such gates first before mapping.");
+                }
+                qlg.push_back(gp);
+                if (qlg.size() == maxcount)
+                {
+                    return true;
+                }
             }
-            qlg.push_back(gp);
         }
     }
     return qlg.size() != 0;
@@ -2142,7 +2255,7 @@ void DoneGate(ql::gate* gp)
     }
     else
     {
-        schedp->TakeAvailable(schedp->node[gp], avlist, scheduled, ql::forward_scheduling);
+        TakeAvailable(schedp->node[gp]);
     }
 }
 
@@ -2250,10 +2363,26 @@ private:
                                     // Initialized by Mapper.Map
     std::mt19937    gen;            // Standard mersenne_twister_engine, not yet seeded
 
+                                    // Initialized by MapCircuit, option mapbudget; used by MapGates and SelectAlter
+    typedef std::chrono::steady_clock budget_clock;
+    bool            budgeted;       // is there a time budget for SelectAlter's recursion in this kernel?
+    budget_clock::time_point budgetend;  // when the kernel's time budget runs out
+    budget_clock::time_point selectend;  // when the current decision's part of the budget runs out
+    size_t          ntwoqubit;      // number of two-qubit gates in the kernel, to spread the budget over
+    int             selectmaxlevel; // max level of recursion of SelectAlter in the current search
+    bool            selectcutoff;   // did the current search stop recursion at selectmaxlevel?
+    bool            selectaborted;  // did the current search stop recursion because selectend passed?
+
 public:
                                     // Passed back by Mapper::Map to caller for reporting
     size_t          nswapsadded;    // number of swaps added (including moves)
     size_t          nmovesadded;    // number of moves added
+    size_t          ndecisions;     // number of routing decisions taken, i.e. number of calls of SelectAlter at level 0
+    size_t          nexpansions;    // number of calls of SelectAlter, at any level
+    int             mindepth;       // with mapbudget: min over decisions of max recursion level of the deepest full search
+    int             maxdepth;       // with mapbudget: max over decisions of the same
+    double          sumdepth;       // with mapbudget: sum over decisions of the same, for the average
+    double          budgetused;     // with mapbudget: time in ms spent in routing decisions
     std::vector<size_t> v2r_in;     // v2r[virtual qubit index] -> real qubit index | UNDEFINED_QUBIT
     std::vector<int>    rs_in;      // rs[real qubit index] -> {nostate|wasinited|hasstate}
     std::vector<size_t> v2r_ip;     // v2r[virtual qubit index] -> real qubit index | UNDEFINED_QUBIT
@@ -2682,7 +2811,8 @@ bool MapMappableGates(Future& future, Past& past, std::list<ql::gate*>& lg, bool
 // - if minextend[rc], select Alter from list of Alters with minimal cycle extension of given past
 //   when several remain with equal minimum extension, recurse to reduce this set of remaining ones
 //   - level: level of recursion at which SelectAlter is called: 0 is base, 1 is 1st, etc.
-//   - option mapselectmaxlevel: max level of recursion to use, where inf indicates no maximum
+//   - selectmaxlevel: max level of recursion to use, from option mapselectmaxlevel (inf indicates no maximum)
+//     or lower as set by SelectAlterInBudget
 // - maptiebreak option indicates which one to take when several (still) remain
 // result is returned in resa
 void SelectAlter(std::list<Alter>& la, Alter & resa, Future& future, Past& past, Past& basePast, int level)
@@ -2693,6 +2823,9 @@ void SelectAlter(std::list<Alter>& la, Alter & resa, Future& future, Past& past,
     std::list<Alter> gla;       // good alternative subset of la, suitable to go in recursion with
     std::list<Alter> bla;       // best alternative subset of gla, suitable to choose result from
 
+    QL_TRACE_SPAN("mapper", "SelectAlter", (int64_t)level);
+    ql::trace::counter("mapper", "alternatives", la.size());
+    nexpansions++;
     DOUT("SelectAlter ENTRY level=" << level << " from " << la.size() << " alternatives");
     auto mapperopt = ql::options::get("mapper");
     if (mapperopt == "base"|| mapperopt == "baserc")
@@ -2761,13 +2894,18 @@ void SelectAlter(std::list<Alter>& la, Alter & resa, Future& future, Past& past,
     Alter::DPRINT("... SelectAlter good alternatives before recursion:", gla);
 
     // Prepare for recursion;
-    // option mapselectmaxlevel indicates the maximum level of recursion (0 is no recursion)
-    auto mapselectmaxlevelstring = ql::options::get("mapselectmaxlevel");
-    int  mapselectmaxlevel = ("inf" == mapselectmaxlevelstring) ?  MAX_CYCLE : atoi(mapselectmaxlevelstring.c_str());
+    // selectmaxlevel indicates the maximum level of recursion (0 is no recursion),
+    // set by MapGates from option mapselectmaxlevel, or lower for a search within the time budget (option mapbudget);
+    // when the current decision's part of the budget has run out, the search is aborted by not recursing anymore
+    if (level > 0 && budgeted && budget_clock::now() > selectend)
+    {
+        selectaborted = true;
+    }
 
     // When maxlevel has been reached, stop the recursion, and choose from the best minextend/maxfidelity alternatives
-    if (level >= mapselectmaxlevel)
+    if (level >= selectmaxlevel || selectaborted)
     {
+        selectcutoff = true;
         // Reduce list of good alternatives (gla) to list of minextend/maxfidelity best alternatives (bla)
         // and make a choice from that list to return as result
         bla = gla;
@@ -2841,7 +2979,7 @@ void SelectAlter(std::list<Alter>& la, Alter & resa, Future& future, Past& past,
             auto mapperopt = ql::options::get("mapper");
             if ("maxfidelity" == mapperopt)
             {
-                a.score = ql::quick_fidelity(past_copy.lg);
+                a.score = past_copy.Fidelity();
             }
             else
             {
@@ -2866,30 +3004,102 @@ void SelectAlter(std::list<Alter>& la, Alter & resa, Future& future, Past& past,
     DOUT("SelectAlter DONE level=" << level << " from " << la.size() << " alternatives");
 }
 
+// select Alter as SelectAlter does, within the part of the kernel's time budget (option mapbudget) for this decision;
+// this part is what remains of the budget divided by the number of two-qubit gates that may still need routing.
+// Recursion is done by iterative deepening: SelectAlter at level 0 without recursion, then with recursion
+// to max level 1, 2, etc., until option mapselectmaxlevel is reached, the search reached the end of the circuit
+// or the next search is predicted not to finish in time, by its growth from the previous one;
+// a search that doesn't finish in time is aborted and the result of the deepest finished search is returned in resa.
+// So when the budget runs out, the mapper degrades to selecting alternatives without recursion.
+void SelectAlterInBudget(std::list<Alter>& la, Alter & resa, Future& future, Past& past, Past& basePast, int maxlevel)
+{
+    typedef std::chrono::duration<double, std::milli> ms;
+
+    budget_clock::time_point start = budget_clock::now();
+    double  remaining = std::max(0.0, ms(budgetend - start).count());
+    double  allowed = remaining / (ntwoqubit > ndecisions ? ntwoqubit - ndecisions : 1);
+    selectend = start + std::chrono::duration_cast<budget_clock::duration>(ms(allowed));
+
+    int     depth = 0;                      // max level of the deepest search that finished
+    double  prevtime = 0.0;                 // time taken by the previous search
+    double  growth = 2.0;                   // predicted ratio of time taken by next and previous search
+    for (int maxlvl = 0; ; maxlvl++)
+    {
+        budget_clock::time_point t1 = budget_clock::now();
+        std::list<Alter> lac = la;          // copy since SelectAlter extends and sorts, and an aborted search is dropped
+        Alter   resac;
+        selectmaxlevel = maxlvl;
+        selectcutoff = false;
+        selectaborted = false;
+        SelectAlter(lac, resac, future, past, basePast, 0);
+        if (selectaborted)
+        {
+            DOUT("SelectAlterInBudget: search to level " << maxlvl << " aborted, keeping level " << depth);
+            break;
+        }
+        resa = resac;
+        depth = maxlvl;
+
+        budget_clock::time_point t2 = budget_clock::now();
+        double  thistime = ms(t2 - t1).count();
+        if (maxlvl > 0 && prevtime > 0.0)
+        {
+            growth = std::max(1.0, thistime / prevtime);
+        }
+        prevtime = thistime;
+        if (!selectcutoff || maxlvl >= maxlevel || t2 + std::chrono::duration_cast<budget_clock::duration>(ms(thistime * growth)) > selectend)
+        {
+            break;
+        }
+    }
+
+    ql::trace::counter("mapper", "depth", depth);
+    mindepth = std::min(mindepth, depth);
+    maxdepth = std::max(maxdepth, depth);
+    sumdepth += depth;
+    budgetused += ms(budget_clock::now() - start).count();
+}
+
 // Given the states of past and future
 // map all mappable gates and find the non-mappable ones
 // for those evaluate what to do next and do it;
 // during recursion, comparison is done with the base past (bottom of recursion stack),
 // and past is the last past (top of recursion stack) relative to which the mapping is done.
-void MapGates(Future& future, Past& past, Past& basePast)
+void MapGates(Future& future, Past& past, Past& basePast, ql::circuit& outCirc)
 {
     std::list<ql::gate*>   lg;              // list of non-mappable gates taken from avlist, as returned from MapMappableGates
     std::string maplookaheadopt = ql::options::get("maplookahead");
     bool alsoNN2q = ( "noroutingfirst" == maplookaheadopt || "all" == maplookaheadopt );
+    // option mapselectmaxlevel indicates the maximum level of recursion (0 is no recursion)
+    auto mapselectmaxlevelstring = ql::options::get("mapselectmaxlevel");
+    int  mapselectmaxlevel = ("inf" == mapselectmaxlevelstring) ?  MAX_CYCLE : atoi(mapselectmaxlevelstring.c_str());
     while (MapMappableGates(future, past, lg, alsoNN2q))  // returns false when no gates remain
     {
         // all gates in lg are two-qubit quantum gates that cannot be mapped
         // select which one(s) to (partially) route, according to one of the known strategies
         // the only requirement on the code below is that at least something is done that decreases the problem
 
+        // keep the cost of cloning past for each alternative independent of the number of gates mapped before
+        past.FlushWindow();
+        past.Out(outCirc);
+
         // generate all variations
         std::list<Alter> la;                // list that will hold all variations, as returned by GenAlters
         GenAlters(lg, la, past);            // gen all possible variations to make gates in lg NN, in current past.v2r mapping
     
         // select best one
         Alter resa;
-        SelectAlter(la, resa, future, past, basePast, 0);
+        if (budgeted)
+        {
+            SelectAlterInBudget(la, resa, future, past, basePast, mapselectmaxlevel);
+        }
+        else
+        {
+            selectmaxlevel = mapselectmaxlevel;
+            SelectAlter(la, resa, future, past, basePast, 0);
+        }
                                             // select one according to strategy specified by options; result in resa
+        ndecisions++;
     
         // commit to best one
         // add all or just one swap, as described by resa, to THIS past, and schedule them/it in
@@ -2897,35 +3107,448 @@ void MapGates(Future& future, Past& past, Past& basePast)
     }
 }
 
+// SABRE: swap-based bidirectional heuristic search (Li, Ding and Xie, ASPLOS 2019), option mapper=sabre.
+// Unlike the other mapper heuristics, it doesn't generate Alters with cloned Pasts to evaluate routing alternatives.
+// It maintains a front layer of two-qubit gates of which all dependences have been mapped but that are not NN,
+// and repeatedly applies the single swap on an edge touching an operand of a front gate that minimizes the cost:
+// the average distance between the operands of the front gates after the swap,
+// plus sabre_extended_weight times that average of an extended set of the next two-qubit gates in the dependence graph,
+// multiplied by a decay factor of the swapped qubits that discourages swapping the same qubits again and again.
+// The cost of a candidate swap is computed from the gates with an operand in one of its two qubits only,
+// so that a step is linear in the number of candidates and the work is near-linear in the number of gates.
+// When swapping doesn't make a front gate NN for a long time, the first front gate is routed along a shortest path.
+//
+// Starting from the kernel's initial mapping, a forward pass over the dependence graph and a backward pass
+// over the reversed graph, which only update a copy of the Virt2Real map, produce an improved initial mapping;
+// with that mapping, a final forward pass maps the gates and adds the swaps to the main Past.
+
+// one SABRE pass over the dependence graph in direction dir, starting from and updating the mapping in v2r;
+// with pastp nullptr, only v2r is updated, otherwise the mapped gates and the swaps are also added to *pastp,
+// of which the map must be equal to v2r initially; both maps are kept equal
+void SabrePass(Scheduler& sched, ql::scheduling_direction_t dir, Virt2Real& v2r, Past* pastp)
+{
+    const size_t    sabre_extended_size = 20;       // max number of two-qubit gates in the extended set
+    const double    sabre_extended_weight = 0.5;    // weight of the extended set relative to the front layer
+    const double    sabre_decay_delta = 0.001;      // increment of the decay factor of a swapped qubit
+    const size_t    sabre_decay_reset = 5;          // number of swaps after which the decay factors are reset
+
+    QL_TRACE_SPAN("mapper", "SabrePass", (int64_t)(pastp != nullptr));
+    bool            forward = (ql::forward_scheduling == dir);
+    ListDigraph&    graph = sched.graph;
+    size_t          nodecount = graph.maxNodeId() + 1;
+
+    std::vector<size_t> npending(nodecount, 0);     // number of dependences of node that were not mapped yet
+    for (ListDigraph::ArcIt a(graph); a != INVALID; ++a)
+    {
+        npending[graph.id(forward ? graph.target(a) : graph.source(a))]++;
+    }
+    std::vector<size_t> visited(nodecount, 0);      // stamp of the last extended set computation that visited node
+    size_t              visitstamp = 0;
+
+    std::list<ListDigraph::Node>    ready;          // nodes of which all dependences were mapped, to be inspected
+    std::list<ListDigraph::Node>    front;          // 2q gates of which all dependences were mapped but which are not NN
+    std::list<ListDigraph::Node>    extended;       // next 2q gates after the front layer
+    bool                            frontchanged = true;
+    std::vector<double>             decay(nq, 1.0);
+    std::vector<size_t>             decayed;        // real qubits of which decay is not 1.0
+    size_t                          nswaps = 0;     // swaps since the decay factors were reset
+    size_t                          nstalled = 0;   // swaps since a gate was mapped
+    size_t                          maxstalled = 0;
+    std::vector<std::list<std::pair<size_t,double>>>    incident(nq);   // [r]: (gate index, weight) of gates on r
+    std::vector<std::pair<size_t,size_t>>               gates;          // virtual operands of front and extended gates
+
+    ready.push_back(forward ? sched.s : sched.t);
+
+    auto mapqubit = [&](size_t v) -> size_t
+    {
+        size_t r = v2r[v];
+        if (r == UNDEFINED_QUBIT)
+        {
+            r = v2r.AllocQubit(v);
+            if (pastp != nullptr)
+            {
+                MapperAssert(pastp->MapQubit(v) == r);
+            }
+        }
+        return r;
+    };
+    auto isquantum = [&](ql::gate* gp) -> bool
+    {
+        return gp->type() != ql::__classical_gate__ && gp->type() != ql::__dummy_gate__;
+    };
+    auto istwoqubit = [&](ql::gate* gp) -> bool
+    {
+        return isquantum(gp) && gp->type() != ql::gate_type_t::__wait_gate__ && gp->operands.size() == 2;
+    };
+    auto resetdecay = [&]()
+    {
+        for (auto r : decayed)
+        {
+            decay[r] = 1.0;
+        }
+        decayed.clear();
+        nswaps = 0;
+    };
+    auto swap = [&](size_t r0, size_t r1)
+    {
+        v2r.Swap(r0, r1);
+        if (pastp != nullptr)
+        {
+            pastp->AddSwap(r0, r1);
+            pastp->Schedule();
+            pastp->FlushAll();
+        }
+    };
+
+    while (true)
+    {
+        // map the ready gates that don't need routing, making their dependents ready; put the others in front
+        while (!ready.empty())
+        {
+            ListDigraph::Node   n = ready.front();
+            ready.pop_front();
+            ql::gate*           gp = sched.instruction[n];
+            if (isquantum(gp))
+            {
+                if (gp->operands.size() > 2 && gp->type() != ql::gate_type_t::__wait_gate__)
+                {
+                    FATAL(" gate: " << gp->qasm() << " has more than 2 operand qubits; please decompose such gates first before mapping.");
+                }
+                for (auto v : gp->operands)
+                {
+                    mapqubit(v);
+                }
+                if (istwoqubit(gp) && grid.Distance(v2r[gp->operands[0]], v2r[gp->operands[1]]) != 1)
+                {
+                    front.push_back(n);
+                    frontchanged = true;
+                    continue;
+                }
+                if (pastp != nullptr)
+                {
+                    // flushing keeps Past::Schedule from scanning a long list of gates to insert a gate in cycle order;
+                    // SABRE doesn't compare Pasts, so the output needs not be in cycle order, just in topological order
+                    MapRoutedGate(gp, *pastp);
+                    pastp->FlushAll();
+                }
+            }
+            else if (pastp != nullptr && gp->type() != ql::__dummy_gate__)
+            {
+                pastp->ByPass(gp);
+            }
+            if (forward)
+            {
+                for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc)
+                {
+                    if (--npending[graph.id(graph.target(arc))] == 0)
+                    {
+                        ready.push_back(graph.target(arc));
+                    }
+                }
+            }
+            else
+            {
+                for (ListDigraph::InArcIt arc(graph, n); arc != INVALID; ++arc)
+                {
+                    if (--npending[graph.id(graph.source(arc))] == 0)
+                    {
+                        ready.push_back(graph.source(arc));
+                    }
+                }
+            }
+            nstalled = 0;
+            if (!decayed.empty())
+            {
+                resetdecay();
+            }
+        }
+        if (front.empty())
+        {
+            break;
+        }
+
+        if (nstalled == 0)
+        {
+            maxstalled = 0;
+            for (auto n : front)
+            {
+                auto& q = sched.instruction[n]->operands;
+                size_t d = grid.Distance(v2r[q[0]], v2r[q[1]]);
+                if (d == MAX_CYCLE)
+                {
+                    FATAL("SabrePass: no path between real qubits " << v2r[q[0]] << " and " << v2r[q[1]] << " of gate " << sched.instruction[n]->qasm() << " in the platform's topology");
+                }
+                maxstalled = std::max(maxstalled, d);
+            }
+            maxstalled = 3 * maxstalled + 10;
+        }
+        if (nstalled >= maxstalled)
+        {
+            // no progress by the cost function, so route the first front gate along a shortest path
+            auto&   q = sched.instruction[front.front()]->operands;
+            size_t  src = v2r[q[0]];
+            size_t  tgt = v2r[q[1]];
+            DOUT("SabrePass: stalled, routing " << sched.instruction[front.front()]->qasm() << " along a shortest path");
+            if (grid.Distance(src, tgt) == MAX_CYCLE)
+            {
+                FATAL("SabrePass: no path between real qubits " << src << " and " << tgt << " of gate " << sched.instruction[front.front()]->qasm() << " in the platform's topology");
+            }
+            while (grid.Distance(src, tgt) > 1)
+            {
+                bool    progress = false;
+                for (auto nb : grid.nbs[src])
+                {
+                    if (grid.Distance(nb, tgt) + 1 == grid.Distance(src, tgt))
+                    {
+                        swap(src, nb);
+                        src = nb;
+                        progress = true;
+                        break;
+                    }
+                }
+                if (!progress)
+                {
+                    FATAL("SabrePass: no neighbor of real qubit " << src << " is closer to real qubit " << tgt);
+                }
+            }
+        }
+        else
+        {
+            // the extended set: the first two-qubit gates found by a breadth-first search from the front layer
+            if (frontchanged)
+            {
+                extended.clear();
+                visitstamp++;
+                std::list<ListDigraph::Node>    bfs(front.begin(), front.end());
+                for (auto n : front)
+                {
+                    visited[graph.id(n)] = visitstamp;
+                }
+                size_t  nvisits = 0;
+                while (!bfs.empty() && extended.size() < sabre_extended_size && nvisits < 10*sabre_extended_size)
+                {
+                    ListDigraph::Node   n = bfs.front();
+                    bfs.pop_front();
+                    std::vector<ListDigraph::Node>  dependents;
+                    if (forward)
+                    {
+                        for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc) dependents.push_back(graph.target(arc));
+                    }
+                    else
+                    {
+                        for (ListDigraph::InArcIt arc(graph, n); arc != INVALID; ++arc) dependents.push_back(graph.source(arc));
+                    }
+                    for (auto d : dependents)
+                    {
+                        if (visited[graph.id(d)] == visitstamp)
+                        {
+                            continue;
+                        }
+                        visited[graph.id(d)] = visitstamp;
+                        nvisits++;
+                        ql::gate*   gp = sched.instruction[d];
+                        if (istwoqubit(gp) && v2r[gp->operands[0]] != UNDEFINED_QUBIT && v2r[gp->operands[1]] != UNDEFINED_QUBIT
+                            && extended.size() < sabre_extended_size)
+                        {
+                            extended.push_back(d);
+                        }
+                        bfs.push_back(d);
+                    }
+                }
+                frontchanged = false;
+            }
+
+            // cost of the current mapping and the gates incident to each real qubit
+            gates.clear();
+            double  basecost = 0.0;
+            for (auto lp : { &front, &extended })
+            {
+                double  weight = (lp == &front ? 1.0 : sabre_extended_weight) / std::max<size_t>(lp->size(), 1);
+                for (auto n : *lp)
+                {
+                    auto&   q = sched.instruction[n]->operands;
+                    size_t  r0 = v2r[q[0]];
+                    size_t  r1 = v2r[q[1]];
+                    incident[r0].push_back(std::make_pair(gates.size(), weight));
+                    incident[r1].push_back(std::make_pair(gates.size(), weight));
+                    gates.push_back(std::make_pair(q[0], q[1]));
+                    basecost += weight * grid.Distance(r0, r1);
+                }
+            }
+
+            // evaluate the swaps on the edges touching an operand of a front gate
+            double  bestcost = 0.0;
+            size_t  bestr0 = UNDEFINED_QUBIT;
+            size_t  bestr1 = UNDEFINED_QUBIT;
+            for (auto n : front)
+            {
+                for (auto v : sched.instruction[n]->operands)
+                {
+                    size_t  r0 = v2r[v];
+                    for (auto r1 : grid.nbs[r0])
+                    {
+                        auto moved = [&](size_t r) { return r == r0 ? r1 : (r == r1 ? r0 : r); };
+                        double  delta = 0.0;
+                        for (auto r : { r0, r1 })
+                        {
+                            for (auto& gw : incident[r])
+                            {
+                                size_t  g0 = v2r[gates[gw.first].first];
+                                size_t  g1 = v2r[gates[gw.first].second];
+                                if (r == r1 && (g0 == r0 || g1 == r0))
+                                {
+                                    continue;   // already done for r0
+                                }
+                                delta += gw.second * ((double)grid.Distance(moved(g0), moved(g1)) - (double)grid.Distance(g0, g1));
+                            }
+                        }
+                        double  cost = std::max(decay[r0], decay[r1]) * (basecost + delta);
+                        if (bestr0 == UNDEFINED_QUBIT || cost < bestcost)
+                        {
+                            bestcost = cost;
+                            bestr0 = r0;
+                            bestr1 = r1;
+                        }
+                    }
+                }
+            }
+            for (auto lp : { &front, &extended })
+            {
+                for (auto n : *lp)
+                {
+                    auto&   q = sched.instruction[n]->operands;
+                    incident[v2r[q[0]]].clear();
+                    incident[v2r[q[1]]].clear();
+                }
+            }
+
+            MapperAssert(bestr0 != UNDEFINED_QUBIT);
+            DOUT("SabrePass: swap(q" << bestr0 << ",q" << bestr1 << ") with cost " << bestcost);
+            swap(bestr0, bestr1);
+            for (auto r : { bestr0, bestr1 })
+            {
+                if (decay[r] == 1.0)
+                {
+                    decayed.push_back(r);
+                }
+                decay[r] += sabre_decay_delta;
+            }
+            if (++nswaps >= sabre_decay_reset)
+            {
+                resetdecay();
+            }
+        }
+        nstalled++;
+
+        // the front gates that became NN are ready now
+        for (auto fi = front.begin(); fi != front.end(); )
+        {
+            auto&   q = sched.instruction[*fi]->operands;
+            if (grid.Distance(v2r[q[0]], v2r[q[1]]) == 1)
+            {
+                ready.push_back(*fi);
+                fi = front.erase(fi);
+                frontchanged = true;
+            }
+            else
+            {
+                fi++;
+            }
+        }
+    }
+}
+
+// improve the initial mapping in v2r by a forward and a backward SabrePass, keeping only the resulting mapping;
+// the states of the real qubits are not changed, they are the same for all real qubits when a kernel starts
+void SabreInitialMapping(Scheduler& sched, Virt2Real& v2r)
+{
+    Virt2Real   trial = v2r;
+    SabrePass(sched, ql::forward_scheduling, trial, nullptr);
+    SabrePass(sched, ql::backward_scheduling, trial, nullptr);
+    for (size_t v = 0; v < nq; v++)
+    {
+        v2r[v] = trial[v];
+    }
+}
+
 // Map the circuit's gates in the provided context (v2r maps), updating circuit and v2r maps
 void MapCircuit(ql::quantum_kernel& kernel, Virt2Real& v2r)
 {
     Future  future;         // future window, presents input in avlist
     Past    mainPast;       // past window, contains output schedule, storing all gates until taken out
     Scheduler sched;        // new scheduler instance (from src/scheduler.h) used for its dependence graph
+    ql::circuit outCirc;    // output circuit, taken from mainPast while and after mapping
+
+    std::string mapperopt = ql::options::get("mapper");
+
+    // option mapbudget is spread over the routing decisions, of which there are about as many as two-qubit gates;
+    // the option only accepts numbers of at least 0
+    double budget = std::stod(ql::options::get("mapbudget"));
+    budgeted = (budget > 0.0);
+    selectcutoff = false;
+    selectaborted = false;  // only set when budgeted, so searches without budget are never aborted
+    budgetend = budget_clock::now() + std::chrono::duration_cast<budget_clock::duration>(std::chrono::duration<double, std::milli>(budget));
+    ntwoqubit = std::count_if(kernel.c.begin(), kernel.c.end(), [](ql::gate* gp) { return gp->type() != ql::__classical_gate__ && gp->operands.size() == 2; });
+    ndecisions = 0;
+    nexpansions = 0;
+    mindepth = MAX_CYCLE;
+    maxdepth = 0;
+    sumdepth = 0.0;
+    budgetused = 0.0;
 
-    future.Init(platformp);
-    future.SetCircuit(kernel, sched, nq, nc); // constructs depgraph, initializes avlist, ready for producing gates
-    kernel.c.clear();       // future has copied kernel.c to private data; kernel.c ready for use by new_gate
+    if ("sabre" == mapperopt)
+    {
+        sched.init(kernel.c, *platformp, nq, nc);   // constructs depgraph, SabrePass walks it in both directions
+    }
+    else
+    {
+        future.Init(platformp);
+        future.SetCircuit(kernel, sched, nq, nc); // constructs depgraph, initializes avlist, ready for producing gates
+    }
+    kernel.c.clear();       // future/sched has copied kernel.c to private data; kernel.c ready for use by new_gate
     kernelp = &kernel;      // keep kernel to call kernelp->gate() inside Past.new_gate(), to create new gates
 
     mainPast.Init(platformp, kernelp);  // mainPast and Past clones inside Alters ready for generating output schedules into
+    if ("sabre" == mapperopt)
+    {
+        SabreInitialMapping(sched, v2r);
+        v2r.DPRINT("After SabreInitialMapping");
+    }
     mainPast.ImportV2r(v2r);    // give it the current mapping/state
     // mainPast.DPRINT("start mapping");
 
-    MapGates(future, mainPast, mainPast);
+    if ("sabre" == mapperopt)
+    {
+        SabrePass(sched, ql::forward_scheduling, v2r, &mainPast);
+    }
+    else
+    {
+        MapGates(future, mainPast, mainPast, outCirc);
+    }
     mainPast.FlushAll();                // all output to mainPast.outlg, the output window of mainPast
 
     // mainPast.DPRINT("end mapping");
 
     DOUT("... retrieving outCirc from mainPast.outlg; swapping outCirc with kernel.c, kernel.c contains output circuit");
-    ql::circuit outCirc;
     mainPast.Out(outCirc);                          // copy (final part of) mainPast's output window into this outCirc
+
+    // MapGates and SabrePass flushed mainPast while mapping, so sort the gates on cycle between the non-quantum gates
+    auto first = outCirc.begin();
+    while (first != outCirc.end())
+    {
+        auto last = std::find_if(first, outCirc.end(), [](ql::gate* gp) { return gp->type() == ql::__classical_gate__; });
+        std::stable_sort(first, last, [](ql::gate* gp1, ql::gate* gp2) { return gp1->cycle < gp2->cycle; });
+        first = (last == outCirc.end() ? last : std::next(last));
+    }
     kernel.c.swap(outCirc);                         // and then to kernel.c
     kernel.cycles_valid = true;                     // decomposition was scheduled in; see Past.Add() and Past.Schedule()
     mainPast.ExportV2r(v2r);
     nswapsadded = mainPast.NumberOfSwapsAdded();
     nmovesadded = mainPast.NumberOfMovesAdded();
+    if (0 == ndecisions)
+    {
+        mindepth = 0;
+    }
 }
 
 public:
@@ -2948,12 +3571,15 @@ void MakePrimitives(ql::quantum_kernel& kernel)
         for (auto newgp : tmpCirc)
         {
             mainPast.AddAndSchedule(newgp);     // decomposition is scheduled in gate by gate
+            mainPast.FlushAll();                // keep Past::Schedule from scanning all gates to insert in cycle order
         }
     }
     mainPast.FlushAll();
 
     ql::circuit     outCirc;                    // ultimate output gate stream
     mainPast.Out(outCirc);
+    // Past::Schedule would have inserted each gate after the last one with a cycle not later, so a stable sort is equivalent
+    std::stable_sort(outCirc.begin(), outCirc.end(), [](ql::gate* gp1, ql::gate* gp2) { return gp1->cycle < gp2->cycle; });
     kernel.c.swap(outCirc);
     kernel.cycles_valid = true;                 // decomposition was scheduled in above
 
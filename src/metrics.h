@@ -12,6 +12,8 @@
 #define METRICS_H
 
 #include <cmath> 
+#include <cstdint>
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <random>
@@ -319,18 +321,16 @@ public:
 }; //class end
 
 
-	static double quick_fidelity(std::list< ql::gate * > gate_list )
+    static double quick_fidelity_circuit(ql::circuit circuit )
 	{
 		ql::Metrics estimator(17);
 		std::vector<double> previous_fids;
-		ql::circuit circuit;
-		std::copy(std::begin(gate_list), std::end(gate_list), std::back_inserter(circuit));
 		double fidelity = estimator.bounded_fidelity(circuit, previous_fids);
 		fidelity =- fidelity; //Symmetric value because lower score is considered better in mapper.h
 		return fidelity;
 	}
 
-    static double quick_fidelity_circuit(ql::circuit circuit )
+    static double quick_fidelity(ql::circuit circuit )
 	{
 		ql::Metrics estimator(17);
 		std::vector<double> previous_fids;
@@ -339,421 +339,879 @@ public:
 		return fidelity;
 	}
 
-    static double quick_fidelity(ql::circuit circuit )
+
+	// Incremental version of quick_fidelity, used by the mapper (mapper=maxfidelity) to score each alternative.
+	// It keeps the per-qubit state of Metrics::bounded_fidelity, i.e. the fidelity and the end of the last operation,
+	// so that adding a gate takes constant time and scoring takes time linear in the number of qubits,
+	// instead of recomputing both over all gates for each score.
+	// The gates on each qubit must be added in cycle order; the score is then equal to that of quick_fidelity
+	// on the added gates in cycle order, for a platform with nqubits qubits.
+	class FidelityState
 	{
-		ql::Metrics estimator(17);
-		std::vector<double> previous_fids;
-		double fidelity = estimator.bounded_fidelity(circuit, previous_fids);
-		fidelity =- fidelity; //Symmetric value because lower score is considered better in mapper.h
-		return fidelity;
+	private:
+		double gatefid_1 = 0.999;               // same defaults as of Metrics
+		double gatefid_2 = 0.99;
+		double decoherence_time = 3000/20;
+		std::vector<double> fids;               // [qubit]: fidelity up to the end of its last operation
+		std::vector<size_t> last_op_endtime;    // [qubit]: cycle at which its last operation ended
+		bool empty;                             // no gates were added yet
+		size_t last_cycle;                      // start cycle of the latest gate added
+		size_t end_cycle;                       // end cycle of the latest gate added, at which the circuit ends
+
+	public:
+		void Init(size_t Nqubits)
+		{
+			fids.assign(Nqubits, 1.0);
+			last_op_endtime.assign(Nqubits, 1); //First cycle has index 1
+			empty = true;
+			last_cycle = 0;
+			end_cycle = 0;
+		}
+
+		void Add(const ql::gate* gate)
+		{
+			if (empty || gate->cycle >= last_cycle)
+			{
+				empty = false;
+				last_cycle = gate->cycle;
+				end_cycle = gate->cycle + gate->duration/CYCLE_TIME;
+			}
+
+			if (gate->name == "measure")
+				return;
+			else if (gate->name == "prepz")
+			{
+				size_t qubit = gate->operands[0];
+				fids[qubit] = 1.0;
+				last_op_endtime[qubit] = gate->cycle + gate->duration / CYCLE_TIME;
+				return;
+			}
+
+			if (gate->duration > CYCLE_TIME*2 && gate->name!="prep_z" && gate->name!="measure" )
+			{
+				EOUT("Gate with duration larger than CYCLE_TIME*20 detected! Non primitive?: " << gate->name );
+				throw ql::exception("Check for non primitive gates at cycle "  + std::to_string(gate->cycle) + "!", false);
+			}
+
+			if (gate->operands.size() == 1)
+			{
+				size_t qubit = gate->operands[0];
+				size_t idled_time = gate->cycle - last_op_endtime[qubit];
+				last_op_endtime[qubit] = gate->cycle + gate->duration / CYCLE_TIME;
+				fids[qubit] *= std::exp(-((double)idled_time)/decoherence_time);
+				fids[qubit] *= gatefid_1;
+			}
+			else if (gate->operands.size() == 2)
+			{
+				size_t qubit_c = gate->operands[0];
+				size_t qubit_t = gate->operands[1];
+				size_t idled_time_c = gate->cycle - last_op_endtime[qubit_c];
+				size_t idled_time_t = gate->cycle - last_op_endtime[qubit_t];
+				last_op_endtime[qubit_c] = gate->cycle + gate->duration / CYCLE_TIME;
+				last_op_endtime[qubit_t] = gate->cycle + gate->duration / CYCLE_TIME;
+				fids[qubit_c] *= std::exp(-(double) idled_time_c/decoherence_time);
+				fids[qubit_t] *= std::exp(-(double)idled_time_t/decoherence_time);
+				fids[qubit_c] *= fids[qubit_t] * gatefid_2;
+				fids[qubit_t] = fids[qubit_c];
+			}
+		}
+
+		// average fidelity after idling until the end of the circuit, negated as by quick_fidelity
+		double Score() const
+		{
+			double sum = 0;
+			for (size_t i = 0; i < fids.size(); i++)
+			{
+				double fid = fids[i];
+				if (!empty)
+				{
+					size_t idled_time_final = end_cycle - last_op_endtime[i];
+					fid *= std::exp(-(double) idled_time_final/decoherence_time);
+				}
+				sum += fid;
+			}
+			return -(sum / fids.size());
+		}
+	};
+
+
+	// Classes of gates in a packed_schedule, as distinguished by Metrics::bounded_fidelity.
+	typedef enum
+	{
+		fidelity_skip = 0,      // gate that doesn't affect the fidelity, e.g. a measurement or a wait
+		fidelity_prepz = 1,     // preparation, restoring the fidelity of its qubit
+		fidelity_1q = 2,        // one-qubit gate
+		fidelity_2q = 3         // two-qubit gate
+	} fidelity_class_t;
+
+	// A scheduled circuit packed in arrays, one element per gate, as input to FidelityBatch:
+	// its qubit operands (qubit1 only used by two-qubit gates), start cycle, duration in cycles and fidelity_class_t.
+	struct packed_schedule
+	{
+		std::vector<uint32_t> qubit0;
+		std::vector<uint32_t> qubit1;
+		std::vector<uint64_t> cycle;
+		std::vector<uint32_t> duration;
+		std::vector<uint8_t> gclass;
+
+		size_t size() const
+		{
+			return gclass.size();
+		}
+
+		void push_back(uint32_t q0, uint32_t q1, uint64_t c, uint32_t d, uint8_t g)
+		{
+			qubit0.push_back(q0);
+			qubit1.push_back(q1);
+			cycle.push_back(c);
+			duration.push_back(d);
+			gclass.push_back(g);
+		}
+	};
+
+	// pack a scheduled circuit; gate durations are converted to cycles by rounding down, as bounded_fidelity does
+	inline packed_schedule pack_schedule(const ql::circuit& circ, size_t cycle_time)
+	{
+		packed_schedule s;
+		for (auto gate : circ)
+		{
+			uint8_t g = fidelity_skip;
+			if (gate->name == "prepz")
+				g = fidelity_prepz;
+			else if (gate->name != "measure" && gate->operands.size() == 1)
+				g = fidelity_1q;
+			else if (gate->name != "measure" && gate->operands.size() == 2)
+				g = fidelity_2q;
+			s.push_back(gate->operands.size() > 0 ? gate->operands[0] : 0,
+						gate->operands.size() > 1 ? gate->operands[1] : 0,
+						gate->cycle, gate->duration / cycle_time, g);
+		}
+		return s;
 	}
 
+	// Estimator of the fidelity of many scheduled circuits at once, e.g. to compare candidate schedules or mappings.
+	// It computes the model of Metrics::bounded_fidelity with output mode average,
+	// but in the log domain: idling and gates add to the log of the fidelity of their qubits,
+	// so that the only exponentials are computed per qubit at the end, instead of one per gate operand.
+	// The gates are processed in three passes over the packed arrays:
+	// a scan finding for each operand the end of the previous operation on its qubit,
+	// an elementwise loop computing the log fidelity change of each operand,
+	// which has no dependences between iterations and is vectorized by the compiler,
+	// and a scan combining these per qubit, of which two-qubit gates merge the fidelities of their operands.
+	// Unlike bounded_fidelity, the circuit ends when its last gate ends (instead of when the last gate in the list ends).
+	class FidelityBatch
+	{
+	private:
+		size_t Nqubits;
+		double log_gatefid_1;
+		double log_gatefid_2;
+		double inv_decoherence_time;
+
+		std::vector<uint64_t> last_op_endtime;  // scratch, [qubit]: end cycle of the last operation
+		std::vector<double> log_fids;           // scratch, [qubit]: log of fidelity up to the end of that operation
+		std::vector<double> idle0;              // scratch, [gate]: idle cycles of qubit0 before the gate
+		std::vector<double> idle1;              // scratch, [gate]: idle cycles of qubit1 before the gate
+		std::vector<double> delta0;             // scratch, [gate]: change of log fidelity of qubit0 by idling and gate
+		std::vector<double> delta1;             // scratch, [gate]: same for qubit1
+
+	public:
+		FidelityBatch(size_t Nqubits, double gatefid_1 = 0.999, double gatefid_2 = 0.99, double decoherence_time = 3000/20)
+		: Nqubits(Nqubits), log_gatefid_1(std::log(gatefid_1)), log_gatefid_2(std::log(gatefid_2)), inv_decoherence_time(1.0/decoherence_time)
+		{
+			if (Nqubits == 0)
+			{
+				FATAL("FidelityBatch: the number of qubits must be at least 1, the fidelity is averaged over them");
+			}
+		}
 
-// const unsigned char transition_matrix[4][4]  = {{ 0, 1, 2, 3 },  //[input_state][new_error]
-// 					   						    { 1, 0, 3, 2 },  //I = 0, X = 1, Y = 2, Z = 3
-// 											    { 2, 3, 0, 1 },
-// 											    { 3, 2, 1, 0 }};
-
-// unsigned char new_state_calc(char old_state, char new_error) 
-// {
-// 	return transition_matrix[old_state][new_error]; 
-// }
-
-
-// class QubitSet
-// {
-// 	//Each physical qubit should be associated to only one QubitSet
-// 	private:
-// 		std::map<std::string, double> error_map; //the string contains the error status of each Qubit. Ex: IIXYXXI for a qubit set with 7 qubits 
-// 	public:
-// 		std::vector<size_t> qubits; //Contains the qubits ordered as they would appear in a error string
-// 		static double new_error_threshold;
-
-// 		QubitSet( std::vector<size_t> qubits )
-// 		{
-// 			// error_map.reserve( qubits.size() );
-// 			this->qubits = qubits;
-// 			reset();
-// 		}
-
-// 		QubitSet( size_t qubit )
-// 		{
-// 			// error_map.reserve( qubits.size() );
-// 			this->qubits.push_back(qubit);
-// 			reset();
-// 		}
-
-// 		//Constructor for merging sets, doesn't use reset
-// 		QubitSet( QubitSet* qubit_set1, QubitSet* qubit_set2 )
-// 		{
-
-// 			// for (auto& error : qubit_set2->error_map) //Wrong, we need to do the cross product
-//   			// 	error_map.insert(std::move(error));
-// 			for (auto & error1 : qubit_set1->error_map)
-// 			{
-// 				for (auto & error2 : qubit_set2->error_map )
-// 				{
-// 					double joint_probability = error1.second * error2.second;
-// 					if ( joint_probability > 0.01)
-// 						error_map[error1.first + error2.first] = joint_probability; 
-// 				}
-// 			}
-// 			// error_map.push_back(std::move(qubit_set2->error_map));
-			
-// 			this->qubits = qubit_set1->qubits;
-// 			std::move(qubit_set2->qubits.begin(), qubit_set2->qubits.end(), std::back_inserter(this->qubits));
-		
+		double estimate(const packed_schedule& s)
+		{
+			size_t n = s.size();
+			const uint32_t* q0 = s.qubit0.data();
+			const uint32_t* q1 = s.qubit1.data();
+			const uint64_t* cycle = s.cycle.data();
+			const uint32_t* duration = s.duration.data();
+			const uint8_t* gclass = s.gclass.data();
+
+			// scan: idle time of each operand since the previous operation on its qubit, and the end of the circuit
+			last_op_endtime.assign(Nqubits, 1); //First cycle has index 1
+			idle0.resize(n);
+			idle1.resize(n);
+			uint64_t end_cycle = 1;
+			for (size_t i = 0; i < n; i++)
+			{
+				uint64_t end = cycle[i] + duration[i];
+				end_cycle = std::max(end_cycle, end);
+				idle0[i] = 0;
+				idle1[i] = 0;
+				if (gclass[i] == fidelity_skip)
+					continue;
+				idle0[i] = (double)(cycle[i] - std::min(cycle[i], last_op_endtime[q0[i]]));
+				last_op_endtime[q0[i]] = end;
+				if (gclass[i] == fidelity_2q)
+				{
+					idle1[i] = (double)(cycle[i] - std::min(cycle[i], last_op_endtime[q1[i]]));
+					last_op_endtime[q1[i]] = end;
+				}
+			}
 
-// 		}
+			// elementwise: change of log fidelity of each operand by its idling followed by the gate
+			delta0.resize(n);
+			delta1.resize(n);
+			double* d0 = delta0.data();
+			double* d1 = delta1.data();
+			const double* i0 = idle0.data();
+			const double* i1 = idle1.data();
+			double lg1 = log_gatefid_1;
+			double lg2 = log_gatefid_2;
+			double itd = inv_decoherence_time;
+			for (size_t i = 0; i < n; i++)
+			{
+				// branch-free: fidelity_1q and fidelity_2q both have bit 1 set and are distinguished by bit 0
+				int32_t isgate = (gclass[i] >> 1) & 1;
+				int32_t istwoqubit = gclass[i] & isgate;
+				d0[i] = isgate * lg1 + istwoqubit * (lg2 - lg1) - i0[i] * itd;
+				d1[i] = -i1[i] * itd;
+			}
 
-// 		void reset()
-// 		{
-// 			std::string initial_state(qubits.size(), 0);
-// 			error_map[initial_state] = 1.0;
-// 		}
+			// scan: accumulate per qubit; a two-qubit gate gives both operands the product of their fidelities
+			log_fids.assign(Nqubits, 0.0);
+			for (size_t i = 0; i < n; i++)
+			{
+				switch (gclass[i])
+				{
+				case fidelity_prepz:
+					log_fids[q0[i]] = 0.0;
+					break;
+				case fidelity_1q:
+					log_fids[q0[i]] += d0[i];
+					break;
+				case fidelity_2q:
+					log_fids[q0[i]] += log_fids[q1[i]] + d0[i] + d1[i];
+					log_fids[q1[i]] = log_fids[q0[i]];
+					break;
+				default:
+					break;
+				}
+			}
 
+			// idling of each qubit until the end of the circuit, and the average
+			double sum = 0.0;
+			for (size_t q = 0; q < Nqubits; q++)
+			{
+				sum += std::exp(log_fids[q] - (double)(end_cycle - last_op_endtime[q]) * itd);
+			}
+			return sum / Nqubits;
+		}
 
-// 		void remove_qubit(size_t qubit)
-// 		{
-// 			size_t q_index = get_qubit_index(qubit)
-			
-// 			for (auto & error : error_map)
-// 			{
-// 				//Since map is ordered by string, this can probably be optimized, by checking the next 3 keys and verifying if they are variations
-// 				//^ This would probably be faster than map::find()
-// 				std::string error_string = error.first; 
-// 				unsigned char original = error.first.at(q_index);
-// 				unsigned char variations[3];
-
-// 				if (original == 0)
-// 					variations = {1,2,3};
-// 				else if (original == 1)
-// 					variations = {0,2,3};
-// 				else if (original == 2)
-// 					variations = {0,1,3};
-// 				else if (original == 3)
-// 					variations = {0,1,2};
-
-// 				for (auto variant : variations)
-// 				{
-// 					error_string.at(q_index) = variant;
-// 					auto it = error_map.find(error_string);
-					
-// 					if ( it != error_map.end() )
-// 					{
-// 						//If variation is found, its probability is summed to original string, and it is deleted
-// 						error.second += it->second; 
-// 						error_map.erase(it);
-// 					}
-
-// 				}
-// 				//The probabilities are now funneled onto this error.
-// 				//Now we erase the qubit from this string.
-// 				error.first.erase(q_index, 1);
-// 			}
-// 			//Finally, we remove the qubit from the qubit_list
-// 			qubits.erase(qubits.begin() + q_index);
-// 		}
-
-
-// 	// void introduce_wait_cycles(size_t cycles, size_t qubit)
-// 	// {
-// 	// 	for (int i = 0 ; i<cycles ; i++)
-// 	// 	{
-// 	// 		single_qubit_gate(qubit, fid_dec);
-// 	// 	}
-// 	// }
-
-// 		size_t get_qubit_index(size_t qubit)
-// 		{
-
-// 			std::vector<size_t>::iterator it = std::find(qubits.begin(), qubits.end(), 22);
-
-// 			if (it == qubits.end())
-// 			{
-// 				DOUT("Qubit not found in expected QubitSet \n");
-// 				throw ql::exception("Qubit not found in expected QubitSet", false);
-// 			}
-
-// 			return std::distance(qubits.begin(), it);
-// 		}
-
-// 		void single_qubit_gate(size_t qubit, double fid, const std::string &name)
-// 		{
-// 			//TODO: Transform previous errors first
-// 			introduce_single_qubit_error(qubit, fid); 
-// 		}
-
-// 		void two_qubit_gate(size_t qubit, double fid, const std::string &name, int control_target)
-// 		{
-// 			//TODO: Transform previous errors first
-// 			introduce_single_qubit_error(qubit, fid); 
-// 		}
-
-// 		void introduce_single_qubit_error(size_t qubit, double fid)
-// 		{
-// 			double axis_flip_prob = (1-fid)/3;
-// 			std::map< std::string, double> new_error_map;
-			
-// 			for (auto & error : error_map)
-// 			{
+		std::vector<double> estimate(const std::vector<packed_schedule>& schedules)
+		{
+			std::vector<double> fids;
+			fids.reserve(schedules.size());
+			for (auto& s : schedules)
+			{
+				fids.push_back(estimate(s));
+			}
+			return fids;
+		}
+	};
 
-// 				char current_state = error.first.at( get_qubit_index(qubit) ); //Gets error status for qubit at a error string. Replace .at() for [] for optimization
-				
 
-// 				// new_error_map.insert(std::pair<std::string, double>(error, error.second * fid)); //Inserts the new states for a 'I' injected error
-// 				// use pointers and the new char instead of the string?
-				
-// 				new_error_map.insert(std::pair<std::string, double>(error.first, error.second * fid));
-
-// 				for (auto new_error = 1; new_error < 4; new_error++)
-// 				{
-// 					unsigned char new_state = new_state_calc(current_state, new_error);
-// 					double new_state_prob = error.second * axis_flip_prob;
-
-// 					std::string new_error_string(error.first);
-// 					new_error_string.at( get_qubit_index(qubit) ) = new_state; //string with the new error syndrome, for each case
-					
-// 					if (new_state_prob > new_error_threshold )
-// 					{
-// 						auto ret = new_error_map.insert(std::pair<std::string, double>(new_error_string, new_state_prob)); //only adds if error syndrome not on the list
-// 						if (ret.second == false) //If a key already existed, then
-// 							error_map[new_error_string] += new_state_prob; 
-// 					}
-// 				}
-
-// 			}
-// 			error_map = new_error_map;
-// 		}
-
-
-
-// };
-
-// class Depolarizing_model
-// {
-// 	private:
-// 		std::vector< QubitSet * > qubit_partition;
-// 		double gatefid1;
-// 		double gatefid2;
-// 		size_t Nqubits;
-
-// 	public:
-// 		Depolarizing_model(size_t Nqubits, double gatefid1, double gatefid2, double new_error_threshold): gatefid1(gatefid1), gatefid2(gatefid2)
-// 		{
-// 			qubit_partition.reserve(Nqubits);
-// 			QubitSet::new_error_threshold = new_error_threshold; 
-
-// 			for (size_t i = 0; i<Nqubits; i++)
-// 			{
-// 				std::vector<size_t> initial_qubit (1, (size_t)1);
-// 				qubit_partition.push_back(new QubitSet(  initial_qubit ));
-// 			}
-// 			this->Nqubits = Nqubits;
-// 		}
-
-// 		void merge_sets(size_t qubit1, size_t qubit2)
-// 		{
-// 			QubitSet* qubit_set1 = qubit_partition.at(qubit1);
-// 			QubitSet* qubit_set2 = qubit_partition.at(qubit2);
-
-// 			QubitSet* new_set = new QubitSet(qubit_set1, qubit_set2);
-
-// 			delete qubit_set1; //We destroy the old qubit sets
-// 			delete qubit_set2;
-
-// 			for (auto & qubit : new_set->qubits)
-// 			{
-// 				qubit_partition[qubit] = new_set; //Change the listing in the qubits partition
-// 			}
-// 		}
-
-// 		void split_sets(size_t qubit1)
-// 		{
-// 			QubitSet* qubit_set1 = qubit_partition.at(qubit1);
+	// Pauli errors are encoded in 2 bits: bit 0 is the X component and bit 1 the Z component, i.e. I=0, X=1, Z=2, Y=3,
+	// so that composing two errors is their exclusive or (up to a phase, which doesn't matter for error probabilities).
+	// A Pauli string of a set of qubits packs these per position, 32 positions in each 64-bit word.
+	namespace pauli
+	{
+		const size_t positions_per_word = 32;
 
-			
-// 			if (qubit_set1->qubits.size() == 1 && qubit_set1->qubits.at(0) != qubit_1)
-// 				DOUT("Something seriously wrong happened: splitting qubit from the wrong, trivial set")
-// 			else if (qubit_set1->qubits.size() == 1)
-// 			{
-// 				DOUT("This shouldn't happen: Spliting qubit from trivial set")
-// 				return; //Just a safety, no sense moving a qubit to a new set when it is alone already...
-// 			}
-
-// 			QubitSet* new_set = new QubitSet(qubit1);
-
-// 			qubit_partition[qubit_1] = new_set; //Change the listing in the qubits partition
-// 			qubit_set1->remove_qubit(qubit1);
-
-// 			return;
-// 		}
-
-// 		double run_circuit(ql::circuit &circ)
-// { 
-// 		//this function considers the primitive gates! each operand undergoing a 2-qubit operation is always considered to have the same latency
-// 		//same end fidelity considered for the two operands of the same 2-qubit gate
-// 		//TODO - URGENT!! Check if gate->cycle starts in zero;
-// 		//TODO - URGENT!! do not consider the fidelity of non-used qubits (set to 2/-1?)
-
-// 		// if (fids.size() == 0)
-// 		// {
-// 		// 	IOUT("EMPTY VECTOR - Initializing. Nqubits = " + std::to_string(Nqubits));
-// 		// 	fids.resize(Nqubits, 1.0); //Initiallize a fidelity vector, if one is not provided
-// 		// 	//TODO: non initialized qubits should have undefined fidelity. It shouldn't be taken into account.
-// 		// }
-
-// 		std::vector<size_t> last_op_endtime(Nqubits, 1); //First cycle has index 1
-
-// 		PRINTER(last_op_endtime);
-// 		IOUT("\n\n");
-
-// 		for (auto &gate : circ)
-// 		{
-
-// 			if (gate->name == "measure")
-// 				continue;
-// 			else if (gate->name == "prep_z")
-// 			{
-// 				size_t qubit = gate->operands[0]; 
-// 				// fids[qubit] = 1.0;
-// 				split_qubits(qubit);
-// 				last_op_endtime[qubit] = gate->cycle + gate->duration / CYCLE_TIME;
-// 				continue;
-// 			}
-			
-// 			if (gate->duration > CYCLE_TIME*2 && gate->name!="prep_z" && gate->name!="measure" )
-// 			{
-// 				EOUT("Gate with duration larger than CYCLE_TIME*20 detected! Non primitive?: " << output_mode);
-//     			throw ql::exception("Check for non primitive gates at cycle "  + std::to_string(gate->cycle) + "!", false);
-// 			}
+		inline size_t words(size_t npositions)
+		{
+			return npositions == 0 ? 1 : (npositions + positions_per_word - 1) / positions_per_word;
+		}
 
-			
-// 			unsigned char type_op = gate->operands.size(); // type of operation (1-qubit/2-qubit)
-// 			if (type_op == 1)
-// 			{
-// 				size_t qubit = gate->operands[0];
-// 				size_t last_time = last_op_endtime[qubit];
-// 				IOUT("Gate " + gate->name + "("+ std::to_string(gate->operands[0]) +") at cycle " + std::to_string(gate->cycle) + " with duration " + std::to_string(gate->duration));
-// 				size_t idled_time = gate->cycle - last_time; //get idlying time to introduce decoherence. This assumes "cycle" starts at zero, otherwise gate->cycle-> (gate->cycle - 1)
-				
-// 				last_op_endtime[qubit] = gate->cycle  + gate->duration / CYCLE_TIME; //This assumes "cycle" starts at zero, otherwise gate->cycle-> (gate->cycle - 1)
-				
-// 				IOUT("Idled time:" + std::to_string(idled_time));
+		inline unsigned get(const uint64_t* key, size_t pos)
+		{
+			return (key[pos / positions_per_word] >> (2 * (pos % positions_per_word))) & 3;
+		}
 
+		inline void set(uint64_t* key, size_t pos, unsigned p)
+		{
+			uint64_t& word = key[pos / positions_per_word];
+			size_t shift = 2 * (pos % positions_per_word);
+			word = (word & ~((uint64_t)3 << shift)) | ((uint64_t)p << shift);
+		}
 
-// 				// fids[qubit] *= std::exp(-((double)idled_time)/decoherence_time); // Update fidelity with idling-caused decoherence
-// 				// fids[qubit] *= gatefid_1; //Update fidelity after gate
-				
-// 				//TODO: OPTIMIZE THE DECOHERENCE PART?
-// 				for (auto i = 0; i < idled_time; i++)
-// 				{
-// 					qubit_partition[qubit]->introduce_single_qubit_error(qubit, std::exp(-(double)1.0/decoherence_time)); //Introduces wait gates
-// 				} 
-// 				qubit_partition[qubit]->single_qubit_gate(qubit, gatefid_1, gate->name); //Introduces gate fidelity
-				
-				
-				
-				
-// 				IOUT("METRICS - one qubit gate - END");
-
-// 			}
-// 			else if (type_op == 2)
-// 			{
-// 				IOUT("METRICS - TWO qubit gate");
-// 				size_t qubit_c = gate->operands[0];
-// 				size_t qubit_t = gate->operands[1];
-				
-// 				size_t last_time_c = last_op_endtime[qubit_c];
-// 				size_t last_time_t = last_op_endtime[qubit_t];
-// 				size_t idled_time_c = gate->cycle - last_time_c;
-// 				size_t idled_time_t = gate->cycle - last_time_t; //get idlying time to introduce decoherence. This assumes "cycle" starts at zero, otherwise gate->cycle-> (gate->cycle - 1)
-// 				last_op_endtime[qubit_c] = gate->cycle  + gate->duration / CYCLE_TIME; //This assumes "cycle" starts at zero, otherwise gate->cycle-> (gate->cycle - 1)
-// 				last_op_endtime[qubit_t] = gate->cycle  + gate->duration / CYCLE_TIME ; //This assumes "cycle" starts at zero, otherwise gate->cycle-> (gate->cycle - 1)
-				
-// 				IOUT("Gate " + gate->name + "("+ std::to_string(gate->operands[0]) + ", " + std::to_string(gate->operands[1]) +") at cycle " + std::to_string(gate->cycle) + " with duration " + std::to_string(gate->duration));
-// 				IOUT("Idled time q_c:" + std::to_string(idled_time_c));
-// 				IOUT("Idled time q_t:" + std::to_string(idled_time_t));
-// 				IOUT("Decoherence time: " + std::to_string(decoherence_time));
+		inline bool is_identity(const uint64_t* key, size_t nwords)
+		{
+			for (size_t w = 0; w < nwords; w++)
+				if (key[w] != 0)
+					return false;
+			return true;
+		}
+	}
 
-// 				// fids[qubit_c] *= std::exp(-(double) idled_time_c/decoherence_time); // Update fidelity with idling-caused decoherence
-// 				// fids[qubit_t] *= std::exp(-(double)idled_time_t/decoherence_time); // Update fidelity with idling-caused decoherence
+	// Flat hash map from Pauli strings of a fixed number of words to their probability.
+	// Entries are kept in insertion order in two arrays, indexed by an open addressing table with linear probing,
+	// so that iterating over the entries and adding to them doesn't chase pointers nor allocate per entry.
+	class PauliErrorMap
+	{
+	private:
+		size_t nwords = 1;
+		std::vector<uint64_t> keys;     // [entry*nwords + word]
+		std::vector<double> probs;      // [entry]
+		std::vector<uint32_t> slots;    // [slot]: entry+1, or 0 when empty; size is a power of 2, at most half full
 
-// 				for (auto i = 0; i < idled_time_c; i++)
-// 					qubit_partition[qubit_c]->introduce_single_qubit_error(qubit_c, std::exp(-(double)1.0/decoherence_time)); //Introduces wait gates
-// 				for (auto i = 0; i < idled_time_t; i++)
-// 					qubit_partition[qubit_t]->introduce_single_qubit_error(qubit_t, std::exp(-(double)1.0/decoherence_time)); //Introduces wait gates
+		static uint64_t hash(const uint64_t* key, size_t nwords)
+		{
+			uint64_t h = 0x9E3779B97F4A7C15ULL;
+			for (size_t w = 0; w < nwords; w++)
+			{
+				h ^= key[w];
+				h *= 0xBF58476D1CE4E5B9ULL;
+				h ^= h >> 31;
+			}
+			return h;
+		}
 
-// 				// IOUT("Error status after idlying: ");
-// 				// PRINTER(fids);
+		// slot holding key, or the empty slot where it would be inserted
+		size_t find_slot(const uint64_t* key) const
+		{
+			size_t mask = slots.size() - 1;
+			size_t s = hash(key, nwords) & mask;
+			while (slots[s] != 0 && !std::equal(key, key + nwords, &keys[(slots[s] - 1) * nwords]))
+				s = (s + 1) & mask;
+			return s;
+		}
 
-// 				qubit_partition[qubit_c]->two_qubit_gate(qubit_c, gatefid_2, gate->name, 0); //Introduces gate fidelity
-// 				qubit_partition[qubit_t]->two_qubit_gate(qubit_t, gatefid_2, gate->name, 1); //Introduces gate fidelity
+		void rebuild_slots(size_t nslots)
+		{
+			slots.assign(nslots, 0);
+			for (size_t e = 0; e < probs.size(); e++)
+				slots[find_slot(&keys[e * nwords])] = e + 1;
+		}
 
+	public:
+		void clear(size_t nw)
+		{
+			nwords = nw;
+			keys.clear();
+			probs.clear();
+			slots.assign(16, 0);
+		}
 
-// 				// fids[qubit_c] *=  fids[qubit_t] * gatefid_2; //Update fidelity after gate
-// 				// fids[qubit_t] = fids[qubit_c];  					//Update fidelity after gate
+		size_t words() const { return nwords; }
+		size_t size() const { return probs.size(); }
+		const uint64_t* key(size_t e) const { return &keys[e * nwords]; }
+		uint64_t* key(size_t e) { return &keys[e * nwords]; }
+		double prob(size_t e) const { return probs[e]; }
 
+		void add(const uint64_t* key, double p)
+		{
+			size_t s = find_slot(key);
+			if (slots[s] != 0)
+			{
+				probs[slots[s] - 1] += p;
+				return;
+			}
+			keys.insert(keys.end(), key, key + nwords);
+			probs.push_back(p);
+			slots[s] = probs.size();
+			if (2 * probs.size() > slots.size())
+				rebuild_slots(2 * slots.size());
+		}
 
+		double get(const uint64_t* key) const
+		{
+			size_t s = find_slot(key);
+			return slots[s] != 0 ? probs[slots[s] - 1] : 0.0;
+		}
 
-// 				//TODO - Convert the code into a for loop with range 2, to get the compiler's for optimization (and possible paralellization?)
-// 			}
-// 				// PRINTER(fids);
-// 				// PRINTER(last_op_endtime);
-				
-// 				IOUT("\n NEXT GATE");
-
-// 		}
-// 		size_t end_cycle = circ.back()->cycle + circ.back()->duration/CYCLE_TIME; 
-// 		for (auto qubit=0; qubit < Nqubits; qubit++ )
-// 		{
-// 			size_t idled_time_final = end_cycle - last_op_endtime[i];
-// 			for(auto wait=0; wait < idled_time_final; wait++)
-// 				qubit_partition[qubit]->introduce_single_qubit_error(qubit, std::exp(-(double)1.0/decoherence_time)); //Introduces wait gates
-				
-// 		}
+		// to be called after the keys were changed in place by a one-to-one mapping
+		void rehash()
+		{
+			rebuild_slots(slots.size());
+		}
 
-// 		IOUT(" \n\n THE END \n\n ");
-// 		IOUT("Fidelity after idlying: ");
-// 		PRINTER(fids);
-// 		//Concatenating data into a single value, to serve as metric
-// 		return create_output(fids);
-// 	};
+		void swap(PauliErrorMap& other)
+		{
+			std::swap(nwords, other.nwords);
+			keys.swap(other.keys);
+			probs.swap(other.probs);
+			slots.swap(other.slots);
+		}
+	};
 
-// 	void print_status()
-// 	{
-// 		for(auto q_set in qubit_partition)
-// 		{
-// 			DOUT("\n\n")
-// 			DOUT("QUBIT_SET: ");
-// 			std::string output;
-// 			for(auto qubit : q_set->qubits)
-// 				output += std::to_string(qubit) + ",";
-// 			DOUT(output)
-// 			output="";
-// 			for(auto error : q_set->error_map)
-// 				output += error.first + std::to_string(error.second) + "\n";
-// 			DOUT(output)
+	// A set of qubits of which errors are correlated, with the probabilities of their joint Pauli errors.
+	// Each qubit has a fixed position in the Pauli strings; a qubit that is reset leaves its position vacant.
+	class QubitSet
+	{
+	public:
+		static const size_t vacant = std::numeric_limits<size_t>::max();
+		std::vector<size_t> qubits;     // [position]: qubit, or vacant
+		size_t nactive = 0;             // number of qubits that are not vacant
+		PauliErrorMap error_map;
+
+		// the set of just qubit, without error
+		void reset(size_t qubit)
+		{
+			qubits.assign(1, qubit);
+			nactive = 1;
+			error_map.clear(1);
+			uint64_t identity = 0;
+			error_map.add(&identity, 1.0);
+		}
 
-// 		} 
-// 	}
+		double no_error_probability() const
+		{
+			std::vector<uint64_t> identity(error_map.words(), 0);
+			return error_map.get(identity.data());
+		}
+
+		double no_error_probability(size_t pos) const
+		{
+			double sum = 0.0;
+			for (size_t e = 0; e < error_map.size(); e++)
+				if (pauli::get(error_map.key(e), pos) == 0)
+					sum += error_map.prob(e);
+			return sum;
+		}
+	};
+
+	// Depolarizing error model, tracking the joint Pauli error probabilities of each set of qubits
+	// that interacted since their preparation.
+	// Gates are followed by a depolarizing error on their operands, idling by one per cycle idled,
+	// and the errors present before a Clifford gate are propagated through it, so that e.g. an X error on the control
+	// of a CNOT becomes an X error on both operands; errors aren't propagated through gates that aren't known to be Clifford.
+	// Sets of qubits are kept in a union-find forest of nodes, a two-qubit gate merging the sets of its operands
+	// by their cross product; a preparation removes its qubit from its set, summing over its errors,
+	// and gives the qubit a new node.
+	// The number of joint errors of a set grows exponentially with its size, so errors of which the probability is less
+	// than new_error_threshold aren't created, making the number of errors tracked at most 1/new_error_threshold per set;
+	// their probability is accumulated in pruned_probability(), which bounds the resulting underestimate of the fidelity.
+	class Depolarizing_model
+	{
+	private:
+		typedef enum
+		{
+			clifford_none,          // not known to be Clifford, errors aren't propagated
+			clifford_pauli,         // Pauli gate, errors commute with it
+			clifford_h,             // exchanges X and Z, as do y90 and ym90 up to sign
+			clifford_s,             // exchanges X and Y
+			clifford_sx,            // exchanges Z and Y, as do x90 and xm90
+			clifford_cnot,
+			clifford_cz,
+			clifford_swap
+		} clifford_t;
+
+		size_t Nqubits;
+		double gatefid1;
+		double gatefid2;
+		double new_error_threshold;
+		double decoherence_time;
+		size_t cycle_time;
+
+		std::vector<size_t> node;       // [qubit]: its node in the forest
+		std::vector<size_t> parent;     // [node]: its parent, or itself when it is a root
+		std::vector<size_t> position;   // [qubit]: its position in the Pauli strings of its set
+		std::vector<QubitSet> sets;     // [node]: the set of the qubits in its tree, when it is a root
+		PauliErrorMap next_map;         // scratch: error map being built
+		std::vector<uint64_t> scratch;  // scratch: Pauli string being built
+		double pruned;
+		size_t max_errors;
+
+		static clifford_t clifford_of(const std::string& name)
+		{
+			static const std::map<std::string, clifford_t> cliffords = {
+				{ "i", clifford_pauli }, { "x", clifford_pauli }, { "y", clifford_pauli }, { "z", clifford_pauli },
+				{ "rx180", clifford_pauli }, { "ry180", clifford_pauli }, { "rz180", clifford_pauli },
+				{ "h", clifford_h }, { "y90", clifford_h }, { "ym90", clifford_h }, { "my90", clifford_h }, { "ry90", clifford_h },
+				{ "s", clifford_s }, { "sdag", clifford_s }, { "rz90", clifford_s },
+				{ "x90", clifford_sx }, { "xm90", clifford_sx }, { "mx90", clifford_sx }, { "rx90", clifford_sx },
+				{ "cnot", clifford_cnot }, { "cx", clifford_cnot }, { "cz", clifford_cz }, { "swap", clifford_swap }
+			};
+			auto it = cliffords.find(name);
+			return it == cliffords.end() ? clifford_none : it->second;
+		}
+
+		size_t find(size_t n)
+		{
+			while (parent[n] != n)
+			{
+				parent[n] = parent[parent[n]];
+				n = parent[n];
+			}
+			return n;
+		}
+
+		QubitSet& set_of(size_t qubit)
+		{
+			return sets[find(node[qubit])];
+		}
+
+		void insert(PauliErrorMap& m, const uint64_t* key, double p)
+		{
+			if (p < new_error_threshold && !pauli::is_identity(key, m.words()))
+				pruned += p;
+			else
+				m.add(key, p);
+		}
+
+		// per-cycle fidelity exp(-1/decoherence_time) composed over cycles: depolarizing channels with
+		// parameter lambda = 1 - 4/3 (1-fid) compose by multiplying lambda
+		double idle_fidelity(uint64_t cycles) const
+		{
+			double lambda = 1.0 - 4.0 / 3.0 * (1.0 - std::exp(-1.0 / decoherence_time));
+			return 1.0 - 0.75 * (1.0 - std::pow(lambda, (double)cycles));
+		}
+
+		void depolarize(size_t qubit, double fid)
+		{
+			if (fid >= 1.0)
+				return;
+			QubitSet& s = set_of(qubit);
+			size_t pos = position[qubit];
+			size_t nw = s.error_map.words();
+			double pflip = (1.0 - fid) / 3;
+			next_map.clear(nw);
+			for (size_t e = 0; e < s.error_map.size(); e++)
+			{
+				double p = s.error_map.prob(e);
+				scratch.assign(s.error_map.key(e), s.error_map.key(e) + nw);
+				insert(next_map, scratch.data(), p * fid);
+				unsigned original = pauli::get(scratch.data(), pos);
+				for (unsigned err = 1; err < 4; err++)
+				{
+					pauli::set(scratch.data(), pos, original ^ err);
+					insert(next_map, scratch.data(), p * pflip);
+				}
+			}
+			s.error_map.swap(next_map);
+		}
 
+		// two-qubit depolarizing error, of which each of the 15 non-identity errors has probability (1-fid)/15;
+		// both qubits must be in the same set
+		void depolarize(size_t qubit0, size_t qubit1, double fid)
+		{
+			if (fid >= 1.0)
+				return;
+			QubitSet& s = set_of(qubit0);
+			size_t pos0 = position[qubit0];
+			size_t pos1 = position[qubit1];
+			size_t nw = s.error_map.words();
+			double pflip = (1.0 - fid) / 15;
+			next_map.clear(nw);
+			for (size_t e = 0; e < s.error_map.size(); e++)
+			{
+				double p = s.error_map.prob(e);
+				scratch.assign(s.error_map.key(e), s.error_map.key(e) + nw);
+				insert(next_map, scratch.data(), p * fid);
+				unsigned original0 = pauli::get(scratch.data(), pos0);
+				unsigned original1 = pauli::get(scratch.data(), pos1);
+				for (unsigned err = 1; err < 16; err++)
+				{
+					pauli::set(scratch.data(), pos0, original0 ^ (err & 3));
+					pauli::set(scratch.data(), pos1, original1 ^ (err >> 2));
+					insert(next_map, scratch.data(), p * pflip);
+				}
+			}
+			s.error_map.swap(next_map);
+		}
 
-// };
+		// propagate the errors of the gate's operands through it; the operands must be in the same set
+		void propagate(const ql::gate* gate)
+		{
+			clifford_t c = clifford_of(gate->name);
+			if (c == clifford_none || c == clifford_pauli)
+				return;
+			if (gate->operands.size() != (c >= clifford_cnot ? 2u : 1u))
+				return;
+			QubitSet& s = set_of(gate->operands[0]);
+			size_t pos0 = position[gate->operands[0]];
+			size_t pos1 = (c >= clifford_cnot ? position[gate->operands[1]] : pos0);
+			for (size_t e = 0; e < s.error_map.size(); e++)
+			{
+				uint64_t* key = s.error_map.key(e);
+				unsigned p0 = pauli::get(key, pos0);
+				unsigned x0 = p0 & 1, z0 = p0 >> 1;
+				unsigned p1 = pauli::get(key, pos1);
+				unsigned x1 = p1 & 1, z1 = p1 >> 1;
+				switch (c)
+				{
+				case clifford_h:
+					pauli::set(key, pos0, (x0 << 1) | z0);
+					break;
+				case clifford_s:
+					pauli::set(key, pos0, ((z0 ^ x0) << 1) | x0);
+					break;
+				case clifford_sx:
+					pauli::set(key, pos0, (z0 << 1) | (x0 ^ z0));
+					break;
+				case clifford_cnot:     // X on control spreads to target, Z on target spreads to control
+					pauli::set(key, pos0, ((z0 ^ z1) << 1) | x0);
+					pauli::set(key, pos1, (z1 << 1) | (x1 ^ x0));
+					break;
+				case clifford_cz:       // X on either operand spreads as Z to the other
+					pauli::set(key, pos0, ((z0 ^ x1) << 1) | x0);
+					pauli::set(key, pos1, ((z1 ^ x0) << 1) | x1);
+					break;
+				case clifford_swap:
+					pauli::set(key, pos0, p1);
+					pauli::set(key, pos1, p0);
+					break;
+				default:
+					break;
+				}
+			}
+			s.error_map.rehash();
+		}
 
+		// move the qubits of the set to the first positions, dropping the vacant ones
+		void compact(QubitSet& s)
+		{
+			std::vector<size_t> qubits;
+			for (auto q : s.qubits)
+				if (q != QubitSet::vacant)
+					qubits.push_back(q);
+			size_t nw = pauli::words(qubits.size());
+			next_map.clear(nw);
+			for (size_t e = 0; e < s.error_map.size(); e++)
+			{
+				scratch.assign(nw, 0);
+				size_t newpos = 0;
+				for (size_t pos = 0; pos < s.qubits.size(); pos++)
+					if (s.qubits[pos] != QubitSet::vacant)
+						pauli::set(scratch.data(), newpos++, pauli::get(s.error_map.key(e), pos));
+				next_map.add(scratch.data(), s.error_map.prob(e));
+			}
+			s.error_map.swap(next_map);
+			s.qubits = qubits;
+			for (size_t pos = 0; pos < qubits.size(); pos++)
+				position[qubits[pos]] = pos;
+		}
 
+		// merge the sets of the qubits into that of the larger one, with the errors of the smaller one at the end
+		void merge(size_t qubit0, size_t qubit1)
+		{
+			size_t r0 = find(node[qubit0]);
+			size_t r1 = find(node[qubit1]);
+			if (r0 == r1)
+				return;
+			if (sets[r0].nactive < sets[r1].nactive)
+				std::swap(r0, r1);
+			QubitSet& a = sets[r0];
+			QubitSet& b = sets[r1];
+			if (a.nactive != a.qubits.size())
+				compact(a);
+			if (b.nactive != b.qubits.size())
+				compact(b);
+
+			size_t na = a.qubits.size();
+			size_t nw = pauli::words(na + b.qubits.size());
+			size_t nwa = a.error_map.words();
+			std::vector<uint64_t> bkeys(b.error_map.size() * nw, 0);    // errors of b, shifted to their new positions
+			for (size_t e = 0; e < b.error_map.size(); e++)
+				for (size_t pos = 0; pos < b.qubits.size(); pos++)
+					pauli::set(&bkeys[e * nw], na + pos, pauli::get(b.error_map.key(e), pos));
+
+			next_map.clear(nw);
+			scratch.resize(nw);
+			for (size_t ea = 0; ea < a.error_map.size(); ea++)
+			{
+				double pa = a.error_map.prob(ea);
+				for (size_t eb = 0; eb < b.error_map.size(); eb++)
+				{
+					for (size_t w = 0; w < nw; w++)
+						scratch[w] = (w < nwa ? a.error_map.key(ea)[w] : 0) | bkeys[eb * nw + w];
+					insert(next_map, scratch.data(), pa * b.error_map.prob(eb));
+				}
+			}
+			a.error_map.swap(next_map);
+			for (auto q : b.qubits)
+			{
+				position[q] = a.qubits.size();
+				a.qubits.push_back(q);
+			}
+			a.nactive += b.nactive;
+			parent[r1] = r0;
+			sets[r1] = QubitSet();
+		}
 
+		// prepare the qubit, removing it from its set
+		void reset(size_t qubit)
+		{
+			size_t r = find(node[qubit]);
+			QubitSet& s = sets[r];
+			if (s.nactive == 1)
+			{
+				s.reset(qubit);
+				position[qubit] = 0;
+				return;
+			}
 
+			size_t pos = position[qubit];
+			size_t nw = s.error_map.words();
+			next_map.clear(nw);
+			for (size_t e = 0; e < s.error_map.size(); e++)
+			{
+				scratch.assign(s.error_map.key(e), s.error_map.key(e) + nw);
+				pauli::set(scratch.data(), pos, 0);
+				next_map.add(scratch.data(), s.error_map.prob(e));
+			}
+			s.error_map.swap(next_map);
+			s.qubits[pos] = QubitSet::vacant;
+			s.nactive--;
+			if (2 * s.nactive < s.qubits.size())
+				compact(s);
+
+			size_t n = parent.size();
+			parent.push_back(n);
+			sets.emplace_back();
+			sets[n].reset(qubit);
+			node[qubit] = n;
+			position[qubit] = 0;
+		}
 
+	public:
+		Depolarizing_model(size_t Nqubits, double gatefid1 = 0.999, double gatefid2 = 0.99, double new_error_threshold = 1e-6,
+						   double decoherence_time = 3000/20, size_t cycle_time = CYCLE_TIME)
+		: Nqubits(Nqubits), gatefid1(gatefid1), gatefid2(gatefid2), new_error_threshold(new_error_threshold),
+		  decoherence_time(decoherence_time), cycle_time(cycle_time)
+		{
+			init();
+		}
 
+		// all qubits in sets of their own, without error
+		void init()
+		{
+			node.resize(Nqubits);
+			parent.resize(Nqubits);
+			position.assign(Nqubits, 0);
+			sets.assign(Nqubits, QubitSet());
+			for (size_t q = 0; q < Nqubits; q++)
+			{
+				node[q] = q;
+				parent[q] = q;
+				sets[q].reset(q);
+			}
+			pruned = 0.0;
+			max_errors = Nqubits;
+		}
 
+		// Run the scheduled circuit, of which the gates must be in cycle order, starting from qubits without error,
+		// and return the probability that no qubit has an error at its end, i.e. when its last gate ends.
+		// As in Metrics::bounded_fidelity, measurements are skipped and the first cycle has index 1.
+		double run_circuit(const ql::circuit& circ)
+		{
+			init();
+			std::vector<uint64_t> last_op_endtime(Nqubits, 1);
+			uint64_t end_cycle = 1;
+			for (auto gate : circ)
+			{
+				uint64_t cycle = gate->cycle;
+				uint64_t end = cycle + gate->duration / cycle_time;
+				end_cycle = std::max(end_cycle, end);
+				if (gate->name == "measure")
+					continue;
+				if (gate->name == "prepz")
+				{
+					reset(gate->operands[0]);
+					last_op_endtime[gate->operands[0]] = end;
+					continue;
+				}
+
+				if (gate->operands.size() == 1)
+				{
+					size_t qubit = gate->operands[0];
+					depolarize(qubit, idle_fidelity(cycle - std::min(cycle, last_op_endtime[qubit])));
+					propagate(gate);
+					depolarize(qubit, gatefid1);
+					last_op_endtime[qubit] = end;
+				}
+				else if (gate->operands.size() == 2)
+				{
+					size_t qubit0 = gate->operands[0];
+					size_t qubit1 = gate->operands[1];
+					depolarize(qubit0, idle_fidelity(cycle - std::min(cycle, last_op_endtime[qubit0])));
+					depolarize(qubit1, idle_fidelity(cycle - std::min(cycle, last_op_endtime[qubit1])));
+					merge(qubit0, qubit1);
+					propagate(gate);
+					depolarize(qubit0, qubit1, gatefid2);
+					last_op_endtime[qubit0] = end;
+					last_op_endtime[qubit1] = end;
+					max_errors = std::max(max_errors, set_of(qubit0).error_map.size());
+				}
+			}
+			for (size_t q = 0; q < Nqubits; q++)
+			{
+				depolarize(q, idle_fidelity(end_cycle - std::min(end_cycle, last_op_endtime[q])));
+			}
+			return fidelity();
+		}
 
+		// probability that no qubit has an error
+		double fidelity()
+		{
+			double fid = 1.0;
+			for (size_t n = 0; n < parent.size(); n++)
+				if (parent[n] == n && sets[n].nactive > 0)
+					fid *= sets[n].no_error_probability();
+			return fid;
+		}
 
+		// probability that the qubit has no error
+		double qubit_fidelity(size_t qubit)
+		{
+			return set_of(qubit).no_error_probability(position[qubit]);
+		}
 
+		std::vector<double> qubit_fidelities()
+		{
+			std::vector<double> fids;
+			for (size_t q = 0; q < Nqubits; q++)
+				fids.push_back(qubit_fidelity(q));
+			return fids;
+		}
 
+		// total probability of the errors that weren't created because below new_error_threshold
+		double pruned_probability() const
+		{
+			return pruned;
+		}
 
+		// largest number of errors tracked by a set after a two-qubit gate in the last run
+		size_t max_error_count() const
+		{
+			return max_errors;
+		}
 
+		void print_status()
+		{
+			for (size_t n = 0; n < parent.size(); n++)
+			{
+				if (parent[n] != n || sets[n].nactive == 0)
+					continue;
+				const QubitSet& s = sets[n];
+				std::string output = "QUBIT_SET:";
+				for (auto q : s.qubits)
+					output += " " + (q == QubitSet::vacant ? std::string("-") : std::to_string(q));
+				DOUT(output);
+				for (size_t e = 0; e < s.error_map.size(); e++)
+				{
+					output = "";
+					for (size_t pos = 0; pos < s.qubits.size(); pos++)
+						output += "IXZY"[pauli::get(s.error_map.key(e), pos)];
+					DOUT(output << " " << s.error_map.prob(e));
+				}
+			}
+		}
+	};
 
+	// as quick_fidelity, but by the depolarizing model, so with errors propagated between interacting qubits
+	inline double quick_depolarizing_fidelity(const ql::circuit& circuit, size_t Nqubits, double new_error_threshold = 1e-4)
+	{
+		ql::Depolarizing_model model(Nqubits, 0.999, 0.99, new_error_threshold);
+		return -model.run_circuit(circuit);
+	}
 
 
 // } //metrics namespace end
@@ -15,11 +15,13 @@
 #include <cassert>
 #include <time.h>
 #include <complex>
+#include <memory>
 
 #include <version.h>
 #include <openql.h>
 #include <classical.h>
 #include <unitary.h>
+#include <metrics.h>
 
 #include "compiler.h"
 
@@ -438,6 +440,11 @@ public:
         program->write_interaction_matrix();
     }
 
+    std::string get_profile()
+    {
+        return program->get_profile();
+    }
+
     ~Program()
     {
         // std::cout << "program::~program()" << std::endl;
@@ -446,6 +453,78 @@ public:
     }
 };
 
+/**
+ * fidelity estimator interface, to score many scheduled circuits at once
+ */
+class FidelityEstimator
+{
+private:
+    std::unique_ptr<ql::FidelityBatch> estimator;  // owned, so a FidelityEstimator is not copyable
+    size_t qubit_count;
+    std::vector<ql::packed_schedule> schedules;
+
+public:
+    FidelityEstimator(size_t qubit_count, double gatefid_1 = 0.999, double gatefid_2 = 0.99, double decoherence_time = 150.0):
+        estimator(new ql::FidelityBatch(qubit_count, gatefid_1, gatefid_2, decoherence_time)), qubit_count(qubit_count)
+    {
+    }
+
+    size_t add_schedule(std::vector<size_t> qubit0, std::vector<size_t> qubit1, std::vector<size_t> cycle,
+                        std::vector<size_t> duration, std::vector<size_t> gate_class)
+    {
+        size_t n = gate_class.size();
+        if (qubit0.size() != n || qubit1.size() != n || cycle.size() != n || duration.size() != n)
+        {
+            throw ql::exception("FidelityEstimator.add_schedule: arguments must have equal lengths", false);
+        }
+        ql::packed_schedule s;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (gate_class[i] > ql::fidelity_2q)
+            {
+                throw ql::exception("FidelityEstimator.add_schedule: gate class " + std::to_string(gate_class[i]) + " is not 0, 1, 2 or 3", false);
+            }
+            if (gate_class[i] != ql::fidelity_skip && (qubit0[i] >= qubit_count || (gate_class[i] == ql::fidelity_2q && qubit1[i] >= qubit_count)))
+            {
+                throw ql::exception("FidelityEstimator.add_schedule: qubit operand of gate " + std::to_string(i) + " out of range", false);
+            }
+            s.push_back(qubit0[i], qubit1[i], cycle[i], duration[i], gate_class[i]);
+        }
+        schedules.push_back(s);
+        return schedules.size() - 1;
+    }
+
+    size_t add_program(Program& p)
+    {
+        size_t first = schedules.size();
+        for (auto & k : p.program->kernels)
+        {
+            for (auto gp : k.c)
+            {
+                for (auto q : gp->operands)
+                {
+                    if (q >= qubit_count)
+                    {
+                        throw ql::exception("FidelityEstimator.add_program: qubit operand of " + gp->qasm() + " out of range", false);
+                    }
+                }
+            }
+            schedules.push_back(ql::pack_schedule(k.c, p.program->platform.cycle_time));
+        }
+        return first;
+    }
+
+    std::vector<double> estimate()
+    {
+        return estimator->estimate(schedules);
+    }
+
+    void clear()
+    {
+        schedules.clear();
+    }
+};
+
 /**
  * cqasm reader interface
  */
@@ -172,6 +172,7 @@ protected:
         DOUT("kernel " << kernel.name << " optimize_kernel(): circuit before optimizing: ");
         print(kernel.c);
         DOUT("... end circuit");
+        size_t  size_before = kernel.c.size();
         ql::rotations_merging rm;
         if (contains_measurements(kernel.c))
         {
@@ -200,6 +201,11 @@ protected:
         {
             kernel.c = rm.optimize(kernel.c);
         }
+        // merging only removes gates, so an unchanged size means an unchanged circuit
+        if (kernel.c.size() != size_before || kernel.cycles_valid)
+        {
+            kernel.set_modified();
+        }
         kernel.cycles_valid = false;
         DOUT("kernel " << kernel.name << " rotation_optimize(): circuit after optimizing: ");
         print(kernel.c);
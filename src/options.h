@@ -10,7 +10,10 @@
 
 #include <utils.h>
 #include <exception.h>
+#include <trace.h>
 #include <CLI/CLI.hpp>
+#include <cstdlib>
+#include <cmath>
 //#include <iostream>
 
 namespace ql
@@ -20,6 +23,18 @@ namespace ql
   private:
       CLI::App * app;
       std::map<std::string, std::string> opt_name2opt_val;
+
+      // validator of an option value that must be a finite number of at least 0
+      static std::string non_negative_number(const std::string &value)
+      {
+          char *end = nullptr;
+          double d = std::strtod(value.c_str(), &end);
+          if (value.empty() || *end != '\0' || !(d >= 0.0) || std::isinf(d))
+          {
+              return "Value " + value + " is not a number of at least 0";
+          }
+          return std::string();
+      }
       
       void set_defaults()
       {
@@ -29,6 +44,9 @@ namespace ql
           opt_name2opt_val["unique_output"] = "no";
           opt_name2opt_val["write_qasm_files"] = "no";
           opt_name2opt_val["write_report_files"] = "no";
+          opt_name2opt_val["profile_passes"] = "no";
+          opt_name2opt_val["write_profile_files"] = "no";
+          opt_name2opt_val["write_trace_files"] = "no";
 
           opt_name2opt_val["optimize"] = "no";
           opt_name2opt_val["use_default_gates"] = "yes";
@@ -39,9 +57,21 @@ namespace ql
           opt_name2opt_val["scheduler"] = "ALAP";
           opt_name2opt_val["scheduler_uniform"] = "no";
           opt_name2opt_val["scheduler_commute"] = "no";
+          opt_name2opt_val["scheduler_portfolio"] = "no";
+          opt_name2opt_val["scheduler_portfolio_seed"] = "0";
+          opt_name2opt_val["scheduler_portfolio_budget"] = "0";
+          opt_name2opt_val["scheduler_exact"] = "no";
+          opt_name2opt_val["scheduler_exact_budget"] = "1000";
+          opt_name2opt_val["scheduler_exact_max_gates"] = "100";
           opt_name2opt_val["prescheduler"] = "yes";
           opt_name2opt_val["scheduler_post179"] = "yes";
           opt_name2opt_val["backend_cc_map_input_file"] = "";
+          opt_name2opt_val["backend_cc_loop_compression"] = "no";
+          opt_name2opt_val["backend_cc_parallel_kernels"] = "no";
+          opt_name2opt_val["backend_cc_vcd_instruments"] = "";
+          opt_name2opt_val["backend_cc_vcd_qubits"] = "";
+          opt_name2opt_val["backend_cc_vcd_kernels"] = "";
+          opt_name2opt_val["backend_cc_vcd_cycles"] = "";
 
           opt_name2opt_val["cz_mode"] = "manual";
           opt_name2opt_val["print_dot_graphs"] = "no";
@@ -57,11 +87,14 @@ namespace ql
           opt_name2opt_val["mapprepinitsstate"] = "no";
           opt_name2opt_val["initialplace"] = "no";
           opt_name2opt_val["initialplace2qhorizon"] = "0";
+          opt_name2opt_val["initialplace_algorithm"] = "mip";
           opt_name2opt_val["maplookahead"] = "noroutingfirst";
+          opt_name2opt_val["maplookaheadwindow"] = "all";
           opt_name2opt_val["mappathselect"] = "all";
           opt_name2opt_val["maprecNN2q"] = "no";
           opt_name2opt_val["mapselectmaxlevel"] = "0";
           opt_name2opt_val["mapselectmaxwidth"] = "min";
+          opt_name2opt_val["mapbudget"] = "0";
           opt_name2opt_val["mapselectswaps"] = "all";
           opt_name2opt_val["maptiebreak"] = "random";
           opt_name2opt_val["mapusemoves"] = "yes";
@@ -78,6 +111,12 @@ namespace ql
           app->add_set_ignore_case("--scheduler", opt_name2opt_val["scheduler"], {"ASAP", "ALAP"}, "scheduler type", true);
           app->add_set_ignore_case("--scheduler_uniform", opt_name2opt_val["scheduler_uniform"], {"yes", "no"}, "Do uniform scheduling or not", true);
           app->add_set_ignore_case("--scheduler_commute", opt_name2opt_val["scheduler_commute"], {"yes", "no"}, "Commute gates when possible, or not", true);
+          app->add_set_ignore_case("--scheduler_portfolio", opt_name2opt_val["scheduler_portfolio"], {"no", "2", "4", "8", "16", "32", "64"}, "Number of list scheduler variants run concurrently by the rc scheduler, keeping the shortest schedule", true);
+          app->add_option("--scheduler_portfolio_seed", opt_name2opt_val["scheduler_portfolio_seed"], "Seed of the randomized scheduler_portfolio variants", true);
+          app->add_option("--scheduler_portfolio_budget", opt_name2opt_val["scheduler_portfolio_budget"], "Time budget in ms of the scheduler_portfolio variants, 0 for none", true);
+          app->add_set_ignore_case("--scheduler_exact", opt_name2opt_val["scheduler_exact"], {"yes", "no"}, "Search the shortest schedule by branch-and-bound after rc scheduling of small kernels", true);
+          app->add_option("--scheduler_exact_budget", opt_name2opt_val["scheduler_exact_budget"], "Time budget in ms of scheduler_exact per kernel, 0 for none", true);
+          app->add_option("--scheduler_exact_max_gates", opt_name2opt_val["scheduler_exact_max_gates"], "Maximum number of gates of a kernel for scheduler_exact", true);
           app->add_set_ignore_case("--use_default_gates", opt_name2opt_val["use_default_gates"], {"yes", "no"}, "Use default gates or not", true);
           app->add_set_ignore_case("--optimize", opt_name2opt_val["optimize"], {"yes", "no"}, "optimize or not", true);
           app->add_set_ignore_case("--clifford_prescheduler", opt_name2opt_val["clifford_prescheduler"], {"yes", "no"}, "clifford optimize before prescheduler yes or not", true);
@@ -88,26 +127,38 @@ namespace ql
           app->add_set_ignore_case("--quantumsim", opt_name2opt_val["quantumsim"], {"no", "yes", "qsoverlay"}, "Produce quantumsim output, and of which kind", true);
           app->add_set_ignore_case("--issue_skip_319", opt_name2opt_val["issue_skip_319"], {"no", "yes"}, "Issue skip instead of wait in bundles", true);
           app->add_option("--backend_cc_map_input_file", opt_name2opt_val["backend_cc_map_input_file"], "Name of CC input map file", true);
+          app->add_set_ignore_case("--backend_cc_loop_compression", opt_name2opt_val["backend_cc_loop_compression"], {"no", "yes"}, "CC backend emits repeating sequences of bundles within a kernel as loops", true);
+          app->add_set_ignore_case("--backend_cc_parallel_kernels", opt_name2opt_val["backend_cc_parallel_kernels"], {"no", "yes"}, "CC backend generates the code of kernels concurrently, on a thread per core", true);
+          app->add_option("--backend_cc_vcd_instruments", opt_name2opt_val["backend_cc_vcd_instruments"], "Comma separated instruments and instrument groups recorded in the CC VCD file (empty for all)", true);
+          app->add_option("--backend_cc_vcd_qubits", opt_name2opt_val["backend_cc_vcd_qubits"], "Comma separated qubits recorded in the CC VCD file (empty for all)", true);
+          app->add_option("--backend_cc_vcd_kernels", opt_name2opt_val["backend_cc_vcd_kernels"], "Comma separated kernels recorded in the CC VCD file (empty for all)", true);
+          app->add_option("--backend_cc_vcd_cycles", opt_name2opt_val["backend_cc_vcd_cycles"], "Range 'first-last' of the cycles of each kernel recorded in the CC VCD file (empty for all)", true);
           app->add_set_ignore_case("--cz_mode", opt_name2opt_val["cz_mode"], {"manual", "auto"}, "CZ mode", true);
 
-          app->add_set_ignore_case("--mapper", opt_name2opt_val["mapper"], {"no", "base", "baserc", "minextend", "minextendrc", "maxfidelity"}, "Mapper heuristic", true);
+          app->add_set_ignore_case("--mapper", opt_name2opt_val["mapper"], {"no", "base", "baserc", "minextend", "minextendrc", "maxfidelity", "sabre"}, "Mapper heuristic", true);
           app->add_set_ignore_case("--mapinitone2one", opt_name2opt_val["mapinitone2one"], {"no", "yes"}, "Initialize mapping of virtual qubits one to one to real qubits", true);
           app->add_set_ignore_case("--mapprepinitsstate", opt_name2opt_val["mapprepinitsstate"], {"no", "yes"}, "Prep gate leaves qubit in zero state", true);
           app->add_set_ignore_case("--mapassumezeroinitstate", opt_name2opt_val["assumezeroinitstate"], {"no", "yes"}, "Assume that qubits are initialized to zero state", true);
           app->add_set_ignore_case("--initialplace", opt_name2opt_val["initialplace"], {"no","yes","1s","10s","1m","10m","1h","1sx","10sx","1mx","10mx","1hx"}, "Initialplace qubits before mapping", true);
           app->add_set_ignore_case("--initialplace2qhorizon", opt_name2opt_val["initialplace2qhorizon"], {"0","1","2","3","4","5","6","7","8","9", "10","11","12","13","14","15","16","17","18","19","20","30","40","50","60","70","80","90","100"}, "Initialplace considers only this number of initial two-qubit gates", true);
+          app->add_set_ignore_case("--initialplace_algorithm", opt_name2opt_val["initialplace_algorithm"], {"mip","anneal"}, "Initialplace solves the placement problem by mip (optimal, needs glpk) or by anneal (heuristic, scales to large devices)", true);
           app->add_set_ignore_case("--maplookahead", opt_name2opt_val["maplookahead"], {"no", "1qfirst", "noroutingfirst", "all"}, "Strategy wrt selecting next gate(s) to map", true);
+          app->add_set_ignore_case("--maplookaheadwindow", opt_name2opt_val["maplookaheadwindow"], {"all", "1", "2", "4", "8", "16", "32", "64"}, "Maximum number of most critical available two-qubit gates considered for mapping next", true);
           app->add_set_ignore_case("--mappathselect", opt_name2opt_val["mappathselect"], {"all", "borders"}, "Which paths: all or borders", true);
           app->add_set_ignore_case("--mapselectswaps", opt_name2opt_val["mapselectswaps"], {"one", "all", "earliest"}, "Select only one swap, or earliest, or all swaps for one alternative", true);
           app->add_set_ignore_case("--maprecNN2q", opt_name2opt_val["maprecNN2q"], {"no","yes"}, "Recursing also on NN 2q gate?", true);
           app->add_set_ignore_case("--mapselectmaxlevel", opt_name2opt_val["mapselectmaxlevel"], {"0","1","2","3","4","5","6","7","8","9","10","inf"}, "Maximum recursion in selecting alternatives on minimum extension", true);
           app->add_set_ignore_case("--mapselectmaxwidth", opt_name2opt_val["mapselectmaxwidth"], {"min","minplusone","minplushalfmin","minplusmin","all"}, "Maximum width number of alternatives to enter recursion with", true);
+          app->add_option("--mapbudget", opt_name2opt_val["mapbudget"], "Time budget in ms of the mapper's recursion in selecting alternatives per kernel, 0 for none", true)->check(non_negative_number);
           app->add_set_ignore_case("--maptiebreak", opt_name2opt_val["maptiebreak"], {"first", "last", "random", "critical"}, "Tie break method", true);
           app->add_set_ignore_case("--mapusemoves", opt_name2opt_val["mapusemoves"], {"no", "yes", "0","1","2","3","4","5","6","7","8","9","10","11","12","13","14","15","16","17","18","19","20"}, "Use unused qubit to move thru", true);
           app->add_set_ignore_case("--mapreverseswap", opt_name2opt_val["mapreverseswap"], {"no", "yes"}, "Reverse swap operands when better", true);
 
           app->add_set_ignore_case("--write_qasm_files", opt_name2opt_val["write_qasm_files"], {"yes", "no"}, "write (un-)scheduled (with and without resource-constraint) qasm files", true);
           app->add_set_ignore_case("--write_report_files", opt_name2opt_val["write_report_files"], {"yes", "no"}, "write report files on circuit characteristics and pass results", true);
+          app->add_set_ignore_case("--profile_passes", opt_name2opt_val["profile_passes"], {"yes", "no"}, "profile time, memory and size of each pass, for get_profile", true);
+          app->add_set_ignore_case("--write_profile_files", opt_name2opt_val["write_profile_files"], {"yes", "no"}, "write json file with time, memory and size profile of each pass", true);
+          app->add_set_ignore_case("--write_trace_files", opt_name2opt_val["write_trace_files"], {"yes", "no"}, "trace passes, kernels, mapper and scheduler and write chrome trace event json file", true);
       }
 
   public:
@@ -138,18 +189,30 @@ namespace ql
                     << "mapinitone2one: "   << opt_name2opt_val["mapinitone2one"] << std::endl
                     << "initialplace: "     << opt_name2opt_val["initialplace"] << std::endl
                     << "initialplace2qhorizon: "<< opt_name2opt_val["initialplace2qhorizon"] << std::endl
+                    << "initialplace_algorithm: "<< opt_name2opt_val["initialplace_algorithm"] << std::endl
                     << "maplookahead: "     << opt_name2opt_val["maplookahead"] << std::endl
+                    << "maplookaheadwindow: " << opt_name2opt_val["maplookaheadwindow"] << std::endl
                     << "mappathselect: "    << opt_name2opt_val["mappathselect"] << std::endl
                     << "maptiebreak: "      << opt_name2opt_val["maptiebreak"] << std::endl
                     << "mapusemoves: "      << opt_name2opt_val["mapusemoves"] << std::endl
                     << "mapreverseswap: "   << opt_name2opt_val["mapreverseswap"] << std::endl
                     << "mapselectswaps: "   << opt_name2opt_val["mapselectswaps"] << std::endl
+                    << "mapbudget: "        << opt_name2opt_val["mapbudget"] << std::endl
                     << "clifford_postmapper: " << opt_name2opt_val["clifford_postmapper"] << std::endl
                     << "scheduler_post179: " << opt_name2opt_val["scheduler_post179"] << std::endl
                     << "scheduler_commute: " << opt_name2opt_val["scheduler_commute"] << std::endl
+                    << "scheduler_portfolio: " << opt_name2opt_val["scheduler_portfolio"] << std::endl
+                    << "scheduler_portfolio_seed: " << opt_name2opt_val["scheduler_portfolio_seed"] << std::endl
+                    << "scheduler_portfolio_budget: " << opt_name2opt_val["scheduler_portfolio_budget"] << std::endl
+                    << "scheduler_exact: " << opt_name2opt_val["scheduler_exact"] << std::endl
+                    << "scheduler_exact_budget: " << opt_name2opt_val["scheduler_exact_budget"] << std::endl
+                    << "scheduler_exact_max_gates: " << opt_name2opt_val["scheduler_exact_max_gates"] << std::endl
                     << "cz_mode: " << opt_name2opt_val["cz_mode"] << std::endl
                     << "write_qasm_files: " << opt_name2opt_val["write_qasm_files"] << std::endl
                     << "write_report_files: " << opt_name2opt_val["write_report_files"] << std::endl
+                    << "profile_passes: " << opt_name2opt_val["profile_passes"] << std::endl
+                    << "write_profile_files: " << opt_name2opt_val["write_profile_files"] << std::endl
+                    << "write_trace_files: " << opt_name2opt_val["write_trace_files"] << std::endl
                     << "print_dot_graphs: " << opt_name2opt_val["print_dot_graphs"] << std::endl;
           // FIXME: incomplete, function seems unused
       }
@@ -217,6 +280,8 @@ namespace ql
               ql::utils::logger::set_log_level(opt_value);
           else if(opt_name == "output_dir")
               ql::utils::make_output_dir(opt_value);
+          else if(opt_name == "write_trace_files")
+              ql::trace::enable(ql_options.get(opt_name) == "yes");
       }
       inline std::string get(std::string opt_name)
       {
@@ -225,6 +290,7 @@ namespace ql
       inline void reset_options()
       {
           ql_options.reset_options();
+          ql::trace::enable(false);
       }
   } // namespace option
 } // namespace ql
@@ -66,18 +66,6 @@ namespace ql
 #include "arch/cbox/cbox_eqasm_compiler.h"
 #include "arch/cc/eqasm_backend_cc.h"
 
-// JvS: this does not belong here *at all*. All header files should have their
-// own CC file with their defs. But only putting the globals in a new
-// corresponding CC file for now breaks linkage on MSVC, because annoyingly CC
-// files are treated as unused and not linked when none of their *functions*
-// are used.
-namespace ql {
-namespace arch {
-size_t CurrSRegCount = 0;
-size_t CurrTRegCount = 0;
-} // namespace arch
-} // namespace ql
-
 
 namespace ql
 {
@@ -277,6 +265,15 @@ void RotationOptimizerPass::runOnProgram(ql::quantum_program *program)
     
     rotation_optimize(program, program->platform, "rotation_optimize");
 }
+
+    /**
+     * @brief  Queries the option controlling the pass
+     * @return bool representing whether rotation optimization is turned on
+     */
+bool RotationOptimizerPass::isEnabled()
+{
+    return ql::options::get("optimize") == "yes";
+}
   
     /**
      * @brief  Apply the pass to the input program
@@ -290,6 +287,15 @@ void DecomposeToffoliPass::runOnProgram(ql::quantum_program *program)
     ql::decompose_toffoli(program, program->platform, "decompose_toffoli");
 }
 
+    /**
+     * @brief  Queries the option controlling the pass
+     * @return bool representing whether toffoli decomposition is turned on
+     */
+bool DecomposeToffoliPass::isEnabled()
+{
+    return ql::options::get("decompose_toffoli") != "no";
+}
+
     /**
      * @brief  Apply the pass to the input program
      * @param  Program object to be read
@@ -392,6 +398,18 @@ void WriteQuantumSimPass::runOnProgram(ql::quantum_program *program)
     ccl_backend_compiler.reset();
 }
 
+    /**
+     * @brief  Queries the options controlling the pass
+     * @return bool representing whether the pass produces any output
+     */
+bool WriteQuantumSimPass::isEnabled()
+{
+    // also when not producing quantumsim output, the pass writes the global in/out report files
+    return ql::options::get("quantumsim") != "no"
+        || ql::options::get("write_report_files") == "yes"
+        || ql::options::get("write_qasm_files") == "yes";
+}
+
     /**
      * @brief  Clifford optimizer
      * @param  Program object to be clifford optimized
@@ -401,6 +419,24 @@ void CliffordOptimizePass::runOnProgram(ql::quantum_program *program)
     ql::clifford_optimize(program, program->platform, getPassName());
 }
 
+    /**
+     * @brief  Queries the option controlling the pass
+     * @return bool representing whether clifford optimization is turned on at this pass' place
+     */
+bool CliffordOptimizePass::isEnabled()
+{
+    return ql::options::get(getPassName()) != "no";
+}
+
+    /**
+     * @brief  Writes the reports of clifford optimization of a program that it wouldn't change
+     * @param  Program object that is already clifford optimized
+     */
+void CliffordOptimizePass::skipOnProgram(ql::quantum_program *program)
+{
+    ql::clifford_report(program, program->platform, getPassName());
+}
+
     /**
      * @brief  Maps the input program to the target platform
      * @param  Program object to be mapped
@@ -22,6 +22,18 @@ class AbstractPass
 {
 public:
     virtual void runOnProgram(ql::quantum_program *program){};
+
+    // queried by PassManager::compile to avoid useless pass executions:
+    // - isEnabled: false when the option controlling the pass turns it into a no-op
+    // - isIdempotent: running the pass again on its own output doesn't change the program
+    // - tracksChanges: the pass calls quantum_kernel::set_modified on each kernel it changes;
+    //   passes that don't are assumed to change the whole program
+    // - skipOnProgram: called instead of runOnProgram when an idempotent pass is avoided;
+    //   writes the reports that runOnProgram writes itself, so that skipping doesn't change the output files
+    virtual bool isEnabled() { return true; };
+    virtual bool isIdempotent() { return false; };
+    virtual bool tracksChanges() { return false; };
+    virtual void skipOnProgram(ql::quantum_program *program){};
     
     AbstractPass(std::string name);
     std::string  getPassName();
@@ -69,6 +81,8 @@ public:
      * @param  Name of the read pass
      */
     WriterPass(std::string name):AbstractPass(name){};
+
+    bool tracksChanges() { return true; };
     
     void runOnProgram(ql::quantum_program *program);
 };
@@ -84,6 +98,9 @@ public:
      * @param  Name of the optimized pass
      */
     RotationOptimizerPass(std::string name):AbstractPass(name){};
+
+    bool isEnabled();
+    bool tracksChanges() { return true; };
     
     void runOnProgram(ql::quantum_program *program);
 };
@@ -99,6 +116,10 @@ public:
      * @param  Name of the optimized pass
      */
     DecomposeToffoliPass(std::string name):AbstractPass(name){};
+
+    bool isEnabled();
+    bool isIdempotent() { return true; };
+    bool tracksChanges() { return true; };
     
     void runOnProgram(ql::quantum_program *program);
 };
@@ -145,6 +166,8 @@ public:
      */
     ReportStatisticsPass(std::string name):AbstractPass(name){};
 
+    bool tracksChanges() { return true; };
+
     void runOnProgram(ql::quantum_program *program);
 };
 
@@ -160,6 +183,8 @@ public:
      */
     CCLPrepCodeGeneration(std::string name):AbstractPass(name){};
 
+    bool tracksChanges() { return true; };
+
     void runOnProgram(ql::quantum_program *program);
 };
 
@@ -175,6 +200,8 @@ public:
      */
     CCLDecomposePreSchedule(std::string name):AbstractPass(name){};
 
+    bool tracksChanges() { return true; };
+
     void runOnProgram(ql::quantum_program *program);
 };
 
@@ -205,6 +232,11 @@ public:
      */
     CliffordOptimizePass(std::string name):AbstractPass(name){};
 
+    bool isEnabled();
+    bool isIdempotent() { return true; };
+    bool tracksChanges() { return true; };
+    void skipOnProgram(ql::quantum_program *program);
+
     void runOnProgram(ql::quantum_program *program);
 };
 
@@ -280,6 +312,9 @@ public:
      */
     WriteQuantumSimPass(std::string name):AbstractPass(name){};
 
+    bool isEnabled();
+    bool tracksChanges() { return true; };
+
     void runOnProgram(ql::quantum_program *program);
 };
 
@@ -7,6 +7,10 @@
 
 #include "passmanager.h"
 #include "write_sweep_points.h"
+#include "profile.h"
+#include "trace.h"
+
+#include <chrono>
 
 namespace ql
 {
@@ -15,7 +19,7 @@ namespace ql
      * @brief   PassManager constructor
      * @param   name Name of the pass manager 
      */
-PassManager::PassManager(std::string name): name(name) {}
+PassManager::PassManager(std::string name): name(name), untrackedChanges(0), avoidedPassCount(0) {}
 
     /**
      * @brief   Applies the sequence of compiler passes to the given program
@@ -25,6 +29,17 @@ void PassManager::compile(ql::quantum_program *program)
 {
    
    DOUT("In PassManager::compile ... ");
+   untrackedChanges = 0;
+   avoidedPassCount = 0;
+   lastRunGeneration.clear();
+   profileRecords.clear();
+   // profiling is only done when asked for; the sizes before a pass are those after the previous one
+   bool profiling = ql::options::get("profile_passes") == "yes" || ql::options::get("write_profile_files") == "yes";
+   program_size_t size = program_size_t();
+   if (profiling)
+   {
+       size = get_program_size(program);
+   }
    for(auto pass : passes)
     {
         ///@todo-rn: implement option to check if following options are actually needed for a pass
@@ -44,16 +59,120 @@ void PassManager::compile(ql::quantum_program *program)
    
         if(!pass->getSkip())
         {
+            // a disabled pass wouldn't change anything, and neither would an idempotent one
+            // that already ran on the very same program; initPass/finalizePass still do the pass' reporting,
+            // and an avoided idempotent pass writes the reports of its runOnProgram by skipOnProgram
+            bool avoid = false;
+            bool idempotent_avoid = false;
+            if (!pass->isEnabled())
+            {
+                DOUT(" Avoiding pass: " << pass->getPassName() << " because it is disabled by its option");
+                avoid = true;
+            }
+            else if (pass->isIdempotent())
+            {
+                auto it = lastRunGeneration.find(std::type_index(typeid(*pass)));
+                if (it != lastRunGeneration.end() && it->second == programGeneration(program))
+                {
+                    DOUT(" Avoiding pass: " << pass->getPassName() << " because its input didn't change since its last run");
+                    avoid = true;
+                    idempotent_avoid = true;
+                }
+            }
+
             DOUT(" Calling pass: " << pass->getPassName());
+            pass_profile_t record;
+            size_t allocations_in = 0;
+            size_t allocated_bytes_in = 0;
+            if (profiling)
+            {
+                record.pass_name = pass->getPassName();
+                record.avoided = avoid;
+                record.size_in = size;
+                allocations_in = profile::allocation_count();
+                allocated_bytes_in = profile::allocated_bytes();
+            }
+
+            QL_TRACE_SPAN("pass", ql::trace::is_enabled() ? ql::trace::intern(pass->getPassName()) : "", (int64_t)avoid);
+            using namespace std::chrono;
+            high_resolution_clock::time_point t0 = high_resolution_clock::now();
             pass->initPass(program);
-            pass->runOnProgram(program);
+            high_resolution_clock::time_point t1 = high_resolution_clock::now();
+            if (avoid)
+            {
+                avoidedPassCount++;
+                if (idempotent_avoid)
+                {
+                    pass->skipOnProgram(program);
+                }
+            }
+            else
+            {
+                pass->runOnProgram(program);
+                if (!pass->tracksChanges())
+                {
+                    untrackedChanges++;
+                }
+                if (pass->isIdempotent())
+                {
+                    lastRunGeneration[std::type_index(typeid(*pass))] = programGeneration(program);
+                }
+            }
+            high_resolution_clock::time_point t2 = high_resolution_clock::now();
             pass->finalizePass(program);
+            high_resolution_clock::time_point t3 = high_resolution_clock::now();
+
+            if (profiling)
+            {
+                record.init_time = duration<double>(t1 - t0).count();
+                record.run_time = duration<double>(t2 - t1).count();
+                record.finalize_time = duration<double>(t3 - t2).count();
+                record.allocations = profile::allocation_count() - allocations_in;
+                record.allocated_bytes = profile::allocated_bytes() - allocated_bytes_in;
+                record.peak_rss = profile::peak_rss();
+                size = avoid ? size : get_program_size(program);
+                record.size_out = size;
+                profileRecords.push_back(record);
+            }
         }
     }
+    IOUT("PassManager " << name << " avoided " << avoidedPassCount << " of " << passes.size() << " pass executions");
+
+    // make the profile available through the program, and write it when requested
+    program->profile = profiling ? profile_to_json(program, profileRecords).dump(4) : "";
+    if (ql::options::get("write_profile_files") == "yes")
+    {
+        std::string fname = ql::options::get("output_dir") + "/" + program->unique_name + "_profile.json";
+        IOUT("writing pass profile to '" << fname << "' ...");
+        ql::utils::write_file(fname, program->profile);
+    }
+    if (ql::options::get("write_trace_files") == "yes")
+    {
+        std::string fname = ql::options::get("output_dir") + "/" + program->unique_name + "_trace.json";
+        IOUT("writing trace to '" << fname << "' ...");
+        ql::trace::write_file(fname);
+        ql::trace::clear();
+    }
     
         // generate sweep_points file ==> TOOD: delete?
         ql::write_sweep_points(program, program->platform, "write_sweep_points");
 }
+
+    /**
+     * @brief   Computes the generation of the program, which changes each time one of its kernels is modified
+     * @param   program   Object reference to the program being compiled
+     * @return  Vector of the number of untracked changes followed by the generation of each kernel
+     */
+std::vector<size_t> PassManager::programGeneration(ql::quantum_program *program)
+{
+    std::vector<size_t> generation;
+    generation.push_back(untrackedChanges);
+    for (auto &kernel : program->kernels)
+    {
+        generation.push_back(kernel.generation);
+    }
+    return generation;
+}
    
     /**
      * @brief   Adds a compiler pass to the pass manager
@@ -10,6 +10,11 @@
 
 #include "passes.h"
 #include "program.h"
+#include "profile.h"
+
+#include <map>
+#include <vector>
+#include <typeindex>
 
 namespace ql
 {
@@ -27,13 +32,25 @@ public:
     AbstractPass* createPass(std::string passName, std::string aliasName);
     AbstractPass* findPass(std::string passName);
     void setPassOptionAll(std::string optionName, std::string optionValue);
+    size_t getAvoidedPassCount() { return avoidedPassCount; };
+    const std::vector<pass_profile_t>& getProfileRecords() { return profileRecords; };
 
 private: 
     void addPass (AbstractPass *pass);
+    std::vector<size_t> programGeneration(ql::quantum_program *program);
     
     std::string           name;
     std::list <class AbstractPass*> passes;
 
+    // to skip useless passes: changes made by passes that don't track them, number of avoided pass executions,
+    // and the program generation at the end of the last execution of each idempotent kind of pass
+    size_t                untrackedChanges;
+    size_t                avoidedPassCount;
+    std::map<std::type_index, std::vector<size_t>> lastRunGeneration;
+
+    // profile of each pass execution of the last compile; see profile.h
+    std::vector<pass_profile_t> profileRecords;
+
 };
 
 } // ql
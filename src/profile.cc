@@ -0,0 +1,185 @@
+/**
+ * @file   profile.cc
+ * @date   10/2020
+ * @brief  compile-time profiling of passes
+ */
+
+#include <utils.h>
+#include <report.h>
+#include <profile.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+// no peak rss support
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef OPENQL_PROFILE_ALLOCATIONS
+// counting replacements of the global allocation functions;
+// these count the allocations of the whole process, not only of OpenQL
+static std::atomic<size_t> ql_allocation_count(0);
+static std::atomic<size_t> ql_allocated_bytes(0);
+
+static void *ql_counting_alloc(std::size_t size)
+{
+    ql_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ql_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+// not inlined into the replacement operator delete, as gcc then mistakes it for a mismatched deallocation
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void ql_counting_free(void *p)
+{
+    std::free(p);
+}
+
+void *operator new(std::size_t size)
+{
+    void *p = ql_counting_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size)
+{
+    void *p = ql_counting_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ql_counting_alloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ql_counting_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    ql_counting_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    ql_counting_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept
+{
+    ql_counting_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept
+{
+    ql_counting_free(p);
+}
+#endif // OPENQL_PROFILE_ALLOCATIONS
+
+namespace ql
+{
+    namespace profile
+    {
+        size_t allocation_count()
+        {
+#ifdef OPENQL_PROFILE_ALLOCATIONS
+            return ql_allocation_count.load(std::memory_order_relaxed);
+#else
+            return 0;
+#endif
+        }
+
+        size_t allocated_bytes()
+        {
+#ifdef OPENQL_PROFILE_ALLOCATIONS
+            return ql_allocated_bytes.load(std::memory_order_relaxed);
+#else
+            return 0;
+#endif
+        }
+
+        size_t peak_rss()
+        {
+#if defined(_WIN32)
+            return 0;
+#else
+            struct rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0)
+            {
+                return 0;
+            }
+#if defined(__APPLE__)
+            return (size_t)usage.ru_maxrss / 1024;     // in bytes on OSX
+#else
+            return (size_t)usage.ru_maxrss;            // in kB on Linux
+#endif
+#endif
+        }
+    } // profile namespace
+
+    program_size_t get_program_size(ql::quantum_program* programp)
+    {
+        program_size_t  size = {0, 0, 0};
+        for (auto &k : programp->kernels)
+        {
+            size.gates += k.c.size();
+            size.quantum_gates += get_quantum_gates_count(k.c, programp->platform);
+            size.cycles += get_circuit_latency(k.c, programp->platform);
+        }
+        return size;
+    }
+
+    static json program_size_to_json(const program_size_t& size)
+    {
+        json j;
+        j["gates"] = size.gates;
+        j["quantum_gates"] = size.quantum_gates;
+        j["cycles"] = size.cycles;
+        return j;
+    }
+
+    json profile_to_json(ql::quantum_program* programp, const std::vector<pass_profile_t>& records)
+    {
+        json j;
+        j["program"] = programp->unique_name;
+        j["allocation_counting"] =
+#ifdef OPENQL_PROFILE_ALLOCATIONS
+            true;
+#else
+            false;
+#endif
+
+        double  total_time = 0.0;
+        json    passes = json::array();
+        for (auto &r : records)
+        {
+            json p;
+            p["name"] = r.pass_name;
+            p["avoided"] = r.avoided;
+            p["init_time"] = r.init_time;
+            p["run_time"] = r.run_time;
+            p["finalize_time"] = r.finalize_time;
+            p["allocations"] = r.allocations;
+            p["allocated_bytes"] = r.allocated_bytes;
+            p["peak_rss_kb"] = r.peak_rss;
+            p["in"] = program_size_to_json(r.size_in);
+            p["out"] = program_size_to_json(r.size_out);
+            passes.push_back(p);
+            total_time += r.init_time + r.run_time + r.finalize_time;
+        }
+        j["passes"] = passes;
+        j["total_time"] = total_time;
+        j["peak_rss_kb"] = profile::peak_rss();
+        return j;
+    }
+
+} // ql namespace
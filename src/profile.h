@@ -0,0 +1,86 @@
+/**
+ * @file   profile.h
+ * @date   10/2020
+ * @brief  compile-time profiling of passes
+ */
+
+#ifndef QL_PROFILE_H
+#define QL_PROFILE_H
+
+#include <program.h>
+
+namespace ql
+{
+    /*
+     * profiling of the passes run by the PassManager
+     *
+     * for each pass execution, the PassManager records a pass_profile_t with:
+     * - the wall-clock time taken by initPass, runOnProgram and finalizePass
+     * - the number of allocations and allocated bytes during the pass;
+     *   these are only counted when OpenQL was built with OPENQL_PROFILE_ALLOCATIONS,
+     *   which replaces the global operator new/delete by counting versions; otherwise they are 0
+     * - the peak resident set size of the process after the pass (in kB, 0 when unknown)
+     * - the number of gates and quantum gates, and the total circuit latency in cycles,
+     *   summed over all kernels, before and after the pass
+     *
+     * this is only done when option profile_passes or write_profile_files is "yes";
+     * profile_to_json converts the records to a machine-readable profile,
+     * which PassManager::compile writes to <output_dir>/<unique_name>_profile.json
+     * when option write_profile_files is "yes"; it is also available through the compiler's and program's APIs
+     */
+
+    namespace profile
+    {
+        /*
+         * number of allocations and allocated bytes since the start of the process;
+         * both are 0 when allocation counting was not compiled in
+         */
+        size_t allocation_count();
+        size_t allocated_bytes();
+
+        /*
+         * peak resident set size of the process in kB; 0 when not available on this platform
+         */
+        size_t peak_rss();
+    } // profile namespace
+
+    /*
+     * sizes of the program at some point in the compilation
+     */
+    struct program_size_t
+    {
+        size_t  gates;              // all gates, including classical and wait gates
+        size_t  quantum_gates;      // see get_quantum_gates_count
+        size_t  cycles;             // sum of the circuit latencies of the kernels
+    };
+
+    /*
+     * record of one pass execution by the PassManager
+     */
+    struct pass_profile_t
+    {
+        std::string     pass_name;
+        bool            avoided;            // the PassManager didn't call runOnProgram; see PassManager::compile
+        double          init_time;          // seconds
+        double          run_time;
+        double          finalize_time;
+        size_t          allocations;
+        size_t          allocated_bytes;
+        size_t          peak_rss;           // kB
+        program_size_t  size_in;
+        program_size_t  size_out;
+    };
+
+    /*
+     * sizes of the given program, summed over its kernels
+     */
+    program_size_t get_program_size(ql::quantum_program* programp);
+
+    /*
+     * convert the pass profile records of a compilation of the given program to json
+     */
+    json profile_to_json(ql::quantum_program* programp, const std::vector<pass_profile_t>& records);
+
+} // ql namespace
+
+#endif //QL_PROFILE_H
@@ -11,7 +11,7 @@
 #include <compiler.h>
 #include <utils.h>
 #include <options.h>
-#include <interactionMatrix.h>
+#include <interaction_graph.h>
 #include <scheduler.h>
 #include <optimizer.h>
 #include <decompose_toffoli.h>
@@ -459,6 +459,14 @@ int quantum_program::compile()
     // generate sweep_points file
     ql::write_sweep_points(this, platform, "write_sweep_points");
 
+    if (ql::options::get("write_trace_files") == "yes")
+    {
+        std::string fname = ql::options::get("output_dir") + "/" + unique_name + "_trace.json";
+        IOUT("writing trace to '" << fname << "' ...");
+        ql::trace::write_file(fname);
+        ql::trace::clear();
+    }
+
     IOUT("compilation of program '" << name << "' done.");
     
     ql::options::reset_options();
@@ -472,8 +480,8 @@ void quantum_program::print_interaction_matrix()
 
     for (auto k : kernels)
     {
-        InteractionMatrix imat( k.get_circuit(), qubit_count);
-        string mstr = imat.getString();
+        ql::interaction_graph graph(k.get_circuit(), qubit_count);
+        string mstr = graph.matrix_string();
         std::cout << mstr << std::endl;
     }
 }
@@ -482,8 +490,8 @@ void quantum_program::write_interaction_matrix()
 {
     for (auto k : kernels)
     {
-        InteractionMatrix imat( k.get_circuit(), qubit_count);
-        string mstr = imat.getString();
+        ql::interaction_graph graph(k.get_circuit(), qubit_count);
+        string mstr = graph.matrix_string();
 
         string fname = ql::options::get("output_dir") + "/" + k.get_name() + "InteractionMatrix.dat";
         IOUT("writing interaction matrix to '" << fname << "' ...");
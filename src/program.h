@@ -37,6 +37,7 @@ public:
     std::string           eqasm_compiler_name;
     bool                  needs_backend_compiler;
     ql::eqasm_compiler *  backend_compiler;
+    std::string           profile;          // json pass profile of the last compilation by a PassManager, if profiled
 
 
 public:
@@ -66,6 +67,7 @@ public:
     void print_interaction_matrix();
     void write_interaction_matrix();
     void set_sweep_points(float * swpts, size_t size);
+    std::string get_profile() { return profile; };
     
     std::vector<quantum_kernel> get_kernels() { return kernels; };
 
@@ -98,6 +98,16 @@ namespace ql
                 const std::string               comment_prefix
                );
 
+    /*
+     * number of quantum gates (so excluding classical and wait gates) in the given circuit
+     */
+    size_t get_quantum_gates_count(const circuit& c, const quantum_platform& platform);
+
+    /*
+     * latency in cycles of the given circuit; 0 when it wasn't scheduled
+     */
+    size_t get_circuit_latency(const circuit& c, const quantum_platform& platform);
+
     /*
      * report given string which is assumed to be closed by an endl by the caller
      */
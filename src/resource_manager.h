@@ -46,6 +46,29 @@ public:
 
     virtual bool available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform) = 0;
     virtual void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform) = 0;
+
+    // the first cycle, starting at op_start_cycle and going in the scheduling direction
+    // (i.e. the earliest cycle >= op_start_cycle when forward, the latest cycle <= op_start_cycle when backward),
+    // at which this resource is available for ins; 0 when backward and there is no such cycle.
+    // This default implementation probes each cycle in turn;
+    // resources override it to answer directly from their state, without probing.
+    virtual size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        while (!available(op_start_cycle, ins, platform))
+        {
+            if (forward_scheduling == direction)
+            {
+                op_start_cycle++;
+            }
+            else
+            {
+                if (op_start_cycle == 0) break;
+                op_start_cycle--;
+            }
+        }
+        return op_start_cycle;
+    }
+
     virtual ~resource_t() {}
     virtual resource_t* clone() const & = 0;
     virtual resource_t* clone() && = 0;
@@ -133,6 +156,28 @@ public:
         return true;
     }
 
+    // the first cycle from op_start_cycle in the scheduling direction at which all resources are available for ins;
+    // since a resource may be available at a cycle and not at the next ones (e.g. a measurement unit
+    // that can be shared only by measurements starting in the same cycle), iterate until all agree
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for(auto rptr : resource_ptrs)
+            {
+                size_t c = rptr->earliest_available(op_start_cycle, ins, platform);
+                if (c != op_start_cycle)
+                {
+                    op_start_cycle = c;
+                    changed = true;
+                }
+            }
+        }
+        return op_start_cycle;
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         // DOUT("reserving resources for: " << ins->qasm());
@@ -224,6 +269,12 @@ public:
         return platform_resource_manager_ptr->available(op_start_cycle, ins, platform);
     }
 
+    size_t earliest_available(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
+    {
+        // DOUT("resource_manager.earliest_available()");
+        return platform_resource_manager_ptr->earliest_available(op_start_cycle, ins, platform);
+    }
+
     void reserve(size_t op_start_cycle, ql::gate * ins, const ql::quantum_platform & platform)
     {
         // DOUT("resource_manager.reserve()");
@@ -47,19 +47,39 @@
     the respective commutatable gates are sequentialized according to the original circuit's order.
     With all 'no's replaced by '/', all event types become equivalent (i.e. as if they were Write).
 
+    Without the 'no' dependences, a run of R events (or of D events) on the same qubit forms a list of commuting gates.
+    All gates of such a list must be ordered before each gate of the next list (of the other kind) or next W.
+    To keep the number of dependences linear in the number of gates, the list is represented by a GROUP node
+    (a dummy gate of duration 0) when it is closed by the first gate of the next list of the other kind:
+    each member of the list gets a dependence to the GROUP node, and each gate of the next list one from it.
+    The GROUP nodes are part of the dependence graph, so schedulers and criticality computation see them as
+    any other dummy node; they are not part of the circuit.
+
     Schedulers come essentially in the following forms:
     - ASAP: a plain forward scheduler using dependences only, aiming at execution each gate as soon as possible
     - ASAP with resource constraints: similar but taking resource constraints of the gates of the platform into account
     - ALAP: as ASAP but then aiming at execution of each gate as late as possible
     - ALAP with resource constraints: similar but taking resource constraints of the gates of the platform into account
     - ALAP with UNIFORM bundle lengths: using dependences only, aim at ALAP but with equally length bundles
+    - ASAP/ALAP with resource constraints by a portfolio of list schedulers, keeping the shortest schedule
+    - exact: for small kernels, the shortest schedule with resource constraints, found by branch-and-bound
     ASAP/ALAP can be controlled by the "scheduler" option. Similarly for UNIFORM ("scheduler_uniform").
+    The portfolio and exact schedulers are enabled by "scheduler_portfolio" and "scheduler_exact".
     With/out resource constraints are separate method calls.
 
     Commutation support during scheduling in general produces more efficient/shorter scheduled circuits.
     It is enabled by option "scheduler_commute".
  */
 
+#include <set>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+
 #include <lemon/list_graph.h>
 #include <lemon/lgf_reader.h>
 #include <lemon/lgf_writer.h>
@@ -73,6 +93,7 @@
 #include "ir.h"
 #include "resource_manager.h"
 #include "report.h"
+#include "trace.h"
 
 using namespace std;
 using namespace lemon;
@@ -107,6 +128,11 @@ public:
     size_t          creg_count;                 // number of cregs, to check/represent creg as cause of dependence
     ql::circuit*    circp;                      // current and result circuit, passed from Init to each scheduler
 
+    // gate and GROUP nodes in the order of creation, which is a topological order of the graph without s and t;
+    // the circuit's gates may be reordered by a scheduler but are also in a topological order
+    std::vector<ListDigraph::Node>  node_order;
+    std::vector<ql::GROUP*>         group_gates;    // the GROUP gates, owned by the scheduler
+
     // scheduler support
     std::map<ListDigraph::Node,size_t>  remaining;  // remaining[node] == cycles until end; critical path representation
 
@@ -115,6 +141,20 @@ public:
     Scheduler(): instruction(graph), name(graph), weight(graph),
         cause(graph), depType(graph) {}
 
+    ~Scheduler()
+    {
+        for (auto gp : group_gates)
+        {
+            delete gp;
+        }
+    }
+
+    // whether node n is a GROUP node, representing a list of commuting gates
+    bool is_group(ListDigraph::Node n)
+    {
+        return n != s && n != t && instruction[n]->type() == ql::gate_type_t::__dummy_gate__;
+    }
+
     // ins->name may contain parameters, so must be stripped first before checking it for gate's name
     void stripname(std::string& name)
     {
@@ -140,9 +180,55 @@ public:
         DOUT("... dep " << name[srcNode] << " -> " << name[tgtNode] << " (opnd=" << operand << ", dep=" << DepTypesNames[deptype] << ", wght=" << weight[arc] << ")");
     }
 
+    // list of the ids of the nodes of the gates with commuting R events (or commuting D events) on a qubit/creg
+    typedef vector<int> ReadersListType;
+
+    // represent the list of commuting gates (by their ids) in members by a single node and return its id:
+    // the gate itself when there is only one, otherwise a new GROUP node that depends on all of them
+    int add_group(const ReadersListType& members, enum DepTypes deptype, int operand)
+    {
+        if (members.size() == 1)
+        {
+            return members.front();
+        }
+        ListDigraph::Node groupNode = graph.addNode();
+        int groupID = graph.id(groupNode);
+        ql::GROUP* gp = new ql::GROUP();
+        group_gates.push_back(gp);
+        instruction[groupNode] = gp;
+        node[instruction[groupNode]] = groupNode;
+        name[groupNode] = instruction[groupNode]->qasm();
+        node_order.push_back(groupNode);
+        for (auto memberID : members)
+        {
+            add_dep(memberID, groupID, deptype, operand);
+        }
+        return groupID;
+    }
+
+    // with commutation, add the dependences of an R (or D) event of gate consID on operand
+    // on the previous list of Ds (or Readers) of operand;
+    // otherList is the current list of the other kind of events, which the event closes when it is not empty,
+    // and lastGroup the node id representing the list before the current list of the same kind, or -1;
+    // at most one of LastReaders/LastDs of an operand is non-empty,
+    // and lastGroup is invalidated by a W event, which depends on all gates of the current list itself
+    void add_commuting_deps(ReadersListType& otherList, int& lastGroup, int consID, enum DepTypes deptype, int operand)
+    {
+        if (!otherList.empty())
+        {
+            lastGroup = add_group(otherList, deptype, operand);
+            otherList.clear();
+        }
+        if (lastGroup != -1)
+        {
+            add_dep(lastGroup, consID, deptype, operand);
+        }
+    }
+
     // fill the dependence graph ('graph') with nodes from the circuit and adding arcs for their dependences
     void init(ql::circuit& ckt, ql::quantum_platform platform, size_t qcount, size_t ccount)
     {
+        QL_TRACE_SPAN("scheduler", "dependence_graph", (int64_t)ckt.size());
         DOUT("Dependence graph creation ... #qubits = " << platform.qubit_number);
         qubit_count = qcount; ///@todo-rn: DDG creation should not depend on #qubits
         creg_count = ccount; ///@todo-rn: DDG creation should not depend on #cregs
@@ -156,8 +242,9 @@ public:
         // - the previous gates that Read r in LastReaders[r]; this is a list
         // - the previous gates that D qubit q in LastDs[q]; this is a list
         // - the previous gate that Wrote r in LastWriter[r]; this can only be one
+        // - with commutation, the node representing the list of Readers/Ds before the current one in LastGroup[r]
         // operands can be a qubit or a classical register
-        typedef vector<int> ReadersListType;
+        bool commute = (ql::options::get("scheduler_commute") == "yes");
 
         vector<ReadersListType> LastReaders;
         LastReaders.resize(qubit_creg_count);
@@ -165,6 +252,9 @@ public:
         vector<ReadersListType> LastDs;
         LastDs.resize(qubit_creg_count);
 
+        vector<int> LastGroup(qubit_creg_count, -1);
+        node_order.clear();
+
         // start filling the dependence graph by creating the s node, the top of the graph
         {
             // add dummy source node
@@ -295,6 +385,7 @@ public:
                     DOUT(".. Clearing LastReaders for operand: " << operand);
                     LastReaders[operand].clear();
                     LastDs[operand].clear();
+                    LastGroup[operand] = -1;
                     DOUT(".. Update LastWriter done");
                 }
                 for( auto coperand : ins->creg_operands )
@@ -334,6 +425,7 @@ public:
                     LastWriter[operand] = consID;
                     LastReaders[operand].clear();
                     LastDs[operand].clear();
+                    LastGroup[operand] = -1;
                 }
             }
             else if(ins->type() == ql::gate_type_t::__classical_gate__)
@@ -375,31 +467,39 @@ public:
                     if( operandNo == 0)
                     {
                         add_dep(LastWriter[operand], consID, RAW, operand);
-	                    if (ql::options::get("scheduler_commute") == "no")
+                        if (commute)
+                        {
+                            add_commuting_deps(LastDs[operand], LastGroup[operand], consID, RAD, operand);
+                        }
+                        else
                         {
                             for(auto & readerID : LastReaders[operand])
                             {
                                 add_dep(readerID, consID, RAR, operand);
                             }
-                        }
-                        for(auto & readerID : LastDs[operand])
-                        {
-                            add_dep(readerID, consID, RAD, operand);
+                            for(auto & readerID : LastDs[operand])
+                            {
+                                add_dep(readerID, consID, RAD, operand);
+                            }
                         }
                     }
                     else
                     {
                         add_dep(LastWriter[operand], consID, DAW, operand);
-	                    if (ql::options::get("scheduler_commute") == "no")
+                        if (commute)
+                        {
+                            add_commuting_deps(LastReaders[operand], LastGroup[operand], consID, DAR, operand);
+                        }
+                        else
                         {
                             for(auto & readerID : LastDs[operand])
                             {
                                 add_dep(readerID, consID, DAD, operand);
                             }
-                        }
-                        for(auto & readerID : LastReaders[operand])
-                        {
-                            add_dep(readerID, consID, DAR, operand);
+                            for(auto & readerID : LastReaders[operand])
+                            {
+                                add_dep(readerID, consID, DAR, operand);
+                            }
                         }
                     }
                     operandNo++;
@@ -434,7 +534,7 @@ public:
                 for( auto operand : operands )
                 {
                     DOUT(".. Operand: " << operand);
-                    if (ql::options::get("scheduler_commute") == "no")
+                    if (!commute)
                     {
                         for(auto & readerID : LastReaders[operand])
                         {
@@ -442,9 +542,16 @@ public:
                         }
                     }
                     add_dep(LastWriter[operand], consID, RAW, operand);
-                    for(auto & readerID : LastDs[operand])
+                    if (commute)
+                    {
+                        add_commuting_deps(LastDs[operand], LastGroup[operand], consID, RAD, operand);
+                    }
+                    else
                     {
-                        add_dep(readerID, consID, RAD, operand);
+                        for(auto & readerID : LastDs[operand])
+                        {
+                            add_dep(readerID, consID, RAD, operand);
+                        }
                     }
                     operandNo++;
                 } // end of operand for
@@ -474,16 +581,20 @@ public:
                 {
                     DOUT(".. Operand: " << operand);
                     add_dep(LastWriter[operand], consID, RAW, operand);
-                    if (ql::options::get("scheduler_commute") == "no")
+                    if (commute)
+                    {
+                        add_commuting_deps(LastDs[operand], LastGroup[operand], consID, RAD, operand);
+                    }
+                    else
                     {
                         for(auto & readerID : LastReaders[operand])
                         {
                             add_dep(readerID, consID, RAR, operand);
                         }
-                    }
-                    for(auto & readerID : LastDs[operand])
-                    {
-                        add_dep(readerID, consID, RAD, operand);
+                        for(auto & readerID : LastDs[operand])
+                        {
+                            add_dep(readerID, consID, RAD, operand);
+                        }
                     }
 
                     if( operandNo < op_count-1 )
@@ -506,6 +617,7 @@ public:
                         LastWriter[operand] = consID;
                         LastReaders[operand].clear();
                         LastDs[operand].clear();
+                        LastGroup[operand] = -1;
                     }
                     operandNo++;
                 } // end of operand for
@@ -533,6 +645,7 @@ public:
                     LastWriter[operand] = consID;
                     LastReaders[operand].clear();
                     LastDs[operand].clear();
+                    LastGroup[operand] = -1;
                 } // end of operand for
 
                 // Read+Write each classical operand
@@ -555,6 +668,7 @@ public:
                     LastDs[qubit_count+coperand].clear();
                 } // end of coperand for
             } // end of if/else
+            node_order.push_back(consNode);     // after the GROUP nodes it depends on
             DOUT(". instruction done: " << ins->qasm());
         } // end of instruction for
 
@@ -603,6 +717,7 @@ public:
 	            LastWriter[operand] = consID;
 	            LastReaders[operand].clear();
 	            LastDs[operand].clear();
+	            LastGroup[operand] = -1;
 	        }
         }
 
@@ -616,7 +731,8 @@ public:
             DOUT("The dependence graph is not a DAG.");
             EOUT("The dependence graph is not a DAG.");
         }
-        DOUT("Dependence graph creation Done.");
+        DOUT("Dependence graph creation Done: " << countNodes(graph) << " nodes of which " << group_gates.size()
+            << " GROUP nodes, " << countArcs(graph) << " arcs");
     }
 
     void print()
@@ -743,11 +859,11 @@ public:
         {
             instruction[s]->cycle = 0;
             DOUT("... set_cycle of " << instruction[s]->qasm() << " cycles " << instruction[s]->cycle);
-            // *circp is by definition in a topological order of the dependence graph
-            for ( ql::circuit::iterator gpit = circp->begin(); gpit != circp->end(); gpit++)
+            // node_order is by definition in a topological order of the dependence graph
+            for ( auto n : node_order )
             {
-                set_cycle_gate(*gpit, dir);
-                DOUT("... set_cycle of " << (*gpit)->qasm() << " cycles " << (*gpit)->cycle);
+                set_cycle_gate(instruction[n], dir);
+                DOUT("... set_cycle of " << name[n] << " cycles " << instruction[n]->cycle);
             }
             set_cycle_gate(instruction[t], dir);
             DOUT("... set_cycle of " << instruction[t]->qasm() << " cycles " << instruction[t]->cycle);
@@ -755,23 +871,23 @@ public:
         else
         {
             instruction[t]->cycle = ALAP_SINK_CYCLE;
-            // *circp is by definition in a topological order of the dependence graph
-            for ( ql::circuit::reverse_iterator gpit = circp->rbegin(); gpit != circp->rend(); gpit++)
+            // node_order is by definition in a topological order of the dependence graph
+            for ( auto nit = node_order.rbegin(); nit != node_order.rend(); nit++)
             {
-                set_cycle_gate(*gpit, dir);
+                set_cycle_gate(instruction[*nit], dir);
             }
             set_cycle_gate(instruction[s], dir);
 
-            // readjust cycle values of gates so that SOURCE is at 0
+            // readjust cycle values of gates (and GROUP nodes) so that SOURCE is at 0
             size_t  SOURCECycle = instruction[s]->cycle;
             DOUT("... readjusting cycle values by -" << SOURCECycle);
 
             instruction[t]->cycle -= SOURCECycle;
             DOUT("... set_cycle of " << instruction[t]->qasm() << " cycles " << instruction[t]->cycle);
-            for ( auto & gp : *circp)
+            for ( auto n : node_order )
             {
-                gp->cycle -= SOURCECycle;
-                DOUT("... set_cycle of " << gp->qasm() << " cycles " << gp->cycle);
+                instruction[n]->cycle -= SOURCECycle;
+                DOUT("... set_cycle of " << name[n] << " cycles " << instruction[n]->cycle);
             }
             instruction[s]->cycle -= SOURCECycle;   // i.e. becomes 0
             DOUT("... set_cycle of " << instruction[s]->qasm() << " cycles " << instruction[s]->cycle);
@@ -807,6 +923,7 @@ public:
     // ASAP scheduler without RC, setting gate cycle values and sorting the resulting circuit
     void schedule_asap(std::string & sched_dot)
     {
+        QL_TRACE_SPAN("scheduler", "schedule_asap");
         DOUT("Scheduling ASAP ...");
         set_cycle(ql::forward_scheduling);
         sort_by_cycle(circp);
@@ -824,6 +941,7 @@ public:
     // ALAP scheduler without RC, setting gate cycle values and sorting the resulting circuit
     void schedule_alap(std::string & sched_dot)
     {
+        QL_TRACE_SPAN("scheduler", "schedule_alap");
         DOUT("Scheduling ALAP ...");
         set_cycle(ql::backward_scheduling);
         sort_by_cycle(circp);
@@ -893,12 +1011,11 @@ public:
         {
             // remaining until SINK (i.e. the SINK.cycle-ALAP value)
             remaining[t] = 0;
-            // *circp is by definition in a topological order of the dependence graph
-            for ( ql::circuit::reverse_iterator gpit = circp->rbegin(); gpit != circp->rend(); gpit++)
+            // node_order is by definition in a topological order of the dependence graph
+            for ( auto nit = node_order.rbegin(); nit != node_order.rend(); nit++)
             {
-                ql::gate*   gp2 = *gpit;
-                set_remaining_gate(gp2, dir);
-                DOUT("... remaining at " << gp2->qasm() << " cycles " << remaining[node[gp2]]);
+                set_remaining_gate(instruction[*nit], dir);
+                DOUT("... remaining at " << name[*nit] << " cycles " << remaining[*nit]);
             }
             gp = instruction[s];
             set_remaining_gate(gp, dir);
@@ -908,12 +1025,11 @@ public:
         {
             // remaining until SOURCE (i.e. the ASAP value)
             remaining[s] = 0;
-            // *circp is by definition in a topological order of the dependence graph
-            for ( ql::circuit::iterator gpit = circp->begin(); gpit != circp->end(); gpit++)
+            // node_order is by definition in a topological order of the dependence graph
+            for ( auto n : node_order )
             {
-                ql::gate*   gp2 = *gpit;
-                set_remaining_gate(gp2, dir);
-                DOUT("... remaining at " << gp2->qasm() << " cycles " << remaining[node[gp2]]);
+                set_remaining_gate(instruction[n], dir);
+                DOUT("... remaining at " << name[n] << " cycles " << remaining[n]);
             }
             gp = instruction[t];
             set_remaining_gate(gp, dir);
@@ -1195,20 +1311,49 @@ public:
     }
 
     // advance curr_cycle
-    // when no node was selected from the avlist, advance to the next cycle
-    // and try again; this makes nodes/instructions to complete execution for one more cycle,
-    // and makes resources finally available in case of resource constrained scheduling
-    // so it contributes to proceeding and to finally have an empty avlist
-    void AdvanceCurrCycle(ql::scheduling_direction_t dir, size_t& curr_cycle)
+    // when no node was selected from the avlist, advance to the first cycle after curr_cycle
+    // (in the direction of scheduling) at which a node of the avlist
+    // becomes immediately schedulable, i.e. at which its dependences have completed and its resources are available;
+    // this makes nodes/instructions to complete execution, and makes resources finally available,
+    // so it contributes to proceeding and to finally have an empty avlist;
+    // since resource state only changes when a node is scheduled, no node from the avlist can be scheduled
+    // in the cycles that are skipped by advancing curr_cycle directly to this one
+    size_t NextEventCycle(std::list<ListDigraph::Node>& avlist, ql::scheduling_direction_t dir, const size_t curr_cycle,
+                                const ql::quantum_platform& platform, ql::arch::resource_manager_t& rm)
     {
-        if (ql::forward_scheduling == dir)
-        {
-            curr_cycle++;
-        }
-        else
+        bool    found = false;
+        size_t  next_cycle = curr_cycle;
+        for ( auto n : avlist)
         {
-            curr_cycle--;
+            ql::gate*   gp = instruction[n];
+            size_t      c;
+            if (ql::forward_scheduling == dir)
+            {
+                c = std::max(curr_cycle + 1, gp->cycle);
+            }
+            else
+            {
+                c = std::min(curr_cycle - 1, gp->cycle);
+            }
+            if ( n != s && n != t
+                && gp->type() != ql::gate_type_t::__dummy_gate__
+                && gp->type() != ql::gate_type_t::__classical_gate__
+                && gp->type() != ql::gate_type_t::__wait_gate__
+               )
+            {
+                c = rm.earliest_available(c, gp, platform);
+            }
+            if (!found
+                || ( ql::forward_scheduling == dir && c < next_cycle)
+                || ( ql::backward_scheduling == dir && c > next_cycle)
+               )
+            {
+                next_cycle = c;
+                found = true;
+            }
         }
+        DOUT("... next event cycle: " << next_cycle);
+        return next_cycle;
     }
 
     // a gate must wait until all its operand are available, i.e. the gates having computed them have completed,
@@ -1320,8 +1465,9 @@ public:
             selected_node = SelectAvailable(avlist, dir, curr_cycle, platform, rm, success);
             if (!success)
             {
-                // i.e. none from avlist was found suitable to schedule in this cycle
-                AdvanceCurrCycle(dir, curr_cycle);
+                // i.e. none from avlist was found suitable to schedule in this cycle;
+                // advance to the cycle at which the first one will be, instead of probing each cycle in between
+                curr_cycle = NextEventCycle(avlist, dir, curr_cycle, platform, rm);
                 // so try again; eventually instrs complete and machine is empty
                 continue;
             }
@@ -1375,6 +1521,7 @@ public:
 
     void schedule_asap(ql::arch::resource_manager_t & rm, const ql::quantum_platform & platform, std::string& sched_dot)
     {
+        QL_TRACE_SPAN("scheduler", "rc_schedule_asap");
         DOUT("Scheduling ASAP");
         schedule(circp, ql::forward_scheduling, platform, rm, sched_dot);
         DOUT("Scheduling ASAP [DONE]");
@@ -1382,75 +1529,697 @@ public:
 
     void schedule_alap(ql::arch::resource_manager_t & rm, const ql::quantum_platform & platform, std::string& sched_dot)
     {
+        QL_TRACE_SPAN("scheduler", "rc_schedule_alap");
         DOUT("Scheduling ALAP");
         schedule(circp, ql::backward_scheduling, platform, rm, sched_dot);
         DOUT("Scheduling ALAP [DONE]");
     }
 
+// =========== portfolio of list schedulers with RC
+    // The list scheduler above makes one greedy pass with a fixed deep-criticality tie-break.
+    // A different priority order or direction may give a shorter schedule;
+    // schedule_portfolio runs a number of variants of the list scheduler concurrently on a pool of threads
+    // and keeps the schedule with the smallest makespan (the cycle of SINK minus the cycle of SOURCE):
+    // - variant 0 is the list scheduler above in the direction of the "scheduler" option, run on the gates themselves;
+    //   the result is never worse than scheduling without portfolio
+    // - variant 1 is a list scheduler in the other direction, preferring the highest remaining value,
+    //   with ties broken by circuit order
+    // - the other variants alternate between both directions and prefer the highest remaining value,
+    //   randomly perturbed by up to 0, 5, 10 or 15 percent, with ties broken randomly
+    // The random choices of variant i only depend on scheduler_portfolio_seed and i, and a tie in makespan
+    // is won by the lowest variant, so the result is deterministic for a given seed, independent of the number of threads.
+    // When a time budget (scheduler_portfolio_budget, in ms) is given, variants that didn't complete within it
+    // are ignored; variant 0 always completes.
+    // Variants other than 0 don't modify the gates nor the dependence graph (the remaining values of both directions
+    // are precomputed) but compute their cycles in a vector indexed by node id, so they can run concurrently.
+
+    struct portfolio_variant_t
+    {
+        ql::scheduling_direction_t  dir;
+        double                      noise;          // relative random perturbation of the remaining values
+        bool                        randomized;     // ties broken randomly instead of by circuit order
+        size_t                      seed;
+    };
+
+    // whether the gate of node n is scheduled without consulting the resource manager
+    bool is_resource_free(ListDigraph::Node n)
+    {
+        ql::gate*   gp = instruction[n];
+        return n == s || n == t
+            || gp->type() == ql::gate_type_t::__dummy_gate__
+            || gp->type() == ql::gate_type_t::__classical_gate__
+            || gp->type() == ql::gate_type_t::__wait_gate__;
+    }
+
+    // list scheduler with RC of a portfolio variant other than 0, with rem the remaining values of its direction;
+    // the resulting cycles (with SOURCE at 0) are returned in cycle, indexed by node id;
+    // returns false when the deadline passed before the schedule was complete
+    bool schedule_variant(const portfolio_variant_t& v, const std::vector<size_t>& rem,
+            const ql::quantum_platform& platform, ql::arch::resource_manager_t& rm,
+            bool has_deadline, std::chrono::steady_clock::time_point deadline, std::vector<size_t>& cycle)
+    {
+        bool    forward = (ql::forward_scheduling == v.dir);
+        size_t  node_count = graph.maxNodeId() + 1;
+        std::mt19937_64 rng(v.seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        // priority of each node: higher key first, then lower tiebreak first
+        std::vector<double> key(node_count, 0.0);
+        std::vector<size_t> tiebreak(node_count, 0);
+        for (ListDigraph::NodeIt n(graph); n != INVALID; ++n)
+        {
+            int id = graph.id(n);
+            key[id] = rem[id] * (1.0 + v.noise * uniform(rng));
+            tiebreak[id] = v.randomized ? size_t(rng()) : (forward ? size_t(id) : node_count - id);
+        }
+        auto higher_priority = [&](ListDigraph::Node n1, ListDigraph::Node n2)
+        {
+            int id1 = graph.id(n1);
+            int id2 = graph.id(n2);
+            if (key[id1] != key[id2]) return key[id1] > key[id2];
+            return tiebreak[id1] < tiebreak[id2];
+        };
+
+        // number of arcs from nodes that are not scheduled yet; a node becomes available when it drops to 0
+        std::vector<size_t> pending(node_count, 0);
+        for (ListDigraph::ArcIt arc(graph); arc != INVALID; ++arc)
+        {
+            pending[graph.id(forward ? graph.target(arc) : graph.source(arc))]++;
+        }
+
+        // while available, cycle[n] is the cycle at which its dependences have completed; once scheduled, its cycle
+        cycle.assign(node_count, 0);
+        std::vector<ListDigraph::Node> avlist;     // ordered on priority, highest first
+        size_t  curr_cycle = (forward ? 0 : ALAP_SINK_CYCLE);
+        ListDigraph::Node   first = (forward ? s : t);
+        cycle[graph.id(first)] = curr_cycle;
+        avlist.push_back(first);
+
+        size_t  step = 0;
+        while (!avlist.empty())
+        {
+            if (has_deadline && (++step % 64) == 0 && std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+
+            // select the first immediately schedulable node of the avlist
+            auto selected = avlist.end();
+            for (auto it = avlist.begin(); it != avlist.end(); ++it)
+            {
+                size_t  c = cycle[graph.id(*it)];
+                if ( (forward ? c <= curr_cycle : curr_cycle <= c)
+                    && (is_resource_free(*it) || rm.available(curr_cycle, instruction[*it], platform))
+                   )
+                {
+                    selected = it;
+                    break;
+                }
+            }
+            if (selected == avlist.end())
+            {
+                // advance to the next cycle at which a node of the avlist becomes schedulable, as NextEventCycle
+                size_t  next_cycle = curr_cycle;
+                bool    found = false;
+                for (auto n : avlist)
+                {
+                    size_t  c = cycle[graph.id(n)];
+                    c = (forward ? std::max(curr_cycle + 1, c) : std::min(curr_cycle - 1, c));
+                    if (!is_resource_free(n))
+                    {
+                        c = rm.earliest_available(c, instruction[n], platform);
+                    }
+                    if (!found || (forward ? c < next_cycle : c > next_cycle))
+                    {
+                        next_cycle = c;
+                        found = true;
+                    }
+                }
+                curr_cycle = next_cycle;
+                continue;
+            }
+
+            // commit it to the schedule and make the nodes depending on it available when they don't wait for others
+            ListDigraph::Node   n = *selected;
+            avlist.erase(selected);
+            cycle[graph.id(n)] = curr_cycle;
+            if (!is_resource_free(n))
+            {
+                rm.reserve(curr_cycle, instruction[n], platform);
+            }
+            std::vector<ListDigraph::Node> newly_available;
+            if (forward)
+            {
+                for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc)
+                {
+                    ListDigraph::Node   succNode = graph.target(arc);
+                    if (--pending[graph.id(succNode)] == 0)
+                    {
+                        size_t  c = 0;
+                        for (ListDigraph::InArcIt predArc(graph, succNode); predArc != INVALID; ++predArc)
+                        {
+                            c = std::max(c, cycle[graph.id(graph.source(predArc))] + weight[predArc]);
+                        }
+                        cycle[graph.id(succNode)] = c;
+                        newly_available.push_back(succNode);
+                    }
+                }
+            }
+            else
+            {
+                for (ListDigraph::InArcIt arc(graph, n); arc != INVALID; ++arc)
+                {
+                    ListDigraph::Node   predNode = graph.source(arc);
+                    if (--pending[graph.id(predNode)] == 0)
+                    {
+                        size_t  c = MAX_CYCLE;
+                        for (ListDigraph::OutArcIt succArc(graph, predNode); succArc != INVALID; ++succArc)
+                        {
+                            c = std::min(c, cycle[graph.id(graph.target(succArc))] - weight[succArc]);
+                        }
+                        cycle[graph.id(predNode)] = c;
+                        newly_available.push_back(predNode);
+                    }
+                }
+            }
+            for (auto m : newly_available)
+            {
+                avlist.insert(std::upper_bound(avlist.begin(), avlist.end(), m, higher_priority), m);
+            }
+        }
+
+        if (!forward)
+        {
+            // readjust cycle values so that SOURCE is at 0
+            size_t  SOURCECycle = cycle[graph.id(s)];
+            for (ListDigraph::NodeIt n(graph); n != INVALID; ++n)
+            {
+                cycle[graph.id(n)] -= SOURCECycle;
+            }
+        }
+        return true;
+    }
+
+    // portfolio scheduler with RC, dir being the direction of variant 0, see above
+    void schedule_portfolio(ql::scheduling_direction_t dir, const ql::quantum_platform & platform, std::string& sched_dot)
+    {
+        QL_TRACE_SPAN("scheduler", "rc_schedule_portfolio");
+        size_t  variant_count;
+        size_t  seed;
+        size_t  budget;
+        try
+        {
+            variant_count = std::stoul(ql::options::get("scheduler_portfolio"));
+            seed = std::stoul(ql::options::get("scheduler_portfolio_seed"));
+            budget = std::stoul(ql::options::get("scheduler_portfolio_budget"));
+        }
+        catch (const std::exception &e)
+        {
+            FATAL("Illegal value of scheduler_portfolio, scheduler_portfolio_seed or scheduler_portfolio_budget option: " << e.what());
+        }
+        DOUT("Scheduling portfolio of " << variant_count << " variants with seed " << seed << " and budget " << budget << " ms ...");
+        bool    has_deadline = (budget != 0);
+        auto    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+
+        // the remaining values of both directions, computed before starting the threads
+        size_t  node_count = graph.maxNodeId() + 1;
+        std::vector<size_t> rem_forward(node_count, 0);
+        std::vector<size_t> rem_backward(node_count, 0);
+        set_remaining(ql::forward_scheduling);
+        for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) rem_forward[graph.id(n)] = remaining[n];
+        set_remaining(ql::backward_scheduling);
+        for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) rem_backward[graph.id(n)] = remaining[n];
+
+        ql::scheduling_direction_t  other_dir = (ql::forward_scheduling == dir ? ql::backward_scheduling : ql::forward_scheduling);
+        std::vector<portfolio_variant_t>    variants(variant_count);
+        std::vector<ql::arch::resource_manager_t>   rms;    // created here since their construction isn't thread-safe
+        rms.reserve(variant_count);
+        for (size_t i = 0; i < variant_count; i++)
+        {
+            variants[i].dir = (i % 2 == 0 ? dir : other_dir);
+            variants[i].noise = (i < 2 ? 0.0 : 0.05 * ((i/2 - 1) % 4));
+            variants[i].randomized = (i >= 2);
+            variants[i].seed = seed * 1000003 + i;
+            rms.emplace_back(platform, variants[i].dir);
+        }
+
+        std::vector<std::vector<size_t>>    cycles(variant_count);
+        std::vector<char>                   completed(variant_count, false);
+        std::atomic<size_t>                 next_variant(1);
+        std::exception_ptr                  worker_exception;
+        std::mutex                          worker_exception_mutex;
+        auto worker = [&]()
+        {
+            for (size_t i = next_variant++; i < variant_count; i = next_variant++)
+            {
+                if (has_deadline && std::chrono::steady_clock::now() > deadline)
+                {
+                    continue;
+                }
+                try
+                {
+                    QL_TRACE_SPAN("scheduler", "portfolio_variant", int64_t(i));
+                    completed[i] = schedule_variant(variants[i],
+                        ql::forward_scheduling == variants[i].dir ? rem_forward : rem_backward,
+                        platform, rms[i], has_deadline, deadline, cycles[i]);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(worker_exception_mutex);
+                    worker_exception = std::current_exception();
+                }
+            }
+        };
+        size_t  thread_count = std::min(variant_count - 1, size_t(std::max(1u, std::thread::hardware_concurrency())));
+        std::vector<std::thread>    threads;
+        for (size_t i = 0; i < thread_count; i++)
+        {
+            threads.emplace_back(worker);
+        }
+
+        // variant 0 is the list scheduler itself, in this thread and on the gates
+        size_t  best = 0;
+        {
+            QL_TRACE_SPAN("scheduler", "portfolio_variant", int64_t(0));
+            schedule(circp, dir, platform, rms[0], sched_dot);
+        }
+        size_t  best_makespan = instruction[t]->cycle - instruction[s]->cycle;
+        DOUT("... portfolio variant 0 makespan: " << best_makespan);
+
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+        if (worker_exception)
+        {
+            std::rethrow_exception(worker_exception);
+        }
+
+        for (size_t i = 1; i < variant_count; i++)
+        {
+            if (!completed[i])
+            {
+                DOUT("... portfolio variant " << i << " didn't complete within budget");
+                continue;
+            }
+            size_t  makespan = cycles[i][graph.id(t)] - cycles[i][graph.id(s)];
+            DOUT("... portfolio variant " << i << " makespan: " << makespan);
+            if (makespan < best_makespan)
+            {
+                best = i;
+                best_makespan = makespan;
+            }
+        }
+        ql::trace::counter("scheduler", "portfolio_best_variant", best);
+        IOUT("Portfolio scheduling: variant " << best << " of " << variant_count << " has the smallest makespan " << best_makespan);
+
+        if (best != 0)
+        {
+            for (ListDigraph::NodeIt n(graph); n != INVALID; ++n)
+            {
+                instruction[n]->cycle = cycles[best][graph.id(n)];
+            }
+            sort_by_cycle(circp);
+
+            if (ql::options::get("print_dot_graphs") == "yes")
+            {
+                stringstream ssdot;
+                get_dot(false, true, ssdot);
+                sched_dot = ssdot.str();
+            }
+        }
+        DOUT("Scheduling portfolio [DONE]");
+    }
+
+// =========== exact scheduling with RC
+    // For small kernels, schedule_exact searches for the schedule with the smallest makespan
+    // by branch-and-bound, starting from the schedule the list scheduler (or portfolio) above computed.
+    // The search space is that of all list schedulers: the gates are placed one by one,
+    // in non-decreasing distance from the start in the direction of scheduling
+    // (which is what the resource manager expects), each at the earliest distance at which its dependences
+    // have completed and its resources are available; a branch is the choice of the next gate to place.
+    // Every schedule that a list scheduler with any priority function can produce in that direction is in this space;
+    // since the shortest schedule of one direction may be longer than that of the other one,
+    // both directions are searched, so the result is never worse than that of any portfolio variant.
+    // To avoid enumerating the same schedule more than once, gates placed at the same distance
+    // must be placed in topological order (rank, below).
+    // A branch is pruned when the lower bound, i.e. the max over the available gates of their earliest distance
+    // plus their remaining value, is not smaller than the makespan of the best schedule found so far.
+    // Branches are tried in the order of the list scheduler's priority (highest remaining first),
+    // so the first schedules found are close to the list scheduler's.
+    // When the search doesn't complete within the time budget (scheduler_exact_budget, in ms),
+    // the best schedule found is used, which is never worse than the one of the list scheduler.
+
+    struct exact_search_t
+    {
+        bool                            forward;
+        std::vector<size_t>             rem;        // remaining values in the direction of scheduling, by node id
+        std::vector<size_t>             rank;       // position in topological order in that direction, by node id
+        std::vector<size_t>             pending;    // number of arcs from nodes that are not placed yet, by node id
+        std::vector<size_t>             ready;      // while available: distance at which its dependences completed
+        std::vector<size_t>             dist;       // once placed: its distance from the start, by node id
+        std::vector<ListDigraph::Node>  avlist;     // available nodes, ordered on priority, highest first
+        std::vector<ql::arch::resource_manager_t> rms;  // rms[d]: resource state after placing d nodes
+        std::vector<size_t>             best_dist;  // dist of the best schedule found
+        size_t                          best_makespan;
+        size_t                          search_nodes;
+        bool                            has_deadline;
+        std::chrono::steady_clock::time_point deadline;
+        bool                            timed_out;
+    };
+
+    // cycle of a distance from the start in the direction of scheduling, and vice-versa
+    size_t exact_cycle(const exact_search_t& es, size_t d)
+    {
+        return es.forward ? d : ALAP_SINK_CYCLE - d;
+    }
+
+    size_t exact_distance(const exact_search_t& es, size_t c)
+    {
+        return es.forward ? c : ALAP_SINK_CYCLE - c;
+    }
+
+    bool exact_higher_priority(const exact_search_t& es, ListDigraph::Node n1, ListDigraph::Node n2)
+    {
+        int id1 = graph.id(n1);
+        int id2 = graph.id(n2);
+        if (es.rem[id1] != es.rem[id2]) return es.rem[id1] > es.rem[id2];
+        return es.rank[id1] < es.rank[id2];
+    }
+
+    // place node n at distance d after depth nodes were placed; returns the nodes that became available
+    std::vector<ListDigraph::Node> exact_place(exact_search_t& es, size_t depth, ListDigraph::Node n, size_t d,
+            const ql::quantum_platform& platform)
+    {
+        es.dist[graph.id(n)] = d;
+        es.avlist.erase(std::find(es.avlist.begin(), es.avlist.end(), n));
+        es.rms[depth+1] = es.rms[depth];
+        if (!is_resource_free(n))
+        {
+            es.rms[depth+1].reserve(exact_cycle(es, d), instruction[n], platform);
+        }
+
+        std::vector<ListDigraph::Node> newly_available;
+        auto make_available = [&](ListDigraph::Node m, size_t ready)
+        {
+            es.ready[graph.id(m)] = ready;
+            newly_available.push_back(m);
+            es.avlist.insert(std::upper_bound(es.avlist.begin(), es.avlist.end(), m,
+                [&](ListDigraph::Node n1, ListDigraph::Node n2) { return exact_higher_priority(es, n1, n2); }), m);
+        };
+        if (es.forward)
+        {
+            for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc)
+            {
+                ListDigraph::Node   succNode = graph.target(arc);
+                if (--es.pending[graph.id(succNode)] == 0)
+                {
+                    size_t  ready = 0;
+                    for (ListDigraph::InArcIt predArc(graph, succNode); predArc != INVALID; ++predArc)
+                    {
+                        ready = std::max(ready, es.dist[graph.id(graph.source(predArc))] + weight[predArc]);
+                    }
+                    make_available(succNode, ready);
+                }
+            }
+        }
+        else
+        {
+            for (ListDigraph::InArcIt arc(graph, n); arc != INVALID; ++arc)
+            {
+                ListDigraph::Node   predNode = graph.source(arc);
+                if (--es.pending[graph.id(predNode)] == 0)
+                {
+                    size_t  ready = 0;
+                    for (ListDigraph::OutArcIt succArc(graph, predNode); succArc != INVALID; ++succArc)
+                    {
+                        ready = std::max(ready, es.dist[graph.id(graph.target(succArc))] + weight[succArc]);
+                    }
+                    make_available(predNode, ready);
+                }
+            }
+        }
+        return newly_available;
+    }
+
+    // undo exact_place of node n
+    void exact_unplace(exact_search_t& es, ListDigraph::Node n, const std::vector<ListDigraph::Node>& newly_available)
+    {
+        for (auto m : newly_available)
+        {
+            es.avlist.erase(std::find(es.avlist.begin(), es.avlist.end(), m));
+        }
+        if (es.forward)
+        {
+            for (ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc) es.pending[graph.id(graph.target(arc))]++;
+        }
+        else
+        {
+            for (ListDigraph::InArcIt arc(graph, n); arc != INVALID; ++arc) es.pending[graph.id(graph.source(arc))]++;
+        }
+        es.avlist.insert(std::upper_bound(es.avlist.begin(), es.avlist.end(), n,
+            [&](ListDigraph::Node n1, ListDigraph::Node n2) { return exact_higher_priority(es, n1, n2); }), n);
+    }
+
+    // branch-and-bound over the choice of the next node to place, after depth nodes were placed,
+    // the last one at distance last_dist and with rank last_rank
+    void exact_search(exact_search_t& es, size_t depth, size_t last_dist, size_t last_rank,
+            const ql::quantum_platform& platform)
+    {
+        es.search_nodes++;
+        if (es.has_deadline && (es.search_nodes % 256) == 0 && std::chrono::steady_clock::now() > es.deadline)
+        {
+            es.timed_out = true;
+        }
+        if (es.timed_out)
+        {
+            return;
+        }
+        if (es.avlist.empty())
+        {
+            // the last node placed is the end node (SINK when forward, SOURCE when backward)
+            if (last_dist < es.best_makespan)
+            {
+                es.best_makespan = last_dist;
+                es.best_dist = es.dist;
+                DOUT("... exact scheduling found makespan " << last_dist);
+            }
+            return;
+        }
+
+        // the distance at which each available node would be placed, and the lower bound of the makespan
+        std::vector<std::pair<ListDigraph::Node, size_t>> candidates;
+        size_t  bound = 0;
+        for (auto n : es.avlist)
+        {
+            size_t  d = std::max(es.ready[graph.id(n)], last_dist);
+            if (!is_resource_free(n))
+            {
+                d = exact_distance(es, es.rms[depth].earliest_available(exact_cycle(es, d), instruction[n], platform));
+            }
+            bound = std::max(bound, d + es.rem[graph.id(n)]);
+            if (d > last_dist || es.rank[graph.id(n)] > last_rank)
+            {
+                candidates.emplace_back(n, d);
+            }
+        }
+
+        for (auto & cand : candidates)
+        {
+            if (bound >= es.best_makespan)
+            {
+                return;
+            }
+            std::vector<ListDigraph::Node> newly_available = exact_place(es, depth, cand.first, cand.second, platform);
+            exact_search(es, depth+1, cand.second, es.rank[graph.id(cand.first)], platform);
+            exact_unplace(es, cand.first, newly_available);
+            if (es.timed_out)
+            {
+                return;
+            }
+        }
+    }
+
+    // branch-and-bound in direction dir for a schedule with a smaller makespan than best_makespan;
+    // when found, best_makespan is updated and its cycles (with SOURCE at 0) are returned in best_cycle, by node id;
+    // returns false when the deadline passed before the search was complete
+    bool exact_search_direction(ql::scheduling_direction_t dir, const ql::quantum_platform& platform,
+            bool has_deadline, std::chrono::steady_clock::time_point deadline,
+            size_t& best_makespan, std::vector<size_t>& best_cycle, size_t& search_nodes)
+    {
+        QL_TRACE_SPAN("scheduler", "exact_search", int64_t(dir));
+        exact_search_t  es;
+        es.forward = (ql::forward_scheduling == dir);
+        size_t  node_count = graph.maxNodeId() + 1;
+        set_remaining(dir);
+        es.rem.assign(node_count, 0);
+        for (ListDigraph::NodeIt n(graph); n != INVALID; ++n) es.rem[graph.id(n)] = remaining[n];
+        es.rank.assign(node_count, 0);
+        for (size_t i = 0; i < node_order.size(); i++)
+        {
+            es.rank[graph.id(node_order[i])] = (es.forward ? 1 + i : node_order.size() - i);
+        }
+        es.rank[graph.id(es.forward ? t : s)] = node_order.size() + 1;
+        es.pending.assign(node_count, 0);
+        for (ListDigraph::ArcIt arc(graph); arc != INVALID; ++arc)
+        {
+            es.pending[graph.id(es.forward ? graph.target(arc) : graph.source(arc))]++;
+        }
+        es.ready.assign(node_count, 0);
+        es.dist.assign(node_count, 0);
+        es.rms.assign(node_order.size() + 3, ql::arch::resource_manager_t(platform, dir));
+        es.best_makespan = best_makespan;
+        es.search_nodes = 0;
+        es.has_deadline = has_deadline;
+        es.deadline = deadline;
+        es.timed_out = false;
+
+        ListDigraph::Node   first = (es.forward ? s : t);
+        es.avlist.push_back(first);
+        std::vector<ListDigraph::Node> newly_available = exact_place(es, 0, first, 0, platform);
+        exact_search(es, 1, 0, 0, platform);
+        exact_unplace(es, first, newly_available);
+        search_nodes += es.search_nodes;
+
+        if (es.best_makespan < best_makespan)
+        {
+            best_makespan = es.best_makespan;
+            best_cycle.assign(node_count, 0);
+            size_t  end_dist = es.best_dist[graph.id(es.forward ? t : s)];
+            for (ListDigraph::NodeIt n(graph); n != INVALID; ++n)
+            {
+                size_t  d = es.best_dist[graph.id(n)];
+                best_cycle[graph.id(n)] = (es.forward ? d : end_dist - d);
+            }
+        }
+        return !es.timed_out;
+    }
+
+    // exact scheduler with RC, improving on the schedule that is in the gates' cycles;
+    // the search is done first in direction dir, then in the other direction, and when a schedule of the same makespan
+    // is found in both, the one of direction dir is used, as in schedule_portfolio;
+    // returns whether the resulting schedule is proven to be optimal
+    bool schedule_exact(ql::scheduling_direction_t dir, const ql::quantum_platform & platform, std::string& sched_dot)
+    {
+        QL_TRACE_SPAN("scheduler", "rc_schedule_exact");
+        size_t  budget;
+        size_t  max_gates;
+        try
+        {
+            budget = std::stoul(ql::options::get("scheduler_exact_budget"));
+            max_gates = std::stoul(ql::options::get("scheduler_exact_max_gates"));
+        }
+        catch (const std::exception &e)
+        {
+            FATAL("Illegal value of scheduler_exact_budget or scheduler_exact_max_gates option: " << e.what());
+        }
+        if (circp->size() > max_gates)
+        {
+            IOUT("Exact scheduling: skipped, kernel has " << circp->size() << " gates, more than scheduler_exact_max_gates=" << max_gates);
+            return false;
+        }
+        DOUT("Scheduling exact with budget " << budget << " ms ...");
+        bool    has_deadline = (budget != 0);
+        auto    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget);
+
+        // the heuristic schedule is the one to beat; the critical path length is a lower bound
+        size_t  heuristic_makespan = instruction[t]->cycle - instruction[s]->cycle;
+        set_remaining(ql::forward_scheduling);
+        size_t  lower_bound = remaining[s];
+        size_t  best_makespan = heuristic_makespan;
+        std::vector<size_t> best_cycle;
+        size_t  search_nodes = 0;
+
+        ql::scheduling_direction_t  other_dir = (ql::forward_scheduling == dir ? ql::backward_scheduling : ql::forward_scheduling);
+        bool    optimal = exact_search_direction(dir, platform, has_deadline, deadline, best_makespan, best_cycle, search_nodes);
+        optimal = exact_search_direction(other_dir, platform, has_deadline, deadline, best_makespan, best_cycle, search_nodes) && optimal;
+
+        ql::trace::counter("scheduler", "exact_search_nodes", search_nodes);
+        ql::trace::counter("scheduler", "exact_gap", heuristic_makespan - best_makespan);
+        if (optimal)
+        {
+            IOUT("Exact scheduling: optimal makespan " << best_makespan << ", heuristic makespan " << heuristic_makespan
+                << ", gap " << heuristic_makespan - best_makespan << " (" << search_nodes << " search nodes)");
+        }
+        else
+        {
+            IOUT("Exact scheduling: budget exceeded, best makespan " << best_makespan << ", heuristic makespan " << heuristic_makespan
+                << ", lower bound " << lower_bound << ", gap at least " << heuristic_makespan - best_makespan
+                << " and at most " << heuristic_makespan - lower_bound << " (" << search_nodes << " search nodes)");
+        }
+
+        if (best_makespan < heuristic_makespan)
+        {
+            for (ListDigraph::NodeIt n(graph); n != INVALID; ++n)
+            {
+                instruction[n]->cycle = best_cycle[graph.id(n)];
+            }
+            sort_by_cycle(circp);
+
+            if (ql::options::get("print_dot_graphs") == "yes")
+            {
+                stringstream ssdot;
+                get_dot(false, true, ssdot);
+                sched_dot = ssdot.str();
+            }
+        }
+        DOUT("Scheduling exact [DONE]");
+        return optimal;
+    }
+
 // =========== uniform
+    // Uniform scheduling with the same result as the published algorithm, but in O(n log n) time instead of O(n^2):
+    // "Balanced Scheduling and Operation Chaining in High-Level Synthesis for FPGA Designs"
+    // by David C. Zaretsky, Gaurav Mittal, Robert P. Dick, and Prith Banerjee, figure 3,
+    // using the alap values instead of the dependence set sizes, starting from an ASAP schedule,
+    // and readjusting the targeted bundle size each cycle; tests/test_uniform_benchmark.cc has it as reference.
+    //
+    // The published algorithm scans the bundles below the current cycle from high to low cycles,
+    // taking from each bundle the gate with the lowest remaining value that can be moved to the current cycle,
+    // until the current bundle is large enough; when no such gate exists, it scans all the way down to cycle 1.
+    // Instead, this version keeps the set of all gates that can be moved to the current cycle,
+    // ordered as the published algorithm would find them: on decreasing cycle, then increasing remaining,
+    // then circuit order; so selecting a gate is taking the first of that set, and when it is empty, the bundle is done.
+    //
+    // A gate can be moved to cycle c when it completes before its successors and SINK start,
+    // i.e. when c <= latest[gate] := min(cycle of successors (looking through GROUP nodes) and SINK) - duration of gate.
+    // The cycles of the successors of each GROUP node are kept in a multiset, so that looking through it is O(1)
+    // and moving one of its successors O(log n); its members are only reconsidered when the minimum increased.
+    // Since gates are only moved to higher cycles and the current cycle only decreases,
+    // the latest value of a gate only increases, and once a gate can be moved to the current cycle,
+    // it can be moved to all lower cycles as long as it is below it.
+    // So gates enter the set when the current cycle gets down to their latest value,
+    // which is tracked by bucketing the gates on it, or when moving a successor increased it,
+    // and leave the set when they are moved, or when the current cycle gets down to their cycle.
+    // Each gate enters the set at most once per move of one of its successors, so at most O(n) times in total.
     void schedule_alap_uniform()
     {
-        // algorithm based on "Balanced Scheduling and Operation Chaining in High-Level Synthesis for FPGA Designs"
-        // by David C. Zaretsky, Gaurav Mittal, Robert P. Dick, and Prith Banerjee
-        // Figure 3. Balanced scheduling algorithm
-        // Modifications:
-        // - dependency analysis in article figure 2 is O(n^2) because of set union
-        //   this has been left out, using our own linear dependency analysis creating a digraph
-        //   and using the alap values as measure instead of the dep set size computed in article's D[n]
-        // - balanced scheduling algorithm dominates with its O(n^2) when it cannot find a node to forward
-        //   no test has been devised yet to break the loop (figure 3, line 14-35)
-        // - targeted bundle size is adjusted each cycle and is number_of_gates_to_go/number_of_non_empty_bundles_to_go
-        //   this is more greedy, preventing oscillation around a target size based on all bundles,
-        //   because local variations caused by local dep chains create small bundles and thus leave more gates still to go
-        //
-        // Oddly enough, it starts off with an ASAP schedule.
-        // This creates bundles which on average are larger at lower cycle values (opposite to ALAP).
-        // After this, it moves gates up in the direction of the higher cycles but, of course, at most to their ALAP cycle
-        // to fill up the small bundles at the higher cycle values to the targeted uniform length, without extending the circuit.
-        // It does this in a backward scan (as ALAP scheduling would do), so bundles at the highest cycles are filled up first,
-        // and such that the circuit's depth is not enlarged and the dependences/latencies are obeyed.
-        // Hence, the result resembles an ALAP schedule with excess bundle lengths solved by moving nodes down ("rolling pin").
-
+        QL_TRACE_SPAN("scheduler", "schedule_alap_uniform");
         DOUT("Scheduling ALAP UNIFORM to get bundles ...");
 
-        // initialize gp->cycle as ASAP cycles as first approximation of result;
-        // note that the circuit doesn't contain the SOURCE and SINK gates but the dependence graph does;
-        // from SOURCE is a weight 1 dep to the first nodes using each qubit and classical register, and to the SINK gate
-        // is a dep from each unused qubit/classical register result with as weight the duration of the last operation.
-        // SOURCE (node s) is at cycle 0 and the first circuit's gates are at cycle 1.
-        // SINK (node t) is at the earliest cycle that all gates/operations have completed.
+        // ASAP cycles as first approximation, SOURCE at cycle 0, gates at cycles 1 to cycle_count, SINK at cycle_count+1
         set_cycle(ql::forward_scheduling);
         size_t   cycle_count = instruction[t]->cycle - 1;
-        // so SOURCE at cycle 0, then all circuit's gates at cycles 1 to cycle_count, and finally SINK at cycle cycle_count+1
-
-        // compute remaining which is the opposite of the alap cycle value (remaining[node] :=: SINK->cycle - alapcycle[node])
-        // remaining[node] indicates number of cycles remaining in schedule from node's execution start to SINK,
-        // and indicates the latest cycle that the node can be scheduled so that the circuit's depth is not increased.
         set_remaining(ql::forward_scheduling);
 
-        // DOUT("Creating gates_per_cycle");
-        // create gates_per_cycle[cycle] = for each cycle the list of gates at cycle cycle
-        // this is the basic map to be operated upon by the uniforming scheduler below;
-        std::map<size_t,std::list<ql::gate*>> gates_per_cycle;
-        for ( ql::circuit::iterator gpit = circp->begin(); gpit != circp->end(); gpit++)
+        // dense per-cycle bundle sizes; gates are only moved to the current cycle, so the bundles below it
+        // keep their gates in circuit order, which is the order in which the published algorithm finds them
+        std::vector<ql::gate*>      gates(circp->begin(), circp->end());
+        ListDigraph::NodeMap<size_t> index(graph);
+        std::vector<size_t>         bundle_size(cycle_count + 2, 0);
+        for (size_t i = 0; i < gates.size(); i++)
         {
-            ql::gate*           gp = *gpit;
-            gates_per_cycle[gp->cycle].push_back(gp);
+            index[node[gates[i]]] = i;
+            bundle_size[gates[i]->cycle]++;
         }
 
-        // DOUT("Displaying circuit and bundle statistics");
-        // to compute how well the algorithm is doing, two measures are computed:
-        // - the largest number of gates in a cycle in the circuit,
-        // - and the average number of gates in non-empty cycles
-        // this is done before and after uniform scheduling, and printed
-        size_t max_gates_per_cycle = 0;
         size_t non_empty_bundle_count = 0;
-        size_t gate_count = 0;
+        size_t gate_count = gates.size();
+        size_t max_gates_per_cycle = 0;
         for (size_t curr_cycle = 1; curr_cycle <= cycle_count; curr_cycle++)
         {
-            max_gates_per_cycle = std::max(max_gates_per_cycle, gates_per_cycle[curr_cycle].size());
-            if (int(gates_per_cycle[curr_cycle].size()) != 0) non_empty_bundle_count++;
-            gate_count += gates_per_cycle[curr_cycle].size();
+            max_gates_per_cycle = std::max(max_gates_per_cycle, bundle_size[curr_cycle]);
+            if (bundle_size[curr_cycle] != 0) non_empty_bundle_count++;
         }
         double avg_gates_per_cycle = double(gate_count)/cycle_count;
         double avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
@@ -1464,157 +2233,170 @@ public:
             << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
             );
 
-        // in a backward scan, make non-empty bundles max avg_gates_per_non_empty_cycle long;
-        // an earlier version of the algorithm aimed at making bundles max avg_gates_per_cycle long
-        // but that flawed because of frequent empty bundles causing this estimate for a uniform length being too low
-        // DOUT("Backward scan uniform scheduling");
-        for (size_t curr_cycle = cycle_count; curr_cycle >= 1; curr_cycle--)
+        // the cycles of the successors of each GROUP node, its minimum being the cycle its members must complete by;
+        // the successors of a GROUP node are gates, the first of the next list of commuting gates or the next writer
+        ListDigraph::NodeMap<size_t> group_index(graph);
+        std::vector<std::multiset<size_t>> group_succ_cycles;
+        for (auto n : node_order)
         {
-            // Backward with pred_cycle from curr_cycle-1 down to 1, look for node(s) to fill up current too small bundle.
-            // After an iteration at cycle curr_cycle, all bundles from curr_cycle to cycle_count have been filled up,
-            // and all bundles from 1 to curr_cycle-1 still have to be done.
-            // This assumes that current bundle is never too long, excess having been moved away earlier, as ASAP does.
-            // When such a node cannot be found, this loop scans the whole circuit for each original node to fill up
-            // and this creates a O(n^2) time complexity.
-            //
-            // A test to break this prematurely based on the current data structure, wasn't devised yet.
-            // A solution is to use the dep graph instead to find a node to fill up the current node,
-            // i.e. maintain a so-called "available list" of nodes free to schedule, as in the non-uniform scheduling algorithm,
-            // which is not hard at all but which is not according to the published algorithm.
-            // When the complexity becomes a problem, it is proposed to rewrite the algorithm accordingly.
+            if (is_group(n))
+            {
+                group_index[n] = group_succ_cycles.size();
+                group_succ_cycles.emplace_back();
+                for ( ListDigraph::OutArcIt arc(graph, n); arc != INVALID; ++arc )
+                {
+                    group_succ_cycles.back().insert(instruction[graph.target(arc)]->cycle);
+                }
+            }
+        }
+
+        // latest cycle the gate can be moved to; 0 when it cannot be moved at all
+        auto latest = [&](size_t i) -> size_t
+        {
+            size_t  bound = cycle_count + 1;
+            for ( ListDigraph::OutArcIt arc(graph, node[gates[i]]); arc != INVALID; ++arc )
+            {
+                ListDigraph::Node   succNode = graph.target(arc);
+                bound = std::min(bound, is_group(succNode) ? *group_succ_cycles[group_index[succNode]].begin() : instruction[succNode]->cycle);
+            }
+            size_t  duration = size_t(std::ceil(static_cast<float>(gates[i]->duration)/cycle_time));
+            return bound >= duration ? bound - duration : 0;
+        };
+
+        // the candidates, ordered as the published algorithm would find them; the cycle is negated to get the highest first
+        typedef std::tuple<long, size_t, size_t> candidate_t;     // (-cycle, remaining, index)
+        std::set<candidate_t>       candidates;
+        std::vector<bool>           is_candidate(gates.size(), false);
+        std::vector<std::vector<size_t>> gates_by_latest(cycle_count + 1);
+        auto consider = [&](size_t i, size_t curr_cycle)
+        {
+            if (is_candidate[i] || gates[i]->cycle >= curr_cycle)
+            {
+                return;
+            }
+            size_t  l = latest(i);
+            if (l >= curr_cycle)
+            {
+                candidates.insert(candidate_t(-long(gates[i]->cycle), remaining[node[gates[i]]], i));
+                is_candidate[i] = true;
+            }
+            else if (l >= 1)
+            {
+                gates_by_latest[l].push_back(i);   // consider again when the current cycle has come down to it
+            }
+        };
+        for (size_t i = 0; i < gates.size(); i++)
+        {
+            size_t  l = latest(i);
+            if (l >= 1)
+            {
+                gates_by_latest[std::min(l, cycle_count)].push_back(i);
+            }
+        }
 
-            long pred_cycle = curr_cycle - 1;    // signed because can become negative
+        // in a backward scan, make non-empty bundles max avg_gates_per_non_empty_cycle long,
+        // i.e. the number of gates still to go divided by the number of non-empty bundles to go;
+        // the target is readjusted during the scan to cater for dips in bundle size caused by local dependence chains
+        for (size_t curr_cycle = cycle_count; curr_cycle >= 1; curr_cycle--)
+        {
+            for (auto i : gates_by_latest[curr_cycle])
+            {
+                consider(i, curr_cycle);
+            }
+            while (!candidates.empty() && size_t(-std::get<0>(*candidates.begin())) >= curr_cycle)
+            {
+                is_candidate[std::get<2>(*candidates.begin())] = false;
+                candidates.erase(candidates.begin());
+            }
 
-            // target size of each bundle is number of gates still to go divided by number of non-empty cycles to go
-            // it averages over non-empty bundles instead of all bundles because the latter would be very strict
-            // it is readjusted during the scan to cater for dips in bundle size caused by local dependence chains
             if (non_empty_bundle_count == 0) break;     // nothing to do
             avg_gates_per_cycle = double(gate_count)/curr_cycle;
             avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
-            DOUT("Cycle=" << curr_cycle << " number of gates=" << gates_per_cycle[curr_cycle].size()
+            DOUT("Cycle=" << curr_cycle << " number of gates=" << bundle_size[curr_cycle]
                 << "; avg_gates_per_cycle=" << avg_gates_per_cycle
                 << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle);
 
-            while ( double(gates_per_cycle[curr_cycle].size()) < avg_gates_per_non_empty_cycle && pred_cycle >= 1 )
+            while ( double(bundle_size[curr_cycle]) < avg_gates_per_non_empty_cycle && !candidates.empty() )
             {
-                DOUT("pred_cycle=" << pred_cycle);
-                DOUT("gates_per_cycle[curr_cycle].size()=" << gates_per_cycle[curr_cycle].size());
-                size_t      min_remaining_cycle = MAX_CYCLE;
-                ql::gate*   best_predgp;
-                bool        best_predgp_found = false;
+                size_t      i = std::get<2>(*candidates.begin());
+                ql::gate*   gp = gates[i];
+                candidates.erase(candidates.begin());
+                is_candidate[i] = false;
+
+                // move gp from its cycle to curr_cycle, adjusting the bookkeeping
+                size_t  pred_cycle = gp->cycle;
+                bundle_size[pred_cycle]--;
+                if (bundle_size[pred_cycle] == 0)
+                {
+                    non_empty_bundle_count--;
+                }
+                if (bundle_size[curr_cycle] == 0)
+                {
+                    non_empty_bundle_count++;
+                }
+                gp->cycle = curr_cycle;
+                bundle_size[curr_cycle]++;
 
-                // scan bundle at pred_cycle to find suitable candidate to move forward to curr_cycle
-                for ( auto predgp : gates_per_cycle[pred_cycle] )
+                // its predecessors may now be moved to a later cycle, also those before a GROUP node
+                // when the GROUP node's minimum successor cycle increased by this
+                for ( ListDigraph::InArcIt arc(graph, node[gp]); arc != INVALID; ++arc )
                 {
-                    bool    forward_predgp = true;
-                    size_t  predgp_completion_cycle;
-                    ListDigraph::Node   pred_node = node[predgp];
-                    DOUT("... considering: " << predgp->qasm() << " @cycle=" << predgp->cycle << " remaining=" << remaining[pred_node]);
-
-                    // candidate's result, when moved, must be ready before end-of-circuit and before used
-                    predgp_completion_cycle = curr_cycle + size_t(std::ceil(static_cast<float>(predgp->duration)/cycle_time));
-                    // predgp_completion_cycle = curr_cycle + (predgp->duration+cycle_time-1)/cycle_time;
-                    if (predgp_completion_cycle > cycle_count + 1)  // at SINK is ok, later not
+                    ListDigraph::Node   pred_node = graph.source(arc);
+                    if (is_group(pred_node))
                     {
-                        forward_predgp = false;
-                        DOUT("... ... rejected (after circuit): " << predgp->qasm() << " would complete @" << predgp_completion_cycle << " SINK @" << cycle_count+1);
-                    }
-                    else
-                    {
-                        for ( ListDigraph::OutArcIt arc(graph,pred_node); arc != INVALID; ++arc )
+                        std::multiset<size_t>& succ_cycles = group_succ_cycles[group_index[pred_node]];
+                        size_t  old_min = *succ_cycles.begin();
+                        succ_cycles.erase(succ_cycles.find(pred_cycle));
+                        succ_cycles.insert(curr_cycle);
+                        if (*succ_cycles.begin() == old_min)
                         {
-                            ql::gate*   target_gp = instruction[graph.target(arc)];
-                            size_t target_cycle = target_gp->cycle;
-                            if(predgp_completion_cycle > target_cycle)
-                            {
-                                forward_predgp = false;
-                                DOUT("... ... rejected (after succ): " << predgp->qasm() << " would complete @" << predgp_completion_cycle << " target=" << target_gp->qasm() << " target_cycle=" << target_cycle);
-                            }
+                            continue;
+                        }
+                        for ( ListDigraph::InArcIt group_arc(graph, pred_node); group_arc != INVALID; ++group_arc )
+                        {
+                            consider(index[graph.source(group_arc)], curr_cycle);
                         }
                     }
-
-                    // when multiple nodes in bundle qualify, take the one with lowest remaining
-                    // because that is the most critical one and thus deserves a cycle as high as possible (ALAP)
-                    if (forward_predgp && remaining[pred_node] < min_remaining_cycle)
+                    else if (pred_node != s)
                     {
-                        min_remaining_cycle = remaining[pred_node];
-                        best_predgp_found = true;
-                        best_predgp = predgp;
+                        consider(index[pred_node], curr_cycle);
                     }
                 }
 
-                // when candidate was found in this bundle, move it, and search for more in this bundle, if needed
-                // otherwise, continue scanning backward
-                if (best_predgp_found)
-                {
-                    // move predgp from pred_cycle to curr_cycle;
-                    // adjust all bookkeeping that is affected by this
-                    gates_per_cycle[pred_cycle].remove(best_predgp);
-                    if (gates_per_cycle[pred_cycle].size() == 0)
-                    {
-                        // source bundle was non-empty, now it is empty
-                        non_empty_bundle_count--;
-                    }
-                    if (gates_per_cycle[curr_cycle].size() == 0)
-                    {
-                        // target bundle was empty, now it will be non_empty
-                        non_empty_bundle_count++;
-                    }
-                    best_predgp->cycle = curr_cycle;        // what it is all about
-                    gates_per_cycle[curr_cycle].push_back(best_predgp);
-
-                    // recompute targets
-                    if (non_empty_bundle_count == 0) break;     // nothing to do
-                    avg_gates_per_cycle = double(gate_count)/curr_cycle;
-                    avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
-                    DOUT("... moved " << best_predgp->qasm() << " with remaining=" << remaining[node[best_predgp]]
-                        << " from cycle=" << pred_cycle << " to cycle=" << curr_cycle
-                        << "; new avg_gates_per_cycle=" << avg_gates_per_cycle
-                        << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
-                        );
-                }
-                else
-                {
-                    pred_cycle --;
-                }
-            }   // end for finding a bundle to forward a node from to the current cycle
+                // recompute targets
+                if (non_empty_bundle_count == 0) break;     // nothing to do
+                avg_gates_per_cycle = double(gate_count)/curr_cycle;
+                avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
+                DOUT("... moved " << gp->qasm() << " with remaining=" << remaining[node[gp]]
+                    << " from cycle=" << pred_cycle << " to cycle=" << curr_cycle
+                    << "; new avg_gates_per_cycle=" << avg_gates_per_cycle
+                    << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
+                    );
+            }
 
-            // curr_cycle ready, recompute counts for remaining cycles
-            // mask current cycle and its gates from the target counts:
-            // - gate_count, non_empty_bundle_count, curr_cycle (as cycles still to go)
-            gate_count -= gates_per_cycle[curr_cycle].size();
-            if (gates_per_cycle[curr_cycle].size() != 0)
+            // curr_cycle ready, mask it and its gates from the target counts
+            gate_count -= bundle_size[curr_cycle];
+            if (bundle_size[curr_cycle] != 0)
             {
-                // bundle is non-empty
                 non_empty_bundle_count--;
             }
-        }   // end curr_cycle loop; curr_cycle is bundle which must be enlarged when too small
+        }
 
         // new cycle values computed; reflect this in circuit's gate order
         sort_by_cycle(circp);
-        // FIXME HvS cycles_valid now
 
-        // recompute and print statistics reporting on uniform scheduling performance
         max_gates_per_cycle = 0;
         non_empty_bundle_count = 0;
-        gate_count = 0;
-        // cycle_count was not changed
         for (size_t curr_cycle = 1; curr_cycle <= cycle_count; curr_cycle++)
         {
-            max_gates_per_cycle = std::max(max_gates_per_cycle, gates_per_cycle[curr_cycle].size());
-            if (int(gates_per_cycle[curr_cycle].size()) != 0) non_empty_bundle_count++;
-            gate_count += gates_per_cycle[curr_cycle].size();
+            max_gates_per_cycle = std::max(max_gates_per_cycle, bundle_size[curr_cycle]);
+            if (bundle_size[curr_cycle] != 0) non_empty_bundle_count++;
         }
-        avg_gates_per_cycle = double(gate_count)/cycle_count;
-        avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
         DOUT("... after uniform scheduling:"
             << " cycle_count=" << cycle_count
-            << "; gate_count=" << gate_count
+            << "; gate_count=" << gates.size()
             << "; non_empty_bundle_count=" << non_empty_bundle_count
-            );
-        DOUT("... and max_gates_per_cycle=" << max_gates_per_cycle
-            << "; avg_gates_per_cycle=" << avg_gates_per_cycle
-            << "; ..._per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
+            << "; max_gates_per_cycle=" << max_gates_per_cycle
             );
 
         DOUT("Scheduling ALAP UNIFORM [DONE]");
@@ -1746,6 +2528,7 @@ static void schedule_kernel(quantum_kernel& kernel, quantum_platform platform,
     std::string scheduler_uniform = ql::options::get("scheduler_uniform");
 
     IOUT( scheduler << " scheduling the quantum kernel '" << kernel.name << "'...");
+    QL_TRACE_SPAN("kernel", "schedule", kernel.name);
 
     Scheduler sched;
     sched.init(kernel.c, platform, kernel.qubit_count, kernel.creg_count);
@@ -1817,25 +2600,33 @@ static void rcschedule_kernel(ql::quantum_kernel& kernel,
     IOUT("Resource constraint scheduling ...");
 
     std::string schedopt = ql::options::get("scheduler");
-    if ("ASAP" == schedopt)
+    if ("ASAP" != schedopt && "ALAP" != schedopt)
     {
-        Scheduler sched;
-        sched.init(kernel.c, platform, nqubits, ncreg);
+        FATAL("Not supported scheduler option: scheduler=" << schedopt);
+    }
+    ql::scheduling_direction_t dir = ("ASAP" == schedopt ? forward_scheduling : backward_scheduling);
+
+    Scheduler sched;
+    sched.init(kernel.c, platform, nqubits, ncreg);
 
+    if ("no" != ql::options::get("scheduler_portfolio"))
+    {
+        sched.schedule_portfolio(dir, platform, dot);
+    }
+    else if (forward_scheduling == dir)
+    {
         ql::arch::resource_manager_t rm(platform, forward_scheduling);
         sched.schedule_asap(rm, platform, dot);
     }
-    else if ("ALAP" == schedopt)
+    else
     {
-        Scheduler sched;
-        sched.init(kernel.c, platform, nqubits, ncreg);
-
         ql::arch::resource_manager_t rm(platform, backward_scheduling);
         sched.schedule_alap(rm, platform, dot);
     }
-    else
+
+    if ("yes" == ql::options::get("scheduler_exact"))
     {
-        FATAL("Not supported scheduler option: scheduler=" << schedopt);
+        sched.schedule_exact(dir, platform, dot);
     }
 
     IOUT("Resource constraint scheduling [Done].");
@@ -1854,6 +2645,7 @@ static void rcschedule(ql::quantum_program* programp, const ql::quantum_platform
         IOUT("Scheduling kernel: " << kernel.name);
         if (! kernel.c.empty())
         {
+            QL_TRACE_SPAN("kernel", "rcschedule", kernel.name);
             auto num_creg = kernel.creg_count;
             std::string     sched_dot;
 
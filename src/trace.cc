@@ -0,0 +1,230 @@
+/**
+ * @file   trace.cc
+ * @date   10/2020
+ * @brief  low-overhead structured tracing, exported as chrome trace events
+ */
+
+#include <trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace ql
+{
+namespace trace
+{
+    std::atomic<bool> active(false);
+
+    // event as stored in the ring buffers
+    struct event_t
+    {
+        const char *category;
+        const char *name;
+        char        phase;          // 'X': complete span, 'C': counter
+        uint64_t    ts;             // ns since the epoch
+        uint64_t    dur;            // ns, only for spans
+        int64_t     value;          // counter value or span integer argument; -1 for no argument
+        char        arg[48];        // span string argument
+    };
+
+    // ring buffer of events of a single thread, growing until it holds capacity events;
+    // only its owner thread writes, others may only read after that thread stopped tracing;
+    // when the owner thread exits, the buffer is retired and taken over by the next thread that starts tracing,
+    // so the number of buffers is the maximum number of threads that traced at the same time
+    class ring_buffer_t
+    {
+    public:
+        ring_buffer_t(size_t capacity, size_t tid) : capacity(capacity), head(0), tid(tid), retired(false) {}
+
+        void push(const event_t &e)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (events.size() < capacity)
+            {
+                events.push_back(e);                // NB: then h == events.size()
+            }
+            else
+            {
+                events[h % capacity] = e;
+            }
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        std::vector<event_t>    events;
+        size_t                  capacity;
+        std::atomic<size_t>     head;       // number of events pushed since last clear
+        size_t                  tid;
+        bool                    retired;    // its owner thread exited; protected by registry_mutex
+    };
+
+    static size_t buffer_capacity = 1 << 16;
+    static std::mutex registry_mutex;       // protects buffers, their retired flags and buffer_capacity
+    static std::vector<std::unique_ptr<ring_buffer_t>> buffers;
+    static thread_local ring_buffer_t *local_buffer = nullptr;
+    static std::mutex intern_mutex;         // protects interned
+    static std::set<std::string> interned;
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    // retires the buffer of its thread when that exits
+    class buffer_owner_t
+    {
+    public:
+        ~buffer_owner_t()
+        {
+            if (local_buffer)
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex);
+                local_buffer->retired = true;
+            }
+        }
+    };
+    static thread_local buffer_owner_t buffer_owner;
+
+    static ring_buffer_t *get_local_buffer()
+    {
+        if (!local_buffer)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            for (auto &b : buffers)
+            {
+                if (b->retired)
+                {
+                    b->retired = false;
+                    local_buffer = b.get();
+                    break;
+                }
+            }
+            if (!local_buffer)
+            {
+                buffers.emplace_back(new ring_buffer_t(buffer_capacity, buffers.size()));
+                local_buffer = buffers.back().get();
+            }
+            (void)&buffer_owner;                    // NB: constructs it, so that it is destroyed at thread exit
+        }
+        return local_buffer;
+    }
+
+    void enable(bool on)
+    {
+        active.store(on, std::memory_order_relaxed);
+    }
+
+    void set_buffer_capacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffer_capacity = std::max(capacity, (size_t)1);
+    }
+
+    const char *intern(const std::string &s)
+    {
+        std::lock_guard<std::mutex> lock(intern_mutex);
+        return interned.insert(s).first->c_str();
+    }
+
+    uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void record_span(const char *category, const char *name, uint64_t start, uint64_t end,
+                     int64_t value, const char *arg)
+    {
+        event_t e;
+        e.category = category;
+        e.name = name;
+        e.phase = 'X';
+        e.ts = start;
+        e.dur = end - start;
+        e.value = value;
+        std::strncpy(e.arg, arg, sizeof(e.arg)-1);
+        e.arg[sizeof(e.arg)-1] = '\0';
+        get_local_buffer()->push(e);
+    }
+
+    void record_counter(const char *category, const char *name, int64_t value)
+    {
+        event_t e;
+        e.category = category;
+        e.name = name;
+        e.phase = 'C';
+        e.ts = now();
+        e.dur = 0;
+        e.value = value;
+        e.arg[0] = '\0';
+        get_local_buffer()->push(e);
+    }
+
+    std::string to_chrome_json()
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+
+        json events = json::array();
+        size_t dropped = 0;
+        for (auto &b : buffers)
+        {
+            size_t head = b->head.load(std::memory_order_acquire);
+            size_t size = b->capacity;
+            size_t first = head > size ? head - size : 0;
+            dropped += first;
+
+            json meta;
+            meta["ph"] = "M";
+            meta["name"] = "thread_name";
+            meta["pid"] = 1;
+            meta["tid"] = b->tid;
+            meta["args"]["name"] = b->tid == 0 ? std::string("main") : "thread " + std::to_string(b->tid);
+            events.push_back(meta);
+
+            for (size_t i = first; i < head; i++)
+            {
+                const event_t &e = b->events[i % size];
+                json j;
+                j["cat"] = e.category;
+                j["name"] = e.name;
+                j["ph"] = std::string(1, e.phase);
+                j["ts"] = e.ts / 1000.0;            // chrome trace timestamps are in us
+                j["pid"] = 1;
+                j["tid"] = b->tid;
+                if (e.phase == 'X')
+                {
+                    j["dur"] = e.dur / 1000.0;
+                    if (e.value >= 0) j["args"]["value"] = e.value;
+                    if (e.arg[0] != '\0') j["args"]["arg"] = std::string(e.arg);
+                }
+                else
+                {
+                    j["args"][e.name] = e.value;
+                }
+                events.push_back(j);
+            }
+        }
+
+        json trace;
+        trace["traceEvents"] = events;
+        trace["displayTimeUnit"] = "ns";
+        trace["otherData"]["dropped_events"] = dropped;
+        return trace.dump();
+    }
+
+    void write_file(const std::string &file_name)
+    {
+        ql::utils::write_file(file_name, to_chrome_json());
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (auto &b : buffers)
+        {
+            b->head.store(0, std::memory_order_release);
+            std::vector<event_t>().swap(b->events);
+        }
+    }
+
+} // trace namespace
+} // ql namespace
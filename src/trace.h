@@ -0,0 +1,147 @@
+/**
+ * @file   trace.h
+ * @date   10/2020
+ * @brief  low-overhead structured tracing, exported as chrome trace events
+ */
+
+#ifndef QL_TRACE_H
+#define QL_TRACE_H
+
+#include <utils.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*
+    Summary
+
+    Tracing records what the compiler is doing over time, without the cost of formatting log messages.
+    Two kinds of events are recorded:
+    - spans: a named interval of time, e.g. the execution of a pass, the scheduling of a kernel,
+        a recursion level of the mapper; they are created by constructing a ql::trace::span object
+        (usually through the QL_TRACE_SPAN macro) and end when it goes out of scope
+    - counters: a named value at some point in time, e.g. the number of alternatives the mapper considers;
+        they are recorded by calling ql::trace::counter
+    Each event has a category (e.g. "pass", "kernel", "mapper", "scheduler", "backend") and a name;
+    these must be string literals or interned (see ql::trace::intern) since only the pointers are stored.
+    Spans can have an argument, an integer or a short string (e.g. the kernel name, truncated when too long).
+
+    Events are written to a per-thread ring buffer, which is only written by the thread that owns it,
+    so recording doesn't lock; when the buffer is full the oldest events are overwritten.
+    Only the first use of tracing by a thread takes a lock, to register its buffer.
+    When tracing is disabled, a span or counter only costs a test of a flag.
+
+    Tracing is enabled by option write_trace_files; the events are written at the end of compilation
+    to <output_dir>/<unique_name>_trace.json in chrome trace event format, which can be loaded
+    in chrome://tracing and in Perfetto (ui.perfetto.dev).
+    Writing the trace should be done when no other threads are tracing.
+*/
+
+namespace ql
+{
+namespace trace
+{
+    OPENQL_DECLSPEC extern std::atomic<bool> active;
+
+    // whether events are recorded
+    inline bool is_enabled()
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // start/stop recording events; recorded events are kept until clear
+    void enable(bool on);
+
+    // capacity in events of each per-thread ring buffer; only affects buffers created after the call
+    void set_buffer_capacity(size_t capacity);
+
+    // a pointer to a copy of the given string that stays valid as long as the process lives;
+    // for using run-time names (e.g. of passes) as span names
+    const char *intern(const std::string &s);
+
+    // time in ns since the start of tracing
+    uint64_t now();
+
+    // record a completed span and a counter, respectively; call these only when is_enabled()
+    void record_span(const char *category, const char *name, uint64_t start, uint64_t end,
+                     int64_t value, const char *arg);
+    void record_counter(const char *category, const char *name, int64_t value);
+
+    // record the current value of a counter
+    inline void counter(const char *category, const char *name, int64_t value)
+    {
+        if (is_enabled())
+        {
+            record_counter(category, name, value);
+        }
+    }
+
+    // span from construction until destruction, recorded only when tracing was enabled at construction
+    class span
+    {
+    public:
+        span(const char *category, const char *name)
+            : category(category), name(name), value(-1), recording(is_enabled()), start(0)
+        {
+            arg[0] = '\0';
+            if (recording) start = now();
+        }
+
+        span(const char *category, const char *name, int64_t value)
+            : category(category), name(name), value(value), recording(is_enabled()), start(0)
+        {
+            arg[0] = '\0';
+            if (recording) start = now();
+        }
+
+        span(const char *category, const char *name, const std::string &s)
+            : category(category), name(name), value(-1), recording(is_enabled()), start(0)
+        {
+            arg[0] = '\0';
+            if (recording)
+            {
+                s.copy(arg, sizeof(arg)-1);
+                arg[std::min(s.size(), sizeof(arg)-1)] = '\0';
+                start = now();
+            }
+        }
+
+        ~span()
+        {
+            if (recording)
+            {
+                record_span(category, name, start, now(), value, arg);
+            }
+        }
+
+        span(const span &) = delete;
+        span &operator=(const span &) = delete;
+
+    private:
+        const char *category;
+        const char *name;
+        int64_t     value;
+        bool        recording;
+        uint64_t    start;
+        char        arg[48];
+    };
+
+    // the recorded events of all threads in chrome trace event json format
+    std::string to_chrome_json();
+
+    // write the recorded events in chrome trace event json format to the given file
+    void write_file(const std::string &file_name);
+
+    // forget the recorded events
+    void clear();
+
+} // trace namespace
+} // ql namespace
+
+// span covering the rest of the enclosing scope
+#define QL_TRACE_CONCAT_(a, b) a##b
+#define QL_TRACE_CONCAT(a, b) QL_TRACE_CONCAT_(a, b)
+#define QL_TRACE_SPAN(...) ql::trace::span QL_TRACE_CONCAT(ql_trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif // QL_TRACE_H
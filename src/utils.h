@@ -37,7 +37,7 @@ using json = nlohmann::json;
 
 #define println(x) std::cout << "[OPENQL] "<< x << std::endl
 
-static size_t MAX_CYCLE = std::numeric_limits<int>::max();
+constexpr size_t MAX_CYCLE = std::numeric_limits<int>::max();
 
 #if defined(_WIN32)
 #include <direct.h>
@@ -203,6 +203,13 @@ namespace ql
                 return false;
         }
 
+        // The most verbose log level that is compiled in: DOUT and IOUT of levels beyond it are compiled away,
+        // so that they don't cost a run-time test in hot loops. Set by the CMake option of the same name;
+        // all levels are compiled in by default. Levels below it are still selected at run-time by option log_level.
+#ifndef OPENQL_MIN_LOG_LEVEL
+#define OPENQL_MIN_LOG_LEVEL LOG_DEBUG
+#endif
+
         namespace logger
         {
             enum log_level_t
@@ -232,6 +239,10 @@ namespace ql
                     ql::utils::logger::LOG_LEVEL = ql::utils::logger::log_level_t::LOG_DEBUG;
                 else
                     std::cerr << "[OPENQL] " << __FILE__ <<":"<< __LINE__ <<" Error: Unknown log level" << std::endl;
+
+                if (ql::utils::logger::LOG_LEVEL > ql::utils::logger::log_level_t::OPENQL_MIN_LOG_LEVEL)
+                    std::cerr << "[OPENQL] " << __FILE__ <<":"<< __LINE__ <<" Warning: log level " << level
+                              << " is more verbose than the level this build was compiled with" << std::endl;
             }
 
         } // logger namespace
@@ -249,11 +260,13 @@ namespace ql
         std::cerr << "[OPENQL] " << __FILE__ <<":"<< __LINE__ <<" Warning: "<< content << std::endl
 
 #define IOUT(content) \
-    if ( ql::utils::logger::LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_INFO ) \
+    if ( ql::utils::logger::log_level_t::OPENQL_MIN_LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_INFO \
+        && ql::utils::logger::LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_INFO ) \
         std::cout << "[OPENQL] " << __FILE__ <<":"<< __LINE__ <<" Info: "<< content << std::endl
 
 #define DOUT(content) \
-    if ( ql::utils::logger::LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_DEBUG ) \
+    if ( ql::utils::logger::log_level_t::OPENQL_MIN_LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_DEBUG \
+        && ql::utils::logger::LOG_LEVEL >= ql::utils::logger::log_level_t::LOG_DEBUG ) \
         std::cout << "[OPENQL] " << __FILE__ <<":"<< __LINE__ <<" "<< content << std::endl
 
 #define COUT(content) \
@@ -0,0 +1,108 @@
+/*
+    file:       test_cc_benchmark.cc
+    notes:      benchmark of the CC backend's code generation on large programs:
+                random layers of single-qubit, cz and measure gates on the 17 qubits of test_cfg_cc.json,
+                separated by waits so that no bundle has conflicting signals;
+                shows the time taken by compiling programs of increasing size, with kernels generated sequentially
+                and concurrently (option backend_cc_parallel_kernels), and checks that both generate the same files
+*/
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include <openql.h>
+#include <utils.h>
+
+#define CFG_FILE_JSON   "test_cfg_cc.json"
+
+static void random_layers(ql::quantum_kernel &k, std::mt19937 &rng, size_t num_qubits, size_t layers)
+{
+    static const char* mw_gates[5] = { "rx180", "ry180", "rx90", "ry90", "rym90" };
+    std::vector<size_t> all(num_qubits);
+    for (size_t q=0; q<num_qubits; q++) {
+        all[q] = q;
+    }
+
+    for (size_t l=0; l<layers; l++) {
+        std::vector<size_t> qubits = all;
+        std::shuffle(qubits.begin(), qubits.end(), rng);
+        size_t n = 1 + rng()%num_qubits;
+        size_t kind = rng()%7;
+        if (kind < 5) {
+            for (size_t i=0; i<n; i++) {
+                k.gate(mw_gates[kind], qubits[i]);
+            }
+        } else if (kind == 5) {
+            for (size_t i=0; i+1<n; i+=2) {
+                k.gate("cz", qubits[i], qubits[i+1]);
+            }
+        } else {
+            for (size_t i=0; i<n; i++) {
+                k.gate("measure", std::vector<size_t> {qubits[i]}, std::vector<size_t> {});
+            }
+        }
+        k.wait(all, 0);      // help scheduler
+    }
+}
+
+static std::string read_file(const std::string &file_name)
+{
+    std::ifstream file(file_name);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static double compile_program(size_t kernels, size_t layers, const std::string &parallel, std::string &output)
+{
+    const size_t num_qubits = 17;
+    const size_t num_cregs = 3;
+
+    ql::options::set("backend_cc_parallel_kernels", parallel);
+    ql::quantum_platform s17("s17", CFG_FILE_JSON);
+    std::string name = "test_cc_benchmark_" + std::to_string(kernels) + "x" + std::to_string(layers);
+    ql::quantum_program prog(name, s17, num_qubits, num_cregs);
+    std::mt19937 rng(kernels * layers);
+    for (size_t i=0; i<kernels; i++) {
+        ql::quantum_kernel k("kernel" + std::to_string(i), s17, num_qubits, num_cregs);
+        random_layers(k, rng, num_qubits, layers);
+        prog.add(k);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    prog.compile();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    output = read_file("test_output/" + name + ".vq1asm") + read_file("test_output/" + name + ".vcd");
+    return seconds;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::utils::logger::set_log_level("LOG_WARNING");
+    ql::options::set("output_dir", "test_output");      // creates it: the output is read back below
+    ql::options::set("scheduler", "ALAP");
+    ql::options::set("scheduler_uniform", "no");
+
+    std::cout << std::setw(10) << "kernels" << std::setw(10) << "layers"
+              << std::setw(12) << "sequential" << std::setw(12) << "parallel" << std::endl;
+    bool ok = true;
+    std::vector<std::pair<size_t, size_t>> sizes = { {4, 100}, {4, 400}, {4, 1600}, {64, 100} };
+    for (auto &size : sizes) {
+        std::string sequential_output, parallel_output;
+        double sequential = compile_program(size.first, size.second, "no", sequential_output);
+        double parallel = compile_program(size.first, size.second, "yes", parallel_output);
+        bool same = (parallel_output == sequential_output);
+        std::cout << std::setw(10) << size.first << std::setw(10) << size.second
+                  << std::setw(12) << std::fixed << std::setprecision(3) << sequential
+                  << std::setw(12) << parallel << (same ? "" : "  FAIL: output differs") << std::endl;
+        ok = ok && same;
+    }
+    ql::options::set("backend_cc_parallel_kernels", "no");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+    file:       test_cc_loop.cc
+    notes:      test of loop compression in the CC backend (option backend_cc_loop_compression):
+                compiles a program with repeated rounds of X stabilizer measurements with and without compression,
+                and checks by interpreting both .vq1asm files that every slot outputs the same code words with the same
+                timing, while the compressed program has fewer instructions
+*/
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <openql.h>
+#include <utils.h>
+
+#define CFG_FILE_JSON   "test_cfg_cc.json"
+
+typedef std::map<int, std::vector<std::string>> timeline_t;     // per slot: the seq_out operands in order of execution
+
+// interpret the instructions of a .vq1asm file that matter for output timing: seq_out, move, loop and jmp (ending the program)
+static bool interpret(const std::string &file_name, timeline_t &timeline, size_t &nr_instructions)
+{
+    std::ifstream file(file_name);
+    if (!file) {
+        std::cout << "cannot open " << file_name << std::endl;
+        return false;
+    }
+
+    // parse into lines of tokens, without comments and labels
+    std::vector<std::vector<std::string>> lines;
+    std::map<std::string, size_t> labels;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream iss(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (iss >> token) {
+            if (token.back() == ':') {
+                labels[token.substr(0, token.size()-1)] = lines.size();
+            } else {
+                tokens.push_back(token);
+            }
+        }
+        if (!tokens.empty()) {
+            lines.push_back(tokens);
+        }
+    }
+    nr_instructions = lines.size();
+
+    std::map<std::string, long> regs;
+    for (size_t pc=0; pc<lines.size(); pc++) {
+        const std::vector<std::string> &tokens = lines[pc];
+        int slot = -1;
+        size_t t = 0;
+        if (tokens[0][0] == '[') {
+            slot = std::stoi(tokens[0].substr(1));
+            t++;
+        }
+        const std::string &instr = tokens[t];
+        std::string operands = tokens.size() > t+1 ? tokens[t+1] : "";
+        size_t comma = operands.find(',');
+        if (instr == "seq_out") {
+            timeline[slot].push_back(operands);
+        } else if (instr == "move") {
+            regs[operands.substr(comma+1)] = std::stol(operands.substr(0, comma));
+        } else if (instr == "loop") {
+            std::string reg = operands.substr(0, comma);
+            if (--regs[reg] > 0) {
+                pc = labels.at(operands.substr(comma+2)) - 1;               // NB: skip '@'
+            }
+        } else if (instr == "jmp") {
+            break;                                                          // loop indefinitely
+        }
+    }
+    return true;
+}
+
+static size_t compile_program(const std::string &compression)
+{
+    const int num_qubits = 17;
+    const int num_cregs = 3;
+    const int rounds = 25;
+    std::vector<size_t> all = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16};
+
+    ql::options::set("backend_cc_loop_compression", compression);
+    ql::quantum_platform s17("s17", CFG_FILE_JSON);
+    ql::quantum_program prog("test_cc_loop_" + compression, s17, num_qubits, num_cregs);
+
+    // X stabilizer as in test_qec_pipelined of test_cc.cc, measured repeatedly
+    const size_t x = 7;
+    std::vector<size_t> data = {x-5, x+1, x+5, x-1};
+    ql::quantum_kernel k("rounds", s17, num_qubits, num_cregs);
+    for (size_t q=6; q<17; q++) {
+        k.gate("x", q);
+    }
+    k.wait(all, 0);
+    for (int r=0; r<rounds; r++) {
+        k.gate("rym90", x);
+        for (auto q : data) k.gate("rym90", q);
+        k.wait(all, 0);
+        for (auto q : data) k.gate("cz", x, q);
+        k.wait(all, 0);
+        k.gate("ry90", x);
+        for (auto q : data) k.gate("ry90", q);
+        k.wait(all, 0);
+        k.gate("measure", std::vector<size_t> {x}, std::vector<size_t> {});
+        k.wait(all, 0);
+    }
+    prog.add(k);
+
+    // a kernel without repetitions
+    ql::quantum_kernel k2("single", s17, num_qubits, num_cregs);
+    k2.gate("rx180", 6);
+    k2.gate("cz", 6, 7);
+    k2.gate("measure", std::vector<size_t> {6}, std::vector<size_t> {});
+    prog.add(k2);
+
+    prog.compile();
+    return rounds;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::utils::logger::set_log_level("LOG_WARNING");
+    ql::options::set("output_dir", "test_output");      // creates it: the output is read back below
+    ql::options::set("scheduler", "ALAP");
+    ql::options::set("scheduler_uniform", "no");
+
+    compile_program("no");
+    compile_program("yes");
+    ql::options::set("backend_cc_loop_compression", "no");
+
+    timeline_t plain, compressed;
+    size_t plain_instructions = 0, compressed_instructions = 0;
+    bool ok = interpret("test_output/test_cc_loop_no.vq1asm", plain, plain_instructions)
+           && interpret("test_output/test_cc_loop_yes.vq1asm", compressed, compressed_instructions);
+
+    ok = ok && plain == compressed && compressed_instructions < plain_instructions;
+    for (auto &slot : plain) {
+        std::cout << "slot " << slot.first << ": " << slot.second.size() << " seq_out" << std::endl;
+    }
+    std::cout << "instructions: " << plain_instructions << " without, " << compressed_instructions << " with loop compression, "
+              << (ok ? "equivalent" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
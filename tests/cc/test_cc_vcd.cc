@@ -0,0 +1,155 @@
+/*
+    file:       test_cc_vcd.cc
+    notes:      test of the selection of what the CC backend records in its Value Change Dump (options backend_cc_vcd_*):
+                compiles a program without selection, with a selection of instruments and qubits, and with a selection
+                of a kernel and a cycle range too, and checks the variables and changes of the VCD files against
+                those of the unselected one
+*/
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <tuple>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <openql.h>
+#include <utils.h>
+
+#define CFG_FILE_JSON   "test_cfg_cc.json"
+
+typedef std::tuple<long, std::string, std::string> change_t;    // timestamp, variable name, value
+
+// read the variable names and changes of a VCD file, and check that its timestamps increase
+static bool read_vcd(const std::string &file_name, std::set<std::string> &names, std::vector<change_t> &changes)
+{
+    std::ifstream file(file_name);
+    if (!file) {
+        std::cout << "cannot open " << file_name << std::endl;
+        return false;
+    }
+
+    std::map<std::string, std::string> ids;                     // id to name
+    long timestamp = -1;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string token;
+        iss >> token;
+        if (token == "$var") {
+            std::string type, width, id, name;
+            iss >> type >> width >> id >> name;
+            ids[id] = name;
+            names.insert(name);
+        } else if (token[0] == '#') {
+            long t = std::stol(token.substr(1));
+            if (t <= timestamp) {
+                std::cout << file_name << ": timestamp " << t << " after " << timestamp << std::endl;
+                return false;
+            }
+            timestamp = t;
+        } else if (token[0] == 's') {
+            std::string id;
+            iss >> id;
+            changes.emplace_back(timestamp, ids.at(id), token.substr(1));
+        }
+    }
+    return true;
+}
+
+static void compile_program(const std::string &name, const std::string &instruments, const std::string &qubits,
+                            const std::string &kernels, const std::string &cycles)
+{
+    const int num_qubits = 17;
+    const int num_cregs = 3;
+    std::vector<size_t> all = {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16};
+
+    ql::options::set("scheduler", "ALAP");
+    ql::options::set("scheduler_uniform", "no");
+    ql::options::set("backend_cc_vcd_instruments", instruments);  // NB: compile() resets options
+    ql::options::set("backend_cc_vcd_qubits", qubits);
+    ql::options::set("backend_cc_vcd_kernels", kernels);
+    ql::options::set("backend_cc_vcd_cycles", cycles);
+    ql::quantum_platform s17("s17", CFG_FILE_JSON);
+    ql::quantum_program prog(name, s17, num_qubits, num_cregs);
+    for (std::string kname : { "first", "second" }) {
+        ql::quantum_kernel k(kname, s17, num_qubits, num_cregs);
+        for (size_t layer=0; layer<12; layer++) {
+            for (size_t q=layer%3; q<17; q+=3) {
+                k.gate(layer%2 ? "rx180" : "ry90", q);
+            }
+            k.wait(all, 0);
+            k.gate("cz", 2, 0);
+            k.gate("cz", 7, 3);
+            k.wait(all, 0);
+            k.gate("measure", std::vector<size_t> {layer%17}, std::vector<size_t> {});
+            k.wait(all, 0);
+        }
+        prog.add(k);
+    }
+    prog.compile();
+}
+
+int main(int argc, char ** argv)
+{
+    ql::utils::logger::set_log_level("LOG_WARNING");
+    ql::options::set("output_dir", "test_output");      // creates it: the output is read back below
+
+    compile_program("test_cc_vcd_all", "", "", "", "");
+    compile_program("test_cc_vcd_signals", "mw_0,flux_0-1", "2,7", "", "");
+    compile_program("test_cc_vcd_cycles", "mw_0,flux_0-1", "2,7", "second", "5-40");
+
+    std::set<std::string> all_names, signals_names, cycles_names;
+    std::vector<change_t> all_changes, signals_changes, cycles_changes;
+    bool ok = read_vcd("test_output/test_cc_vcd_all.vcd", all_names, all_changes)
+           && read_vcd("test_output/test_cc_vcd_signals.vcd", signals_names, signals_changes)
+           && read_vcd("test_output/test_cc_vcd_cycles.vcd", cycles_names, cycles_changes);
+    if (!ok) {
+        return 1;
+    }
+
+    // the selected variables, with exactly the changes they have without selection
+    std::set<std::string> selected_names;
+    std::vector<change_t> selected_changes;
+    for (auto &name : all_names) {
+        if (name == "kernel" || name == "q2" || name == "q7" || name == "mw_0" || name.compare(0, 5, "mw_0-") == 0 || name == "flux_0-1") {
+            selected_names.insert(name);
+        }
+    }
+    for (auto &change : all_changes) {
+        if (selected_names.count(std::get<1>(change))) {
+            selected_changes.push_back(change);
+        }
+    }
+    bool pass = signals_names == selected_names && signals_changes == selected_changes;
+    std::cout << "instruments and qubits: " << signals_names.size() << " of " << all_names.size() << " variables, "
+              << signals_changes.size() << " of " << all_changes.size() << " changes" << (pass ? "" : "  FAIL") << std::endl;
+    ok = ok && pass;
+
+    // a subset of these changes, starting within cycles 5-40 of the second kernel (or being the kernel itself)
+    ql::quantum_platform s17("s17", CFG_FILE_JSON);
+    long second_start = -1;
+    for (auto &change : all_changes) {
+        if (std::get<1>(change) == "kernel" && std::get<2>(change) == "second") {
+            second_start = std::get<0>(change);
+        }
+    }
+    std::set<change_t> selected_set(selected_changes.begin(), selected_changes.end());
+    size_t outside = 0;
+    for (auto &change : cycles_changes) {
+        long t = std::get<0>(change);
+        if (!selected_set.count(change)) {
+            outside++;
+        } else if (std::get<1>(change) != "kernel" && std::get<2>(change) != ""
+                && (t < second_start + 5*(long)s17.cycle_time || t > second_start + 40*(long)s17.cycle_time)) {
+            outside++;
+        }
+    }
+    pass = cycles_names == selected_names && outside == 0 && cycles_changes.size() > 2 && cycles_changes.size() < signals_changes.size();
+    std::cout << "kernel and cycles: " << cycles_changes.size() << " changes, " << outside << " not selected"
+              << (pass ? "" : "  FAIL") << std::endl;
+    ok = ok && pass;
+
+    return ok ? 0 : 1;
+}
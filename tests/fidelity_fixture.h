@@ -0,0 +1,70 @@
+// shared by the fidelity tests: random circuits on all qubits of a kernel,
+// scheduled as soon as their operands are free as the fidelity estimators in metrics.h assume
+
+#ifndef QL_TESTS_FIDELITY_FIXTURE_H
+#define QL_TESTS_FIDELITY_FIXTURE_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <openql.h>
+
+// random gates, two-qubit gates on any pair of qubits; of each 10 gates on average 1 is a prepz,
+// 1 a measure (or with measure false, a single-qubit gate), 3 single-qubit and 5 two-qubit gates;
+// the single-qubit gates are one of gates1 and the two-qubit gates one of gates2, both chosen by the same coin,
+// a two-qubit gate of which both operands are the same qubit becoming a single-qubit gate
+inline void random_circuit(ql::quantum_kernel& k, size_t seed, size_t gate_count,
+    const std::vector<std::string>& gates1, const std::vector<std::string>& gates2, bool measure)
+{
+    size_t nq = k.qubit_count;
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < gate_count; i++)
+    {
+        size_t q0 = rng()%nq;
+        size_t q1 = rng()%nq;
+        size_t kind = rng()%10;
+        if (kind == 0)
+        {
+            k.gate("prepz", q0);
+        }
+        else if (kind == 1 && measure)
+        {
+            k.gate("measure", q0);
+        }
+        else if (kind < 5 || q0 == q1)
+        {
+            k.gate(gates1[kind%2], q0);
+        }
+        else
+        {
+            k.gate(gates2[kind%2], q0, q1);
+        }
+    }
+}
+
+// schedule as soon as the operands are free, with the first cycle at index 1, setting the cycle of the kernel's gates;
+// returns the gates sorted on cycle
+inline ql::circuit schedule_asap(ql::quantum_kernel& k, size_t cycle_time)
+{
+    std::vector<size_t> freecycle(k.qubit_count, 1);
+    for (auto gp : k.c)
+    {
+        size_t cycle = 1;
+        for (auto q : gp->operands)
+        {
+            cycle = std::max(cycle, freecycle[q]);
+        }
+        gp->cycle = cycle;
+        for (auto q : gp->operands)
+        {
+            freecycle[q] = cycle + (gp->duration + cycle_time - 1) / cycle_time;
+        }
+    }
+    ql::circuit circ = k.c;
+    std::stable_sort(circ.begin(), circ.end(), [](ql::gate* gp1, ql::gate* gp2) { return gp1->cycle < gp2->cycle; });
+    return circ;
+}
+
+#endif // QL_TESTS_FIDELITY_FIXTURE_H
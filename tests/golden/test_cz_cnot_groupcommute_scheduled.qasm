@@ -0,0 +1,13 @@
+version 1.0
+# this file has been automatically generated by the OpenQL compiler please do not modify it manually.
+qubits 7
+
+.aKernel
+    { x q[0] | cz q[3],q[1] }
+    x q[0]
+    cz q[0],q[3]
+    wait 1
+    { cnot q[1],q[3] | cnot q[5],q[3] | cnot q[6],q[3] }
+    wait 3
+    cz q[3],q[0]
+    wait 1
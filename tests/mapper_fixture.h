@@ -0,0 +1,138 @@
+// shared by the mapper tests: random circuits on the 17 qubits of test_mapper_s17.json,
+// mapped by Mapper::Map with the options set by the caller, and the checks of the result of mapping any kernel
+
+#ifndef QL_TESTS_MAPPER_FIXTURE_H
+#define QL_TESTS_MAPPER_FIXTURE_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <openql.h>
+#include <mapper.h>
+
+// random gates on 17 virtual qubits, two-qubit gates on any pair of them
+inline void random_circuit(ql::quantum_kernel& k, size_t seed, size_t gate_count)
+{
+    static const char* single_qubit_gates[4] = { "x", "y", "x90", "ym90" };
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < gate_count; i++)
+    {
+        size_t q0 = rng()%17;
+        size_t q1 = rng()%17;
+        if (rng()%3 == 0 || q0 == q1)
+        {
+            k.gate(single_qubit_gates[rng()%4], q0);
+        }
+        else
+        {
+            k.gate("cnot", q0, q1);
+        }
+    }
+}
+
+struct map_result_t
+{
+    size_t  swaps;      // swaps and moves added by the mapper
+    size_t  depth;      // cycles from the start of the first to the end of the last gate
+    double  avgdepth;   // with mapbudget: average lookahead depth achieved
+    int     maxdepth;   // with mapbudget: max lookahead depth achieved
+    bool    adjacent;   // all two-qubit gates operate on nearest neighbors
+    bool    complete;   // the gates of the circuit are all there, next to those of the swaps and moves
+};
+
+// the names of the gates into which the platform decomposes gate name+suffix, or just name when it has no such entry
+inline std::vector<std::string> decomposed(const json& decompositions, const std::string& name, const std::string& suffix)
+{
+    std::vector<std::string> names;
+    for (auto it = decompositions.begin(); it != decompositions.end(); ++it)
+    {
+        std::string key = it.key();
+        if (key.substr(0, key.find(' ')) == name + suffix)
+        {
+            for (auto& sub : it.value())
+            {
+                std::string subname = sub;
+                names.push_back(subname.substr(0, subname.find(' ')));
+            }
+            return names;
+        }
+    }
+    names.push_back(name);
+    return names;
+}
+
+// count in counts the gates into which the mapper turns gate name:
+// the decomposition of its _real entry, of which each gate by the decomposition of its _prim entry
+inline void count_mapped(std::map<std::string,size_t>& counts, const json& decompositions, const std::string& name, size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    for (auto& real : decomposed(decompositions, name, "_real"))
+    {
+        for (auto& prim : decomposed(decompositions, real, "_prim"))
+        {
+            counts[prim] += n;
+        }
+    }
+}
+
+// map the circuit of kernel k by Mapper::Map and check the result;
+// the gates of the circuit must all be there as the platform decomposes them, next to those of the swaps and moves;
+// only prepz gates may be added, to initialize the qubit to which a move moves
+inline map_result_t map_kernel(ql::quantum_platform& platform, Grid& grid, ql::quantum_kernel& k)
+{
+    json decompositions = ql::load_json(platform.configuration_file_name)["gate_decomposition"];
+    std::map<std::string,size_t> count_expected;
+    for (auto gp : k.c)
+    {
+        std::string name = gp->name;
+        count_mapped(count_expected, decompositions, name.substr(0, name.find(' ')), 1);
+    }
+
+    Mapper m;
+    m.Init(&platform);
+    m.Map(k);
+
+    map_result_t result;
+    result.swaps = m.nswapsadded;
+    result.avgdepth = (m.ndecisions ? m.sumdepth / m.ndecisions : 0.0);
+    result.maxdepth = m.maxdepth;
+    result.adjacent = true;
+    std::map<std::string,size_t> count_out;
+    size_t first = MAX_CYCLE;
+    size_t last = 0;
+    for (auto gp : k.c)
+    {
+        std::string name = gp->name;
+        count_out[name.substr(0, name.find(' '))]++;
+        if (gp->operands.size() == 2 && grid.Distance(gp->operands[0], gp->operands[1]) != 1)
+        {
+            result.adjacent = false;
+        }
+        first = std::min(first, gp->cycle);
+        last = std::max(last, gp->cycle + (gp->duration + platform.cycle_time - 1) / platform.cycle_time);
+    }
+    result.depth = (k.c.empty() ? 0 : last - first);
+    count_mapped(count_expected, decompositions, "swap", m.nswapsadded - m.nmovesadded);
+    count_mapped(count_expected, decompositions, "move", m.nmovesadded);
+    result.complete = count_out["prepz"] >= count_expected["prepz"];
+    count_out.erase("prepz");
+    count_expected.erase("prepz");
+    result.complete = result.complete && count_out == count_expected;
+    return result;
+}
+
+// map random_circuit(seed, gate_count) and check the result
+inline map_result_t map_random_circuit(ql::quantum_platform& platform, Grid& grid, size_t seed, size_t gate_count)
+{
+    ql::quantum_kernel k("k", platform, 17, 0);
+    random_circuit(k, seed, gate_count);
+    return map_kernel(platform, grid, k);
+}
+
+#endif // QL_TESTS_MAPPER_FIXTURE_H
@@ -0,0 +1,633 @@
+// shared by the mapper tests: the circuits of real applications that test_mapper.cc maps on test_mapper_s17.json,
+// each to be put in a kernel of the number of qubits that its comment states
+
+#ifndef QL_TESTS_MAPPER_S17_FIXTURE_H
+#define QL_TESTS_MAPPER_S17_FIXTURE_H
+
+#include <openql.h>
+
+// the kernel of daniel that once used a location not in the initial map; moves, ancillas, around 220 gates; 6 qubits
+inline void daniel2_circuit(ql::quantum_kernel& k)
+{
+    k.gate("x",0);
+    k.gate("cnot",4,0);
+    k.gate("h",0);
+    k.gate("t",1);
+    k.gate("t",5);
+    k.gate("t",0);
+    k.gate("cnot",5,1);
+    k.gate("cnot",0,5);
+    k.gate("cnot",1,0);
+    k.gate("tdag",5);
+    k.gate("cnot",1,5);
+    k.gate("tdag",1);
+    k.gate("tdag",5);
+    k.gate("t",0);
+    k.gate("cnot",0,5);
+    k.gate("cnot",1,0);
+    k.gate("cnot",5,1);
+    k.gate("h",0);
+    k.gate("h",5);
+    k.gate("t",4);
+    k.gate("t",2);
+    k.gate("t",5);
+    k.gate("cnot",2,4);
+    k.gate("cnot",5,2);
+    k.gate("cnot",4,5);
+    k.gate("tdag",2);
+    k.gate("cnot",4,2);
+    k.gate("tdag",4);
+    k.gate("tdag",2);
+    k.gate("t",5);
+    k.gate("cnot",5,2);
+    k.gate("cnot",4,5);
+    k.gate("cnot",2,4);
+    k.gate("h",5);
+    k.gate("h",0);
+    k.gate("t",1);
+    k.gate("t",5);
+    k.gate("t",0);
+    k.gate("cnot",5,1);
+    k.gate("cnot",0,5);
+    k.gate("cnot",1,0);
+    k.gate("tdag",5);
+    k.gate("cnot",1,5);
+    k.gate("tdag",1);
+    k.gate("tdag",5);
+    k.gate("t",0);
+    k.gate("cnot",0,5);
+    k.gate("cnot",1,0);
+    k.gate("cnot",5,1);
+    k.gate("h",0);
+    k.gate("h",5);
+    k.gate("t",4);
+    k.gate("t",2);
+    k.gate("t",5);
+    k.gate("cnot",2,4);
+    k.gate("cnot",5,2);
+    k.gate("cnot",4,5);
+    k.gate("tdag",2);
+    k.gate("cnot",4,2);
+    k.gate("tdag",4);
+    k.gate("tdag",2);
+    k.gate("t",5);
+    k.gate("cnot",5,2);
+    k.gate("cnot",4,5);
+    k.gate("cnot",2,4);
+    k.gate("h",5);
+    k.gate("x",4);
+    k.gate("h",5);
+    k.gate("t",4);
+    k.gate("t",3);
+    k.gate("t",5);
+    k.gate("cnot",3,4);
+    k.gate("cnot",5,3);
+    k.gate("cnot",4,5);
+    k.gate("tdag",3);
+    k.gate("cnot",4,3);
+    k.gate("tdag",4);
+    k.gate("tdag",3);
+    k.gate("t",5);
+    k.gate("cnot",5,3);
+    k.gate("cnot",4,5);
+    k.gate("cnot",3,4);
+    k.gate("h",5);
+    k.gate("h",0);
+    k.gate("t",5);
+    k.gate("t",4);
+    k.gate("t",0);
+    k.gate("cnot",4,5);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("tdag",4);
+    k.gate("cnot",5,4);
+    k.gate("tdag",5);
+    k.gate("tdag",4);
+    k.gate("t",0);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("cnot",4,5);
+    k.gate("h",0);
+    k.gate("h",4);
+    k.gate("t",2);
+    k.gate("t",1);
+    k.gate("t",4);
+    k.gate("cnot",1,2);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("tdag",1);
+    k.gate("cnot",2,1);
+    k.gate("tdag",2);
+    k.gate("tdag",1);
+    k.gate("t",4);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("cnot",1,2);
+    k.gate("h",4);
+    k.gate("h",0);
+    k.gate("t",5);
+    k.gate("t",4);
+    k.gate("t",0);
+    k.gate("cnot",4,5);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("tdag",4);
+    k.gate("cnot",5,4);
+    k.gate("tdag",5);
+    k.gate("tdag",4);
+    k.gate("t",0);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("cnot",4,5);
+    k.gate("h",0);
+    k.gate("h",4);
+    k.gate("t",2);
+    k.gate("t",1);
+    k.gate("t",4);
+    k.gate("cnot",1,2);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("tdag",1);
+    k.gate("cnot",2,1);
+    k.gate("tdag",2);
+    k.gate("tdag",1);
+    k.gate("t",4);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("cnot",1,2);
+    k.gate("h",4);
+    k.gate("h",5);
+    k.gate("t",4);
+    k.gate("t",3);
+    k.gate("t",5);
+    k.gate("cnot",3,4);
+    k.gate("cnot",5,3);
+    k.gate("cnot",4,5);
+    k.gate("tdag",3);
+    k.gate("cnot",4,3);
+    k.gate("tdag",4);
+    k.gate("tdag",3);
+    k.gate("t",5);
+    k.gate("cnot",5,3);
+    k.gate("cnot",4,5);
+    k.gate("cnot",3,4);
+    k.gate("h",5);
+    k.gate("h",0);
+    k.gate("t",5);
+    k.gate("t",4);
+    k.gate("t",0);
+    k.gate("cnot",4,5);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("tdag",4);
+    k.gate("cnot",5,4);
+    k.gate("tdag",5);
+    k.gate("tdag",4);
+    k.gate("t",0);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("cnot",4,5);
+    k.gate("h",0);
+    k.gate("h",4);
+    k.gate("t",2);
+    k.gate("t",1);
+    k.gate("t",4);
+    k.gate("cnot",1,2);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("tdag",1);
+    k.gate("cnot",2,1);
+    k.gate("tdag",2);
+    k.gate("tdag",1);
+    k.gate("t",4);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("cnot",1,2);
+    k.gate("h",4);
+    k.gate("h",0);
+    k.gate("t",5);
+    k.gate("t",4);
+    k.gate("t",0);
+    k.gate("cnot",4,5);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("tdag",4);
+    k.gate("cnot",5,4);
+    k.gate("tdag",5);
+    k.gate("tdag",4);
+    k.gate("t",0);
+    k.gate("cnot",0,4);
+    k.gate("cnot",5,0);
+    k.gate("cnot",4,5);
+    k.gate("h",0);
+    k.gate("h",4);
+    k.gate("t",2);
+    k.gate("t",1);
+    k.gate("t",4);
+    k.gate("cnot",1,2);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("tdag",1);
+    k.gate("cnot",2,1);
+    k.gate("tdag",2);
+    k.gate("tdag",1);
+    k.gate("t",4);
+    k.gate("cnot",4,1);
+    k.gate("cnot",2,4);
+    k.gate("cnot",1,2);
+    k.gate("h",4);
+    k.gate("cnot",0,4);
+
+    for (size_t q=0; q<k.qubit_count; q++)
+    {
+	    k.gate("measure", q);
+    }
+}
+
+// 5-qubit short error code checkers in 4 variations next to each other; 7 qubits
+inline void lingling5esm_circuit(ql::quantum_kernel& k)
+{
+    k.gate("prepz",5);
+    k.gate("prepz",6);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("x",6);
+    k.gate("ym90",6);
+    k.gate("ym90",0);
+    k.gate("cz",5,0);
+    k.gate("ry90",0);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",1,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",2,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",3);
+    k.gate("cz",5,3);
+    k.gate("ry90",3);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("measure",5);
+    k.gate("measure",6);
+
+    k.gate("prepz",5);
+    k.gate("prepz",6);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("x",6);
+    k.gate("ym90",6);
+    k.gate("ym90",1);
+    k.gate("cz",5,1);
+    k.gate("ry90",1);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",2,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",3,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",4);
+    k.gate("cz",5,4);
+    k.gate("ry90",4);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("measure",5);
+    k.gate("measure",6);
+
+    k.gate("prepz",5);
+    k.gate("prepz",6);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("x",6);
+    k.gate("ym90",6);
+    k.gate("ym90",2);
+    k.gate("cz",5,2);
+    k.gate("ry90",2);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",3,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",4,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",0);
+    k.gate("cz",5,0);
+    k.gate("ry90",0);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("measure",5);
+    k.gate("measure",6);
+
+    k.gate("prepz",5);
+    k.gate("prepz",6);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("x",6);
+    k.gate("ym90",6);
+    k.gate("ym90",3);
+    k.gate("cz",5,3);
+    k.gate("ry90",3);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",4,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",0,5);
+    k.gate("ry90",5);
+    k.gate("ym90",5);
+    k.gate("cz",6,5);
+    k.gate("ry90",5);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("ym90",1);
+    k.gate("cz",5,1);
+    k.gate("ry90",1);
+    k.gate("x",5);
+    k.gate("ym90",5);
+    k.gate("measure",5);
+    k.gate("measure",6);
+}
+
+// 7-qubit short error code checkers in 3 variations next to each other; 9 qubits
+inline void lingling7esm_circuit(ql::quantum_kernel& k)
+{
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",4);
+    k.gate("cz",7,4);
+    k.gate("ry90",4);
+    k.gate("ym90",8);
+    k.gate("cz",0,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",3);
+    k.gate("cz",7,3);
+    k.gate("ry90",3);
+    k.gate("ym90",8);
+    k.gate("cz",4,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",1,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",3);
+    k.gate("cz",7,3);
+    k.gate("ry90",3);
+    k.gate("ym90",8);
+    k.gate("cz",5,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",4);
+    k.gate("cz",7,4);
+    k.gate("ry90",4);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",1);
+    k.gate("cz",7,1);
+    k.gate("ry90",1);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("ym90",2);
+    k.gate("cz",7,2);
+    k.gate("ry90",2);
+    k.gate("ym90",8);
+    k.gate("cz",0,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",4,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+}
+
+// 7-qubit short error code checkers in 3 variations next to each other, as subroutine; 9 qubits
+inline void lingling7sub_circuit(ql::quantum_kernel& k)
+{
+#define SUB1    1
+
+#ifdef SUB1
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",4);
+    k.gate("cz",7,4);
+    k.gate("ry90",4);
+    k.gate("ym90",8);
+    k.gate("cz",0,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",3);
+    k.gate("cz",7,3);
+    k.gate("ry90",3);
+    k.gate("ym90",8);
+    k.gate("cz",4,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+#endif
+
+#ifdef SUB2
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",1,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",3);
+    k.gate("cz",7,3);
+    k.gate("ry90",3);
+    k.gate("ym90",8);
+    k.gate("cz",5,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",4);
+    k.gate("cz",7,4);
+    k.gate("ry90",4);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+#endif
+
+#ifdef SUB3
+    k.gate("prepz",7);
+    k.gate("prepz",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("ym90",1);
+    k.gate("cz",7,1);
+    k.gate("ry90",1);
+    k.gate("ym90",8);
+    k.gate("cz",2,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",5);
+    k.gate("cz",7,5);
+    k.gate("ry90",5);
+    k.gate("ym90",8);
+    k.gate("cz",6,8);
+    k.gate("ry90",8);
+    k.gate("ym90",2);
+    k.gate("cz",7,2);
+    k.gate("ry90",2);
+    k.gate("ym90",8);
+    k.gate("cz",0,8);
+    k.gate("ry90",8);
+    k.gate("ym90",8);
+    k.gate("cz",7,8);
+    k.gate("ry90",8);
+    k.gate("ym90",6);
+    k.gate("cz",7,6);
+    k.gate("ry90",6);
+    k.gate("ym90",8);
+    k.gate("cz",4,8);
+    k.gate("ry90",8);
+    k.gate("x",7);
+    k.gate("ym90",7);
+    k.gate("measure",7);
+    k.gate("measure",8);
+#endif
+}
+
+#endif // QL_TESTS_MAPPER_S17_FIXTURE_H
@@ -0,0 +1,113 @@
+// shared by the scheduler tests: random circuits on the 17 qubits of test_mapper_s17.json,
+// scheduled by the rc scheduler with the options set by the caller, and the checks of the schedule
+
+#ifndef QL_TESTS_SCHEDULER_FIXTURE_H
+#define QL_TESTS_SCHEDULER_FIXTURE_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <openql.h>
+#include <scheduler.h>
+
+// random gates on 17 qubits, two-qubit gates only on edges of the surface-17 topology;
+// the number of gates is min_gates plus a random number less than range
+inline void random_circuit(ql::quantum_kernel& k, size_t seed, size_t min_gates, size_t range)
+{
+    static const size_t edges[24][2] = {
+        {2,0}, {0,3}, {4,1}, {1,5}, {5,2}, {2,6}, {6,3}, {4,7}, {7,5}, {5,8}, {8,6}, {6,9},
+        {7,10}, {10,8}, {8,11}, {11,9}, {9,12}, {13,10}, {10,14}, {14,11}, {11,15}, {15,12}, {13,16}, {16,14}
+    };
+    static const char* single_qubit_gates[5] = { "x", "y", "x90", "ym90", "prepz" };
+    std::mt19937 rng(seed);
+    size_t gate_count = min_gates + rng()%range;
+    for (size_t i = 0; i < gate_count; i++)
+    {
+        size_t r = rng()%10;
+        if (r < 5)
+        {
+            k.gate(single_qubit_gates[rng()%5], rng()%17);
+        }
+        else if (r < 8)
+        {
+            const size_t* e = edges[rng()%24];
+            k.gate("cz", e[0], e[1]);
+        }
+        else
+        {
+            k.gate("measure", rng()%17);
+        }
+    }
+}
+
+struct schedule_result_t
+{
+    std::vector<size_t> cycles;     // of the gates in the original order
+    size_t              latency;    // cycle of SINK minus cycle of SOURCE
+    bool                valid;      // dependences and resource constraints are respected
+    bool                optimal;    // exact scheduling was asked for and completed
+};
+
+// schedule the circuit in direction scheduler (ASAP or ALAP) by the plain list scheduler or,
+// when portfolio isn't "no", by a portfolio of that many list schedulers; then by the exact scheduler when asked;
+// the schedule is valid when each dependence is respected and a fresh resource manager accepts the gates in cycle order
+inline schedule_result_t schedule_circuit(ql::quantum_platform& platform, ql::quantum_kernel& k,
+    const std::string& scheduler, const std::string& portfolio, bool exact)
+{
+    ql::options::set("scheduler", scheduler);
+    ql::options::set("scheduler_portfolio", portfolio);
+    std::vector<ql::gate*> gates(k.c.begin(), k.c.end());
+
+    ql::scheduling_direction_t dir = (scheduler == "ASAP" ? ql::forward_scheduling : ql::backward_scheduling);
+    Scheduler sched;
+    sched.init(k.c, platform, 17, 0);
+    std::string dot;
+    if (portfolio == "no")
+    {
+        ql::arch::resource_manager_t rm(platform, dir);
+        if (dir == ql::forward_scheduling)
+        {
+            sched.schedule_asap(rm, platform, dot);
+        }
+        else
+        {
+            sched.schedule_alap(rm, platform, dot);
+        }
+    }
+    else
+    {
+        sched.schedule_portfolio(dir, platform, dot);
+    }
+
+    schedule_result_t result;
+    result.optimal = exact && sched.schedule_exact(dir, platform, dot);
+    for (auto gp : gates)
+    {
+        result.cycles.push_back(gp->cycle);
+    }
+    result.latency = sched.instruction[sched.t]->cycle - sched.instruction[sched.s]->cycle;
+    result.valid = true;
+    for (ListDigraph::ArcIt a(sched.graph); a != INVALID; ++a)
+    {
+        if (sched.instruction[sched.graph.target(a)]->cycle < sched.instruction[sched.graph.source(a)]->cycle + sched.weight[a])
+        {
+            result.valid = false;
+        }
+    }
+    // replay the gates in cycle order in a fresh resource manager
+    std::stable_sort(gates.begin(), gates.end(), [](ql::gate* g1, ql::gate* g2) { return g1->cycle < g2->cycle; });
+    ql::arch::resource_manager_t rm(platform, ql::forward_scheduling);
+    for (auto gp : gates)
+    {
+        if (!rm.available(gp->cycle, gp, platform))
+        {
+            result.valid = false;
+        }
+        rm.reserve(gp->cycle, gp, platform);
+    }
+    return result;
+}
+
+#endif // QL_TESTS_SCHEDULER_FIXTURE_H
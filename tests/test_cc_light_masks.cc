@@ -0,0 +1,178 @@
+// test of the allocation of mask registers by the cc_light backend (ql::arch::MaskManager in cc_light_eqasm_compiler.h):
+// compiles programs for surface-17 whose bundles apply x to random subsets of qubits, besides y to a few frequent
+// subsets and cz to a few pairs, once with fewer masks than mask registers and once with many more, in a loop too;
+// interprets the .qisa files, starting every kernel with only the masks of the prologue loaded, and checks that every
+// qubit (and pair of qubits) gets the intended sequence of gates, that no register is out of range, and that the
+// prologue's registers are never overwritten
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+
+#include <openql.h>
+
+typedef std::map<std::string, std::vector<std::string>> gates_t;     // qubit or qubit pair, as in a mask, to its gates
+
+// the qubits "q0, q1, ..." of a smis mask, or the qubit pairs "(q0, q1), ..." of a smit mask
+static std::vector<std::string> mask_elements(const std::string &mask)
+{
+    std::vector<std::string> elements;
+    size_t pos = 0;
+    while (pos < mask.size())
+    {
+        size_t end = mask[pos] == '(' ? mask.find(')', pos) + 1 : mask.find(',', pos);
+        end = std::min(end, mask.size());
+        elements.push_back(mask.substr(pos, end - pos));
+        pos = mask.find_first_not_of(", ", end);
+    }
+    return elements;
+}
+
+// interpret the mask instructions and bundles of a .qisa file
+static bool interpret(const std::string &file_name, gates_t &gates, size_t &bundles, size_t &prologue_masks, size_t &inline_masks)
+{
+    std::ifstream file(file_name);
+    if (!file)
+    {
+        std::cout << "cannot open " << file_name << std::endl;
+        return false;
+    }
+
+    std::map<std::string, std::string> prologue;        // register to mask
+    std::map<std::string, std::string> registers;
+    bool in_prologue = true;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream iss(line);
+        std::string token;
+        if (!(iss >> token))
+        {
+            continue;
+        }
+        if (token == "smis" || token == "smit")
+        {
+            std::string reg;
+            iss >> reg;
+            reg.pop_back();                             // NB: ','
+            std::string mask = line.substr(line.find('{') + 1);
+            mask = mask.substr(0, mask.find('}'));
+            size_t max_reg = token == "smis" ? 32 : 64;
+            if (std::stoul(reg.substr(1)) >= max_reg || (!in_prologue && prologue.count(reg)))
+            {
+                std::cout << "illegal register in: " << line << std::endl;
+                return false;
+            }
+            (in_prologue ? prologue : registers)[reg] = mask;
+            (in_prologue ? prologue_masks : inline_masks)++;
+        }
+        else if (token.back() == ':')                   // kernel label: only the masks of the prologue are known
+        {
+            in_prologue = false;
+            registers = prologue;
+        }
+        else if (isdigit(token[0]))                     // bundle: <pre-interval> <gate> <register> | ...
+        {
+            std::string gate, reg;
+            while (iss >> gate >> reg)
+            {
+                if (!registers.count(reg))
+                {
+                    std::cout << "undefined register in: " << line << std::endl;
+                    return false;
+                }
+                for (auto &element : mask_elements(registers[reg]))
+                {
+                    gates[element].push_back(gate);
+                }
+                iss >> token;                           // NB: '|'
+            }
+            bundles++;
+        }
+    }
+    return true;
+}
+
+static bool test_masks(const std::string &name, size_t layers, size_t random_masks, bool loop)
+{
+    const size_t nq = 17;
+    std::vector<size_t> all;
+    for (size_t q = 0; q < nq; q++)
+    {
+        all.push_back(q);
+    }
+    std::vector<std::vector<size_t>> frequent = { {0}, {1}, {0, 1, 2}, {0, 2} };
+    std::vector<std::pair<size_t, size_t>> pairs = { {2, 0}, {0, 3}, {4, 1} };
+
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("scheduler", "ALAP");
+    ql::options::set("scheduler_uniform", "no");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    ql::quantum_program prog(name, platform, nq, 0);
+    std::mt19937 rng(layers);
+    gates_t expected;
+    for (size_t kernel = 0; kernel < 2; kernel++)
+    {
+        ql::quantum_kernel k(name + "_" + std::to_string(kernel), platform, nq, 0);
+        for (size_t layer = 0; layer < layers; layer++)
+        {
+            if (layer % 10 == 9)
+            {
+                auto &p = pairs[layer / 10 % pairs.size()];
+                k.gate("cz", p.first, p.second);
+                expected["(" + std::to_string(p.first) + ", " + std::to_string(p.second) + ")"].push_back("cz");
+            }
+            else
+            {
+                size_t subset = 1 + rng() % random_masks;  // NB: a subset of qubits 3..16
+                for (size_t q = 3; q < nq; q++)
+                {
+                    if (subset & (1 << (q - 3)))
+                    {
+                        k.gate("x", q);
+                        expected[std::to_string(q)].push_back("x");
+                    }
+                }
+                auto &f = frequent[layer % frequent.size()];
+                for (auto q : f)
+                {
+                    k.gate("y", q);
+                    expected[std::to_string(q)].push_back("y");
+                }
+            }
+            k.wait(all, 0);
+        }
+        if (loop && kernel == 1)
+        {
+            prog.add_for(k, 3);
+        }
+        else
+        {
+            prog.add(k);
+        }
+    }
+    prog.compile();
+
+    gates_t gates;
+    size_t bundles = 0;
+    size_t prologue_masks = 0;
+    size_t inline_masks = 0;
+    bool pass = interpret("test_output/" + name + ".qisa", gates, bundles, prologue_masks, inline_masks) && gates == expected;
+    std::cout << name << ": " << bundles << " bundles, " << prologue_masks << " masks loaded by the prologue, "
+              << inline_masks << " before bundles" << (pass ? "" : "  FAIL") << std::endl;
+    return pass;
+}
+
+int main(int argc, char ** argv)
+{
+    bool ok = true;
+    ok = test_masks("test_cc_light_masks_fit", 20, 7, false) && ok;
+    ok = test_masks("test_cc_light_masks_spill", 300, 2000, false) && ok;
+    ok = test_masks("test_cc_light_masks_loop", 300, 2000, true) && ok;
+    return ok ? 0 : 1;
+}
@@ -172,5 +172,37 @@ class Test_commutation(unittest.TestCase):
         qasm_fn = os.path.join(output_dir, p.name+'_scheduled.qasm')
         self.assertTrue( file_compare(qasm_fn, gold_fn) )
 
+    # the cnots with target 3 commute with each other but not with the czs on 3,
+    # so all of them must be scheduled after the list of czs before them, not only the first one
+    def test_cz_cnot_groupcommute(self):
+        config_fn = os.path.join(curdir, 'test_179.json')
+        platf = ql.Platform("starmon", config_fn)
+        ql.set_option("scheduler", 'ASAP');
+        ql.set_option("scheduler_post179", 'yes');
+        ql.set_option("scheduler_commute", 'yes');
+
+        nqubits = 7
+        k = ql.Kernel("aKernel", platf, nqubits)
+
+        k.gate("x", [0]);
+        k.gate("x", [0]);
+        k.gate("cz", [0,3]);
+        k.gate("cz", [3,1]);
+        k.gate("cnot", [1,3]);
+        k.gate("cnot", [5,3]);
+        k.gate("cnot", [6,3]);
+        k.gate("cz", [3,0]);
+
+        sweep_points = [2]
+
+        p = ql.Program("test_cz_cnot_groupcommute", platf, nqubits)
+        p.set_sweep_points(sweep_points)
+        p.add_kernel(k)
+        p.compile()
+
+        gold_fn = curdir + '/golden/'+ p.name + '_scheduled.qasm'
+        qasm_fn = os.path.join(output_dir, p.name+'_scheduled.qasm')
+        self.assertTrue( file_compare(qasm_fn, gold_fn) )
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,124 @@
+// test of the depolarizing error model (ql::Depolarizing_model in metrics.h):
+// - for circuits of Pauli gates only, errors of qubits stay independent, and the fidelity of each qubit
+//   must equal the closed form of composing its depolarizing channels
+// - an error before a cnot or cz must be propagated to its target, and a preparation must remove it
+// - on random surface-17 circuits with two-qubit gates, pruning at a higher threshold must give a lower estimate,
+//   by at most the probability that was pruned, and must bound the number of errors tracked
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include <openql.h>
+#include <metrics.h>
+
+#include "fidelity_fixture.h"
+
+static bool near(double a, double b)
+{
+    return std::fabs(a - b) <= 1e-12;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    size_t nq = platform.qubit_number;
+    size_t cycle_time = platform.cycle_time;
+    bool ok = true;
+
+    // Pauli gates only: P(no error) = 1/4 + 3/4 * product of the lambda of each channel on the qubit
+    {
+        double gatefid1 = 0.999;
+        double decoherence_time = 150;
+        ql::quantum_kernel k("k", platform, nq, 0);
+        std::mt19937 rng(1);
+        for (size_t i = 0; i < 200; i++)
+        {
+            k.gate(rng()%2 ? "x" : "y", rng()%nq);
+        }
+        ql::circuit circ = schedule_asap(k, cycle_time);
+
+        double lambda_gate = 1 - 4.0/3 * (1 - gatefid1);
+        double lambda_cycle = 1 - 4.0/3 * (1 - std::exp(-1.0/decoherence_time));
+        std::vector<double> lambda(nq, 1.0);
+        std::vector<size_t> last_op_endtime(nq, 1);
+        size_t end_cycle = 1;
+        for (auto gp : circ)
+        {
+            size_t q = gp->operands[0];
+            lambda[q] *= std::pow(lambda_cycle, (double)(gp->cycle - last_op_endtime[q])) * lambda_gate;
+            last_op_endtime[q] = gp->cycle + gp->duration / cycle_time;
+            end_cycle = std::max(end_cycle, last_op_endtime[q]);
+        }
+        double expected = 1.0;
+        for (size_t q = 0; q < nq; q++)
+        {
+            lambda[q] *= std::pow(lambda_cycle, (double)(end_cycle - last_op_endtime[q]));
+            expected *= 0.25 + 0.75 * lambda[q];
+        }
+
+        ql::Depolarizing_model model(nq, gatefid1, 0.99, 0.0, decoherence_time, cycle_time);
+        double fid = model.run_circuit(circ);
+        bool pass = near(fid, expected) && model.pruned_probability() == 0.0;
+        std::cout << "pauli gates: fidelity " << fid << ", expected " << expected << (pass ? "" : "  FAIL") << std::endl;
+        ok = ok && pass;
+    }
+
+    // propagation: an X or Y error on the control of a cnot, or on either operand of a cz, spreads to the other operand
+    for (std::string twoqubitgate : { "cnot", "cz" })
+    {
+        double gatefid1 = 0.99;
+        ql::quantum_kernel k("k", platform, nq, 0);
+        k.gate("x", 0);
+        k.gate(twoqubitgate, 0, 1);
+        ql::circuit circ = schedule_asap(k, cycle_time);
+
+        ql::Depolarizing_model model(nq, gatefid1, 1.0, 0.0, 1e30, cycle_time);
+        double fid = model.run_circuit(circ);
+        double fid0 = model.qubit_fidelity(0);
+        double fid1 = model.qubit_fidelity(1);
+        bool pass = near(fid, gatefid1) && near(fid0, gatefid1) && near(fid1, 1 - 2 * (1 - gatefid1) / 3);
+
+        k.gate("prepz", 1);
+        circ = schedule_asap(k, cycle_time);
+        double fid_prep = model.run_circuit(circ);
+        pass = pass && near(fid_prep, gatefid1) && near(model.qubit_fidelity(1), 1.0) && near(model.qubit_fidelity(0), gatefid1);
+        std::cout << twoqubitgate << " propagation: fidelity " << fid << ", qubit 0 " << fid0 << ", qubit 1 " << fid1
+                  << ", after prepz of qubit 1 " << fid_prep << (pass ? "" : "  FAIL") << std::endl;
+        ok = ok && pass;
+    }
+
+    // pruning on random circuits with two-qubit gates on any pair of qubits, entangling them all
+    for (size_t seed = 1; seed <= 3; seed++)
+    {
+        ql::quantum_kernel k("k", platform, nq, 0);
+        random_circuit(k, seed, 100, { "h", "x90" }, { "cnot", "cz" }, false);
+        ql::circuit circ = schedule_asap(k, cycle_time);
+
+        ql::Depolarizing_model fine(nq, 0.999, 0.99, 1e-6, 150, cycle_time);
+        auto t0 = std::chrono::steady_clock::now();
+        double fid_fine = fine.run_circuit(circ);
+        auto t1 = std::chrono::steady_clock::now();
+        ql::Depolarizing_model coarse(nq, 0.999, 0.99, 1e-4, 150, cycle_time);
+        double fid_coarse = coarse.run_circuit(circ);
+        auto t2 = std::chrono::steady_clock::now();
+
+        bool pass = fid_coarse <= fid_fine + 1e-12
+                 && fid_fine - fid_coarse <= coarse.pruned_probability() + 1e-12
+                 && coarse.max_error_count() <= 1e4 + 1
+                 && fine.max_error_count() <= 1e6 + 1;
+        std::cout << "seed " << seed << ": threshold 1e-6 fidelity " << fid_fine << " errors " << fine.max_error_count()
+                  << " in " << std::chrono::duration<double>(t1 - t0).count() << " s"
+                  << "; threshold 1e-4 fidelity " << fid_coarse << " errors " << coarse.max_error_count()
+                  << " pruned " << coarse.pruned_probability()
+                  << " in " << std::chrono::duration<double>(t2 - t1).count() << " s" << (pass ? "" : "  FAIL") << std::endl;
+        ok = ok && pass;
+    }
+
+    return ok ? 0 : 1;
+}
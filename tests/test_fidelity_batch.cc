@@ -0,0 +1,89 @@
+// test of the batch fidelity estimator (ql::FidelityBatch in metrics.h):
+// schedules random circuits on the surface-17 platform, ending with a gate on each qubit,
+// and checks that the estimate of each packed circuit equals that of ql::quick_fidelity, and that 0 qubits are rejected;
+// then estimates all circuits at once and compares the time taken with that of quick_fidelity
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+#include <openql.h>
+#include <metrics.h>
+
+#include "fidelity_fixture.h"
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    size_t nq = platform.qubit_number;
+
+    std::vector<ql::circuit> circuits;
+    std::vector<ql::quantum_kernel> kernels;
+    for (size_t seed = 1; seed <= 50; seed++)
+    {
+        ql::quantum_kernel k("k", platform, nq, 0);
+        random_circuit(k, seed, 200, { "y", "x" }, { "cz", "cz" }, true);
+        for (size_t q = 0; q < nq; q++)
+        {
+            k.gate("x", q);             // so that the circuit ends when the last gate in cycle order ends
+        }
+        kernels.push_back(k);
+    }
+    for (auto& k : kernels)
+    {
+        circuits.push_back(schedule_asap(k, platform.cycle_time));
+    }
+
+    std::vector<ql::packed_schedule> schedules;
+    for (auto& circ : circuits)
+    {
+        schedules.push_back(ql::pack_schedule(circ, platform.cycle_time));
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<double> reference;
+    for (auto& circ : circuits)
+    {
+        reference.push_back(-ql::quick_fidelity(circ));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    ql::FidelityBatch batch(nq);
+    std::vector<double> estimates = batch.estimate(schedules);
+    auto t2 = std::chrono::steady_clock::now();
+
+    bool ok = (estimates.size() == reference.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; ok && i < estimates.size(); i++)
+    {
+        if (std::fabs(estimates[i] - reference[i]) > 1e-12 + 1e-9 * reference[i])
+        {
+            std::cout << "circuit " << i << ": batch " << estimates[i] << ", quick_fidelity " << reference[i] << std::endl;
+            mismatches++;
+        }
+    }
+    ok = ok && mismatches == 0;
+
+    // the estimate averages over the qubits, so there must be some
+    bool rejected = false;
+    try
+    {
+        ql::FidelityBatch empty(0);
+    }
+    catch (ql::exception&)
+    {
+        rejected = true;
+    }
+    if (!rejected)
+    {
+        std::cout << "a batch without qubits is accepted  FAIL" << std::endl;
+    }
+    ok = ok && rejected;
+
+    std::cout << circuits.size() << " circuits, mismatches " << mismatches
+              << ", quick_fidelity " << std::chrono::duration<double>(t1 - t0).count() << " s"
+              << ", batch " << std::chrono::duration<double>(t2 - t1).count() << " s" << std::endl;
+    return ok ? 0 : 1;
+}
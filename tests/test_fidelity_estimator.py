@@ -0,0 +1,97 @@
+import os
+import math
+import unittest
+from openql import openql as ql
+
+curdir = os.path.dirname(os.path.realpath(__file__))
+output_dir = os.path.join(curdir, 'test_output')
+
+# gate classes of FidelityEstimator.add_schedule
+SKIP, PREPZ, ONE_QUBIT, TWO_QUBIT = 0, 1, 2, 3
+
+class Test_fidelity_estimator(unittest.TestCase):
+
+    def test_single_gates(self):
+        est = ql.FidelityEstimator(2, 0.999, 0.99, 150.0)
+        # x on q0 in cycle 1: q1 idles for that cycle
+        i = est.add_schedule([0], [0], [1], [1], [ONE_QUBIT])
+        # cz on q0,q1 in cycles 1-2: both get 0.99
+        j = est.add_schedule([0], [1], [1], [2], [TWO_QUBIT])
+        # measure doesn't affect fidelity, but both qubits idle for its cycle
+        k = est.add_schedule([0], [0], [1], [1], [SKIP])
+        self.assertEqual([i, j, k], [0, 1, 2])
+
+        fids = est.estimate()
+        self.assertEqual(len(fids), 3)
+        self.assertAlmostEqual(fids[0], (0.999 + math.exp(-1/150.0)) / 2)
+        self.assertAlmostEqual(fids[1], 0.99)
+        self.assertAlmostEqual(fids[2], math.exp(-1/150.0))
+
+    def test_prepz_restores(self):
+        est = ql.FidelityEstimator(1)
+        # x, x, prepz, all back to back on q0: prepz restores fidelity 1
+        est.add_schedule([0, 0, 0], [0, 0, 0], [1, 2, 3], [1, 1, 1], [ONE_QUBIT, ONE_QUBIT, PREPZ])
+        self.assertAlmostEqual(est.estimate()[0], 1.0)
+
+    def test_clear(self):
+        est = ql.FidelityEstimator(2)
+        est.add_schedule([0], [1], [1], [1], [TWO_QUBIT])
+        est.clear()
+        self.assertEqual(len(est.estimate()), 0)
+        self.assertEqual(est.add_schedule([1], [0], [1], [1], [ONE_QUBIT]), 0)
+
+    def test_invalid_schedule(self):
+        est = ql.FidelityEstimator(2)
+        with self.assertRaises(Exception):
+            est.add_schedule([0, 1], [0], [1], [1], [ONE_QUBIT])  # lengths differ
+        with self.assertRaises(Exception):
+            est.add_schedule([2], [0], [1], [1], [ONE_QUBIT])     # qubit out of range
+        with self.assertRaises(Exception):
+            est.add_schedule([0], [0], [1], [1], [4])             # no such gate class
+
+    def test_no_qubits(self):
+        # the estimate averages over the qubits
+        with self.assertRaises(Exception):
+            ql.FidelityEstimator(0)
+
+    def test_state_not_exposed(self):
+        est = ql.FidelityEstimator(2)
+        self.assertFalse(hasattr(est, 'schedules'))
+        self.assertFalse(hasattr(est, 'qubit_count'))
+
+    def test_add_program(self):
+        ql.set_option('output_dir', output_dir)
+        ql.set_option('optimize', 'no')
+        ql.set_option('scheduler', 'ASAP')
+        ql.set_option('log_level', 'LOG_WARNING')
+
+        config_fn = os.path.join(curdir, 'test_cfg_none_s7.json')
+        platform = ql.Platform('starmon', config_fn)
+        num_qubits = 7
+        p = ql.Program('test_fidelity_estimator', platform, num_qubits, 0)
+        k1 = ql.Kernel('kernel_1', platform, num_qubits, 0)
+        k1.gate('x', [0])
+        k2 = ql.Kernel('kernel_2', platform, num_qubits, 0)
+        for q in range(num_qubits):
+            k2.gate('x', [q])
+        k2.gate('cnot', [0, 2])
+        p.add_kernel(k1)
+        p.add_kernel(k2)
+        p.compile()
+
+        est = ql.FidelityEstimator(num_qubits)
+        est.add_schedule([0], [0], [1], [1], [ONE_QUBIT])
+        self.assertEqual(est.add_program(p), 1)
+        fids = est.estimate()
+        self.assertEqual(len(fids), 3)
+        for f in fids:
+            self.assertTrue(0.0 < f <= 1.0)
+        # the second kernel has more gates on more qubits than the first
+        self.assertLess(fids[2], fids[1])
+
+        small = ql.FidelityEstimator(2)
+        with self.assertRaises(Exception):
+            small.add_program(p)                                   # operands beyond 2 qubits
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,47 @@
+// test of the incremental fidelity estimate used by mapper=maxfidelity (ql::FidelityState in metrics.h):
+// schedules random circuits on the surface-17 platform gate by gate,
+// adds each gate to a FidelityState in that order and checks after each gate that its score
+// equals that of ql::quick_fidelity on the gates until then, sorted on cycle
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#include <openql.h>
+#include <metrics.h>
+
+#include "fidelity_fixture.h"
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    size_t nq = platform.qubit_number;
+
+    bool ok = true;
+    for (size_t seed = 1; seed <= 5; seed++)
+    {
+        ql::quantum_kernel k("k", platform, nq, 0);
+        random_circuit(k, seed, 100, { "y", "x" }, { "cz", "cz" }, true);
+        schedule_asap(k, platform.cycle_time);  // gates are added to the state in the order of the kernel
+
+        ql::FidelityState state;
+        state.Init(nq);
+        ql::circuit scheduled;
+        size_t mismatches = 0;
+        for (auto gp : k.c)
+        {
+            state.Add(gp);
+            auto it = std::upper_bound(scheduled.begin(), scheduled.end(), gp,
+                [](ql::gate* gp1, ql::gate* gp2) { return gp1->cycle < gp2->cycle; });
+            scheduled.insert(it, gp);
+            if (state.Score() != ql::quick_fidelity(scheduled))
+            {
+                mismatches++;
+            }
+        }
+        std::cout << "seed " << seed << ": fidelity " << -state.Score() << ", mismatches " << mismatches << std::endl;
+        ok = ok && mismatches == 0;
+    }
+    return ok ? 0 : 1;
+}
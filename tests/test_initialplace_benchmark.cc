@@ -0,0 +1,119 @@
+// benchmark of the initial placement solvers (option initialplace_algorithm):
+// compares the cost and time of simulated annealing with those of the MIP, when the latter is available,
+// on random interaction graphs placed in grids of increasing size,
+// and checks that the placements are valid, that annealing is deterministic,
+// and that cancelled solvers stop with a valid placement (annealing) or none (MIP, cancelled before it started)
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include <openql.h>
+#include <initial_place.h>
+
+// random two-qubit gate counts between nfac facilities, each facility interacting with a few others
+static ql::initial_place::problem_t random_problem(size_t width, size_t seed)
+{
+    ql::initial_place::problem_t problem;
+    problem.nlocs = width * width;
+    problem.nfac = problem.nlocs - problem.nlocs / 4;
+    problem.distance.assign(problem.nlocs, std::vector<size_t>(problem.nlocs, 0));
+    for (size_t k = 0; k < problem.nlocs; k++)
+    {
+        for (size_t l = 0; l < problem.nlocs; l++)
+        {
+            problem.distance[k][l] = std::abs(int(k % width) - int(l % width)) + std::abs(int(k / width) - int(l / width));
+        }
+    }
+    std::mt19937 rng(seed);
+    problem.refcount.assign(problem.nfac, std::vector<size_t>(problem.nfac, 0));
+    for (size_t n = 0; n < 3 * problem.nfac; n++)
+    {
+        size_t i = rng() % problem.nfac;
+        size_t j = rng() % problem.nfac;
+        if (i != j)
+        {
+            problem.refcount[i][j] += 1 + rng() % 4;
+        }
+    }
+    return problem;
+}
+
+// each facility in a distinct location
+static bool valid(const ql::initial_place::problem_t &problem, const std::vector<size_t> &loc)
+{
+    std::vector<bool> used(problem.nlocs, false);
+    if (loc.size() != problem.nfac) return false;
+    for (auto k : loc)
+    {
+        if (k >= problem.nlocs || used[k]) return false;
+        used[k] = true;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+
+    bool ok = true;
+    std::cout << std::left << std::setw(8) << "grid" << std::setw(8) << "seed"
+              << std::right << std::setw(10) << "bound" << std::setw(10) << "anneal" << std::setw(12) << "time[s]"
+              << std::setw(10) << "mip" << std::setw(12) << "time[s]" << std::setw(8) << "valid" << std::endl;
+    for (size_t width : { 3, 4, 5, 7, 10 })
+    {
+        for (size_t seed = 1; seed <= 3; seed++)
+        {
+            ql::initial_place::problem_t problem = random_problem(width, seed);
+
+            // each gate contributes at least distance 1
+            size_t bound = 0;
+            for (auto &row : problem.refcount) for (auto c : row) bound += c;
+
+            std::vector<size_t> loc, again;
+            ql::initial_place::anneal_parameters_t parameters;
+            auto t1 = std::chrono::steady_clock::now();
+            ql::initial_place::solve_anneal(problem, parameters, loc);
+            auto t2 = std::chrono::steady_clock::now();
+            ql::initial_place::solve_anneal(problem, parameters, again);
+            double anneal_time = std::chrono::duration<double>(t2 - t1).count();
+            size_t anneal_cost = ql::initial_place::cost(problem, loc);
+            bool is_valid = valid(problem, loc) && loc == again && anneal_cost >= bound;
+
+            ql::initial_place::cancellation_t cancelled;
+            cancelled.cancel();
+            std::vector<size_t> cancelled_loc;
+            ql::initial_place::anneal_parameters_t cancelled_parameters;
+            cancelled_parameters.cancellation = &cancelled;
+            ql::initial_place::solve_anneal(problem, cancelled_parameters, cancelled_loc);
+            is_valid = is_valid && valid(problem, cancelled_loc);
+            is_valid = is_valid && ql::initial_place::solve_mip(problem, cancelled_loc, &cancelled) == ql::initial_place::solution_none;
+
+            std::string mip_cost = "-", mip_time = "-";
+            std::vector<size_t> mip_loc;
+            if (ql::initial_place::mip_supported() && problem.nlocs <= 16)
+            {
+                auto t3 = std::chrono::steady_clock::now();
+                bool solved = (ql::initial_place::solve_mip(problem, mip_loc, nullptr) == ql::initial_place::solution_optimal);
+                auto t4 = std::chrono::steady_clock::now();
+                if (solved)
+                {
+                    is_valid = is_valid && valid(problem, mip_loc) && ql::initial_place::cost(problem, mip_loc) <= anneal_cost;
+                    mip_cost = std::to_string(ql::initial_place::cost(problem, mip_loc));
+                    mip_time = std::to_string(std::chrono::duration<double>(t4 - t3).count());
+                }
+            }
+            ok = ok && is_valid;
+            std::cout << std::left << std::setw(8) << (std::to_string(width) + "x" + std::to_string(width)) << std::setw(8) << seed
+                      << std::right << std::setw(10) << bound << std::setw(10) << anneal_cost
+                      << std::setw(12) << std::fixed << std::setprecision(3) << anneal_time
+                      << std::setw(10) << mip_cost << std::setw(12) << mip_time
+                      << std::setw(8) << (is_valid ? "yes" : "NO") << std::endl;
+        }
+    }
+    return ok ? 0 : 1;
+}
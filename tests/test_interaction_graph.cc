@@ -0,0 +1,103 @@
+// test of the interaction graph (ql::interaction_graph in interaction_graph.h):
+// builds the graph of random surface-17 circuits of one-qubit gates, cnot, cz and swap gates and waits,
+// with and without a horizon, and checks its weights, use counts and number of edges against dense counts
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <random>
+
+#include <openql.h>
+#include <interaction_graph.h>
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    size_t nq = platform.qubit_number;
+
+    bool ok = true;
+    for (size_t seed = 1; seed <= 5; seed++)
+    {
+        ql::quantum_kernel k("k", platform, nq, 0);
+        std::mt19937 rng(seed);
+        static const char* twoqubit_gates[3] = { "cnot", "cz", "swap" };
+        for (size_t i = 0; i < 200; i++)
+        {
+            size_t q0 = rng()%nq;
+            size_t q1 = rng()%nq;
+            size_t kind = rng()%10;
+            if (kind == 0)
+            {
+                k.wait({q0, q1 == q0 ? (q0 + 1) % nq : q1}, 20);  // not an interaction
+            }
+            else if (kind < 4 || q0 == q1)
+            {
+                k.gate("x", q0);
+            }
+            else
+            {
+                k.gate(twoqubit_gates[kind%3], q0, q1);
+            }
+        }
+
+        for (size_t horizon : { 0, 10, 50 })
+        {
+            // dense counts, as InitialPlace computed them
+            std::vector<std::vector<size_t>> refcount(nq, std::vector<size_t>(nq, 0));
+            std::vector<size_t> usecount(nq, 0);
+            size_t twoqubitcount = 0;
+            for (auto gp : k.c)
+            {
+                bool within = (horizon == 0 || twoqubitcount < horizon);
+                if (within)
+                {
+                    for (auto q : gp->operands)
+                    {
+                        usecount[q]++;
+                    }
+                }
+                if (gp->operands.size() == 2 && gp->type() != ql::__wait_gate__)
+                {
+                    if (within)
+                    {
+                        refcount[gp->operands[0]][gp->operands[1]]++;
+                    }
+                    twoqubitcount++;
+                }
+            }
+
+            ql::interaction_graph graph(k.c, nq, horizon);
+            size_t mismatches = 0;
+            size_t edges = 0;
+            for (size_t q0 = 0; q0 < nq; q0++)
+            {
+                if (graph.use_count(q0) != usecount[q0])
+                {
+                    mismatches++;
+                }
+                for (size_t q1 = 0; q1 < nq; q1++)
+                {
+                    size_t count = refcount[q0][q1] + refcount[q1][q0];
+                    if (graph.weight(q0, q1) != count || graph.directed_weight(q0, q1) != refcount[q0][q1])
+                    {
+                        mismatches++;
+                    }
+                    if (q0 < q1 && count != 0)
+                    {
+                        edges++;
+                    }
+                }
+            }
+            if (graph.edge_count() != edges || graph.total_twoqubit_count() != twoqubitcount)
+            {
+                mismatches++;
+            }
+            std::cout << "seed " << seed << " horizon " << horizon << ": " << graph.twoqubit_count() << " of "
+                      << graph.total_twoqubit_count() << " two-qubit gates, " << graph.edge_count() << " edges, mismatches "
+                      << mismatches << std::endl;
+            ok = ok && mismatches == 0;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -1,5 +1,7 @@
 #include <openql_i.h>
 
+#include "mapper_s17_fixture.h"
+
 void
 test_dpt(std::string v, std::string param1, std::string param2, std::string param3, std::string param4)
 {
@@ -640,240 +642,7 @@ test_daniel2(std::string v, std::string param1, std::string param2, std::string
     ql::quantum_kernel k(kernel_name, starmon, n, 0);
     prog.set_sweep_points(sweep_points, sizeof(sweep_points)/sizeof(float));
 
-
-    k.gate("x",0);
-    k.gate("cnot",4,0);
-    k.gate("h",0);
-    k.gate("t",1);
-    k.gate("t",5);
-    k.gate("t",0);
-    k.gate("cnot",5,1);
-    k.gate("cnot",0,5);
-    k.gate("cnot",1,0);
-    k.gate("tdag",5);
-    k.gate("cnot",1,5);
-    k.gate("tdag",1);
-    k.gate("tdag",5);
-    k.gate("t",0);
-    k.gate("cnot",0,5);
-    k.gate("cnot",1,0);
-    k.gate("cnot",5,1);
-    k.gate("h",0);
-    k.gate("h",5);
-    k.gate("t",4);
-    k.gate("t",2);
-    k.gate("t",5);
-    k.gate("cnot",2,4);
-    k.gate("cnot",5,2);
-    k.gate("cnot",4,5);
-    k.gate("tdag",2);
-    k.gate("cnot",4,2);
-    k.gate("tdag",4);
-    k.gate("tdag",2);
-    k.gate("t",5);
-    k.gate("cnot",5,2);
-    k.gate("cnot",4,5);
-    k.gate("cnot",2,4);
-    k.gate("h",5);
-    k.gate("h",0);
-    k.gate("t",1);
-    k.gate("t",5);
-    k.gate("t",0);
-    k.gate("cnot",5,1);
-    k.gate("cnot",0,5);
-    k.gate("cnot",1,0);
-    k.gate("tdag",5);
-    k.gate("cnot",1,5);
-    k.gate("tdag",1);
-    k.gate("tdag",5);
-    k.gate("t",0);
-    k.gate("cnot",0,5);
-    k.gate("cnot",1,0);
-    k.gate("cnot",5,1);
-    k.gate("h",0);
-    k.gate("h",5);
-    k.gate("t",4);
-    k.gate("t",2);
-    k.gate("t",5);
-    k.gate("cnot",2,4);
-    k.gate("cnot",5,2);
-    k.gate("cnot",4,5);
-    k.gate("tdag",2);
-    k.gate("cnot",4,2);
-    k.gate("tdag",4);
-    k.gate("tdag",2);
-    k.gate("t",5);
-    k.gate("cnot",5,2);
-    k.gate("cnot",4,5);
-    k.gate("cnot",2,4);
-    k.gate("h",5);
-    k.gate("x",4);
-    k.gate("h",5);
-    k.gate("t",4);
-    k.gate("t",3);
-    k.gate("t",5);
-    k.gate("cnot",3,4);
-    k.gate("cnot",5,3);
-    k.gate("cnot",4,5);
-    k.gate("tdag",3);
-    k.gate("cnot",4,3);
-    k.gate("tdag",4);
-    k.gate("tdag",3);
-    k.gate("t",5);
-    k.gate("cnot",5,3);
-    k.gate("cnot",4,5);
-    k.gate("cnot",3,4);
-    k.gate("h",5);
-    k.gate("h",0);
-    k.gate("t",5);
-    k.gate("t",4);
-    k.gate("t",0);
-    k.gate("cnot",4,5);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("tdag",4);
-    k.gate("cnot",5,4);
-    k.gate("tdag",5);
-    k.gate("tdag",4);
-    k.gate("t",0);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("cnot",4,5);
-    k.gate("h",0);
-    k.gate("h",4);
-    k.gate("t",2);
-    k.gate("t",1);
-    k.gate("t",4);
-    k.gate("cnot",1,2);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("tdag",1);
-    k.gate("cnot",2,1);
-    k.gate("tdag",2);
-    k.gate("tdag",1);
-    k.gate("t",4);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("cnot",1,2);
-    k.gate("h",4);
-    k.gate("h",0);
-    k.gate("t",5);
-    k.gate("t",4);
-    k.gate("t",0);
-    k.gate("cnot",4,5);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("tdag",4);
-    k.gate("cnot",5,4);
-    k.gate("tdag",5);
-    k.gate("tdag",4);
-    k.gate("t",0);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("cnot",4,5);
-    k.gate("h",0);
-    k.gate("h",4);
-    k.gate("t",2);
-    k.gate("t",1);
-    k.gate("t",4);
-    k.gate("cnot",1,2);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("tdag",1);
-    k.gate("cnot",2,1);
-    k.gate("tdag",2);
-    k.gate("tdag",1);
-    k.gate("t",4);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("cnot",1,2);
-    k.gate("h",4);
-    k.gate("h",5);
-    k.gate("t",4);
-    k.gate("t",3);
-    k.gate("t",5);
-    k.gate("cnot",3,4);
-    k.gate("cnot",5,3);
-    k.gate("cnot",4,5);
-    k.gate("tdag",3);
-    k.gate("cnot",4,3);
-    k.gate("tdag",4);
-    k.gate("tdag",3);
-    k.gate("t",5);
-    k.gate("cnot",5,3);
-    k.gate("cnot",4,5);
-    k.gate("cnot",3,4);
-    k.gate("h",5);
-    k.gate("h",0);
-    k.gate("t",5);
-    k.gate("t",4);
-    k.gate("t",0);
-    k.gate("cnot",4,5);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("tdag",4);
-    k.gate("cnot",5,4);
-    k.gate("tdag",5);
-    k.gate("tdag",4);
-    k.gate("t",0);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("cnot",4,5);
-    k.gate("h",0);
-    k.gate("h",4);
-    k.gate("t",2);
-    k.gate("t",1);
-    k.gate("t",4);
-    k.gate("cnot",1,2);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("tdag",1);
-    k.gate("cnot",2,1);
-    k.gate("tdag",2);
-    k.gate("tdag",1);
-    k.gate("t",4);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("cnot",1,2);
-    k.gate("h",4);
-    k.gate("h",0);
-    k.gate("t",5);
-    k.gate("t",4);
-    k.gate("t",0);
-    k.gate("cnot",4,5);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("tdag",4);
-    k.gate("cnot",5,4);
-    k.gate("tdag",5);
-    k.gate("tdag",4);
-    k.gate("t",0);
-    k.gate("cnot",0,4);
-    k.gate("cnot",5,0);
-    k.gate("cnot",4,5);
-    k.gate("h",0);
-    k.gate("h",4);
-    k.gate("t",2);
-    k.gate("t",1);
-    k.gate("t",4);
-    k.gate("cnot",1,2);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("tdag",1);
-    k.gate("cnot",2,1);
-    k.gate("tdag",2);
-    k.gate("tdag",1);
-    k.gate("t",4);
-    k.gate("cnot",4,1);
-    k.gate("cnot",2,4);
-    k.gate("cnot",1,2);
-    k.gate("h",4);
-    k.gate("cnot",0,4);
-
-    for (int q=0; q<n; q++)
-    {
-	    k.gate("measure", q);
-    }
+    daniel2_circuit(k);
 
     prog.add(k);
 
@@ -901,137 +670,7 @@ test_lingling5esm(std::string v, std::string param1, std::string param2, std::st
     ql::quantum_kernel k(kernel_name, starmon, n, 0);
     prog.set_sweep_points(sweep_points, sizeof(sweep_points)/sizeof(float));
 
-    k.gate("prepz",5);
-    k.gate("prepz",6);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("x",6);
-    k.gate("ym90",6);
-    k.gate("ym90",0);
-    k.gate("cz",5,0);
-    k.gate("ry90",0);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",1,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",2,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",3);
-    k.gate("cz",5,3);
-    k.gate("ry90",3);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("measure",5);
-    k.gate("measure",6);
-
-    k.gate("prepz",5);
-    k.gate("prepz",6);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("x",6);
-    k.gate("ym90",6);
-    k.gate("ym90",1);
-    k.gate("cz",5,1);
-    k.gate("ry90",1);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",2,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",3,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",4);
-    k.gate("cz",5,4);
-    k.gate("ry90",4);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("measure",5);
-    k.gate("measure",6);
-
-    k.gate("prepz",5);
-    k.gate("prepz",6);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("x",6);
-    k.gate("ym90",6);
-    k.gate("ym90",2);
-    k.gate("cz",5,2);
-    k.gate("ry90",2);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",3,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",4,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",0);
-    k.gate("cz",5,0);
-    k.gate("ry90",0);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("measure",5);
-    k.gate("measure",6);
-
-    k.gate("prepz",5);
-    k.gate("prepz",6);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("x",6);
-    k.gate("ym90",6);
-    k.gate("ym90",3);
-    k.gate("cz",5,3);
-    k.gate("ry90",3);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",4,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",0,5);
-    k.gate("ry90",5);
-    k.gate("ym90",5);
-    k.gate("cz",6,5);
-    k.gate("ry90",5);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("ym90",1);
-    k.gate("cz",5,1);
-    k.gate("ry90",1);
-    k.gate("x",5);
-    k.gate("ym90",5);
-    k.gate("measure",5);
-    k.gate("measure",6);
+    lingling5esm_circuit(k);
 
     prog.add(k);
 
@@ -1059,122 +698,8 @@ test_lingling7esm(std::string v, std::string param1, std::string param2, std::st
     ql::quantum_kernel k(kernel_name, starmon, n, 0);
     prog.set_sweep_points(sweep_points, sizeof(sweep_points)/sizeof(float));
 
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",4);
-    k.gate("cz",7,4);
-    k.gate("ry90",4);
-    k.gate("ym90",8);
-    k.gate("cz",0,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",3);
-    k.gate("cz",7,3);
-    k.gate("ry90",3);
-    k.gate("ym90",8);
-    k.gate("cz",4,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
-
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",1,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",3);
-    k.gate("cz",7,3);
-    k.gate("ry90",3);
-    k.gate("ym90",8);
-    k.gate("cz",5,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",4);
-    k.gate("cz",7,4);
-    k.gate("ry90",4);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
-
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",1);
-    k.gate("cz",7,1);
-    k.gate("ry90",1);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("ym90",2);
-    k.gate("cz",7,2);
-    k.gate("ry90",2);
-    k.gate("ym90",8);
-    k.gate("cz",0,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",4,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
+    lingling7esm_circuit(k);
+
     prog.add(k);
 
     ql::options::set("maplookahead", param1);
@@ -1201,130 +726,7 @@ test_lingling7sub(std::string v, std::string param1, std::string param2, std::st
     ql::quantum_kernel k(kernel_name, starmon, n, 0);
     prog.set_sweep_points(sweep_points, sizeof(sweep_points)/sizeof(float));
 
-#define SUB1    1
-
-#ifdef SUB1
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",4);
-    k.gate("cz",7,4);
-    k.gate("ry90",4);
-    k.gate("ym90",8);
-    k.gate("cz",0,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",3);
-    k.gate("cz",7,3);
-    k.gate("ry90",3);
-    k.gate("ym90",8);
-    k.gate("cz",4,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
-#endif
-
-#ifdef SUB2
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",1,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",3);
-    k.gate("cz",7,3);
-    k.gate("ry90",3);
-    k.gate("ym90",8);
-    k.gate("cz",5,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",4);
-    k.gate("cz",7,4);
-    k.gate("ry90",4);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
-#endif
-
-#ifdef SUB3
-    k.gate("prepz",7);
-    k.gate("prepz",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("ym90",1);
-    k.gate("cz",7,1);
-    k.gate("ry90",1);
-    k.gate("ym90",8);
-    k.gate("cz",2,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",5);
-    k.gate("cz",7,5);
-    k.gate("ry90",5);
-    k.gate("ym90",8);
-    k.gate("cz",6,8);
-    k.gate("ry90",8);
-    k.gate("ym90",2);
-    k.gate("cz",7,2);
-    k.gate("ry90",2);
-    k.gate("ym90",8);
-    k.gate("cz",0,8);
-    k.gate("ry90",8);
-    k.gate("ym90",8);
-    k.gate("cz",7,8);
-    k.gate("ry90",8);
-    k.gate("ym90",6);
-    k.gate("cz",7,6);
-    k.gate("ry90",6);
-    k.gate("ym90",8);
-    k.gate("cz",4,8);
-    k.gate("ry90",8);
-    k.gate("x",7);
-    k.gate("ym90",7);
-    k.gate("measure",7);
-    k.gate("measure",8);
-#endif
+    lingling7sub_circuit(k);
 
     prog.add(k);
 
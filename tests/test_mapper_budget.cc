@@ -0,0 +1,86 @@
+// test of the mapper's time budget (option mapbudget):
+// maps random circuits on the surface-17 topology and checks, by the lookahead depth that the iterative deepening
+// achieved instead of by wall-clock time, that a budget too small for any recursion gives the result of mapping
+// without recursion, and that a large budget lets the search reach mapselectmaxlevel;
+// all two-qubit gates of the output must operate on nearest neighbors and all gates must be kept;
+// and that the option only accepts numbers of at least 0
+
+#include <string>
+#include <iostream>
+
+#include <openql.h>
+#include <mapper.h>
+
+#include "mapper_fixture.h"
+
+static map_result_t run(ql::quantum_platform& platform, Grid& grid, size_t seed, size_t gate_count,
+    const std::string& maxlevel, const std::string& budget)
+{
+    ql::options::set("mapselectmaxlevel", maxlevel);
+    ql::options::set("mapbudget", budget);
+    return map_random_circuit(platform, grid, seed, gate_count);
+}
+
+static bool same(const map_result_t& r1, const map_result_t& r2)
+{
+    return r1.swaps == r2.swaps && r1.depth == r2.depth;
+}
+
+static bool rejected(const std::string& budget)
+{
+    try
+    {
+        ql::options::set("mapbudget", budget);
+    }
+    catch (ql::exception&)
+    {
+        return ql::options::get("mapbudget") == "0";
+    }
+    return false;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("mapper", "minextend");
+    ql::options::set("maptiebreak", "first");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    Grid grid;
+    grid.Init(&platform);
+
+    bool ok = true;
+    for (size_t seed = 1; seed <= 3; seed++)
+    {
+        size_t gate_count = 50 * seed;
+        map_result_t level0 = run(platform, grid, seed, gate_count, "0", "0");
+        // each decision's part of a budget of a picosecond runs out during the search without recursion
+        map_result_t tiny = run(platform, grid, seed, gate_count, "inf", "0.000000001");
+        // a budget of 1000 s per kernel lets the iterative deepening reach level 2
+        map_result_t ample = run(platform, grid, seed, gate_count, "2", "1000000");
+
+        bool valid = level0.adjacent && level0.complete && tiny.adjacent && tiny.complete && ample.adjacent && ample.complete;
+        bool pass = valid && tiny.maxdepth == 0 && same(tiny, level0) && ample.maxdepth == 2;
+        if (!pass)
+        {
+            std::cout << "seed " << seed << ": swaps/depth without recursion " << level0.swaps << "/" << level0.depth
+                      << ", with tiny budget " << tiny.swaps << "/" << tiny.depth << " at max lookahead depth " << tiny.maxdepth
+                      << ", with ample budget " << ample.swaps << "/" << ample.depth << " at max lookahead depth " << ample.maxdepth
+                      << (valid ? "" : ", not adjacent or gates lost") << "  FAIL" << std::endl;
+        }
+        ok = ok && pass;
+    }
+
+    ql::options::set("mapselectmaxlevel", "0");
+    ql::options::set("mapbudget", "0");
+    bool checked = rejected("abc") && rejected("-1") && rejected("") && rejected("10ms") && rejected("inf");
+    if (!checked)
+    {
+        std::cout << "mapbudget accepts a value that is not a number of at least 0  FAIL" << std::endl;
+    }
+    ok = ok && checked;
+
+    ql::options::set("mapbudget", "0");
+    ql::options::set("mapper", "no");
+    ql::options::set("maptiebreak", "random");
+    return ok ? 0 : 1;
+}
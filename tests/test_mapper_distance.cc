@@ -0,0 +1,47 @@
+// regression test of the mapper's grid: distances computed on demand by breadth-first search
+// equal those of Floyd-Warshall, and a row of distances is only computed when a distance from its qubit is asked for
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <openql.h>
+#include <mapper.h>
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    size_t nq = platform.qubit_number;
+
+    Grid grid;
+    grid.Init(&platform);
+
+    bool lazy = true;
+    for (size_t i = 0; i < nq; i++) lazy = lazy && grid.dist[i].empty();
+    grid.Distance(0, nq-1);
+    lazy = lazy && !grid.dist[0].empty();
+    for (size_t i = 1; i < nq; i++) lazy = lazy && grid.dist[i].empty();
+
+    // Floyd-Warshall as reference
+    std::vector<std::vector<size_t>> fw(nq, std::vector<size_t>(nq, MAX_CYCLE));
+    for (size_t i = 0; i < nq; i++)
+    {
+        fw[i][i] = 0;
+        for (size_t j : grid.nbs[i]) fw[i][j] = 1;
+    }
+    for (size_t k = 0; k < nq; k++)
+        for (size_t i = 0; i < nq; i++)
+            for (size_t j = 0; j < nq; j++)
+                if (fw[i][k] != MAX_CYCLE && fw[k][j] != MAX_CYCLE && fw[i][j] > fw[i][k] + fw[k][j])
+                    fw[i][j] = fw[i][k] + fw[k][j];
+
+    bool equal = true;
+    for (size_t i = 0; i < nq; i++)
+        for (size_t j = 0; j < nq; j++)
+            equal = equal && grid.Distance(i, j) == fw[i][j];
+
+    std::cout << "distances " << (equal ? "equal" : "DIFFER") << ", rows computed "
+              << (lazy ? "on demand" : "EAGERLY") << std::endl;
+    return equal && lazy ? 0 : 1;
+}
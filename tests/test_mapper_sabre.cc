@@ -0,0 +1,104 @@
+// regression test of the SABRE mapper heuristic (option mapper=sabre):
+// maps the circuits of test_mapper.cc on the surface-17 topology with sabre and with minextend as baseline,
+// and checks that all two-qubit gates of the output operate on nearest neighbors, that all gates are kept,
+// that sabre doesn't need more than twice the swaps of minextend on any circuit
+// nor more than one and a half times the swaps of minextend in total;
+// also checks that a gate between disconnected qubits is reported instead of hanging the mapper
+
+#include <string>
+#include <iostream>
+#include <vector>
+
+#include <openql.h>
+#include <mapper.h>
+
+#include "mapper_fixture.h"
+#include "mapper_s17_fixture.h"
+
+struct circuit_t
+{
+    std::string name;
+    size_t      qubits;
+    void        (*generate)(ql::quantum_kernel& k);
+};
+
+static map_result_t map_circuit(ql::quantum_platform& platform, Grid& grid, const circuit_t& circuit)
+{
+    ql::quantum_kernel k("k", platform, circuit.qubits, 0);
+    circuit.generate(k);
+    return map_kernel(platform, grid, k);
+}
+
+// maps a cnot between a qubit that has no edges and one that has, which has no route
+static bool test_disconnected()
+{
+    json config = ql::load_json("test_mapper_s17.json");
+    json edges = json::array();
+    for (auto& edge : config["topology"]["edges"])
+    {
+        if (edge["src"] != 16 && edge["dst"] != 16) edges.push_back(edge);
+    }
+    config["topology"]["edges"] = edges;
+    ql::utils::write_file("test_output/test_mapper_sabre_disconnected.json", config.dump(4));
+
+    ql::quantum_platform platform("starmon", "test_output/test_mapper_sabre_disconnected.json");
+    ql::quantum_kernel k("k", platform, 17, 0);
+    k.gate("cnot", 0, 16);
+    Mapper m;
+    m.Init(&platform);
+    bool reported = false;
+    try
+    {
+        m.Map(k);
+    }
+    catch (ql::exception& e)
+    {
+        reported = true;
+    }
+    std::cout << "disconnected qubits: " << (reported ? "reported" : "NOT REPORTED") << std::endl;
+    return reported;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("maptiebreak", "first");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    Grid grid;
+    grid.Init(&platform);
+
+    bool ok = true;
+    size_t total_minextend = 0;
+    size_t total_sabre = 0;
+    std::vector<circuit_t> circuits = {
+        { "daniel2", 6, daniel2_circuit },
+        { "lingling5esm", 7, lingling5esm_circuit },
+        { "lingling7esm", 9, lingling7esm_circuit },
+        { "lingling7sub", 9, lingling7sub_circuit }
+    };
+    for (auto& circuit : circuits)
+    {
+        ql::options::set("mapper", "minextend");
+        map_result_t minextend = map_circuit(platform, grid, circuit);
+        ql::options::set("mapper", "sabre");
+        map_result_t sabre = map_circuit(platform, grid, circuit);
+        bool pass = minextend.adjacent && minextend.complete && sabre.adjacent && sabre.complete
+            && sabre.swaps <= 2 * minextend.swaps;
+        std::cout << circuit.name << ": swaps minextend " << minextend.swaps << ", sabre " << sabre.swaps
+                  << (minextend.adjacent && sabre.adjacent ? "" : ", not adjacent")
+                  << (minextend.complete && sabre.complete ? "" : ", gates lost") << (pass ? "" : "  FAIL") << std::endl;
+        ok = ok && pass;
+        total_minextend += minextend.swaps;
+        total_sabre += sabre.swaps;
+    }
+    bool total = 2 * total_sabre <= 3 * total_minextend;
+    std::cout << "total swaps: minextend " << total_minextend << ", sabre " << total_sabre << (total ? "" : "  FAIL") << std::endl;
+    ok = ok && total;
+
+    ql::options::set("mapper", "sabre");
+    ok = test_disconnected() && ok;
+
+    ql::options::set("mapper", "no");
+    ql::options::set("maptiebreak", "random");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// test of the PassManager (passmanager.cc) compiling with the cc_light pass list of quantum_program::compile_modular:
+// clifford optimization before the mapper gets the unchanged output of clifford optimization after the prescheduler,
+// so the PassManager avoids running it again; checks in the pass profile that it was avoided,
+// and that its in and out report and qasm files were written nevertheless;
+// also checks the pass profile (get_profile): a record per pass with sizes chaining from pass to pass,
+// and an empty profile when profiling is not asked for, while the pass spans in the trace are still named
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+
+#include <openql.h>
+
+static bool file_exists(const std::string &file_name)
+{
+    std::ifstream file(file_name);
+    return file.good();
+}
+
+static bool test_skip()
+{
+    const size_t nq = 7;
+    std::string name = "test_passmanager_skip";
+
+    std::vector<std::string> reports;
+    for (std::string file : { "_in.report", "_out.report", "_in.qasm", "_out.qasm" })
+    {
+        reports.push_back("test_output/" + name + "_clifford_premapper" + file);
+        std::remove(reports.back().c_str());
+    }
+
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("write_report_files", "yes");
+    ql::options::set("write_qasm_files", "yes");
+    ql::options::set("profile_passes", "yes");
+    ql::options::set("clifford_postscheduler", "yes");
+    ql::options::set("clifford_premapper", "yes");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    ql::quantum_program prog(name, platform, nq, 0);
+    ql::quantum_kernel k(name, platform, nq, 0);
+    for (size_t q = 0; q < nq; q++)
+    {
+        k.gate("x", q);
+        k.gate("y", q);
+        k.gate("x90", q);
+    }
+    k.gate("cz", 2, 0);
+    k.gate("x", 0);
+    prog.add(k);
+    prog.compile_modular();
+
+    bool avoided = false;
+    bool ran = false;
+    json profile = json::parse(prog.get_profile());
+    for (auto &pass : profile["passes"])
+    {
+        if (pass["name"] == "clifford_premapper") avoided = pass["avoided"];
+        if (pass["name"] == "clifford_postscheduler") ran = !pass["avoided"];
+    }
+    bool reported = true;
+    for (auto &file : reports)
+    {
+        reported = reported && file_exists(file);
+    }
+
+    bool pass = ran && avoided && reported;
+    std::cout << "clifford_postscheduler " << (ran ? "ran" : "avoided")
+              << ", clifford_premapper " << (avoided ? "avoided" : "ran")
+              << ", its reports " << (reported ? "written" : "missing") << (pass ? "" : "  FAIL") << std::endl;
+    return pass;
+}
+
+static std::string compile_profiled(const std::string &name, bool profile)
+{
+    const size_t nq = 7;
+
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("profile_passes", profile ? "yes" : "no");
+    ql::options::set("write_trace_files", profile ? "no" : "yes");
+    ql::options::set("mapper", "minextend");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+    ql::quantum_program prog(name, platform, nq, 0);
+    ql::quantum_kernel k(name, platform, nq, 0);
+    for (size_t q = 0; q < nq; q++)
+    {
+        k.gate("x", q);
+        k.gate("cz", q, (q + 3) % nq);
+    }
+    prog.add(k);
+    prog.compile_modular();
+    ql::options::set("write_trace_files", "no");
+    return prog.get_profile();
+}
+
+static bool test_profile()
+{
+    json profile = json::parse(compile_profiled("test_passmanager_profile", true));
+    std::vector<std::string> expected = { "initialqasmwriter", "rotation_optimize", "decompose_toffoli",
+        "clifford_prescheduler", "prescheduler", "clifford_postscheduler", "scheduledqasmwriter",
+        "ccl_prep_code_generation", "ccl_decompose_pre_schedule", "write_quantumsim_script_unmapped",
+        "clifford_premapper", "mapper", "clifford_postmapper", "rcscheduler", "ccl_latency_compensation",
+        "ccl_insert_buffer_delays", "ccl_decompose_post_schedule", "write_quantumsim_script_mapped",
+        "qisa_code_generation" };
+    std::vector<std::string> names;
+    bool sizes = true;
+    json previous;
+    for (auto &pass : profile["passes"])
+    {
+        names.push_back(pass["name"]);
+        sizes = sizes && pass["run_time"] >= 0.0 && (previous.is_null() || pass["in"] == previous["out"]);
+        previous = pass;
+    }
+    size_t gates_in = profile["passes"][0]["in"]["gates"];
+    size_t gates_mapped = 0;
+    for (auto &pass : profile["passes"])
+    {
+        if (pass["name"] == "mapper") gates_mapped = pass["out"]["gates"];
+    }
+    bool pass = names == expected && sizes && gates_in == 14 && gates_mapped > gates_in && profile["total_time"] > 0.0;
+
+    std::string unprofiled = compile_profiled("test_passmanager_unprofiled", false);
+    pass = pass && unprofiled.empty();
+
+    std::vector<std::string> traced;
+    std::ifstream trace_file("test_output/test_passmanager_unprofiled_trace.json");
+    json trace = json::parse(std::string(std::istreambuf_iterator<char>(trace_file), std::istreambuf_iterator<char>()));
+    for (auto &event : trace["traceEvents"])
+    {
+        if (event["ph"] == "X" && event["cat"] == "pass") traced.push_back(event["name"]);
+    }
+    pass = pass && traced == expected;
+
+    std::cout << "profile: " << names.size() << " passes, " << gates_in << " gates in, " << gates_mapped
+              << " after mapping, " << (unprofiled.empty() ? "empty" : "non-empty") << " when not profiling, "
+              << traced.size() << " pass spans traced"
+              << (pass ? "" : "  FAIL") << std::endl;
+    return pass;
+}
+
+int main(int argc, char ** argv)
+{
+    bool ok = true;
+    ok = test_skip() && ok;
+    ok = test_profile() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+// regression test of the exact scheduler (option scheduler_exact):
+// checks on small random circuits that its schedules respect the dependences and the resources,
+// that it completes, and that its schedules are not longer than those of the plain list scheduler
+// and of a portfolio of list schedulers, and shorter than those of the plain list scheduler for some circuits
+
+#include <string>
+#include <iostream>
+
+#include <openql.h>
+#include <scheduler.h>
+
+#include "scheduler_fixture.h"
+
+static schedule_result_t run(ql::quantum_platform& platform, size_t seed, const std::string& scheduler,
+    const std::string& portfolio, bool exact)
+{
+    ql::quantum_kernel k("k", platform, 17, 0);
+    random_circuit(k, seed, 8, 7);
+    return schedule_circuit(platform, k, scheduler, portfolio, exact);
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("scheduler_exact_budget", "0");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+
+    bool ok = true;
+    size_t shorter = 0;
+    for (size_t seed = 1; seed <= 10; seed++)
+    {
+        for (std::string scheduler : { "ASAP", "ALAP" })
+        {
+            schedule_result_t plain = run(platform, seed, scheduler, "no", false);
+            schedule_result_t portfolio = run(platform, seed, scheduler, "64", false);
+            schedule_result_t exact = run(platform, seed, scheduler, "no", true);
+            bool valid = plain.valid && portfolio.valid && exact.valid;
+            bool pass = valid && exact.optimal && exact.latency <= plain.latency && exact.latency <= portfolio.latency;
+            if (!pass)
+            {
+                std::cout << "seed " << seed << " " << scheduler << ": latency plain " << plain.latency
+                          << ", portfolio " << portfolio.latency << ", exact " << exact.latency
+                          << (valid ? "" : ", invalid schedule") << (exact.optimal ? "" : ", not completed") << "  FAIL" << std::endl;
+            }
+            ok = ok && pass;
+            shorter += (exact.latency < plain.latency);
+        }
+    }
+    std::cout << "exact schedules shorter than plain list schedules: " << shorter << " of 20" << (shorter > 0 ? "" : "  FAIL") << std::endl;
+    ok = ok && shorter > 0;
+    ql::options::set("scheduler_portfolio", "no");
+    ql::options::set("scheduler_exact_budget", "1000");
+    return ok ? 0 : 1;
+}
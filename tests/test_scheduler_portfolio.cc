@@ -0,0 +1,56 @@
+// regression test of the portfolio of list schedulers (option scheduler_portfolio):
+// checks on random circuits that its schedules respect the dependences and the resources,
+// that they are not longer than those of the plain list scheduler, and shorter in total,
+// and that they are the same in repeated runs with the same seed
+
+#include <string>
+#include <iostream>
+
+#include <openql.h>
+#include <scheduler.h>
+
+#include "scheduler_fixture.h"
+
+static schedule_result_t run(ql::quantum_platform& platform, size_t seed, const std::string& scheduler, const std::string& portfolio)
+{
+    ql::quantum_kernel k("k", platform, 17, 0);
+    random_circuit(k, seed, 300, 300);
+    return schedule_circuit(platform, k, scheduler, portfolio, false);
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::options::set("scheduler_portfolio_seed", "7");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+
+    bool ok = true;
+    size_t total_plain = 0, total_portfolio = 0;
+    for (size_t seed = 1; seed <= 10; seed++)
+    {
+        for (std::string scheduler : { "ASAP", "ALAP" })
+        {
+            schedule_result_t plain = run(platform, seed, scheduler, "no");
+            schedule_result_t portfolio = run(platform, seed, scheduler, "8");
+            schedule_result_t again = run(platform, seed, scheduler, "8");
+            bool valid = plain.valid && portfolio.valid;
+            bool same = (portfolio.cycles == again.cycles);
+            bool pass = valid && same && portfolio.latency <= plain.latency;
+            if (!pass)
+            {
+                std::cout << "seed " << seed << " " << scheduler << ": latency plain " << plain.latency
+                          << ", portfolio " << portfolio.latency << (valid ? "" : ", invalid schedule")
+                          << (same ? "" : ", not repeatable") << "  FAIL" << std::endl;
+            }
+            ok = ok && pass;
+            total_plain += plain.latency;
+            total_portfolio += portfolio.latency;
+        }
+    }
+    bool shorter = total_portfolio < total_plain;
+    std::cout << "total latency plain: " << total_plain << " portfolio: " << total_portfolio << (shorter ? "" : "  FAIL") << std::endl;
+    ok = ok && shorter;
+    ql::options::set("scheduler_portfolio", "no");
+    ql::options::set("scheduler_portfolio_seed", "0");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// test of the trace buffers (trace.cc):
+// a buffer that overflows keeps the most recent events in order and reports the others as dropped,
+// and the buffer of a thread that exited is taken over by the next thread that traces, instead of adding one
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <thread>
+
+#include <openql.h>
+#include <trace.h>
+
+// the thread_name metadata events, one per buffer
+static size_t buffer_count(const json &trace)
+{
+    size_t count = 0;
+    for (auto &event : trace["traceEvents"])
+    {
+        if (event["ph"] == "M") count++;
+    }
+    return count;
+}
+
+// the values of the counter events of the given thread, in the order of the trace
+static std::vector<int64_t> counter_values(const json &trace, size_t tid)
+{
+    std::vector<int64_t> values;
+    for (auto &event : trace["traceEvents"])
+    {
+        if (event["ph"] == "C" && event["tid"] == tid) values.push_back(event["args"]["step"]);
+    }
+    return values;
+}
+
+static bool test_overflow()
+{
+    // the main thread hasn't traced yet, so its buffer gets this capacity
+    ql::trace::set_buffer_capacity(8);
+    ql::trace::enable(true);
+    for (int64_t i = 0; i < 20; i++)
+    {
+        ql::trace::counter("test", "step", i);
+    }
+    ql::trace::enable(false);
+
+    json trace = json::parse(ql::trace::to_chrome_json());
+    std::vector<int64_t> expected;
+    for (int64_t i = 12; i < 20; i++) expected.push_back(i);
+    size_t dropped = trace["otherData"]["dropped_events"];
+    bool pass = dropped == 12 && counter_values(trace, 0) == expected;
+
+    // after clearing, the buffer fills again from its start
+    ql::trace::clear();
+    ql::trace::enable(true);
+    ql::trace::counter("test", "step", 100);
+    ql::trace::enable(false);
+    trace = json::parse(ql::trace::to_chrome_json());
+    dropped = trace["otherData"]["dropped_events"];
+    pass = pass && dropped == 0 && counter_values(trace, 0) == std::vector<int64_t>{ 100 };
+
+    std::cout << "overflow: " << counter_values(trace, 0).size() << " events after clear, "
+              << (pass ? "oldest dropped" : "FAIL") << std::endl;
+    ql::trace::clear();
+    return pass;
+}
+
+static bool test_thread_reuse()
+{
+    ql::trace::set_buffer_capacity(1 << 16);
+    ql::trace::enable(true);
+    size_t before = buffer_count(json::parse(ql::trace::to_chrome_json()));
+
+    std::thread first([]() { ql::trace::counter("test", "step", 1); });
+    first.join();
+    json trace = json::parse(ql::trace::to_chrome_json());
+    size_t after_first = buffer_count(trace);
+    size_t tid = before;            // the new buffer's tid is the number of buffers before it
+
+    std::thread second([]() { ql::trace::counter("test", "step", 2); });
+    second.join();
+    trace = json::parse(ql::trace::to_chrome_json());
+    size_t after_second = buffer_count(trace);
+    ql::trace::enable(false);
+
+    bool pass = after_first == before + 1 && after_second == after_first
+        && counter_values(trace, tid) == std::vector<int64_t>{ 1, 2 };
+    std::cout << "threads: " << before << " buffers before, " << after_first << " after the first thread, "
+              << after_second << " after the second" << (pass ? "" : "  FAIL") << std::endl;
+    ql::trace::clear();
+    return pass;
+}
+
+int main(int argc, char ** argv)
+{
+    bool ok = true;
+    ok = test_overflow() && ok;
+    ok = test_thread_reuse() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,426 @@
+// regression benchmark of the uniform scheduler:
+// checks that schedule_alap_uniform produces the same schedule as the published algorithm
+// in schedule_alap_uniform_reference below, also with GROUP nodes (scheduler_commute),
+// and compares their run times and the variance of the bundle sizes
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <map>
+#include <list>
+#include <algorithm>
+
+#include <openql.h>
+#include <scheduler.h>
+
+// the minimum of bound and the cycles of the successors of node n, looking through GROUP nodes
+static size_t min_successor_cycle(Scheduler& sched, ListDigraph::Node n, size_t bound)
+{
+    for ( ListDigraph::OutArcIt arc(sched.graph, n); arc != INVALID; ++arc )
+    {
+        ListDigraph::Node   succNode = sched.graph.target(arc);
+        if (sched.is_group(succNode))
+        {
+            bound = min_successor_cycle(sched, succNode, bound);
+        }
+        else
+        {
+            bound = std::min(bound, sched.instruction[succNode]->cycle);
+        }
+    }
+    return bound;
+}
+
+// The uniform scheduling algorithm as published, O(n^2) in the worst case, as it was in Scheduler;
+// the reference for Scheduler::schedule_alap_uniform, which must produce the same schedule.
+static void schedule_alap_uniform_reference(Scheduler& sched)
+{
+    // algorithm based on "Balanced Scheduling and Operation Chaining in High-Level Synthesis for FPGA Designs"
+    // by David C. Zaretsky, Gaurav Mittal, Robert P. Dick, and Prith Banerjee
+    // Figure 3. Balanced scheduling algorithm
+    // Modifications:
+    // - dependency analysis in article figure 2 is O(n^2) because of set union
+    //   this has been left out, using our own linear dependency analysis creating a digraph
+    //   and using the alap values as measure instead of the dep set size computed in article's D[n]
+    // - balanced scheduling algorithm dominates with its O(n^2) when it cannot find a node to forward
+    //   no test has been devised yet to break the loop (figure 3, line 14-35)
+    // - targeted bundle size is adjusted each cycle and is number_of_gates_to_go/number_of_non_empty_bundles_to_go
+    //   this is more greedy, preventing oscillation around a target size based on all bundles,
+    //   because local variations caused by local dep chains create small bundles and thus leave more gates still to go
+    //
+    // Oddly enough, it starts off with an ASAP schedule.
+    // This creates bundles which on average are larger at lower cycle values (opposite to ALAP).
+    // After this, it moves gates up in the direction of the higher cycles but, of course, at most to their ALAP cycle
+    // to fill up the small bundles at the higher cycle values to the targeted uniform length, without extending the circuit.
+    // It does this in a backward scan (as ALAP scheduling would do), so bundles at the highest cycles are filled up first,
+    // and such that the circuit's depth is not enlarged and the dependences/latencies are obeyed.
+    // Hence, the result resembles an ALAP schedule with excess bundle lengths solved by moving nodes down ("rolling pin").
+
+    DOUT("Scheduling ALAP UNIFORM to get bundles ...");
+
+    // initialize gp->cycle as ASAP cycles as first approximation of result;
+    // note that the circuit doesn't contain the SOURCE and SINK gates but the dependence graph does;
+    // from SOURCE is a weight 1 dep to the first nodes using each qubit and classical register, and to the SINK gate
+    // is a dep from each unused qubit/classical register result with as weight the duration of the last operation.
+    // SOURCE (node s) is at cycle 0 and the first circuit's gates are at cycle 1.
+    // SINK (node t) is at the earliest cycle that all gates/operations have completed.
+    sched.set_cycle(ql::forward_scheduling);
+    size_t   cycle_count = sched.instruction[sched.t]->cycle - 1;
+    // so SOURCE at cycle 0, then all circuit's gates at cycles 1 to cycle_count, and finally SINK at cycle cycle_count+1
+
+    // compute remaining which is the opposite of the alap cycle value (remaining[node] :=: SINK->cycle - alapcycle[node])
+    // remaining[node] indicates number of cycles remaining in schedule from node's execution start to SINK,
+    // and indicates the latest cycle that the node can be scheduled so that the circuit's depth is not increased.
+    sched.set_remaining(ql::forward_scheduling);
+
+    // DOUT("Creating gates_per_cycle");
+    // create gates_per_cycle[cycle] = for each cycle the list of gates at cycle cycle
+    // this is the basic map to be operated upon by the uniforming scheduler below;
+    std::map<size_t,std::list<ql::gate*>> gates_per_cycle;
+    for ( ql::circuit::iterator gpit = sched.circp->begin(); gpit != sched.circp->end(); gpit++)
+    {
+        ql::gate*           gp = *gpit;
+        gates_per_cycle[gp->cycle].push_back(gp);
+    }
+
+    // DOUT("Displaying circuit and bundle statistics");
+    // to compute how well the algorithm is doing, two measures are computed:
+    // - the largest number of gates in a cycle in the circuit,
+    // - and the average number of gates in non-empty cycles
+    // this is done before and after uniform scheduling, and printed
+    size_t max_gates_per_cycle = 0;
+    size_t non_empty_bundle_count = 0;
+    size_t gate_count = 0;
+    for (size_t curr_cycle = 1; curr_cycle <= cycle_count; curr_cycle++)
+    {
+        max_gates_per_cycle = std::max(max_gates_per_cycle, gates_per_cycle[curr_cycle].size());
+        if (int(gates_per_cycle[curr_cycle].size()) != 0) non_empty_bundle_count++;
+        gate_count += gates_per_cycle[curr_cycle].size();
+    }
+    double avg_gates_per_cycle = double(gate_count)/cycle_count;
+    double avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
+    DOUT("... before uniform scheduling:"
+        << " cycle_count=" << cycle_count
+        << "; gate_count=" << gate_count
+        << "; non_empty_bundle_count=" << non_empty_bundle_count
+        );
+    DOUT("... and max_gates_per_cycle=" << max_gates_per_cycle
+        << "; avg_gates_per_cycle=" << avg_gates_per_cycle
+        << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
+        );
+
+    // in a backward scan, make non-empty bundles max avg_gates_per_non_empty_cycle long;
+    // an earlier version of the algorithm aimed at making bundles max avg_gates_per_cycle long
+    // but that flawed because of frequent empty bundles causing this estimate for a uniform length being too low
+    // DOUT("Backward scan uniform scheduling");
+    for (size_t curr_cycle = cycle_count; curr_cycle >= 1; curr_cycle--)
+    {
+        // Backward with pred_cycle from curr_cycle-1 down to 1, look for node(s) to fill up current too small bundle.
+        // After an iteration at cycle curr_cycle, all bundles from curr_cycle to cycle_count have been filled up,
+        // and all bundles from 1 to curr_cycle-1 still have to be done.
+        // This assumes that current bundle is never too long, excess having been moved away earlier, as ASAP does.
+        // When such a node cannot be found, this loop scans the whole circuit for each original node to fill up
+        // and this creates a O(n^2) time complexity.
+        //
+        // A test to break this prematurely based on the current data structure, wasn't devised yet.
+        // A solution is to use the dep graph instead to find a node to fill up the current node,
+        // i.e. maintain a so-called "available list" of nodes free to schedule, as in the non-uniform scheduling algorithm,
+        // which is not hard at all but which is not according to the published algorithm.
+        // When the complexity becomes a problem, it is proposed to rewrite the algorithm accordingly.
+
+        long pred_cycle = curr_cycle - 1;    // signed because can become negative
+
+        // target size of each bundle is number of gates still to go divided by number of non-empty cycles to go
+        // it averages over non-empty bundles instead of all bundles because the latter would be very strict
+        // it is readjusted during the scan to cater for dips in bundle size caused by local dependence chains
+        if (non_empty_bundle_count == 0) break;     // nothing to do
+        avg_gates_per_cycle = double(gate_count)/curr_cycle;
+        avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
+        DOUT("Cycle=" << curr_cycle << " number of gates=" << gates_per_cycle[curr_cycle].size()
+            << "; avg_gates_per_cycle=" << avg_gates_per_cycle
+            << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle);
+
+        while ( double(gates_per_cycle[curr_cycle].size()) < avg_gates_per_non_empty_cycle && pred_cycle >= 1 )
+        {
+            DOUT("pred_cycle=" << pred_cycle);
+            DOUT("gates_per_cycle[curr_cycle].size()=" << gates_per_cycle[curr_cycle].size());
+            size_t      min_remaining_cycle = MAX_CYCLE;
+            ql::gate*   best_predgp;
+            bool        best_predgp_found = false;
+
+            // scan bundle at pred_cycle to find suitable candidate to move forward to curr_cycle
+            for ( auto predgp : gates_per_cycle[pred_cycle] )
+            {
+                bool    forward_predgp = true;
+                size_t  predgp_completion_cycle;
+                ListDigraph::Node   pred_node = sched.node[predgp];
+                DOUT("... considering: " << predgp->qasm() << " @cycle=" << predgp->cycle << " remaining=" << sched.remaining[pred_node]);
+
+                // candidate's result, when moved, must be ready before end-of-circuit and before used
+                predgp_completion_cycle = curr_cycle + size_t(std::ceil(static_cast<float>(predgp->duration)/sched.cycle_time));
+                // predgp_completion_cycle = curr_cycle + (predgp->duration+sched.cycle_time-1)/sched.cycle_time;
+                if (predgp_completion_cycle > cycle_count + 1)  // at SINK is ok, later not
+                {
+                    forward_predgp = false;
+                    DOUT("... ... rejected (after circuit): " << predgp->qasm() << " would complete @" << predgp_completion_cycle << " SINK @" << cycle_count+1);
+                }
+                else
+                {
+                    for ( ListDigraph::OutArcIt arc(sched.graph,pred_node); arc != INVALID; ++arc )
+                    {
+                        ListDigraph::Node   target_node = sched.graph.target(arc);
+                        ql::gate*   target_gp = sched.instruction[target_node];
+                        // a GROUP node isn't moved; it has duration 0, so look through it at its successors
+                        size_t target_cycle = sched.is_group(target_node) ? min_successor_cycle(sched, target_node, MAX_CYCLE) : target_gp->cycle;
+                        if(predgp_completion_cycle > target_cycle)
+                        {
+                            forward_predgp = false;
+                            DOUT("... ... rejected (after succ): " << predgp->qasm() << " would complete @" << predgp_completion_cycle << " target=" << target_gp->qasm() << " target_cycle=" << target_cycle);
+                        }
+                    }
+                }
+
+                // when multiple nodes in bundle qualify, take the one with lowest remaining
+                // because that is the most critical one and thus deserves a cycle as high as possible (ALAP)
+                if (forward_predgp && sched.remaining[pred_node] < min_remaining_cycle)
+                {
+                    min_remaining_cycle = sched.remaining[pred_node];
+                    best_predgp_found = true;
+                    best_predgp = predgp;
+                }
+            }
+
+            // when candidate was found in this bundle, move it, and search for more in this bundle, if needed
+            // otherwise, continue scanning backward
+            if (best_predgp_found)
+            {
+                // move predgp from pred_cycle to curr_cycle;
+                // adjust all bookkeeping that is affected by this
+                gates_per_cycle[pred_cycle].remove(best_predgp);
+                if (gates_per_cycle[pred_cycle].size() == 0)
+                {
+                    // source bundle was non-empty, now it is empty
+                    non_empty_bundle_count--;
+                }
+                if (gates_per_cycle[curr_cycle].size() == 0)
+                {
+                    // target bundle was empty, now it will be non_empty
+                    non_empty_bundle_count++;
+                }
+                best_predgp->cycle = curr_cycle;        // what it is all about
+                gates_per_cycle[curr_cycle].push_back(best_predgp);
+
+                // recompute targets
+                if (non_empty_bundle_count == 0) break;     // nothing to do
+                avg_gates_per_cycle = double(gate_count)/curr_cycle;
+                avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
+                DOUT("... moved " << best_predgp->qasm() << " with remaining=" << sched.remaining[sched.node[best_predgp]]
+                    << " from cycle=" << pred_cycle << " to cycle=" << curr_cycle
+                    << "; new avg_gates_per_cycle=" << avg_gates_per_cycle
+                    << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
+                    );
+            }
+            else
+            {
+                pred_cycle --;
+            }
+        }   // end for finding a bundle to forward a node from to the current cycle
+
+        // curr_cycle ready, recompute counts for remaining cycles
+        // mask current cycle and its gates from the target counts:
+        // - gate_count, non_empty_bundle_count, curr_cycle (as cycles still to go)
+        gate_count -= gates_per_cycle[curr_cycle].size();
+        if (gates_per_cycle[curr_cycle].size() != 0)
+        {
+            // bundle is non-empty
+            non_empty_bundle_count--;
+        }
+    }   // end curr_cycle loop; curr_cycle is bundle which must be enlarged when too small
+
+    // new cycle values computed; reflect this in circuit's gate order
+    sched.sort_by_cycle(sched.circp);
+    // FIXME HvS cycles_valid now
+
+    // recompute and print statistics reporting on uniform scheduling performance
+    max_gates_per_cycle = 0;
+    non_empty_bundle_count = 0;
+    gate_count = 0;
+    // cycle_count was not changed
+    for (size_t curr_cycle = 1; curr_cycle <= cycle_count; curr_cycle++)
+    {
+        max_gates_per_cycle = std::max(max_gates_per_cycle, gates_per_cycle[curr_cycle].size());
+        if (int(gates_per_cycle[curr_cycle].size()) != 0) non_empty_bundle_count++;
+        gate_count += gates_per_cycle[curr_cycle].size();
+    }
+    avg_gates_per_cycle = double(gate_count)/cycle_count;
+    avg_gates_per_non_empty_cycle = double(gate_count)/non_empty_bundle_count;
+    DOUT("... after uniform scheduling:"
+        << " cycle_count=" << cycle_count
+        << "; gate_count=" << gate_count
+        << "; non_empty_bundle_count=" << non_empty_bundle_count
+        );
+    DOUT("... and max_gates_per_cycle=" << max_gates_per_cycle
+        << "; avg_gates_per_cycle=" << avg_gates_per_cycle
+        << "; ..._per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
+        );
+
+    DOUT("Scheduling ALAP UNIFORM [DONE]");
+}
+
+typedef std::function<void(ql::quantum_kernel&)> kernel_generator_t;
+
+// rounds of surface-17 style syndrome extraction: data qubits 0-8, ancillas 9-16,
+// with some single-qubit gates on the data qubits to get bundles of different sizes
+static kernel_generator_t surface_code(size_t rounds)
+{
+    return [rounds](ql::quantum_kernel& k)
+    {
+        static const size_t stabilizers[8][4] = {
+            {0, 1, 3, 4}, {1, 2, 4, 5}, {3, 4, 6, 7}, {4, 5, 7, 8},
+            {0, 3, 0, 3}, {2, 5, 2, 5}, {3, 6, 3, 6}, {5, 8, 5, 8}
+        };
+        for (size_t r = 0; r < rounds; r++)
+        {
+            for (size_t a = 0; a < 8; a++)
+            {
+                k.gate("prepz", 9+a);
+                k.gate("ym90", 9+a);
+            }
+            for (size_t step = 0; step < 4; step++)
+            {
+                for (size_t a = 0; a < 8; a++)
+                {
+                    if (step < 2 || a < 4)
+                    {
+                        k.gate("cz", stabilizers[a][step], 9+a);
+                    }
+                }
+            }
+            for (size_t a = 0; a < 8; a++)
+            {
+                k.gate("y90", 9+a);
+                k.gate("measure", 9+a);
+            }
+            for (size_t d = 0; d < 9; d += 1 + r%3)
+            {
+                k.gate("x", d);
+            }
+        }
+    };
+}
+
+// random gates on 17 qubits
+static kernel_generator_t random_circuit(size_t gate_count, size_t seed)
+{
+    return [gate_count, seed](ql::quantum_kernel& k)
+    {
+        std::mt19937 rng(seed);
+        for (size_t i = 0; i < gate_count; i++)
+        {
+            size_t q0 = rng()%17;
+            size_t q1 = (q0 + 1 + rng()%16)%17;
+            switch (rng()%4)
+            {
+            case 0: k.gate("x", q0); break;
+            case 1: k.gate("ym90", q0); break;
+            case 2: k.gate("measure", q0); break;
+            default: k.gate("cz", q0, q1); break;
+            }
+        }
+    };
+}
+
+struct run_result_t
+{
+    std::vector<size_t> cycles;     // of the gates in the original order
+    double              time;       // seconds
+    double              variance;   // of the sizes of the non-empty bundles
+};
+
+static run_result_t run(ql::quantum_platform& platform, const kernel_generator_t& generate, bool reference)
+{
+    ql::quantum_kernel k("k", platform, 17, 0);
+    generate(k);
+    std::vector<ql::gate*> gates(k.c.begin(), k.c.end());
+
+    Scheduler sched;
+    sched.init(k.c, platform, 17, 0);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (reference)
+    {
+        schedule_alap_uniform_reference(sched);
+    }
+    else
+    {
+        sched.schedule_alap_uniform();
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    run_result_t result;
+    result.time = std::chrono::duration<double>(t1 - t0).count();
+    std::map<size_t,size_t> bundle_sizes;
+    for (auto gp : gates)
+    {
+        result.cycles.push_back(gp->cycle);
+        bundle_sizes[gp->cycle]++;
+    }
+    double mean = double(gates.size())/bundle_sizes.size();
+    result.variance = 0.0;
+    for (auto& b : bundle_sizes)
+    {
+        result.variance += (b.second - mean)*(b.second - mean);
+    }
+    result.variance /= bundle_sizes.size();
+    return result;
+}
+
+int main(int argc, char ** argv)
+{
+    ql::options::set("log_level", "LOG_WARNING");
+    ql::quantum_platform platform("starmon", "test_mapper_s17.json");
+
+    // with scheduler_commute, runs of commuting czs on a qubit are represented by GROUP nodes
+    struct case_t
+    {
+        std::string         name;
+        kernel_generator_t  generate;
+        bool                commute;
+    };
+    std::vector<case_t> cases = {
+        { "surface_code_10", surface_code(10), false },
+        { "surface_code_100", surface_code(100), false },
+        { "surface_code_200", surface_code(200), false },
+        { "random_1000", random_circuit(1000, 1), false },
+        { "random_10000", random_circuit(10000, 2), false },
+        { "surface_code_100_c", surface_code(100), true },
+        { "random_10000_c", random_circuit(10000, 2), true },
+    };
+
+    bool ok = true;
+    std::cout << std::left << std::setw(20) << "case"
+              << std::right << std::setw(10) << "gates"
+              << std::setw(14) << "reference[s]" << std::setw(14) << "uniform[s]"
+              << std::setw(12) << "variance" << std::setw(10) << "same" << std::endl;
+    for (auto& c : cases)
+    {
+        ql::options::set("scheduler_commute", c.commute ? "yes" : "no");
+        run_result_t ref = run(platform, c.generate, true);
+        run_result_t res = run(platform, c.generate, false);
+        bool same = (ref.cycles == res.cycles);
+        ok = ok && same;
+        std::cout << std::left << std::setw(20) << c.name
+                  << std::right << std::setw(10) << res.cycles.size()
+                  << std::setw(14) << ref.time << std::setw(14) << res.time
+                  << std::setw(12) << res.variance << std::setw(10) << (same ? "yes" : "NO") << std::endl;
+        if (ref.variance != res.variance)
+        {
+            std::cout << "... bundle size variance differs, reference: " << ref.variance << std::endl;
+        }
+    }
+    ql::options::set("scheduler_commute", "no");
+    return ok ? 0 : 1;
+}